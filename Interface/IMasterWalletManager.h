@@ -205,7 +205,8 @@ namespace Elastos {
 			virtual std::string GetVersion() const = 0;
 
 			/**
-			 * Flush data into disk before destructions
+			 * Flush data into disk before destructions. Wallet databases commit their writes in groups every few
+			 * hundred milliseconds, this commits what is pending at once.
 			 */
 			virtual void FlushData() = 0;
 
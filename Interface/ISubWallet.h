@@ -237,6 +237,28 @@ namespace Elastos {
 				uint32_t count,
 				const std::string &txID) const = 0;
 
+			/**
+			 * Get a page of normal transactions sorted by descent (newest first). Unlike GetAllTransaction, a page costs
+			 * the same however deep it is, so prefer this to walk a long history.
+			 * @param cursor empty for the first page, otherwise the "Cursor" of the previous page.
+			 * @param count specify count of transactions we need.
+			 * @return transactions of the page in json format, the same as GetAllTransaction but without "MaxCount". "Cursor" is empty after the last page.
+			 * {"Cursor":"011aa20200bad3db5c00000000b62511d2609c766a013aa4d2d561ebb509423fe4a7564fe0cb3778e5324545ff","Transactions":[{"Amount":"20000","ConfirmStatus":"6+","Direction":"Received","Height":172570,"Status":"Confirmed","Timestamp":1557910458,"TxHash":"ff454532e57837cbe04f56a7e43f4209b5eb61d5d2a43a016a769c60d21125b6","Type":6}]}
+			 */
+			virtual nlohmann::json GetAllTransactionPage(
+				const std::string &cursor,
+				uint32_t count) const = 0;
+
+			/**
+			 * Get a page of coinbase transactions sorted by descent (newest first).
+			 * @param cursor empty for the first page, otherwise the "Cursor" of the previous page.
+			 * @param count specify count of transactions we need.
+			 * @return transactions of the page in json format, see GetAllTransactionPage.
+			 */
+			virtual nlohmann::json GetAllCoinBaseTransactionPage(
+				const std::string &cursor,
+				uint32_t count) const = 0;
+
 			/**
 			 * Get an asset details by specified asset ID
 			 * @param assetID asset hex code from asset hash.
@@ -269,6 +291,23 @@ namespace Elastos {
 			 */
 			virtual void Resync() = 0;
 
+			/**
+			 * Get counters and latency histograms of the chain sync, to see where sync time goes.
+			 * @return sync metrics in json format. Each stage of the sync hot path reports how often it ran and
+			 * how long it took in microseconds, the percentiles being upper bounds of power of 2 buckets. Such as:
+			 * {
+			 *   "Stages":{
+			 *     "MessageReceive":{"Count":20512,"TotalMicroseconds":3581200,"AverageMicroseconds":174,"MaxMicroseconds":40213,"P50Microseconds":128,"P90Microseconds":512,"P99Microseconds":2048},
+			 *     "Checksum":{...},"MerkleRoot":{...},"VerifyBlock":{...},"WalletMatch":{...},
+			 *     "SaveBlocks":{...},"UpdateTxns":{...},"ListenerDispatch":{...}
+			 *   },
+			 *   "Counters":{"MessagesReceived":20512,"BytesReceived":5834291,"ChecksumFailures":0,"InvalidMerkleBlocks":0,"WalletTxMatched":3,"BlocksSaved":20000,...},
+			 *   "Database":{"Commits":61,"CommitsPerBlock":0.0031,"Syncs":52,"SyncMicroseconds":183022,"SyncsPerBlock":0.0026},
+			 *   "FalsePositiveRate":0.0005,"LastBlockHeight":480112,"EstimatedHeight":512000,"ConnectedPeers":3
+			 * }
+			 */
+			virtual nlohmann::json GetSyncMetrics() const = 0;
+
 		};
 
 	}
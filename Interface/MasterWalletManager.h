@@ -67,6 +67,21 @@ namespace Elastos {
 			 * 		}
 			 * 	}
 			 * }
+			 *
+			 * Whatever the netType, the wallet database of a chain may be tuned with "Database", shown here with its defaults:
+			 * {
+			 * 	"ELA": {
+			 * 		"Database": {
+			 * 			"JournalMode": "WAL",
+			 * 			"Synchronous": "NORMAL",
+			 * 			"CacheSizeKB": 8192,
+			 * 			"MmapSize": 67108864,
+			 * 			"CheckpointPages": 1000,
+			 * 			"GroupCommitMilliseconds": 500,
+			 * 			"GroupCommitTransactions": 1000
+			 * 		}
+			 * 	}
+			 * }
 			 */
 			explicit MasterWalletManager(const std::string &rootPath, const std::string &netType = "MainNet",
 										 const nlohmann::json &config = nlohmann::json(),
@@ -64,6 +64,9 @@ namespace Elastos {
 
 			virtual bool ContainsAddress(const AddressPtr &address) const = 0;
 
+			// program hashes of every address and CID generated so far, in generation order
+			virtual const std::vector<bytes_t> &BloomFilterElements() const = 0;
+
 			virtual bytes_t OwnerPubKey() const = 0;
 
 			virtual bytes_t DIDPubKey() const = 0;
@@ -36,6 +36,7 @@ namespace Elastos {
 
             side_address = AddressPtr(new Address());
             side_address->SetRedeemScript(PrefixCrossChain, data);
+			filter_elements.push_back(side_address->ProgramHash().bytes());
 		}
 
 		SideAccount::~SideAccount() {
@@ -99,6 +100,8 @@ namespace Elastos {
 
 		bool SideAccount::ContainsAddress(const AddressPtr &address) const { return *side_address == *address; }
 
+		const std::vector<bytes_t> &SideAccount::BloomFilterElements() const { return filter_elements; }
+
 		bool SideAccount::GetCodeAndPath(const AddressPtr &, bytes_t &, std::string &) const { return false; }
 
 		size_t SideAccount::InternalChainIndex(const TransactionPtr &tx) const { return -1; }
@@ -168,6 +168,8 @@ namespace Elastos {
 
 			bool ContainsAddress(const AddressPtr &address) const;
 
+			const std::vector<bytes_t> &BloomFilterElements() const;
+
 			bytes_t OwnerPubKey() const;
 
 			bytes_t DIDPubKey() const;
@@ -191,6 +193,7 @@ namespace Elastos {
 		private:
 			// The 'X' address generated by the side chain genesis hash.
 			AddressPtr side_address;
+			std::vector<bytes_t> filter_elements;
 			AccountPtr parent;
 		};
 
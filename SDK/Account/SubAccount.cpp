@@ -72,6 +72,7 @@ namespace Elastos {
 					cid->ChangePrefix(PrefixIDChain);
 					_cid.push_back(cid);
 					_allCID.insert(cid);
+					_filterElements.push_back(cid->ProgramHash().bytes());
 				}
 			}
 		}
@@ -150,6 +151,8 @@ namespace Elastos {
 						_externalChain.push_back(AddressPtr(new Address(PrefixStandard, pubkey)));
 						_allAddrs.insert(_externalChain[0]);
 					}
+					if (_externalChain[0]->Valid())
+						_filterElements.push_back(_externalChain[0]->ProgramHash().bytes());
 				}
 				addrs = _externalChain;
 				return addrs;
@@ -201,11 +204,16 @@ namespace Elastos {
 
 			for (i = startCount; i < count; i++) {
 				_allAddrs.insert(addrChain[i]);
+				_filterElements.push_back(addrChain[i]->ProgramHash().bytes());
 			}
 
 			return addrs;
 		}
 
+		const std::vector<bytes_t> &SubAccount::BloomFilterElements() const {
+			return _filterElements;
+		}
+
 		bytes_t SubAccount::OwnerPubKey() const {
 			return _parent->OwnerPubKey();
 		}
@@ -67,6 +67,8 @@ namespace Elastos {
 
 			bool ContainsAddress(const AddressPtr &address) const;
 
+			const std::vector<bytes_t> &BloomFilterElements() const;
+
 			size_t GetAllPublickeys(std::vector<bytes_t> &pubkeys, uint32_t start, size_t count,
 			                        bool containInternal) const;
 
@@ -93,6 +95,7 @@ namespace Elastos {
 			uint32_t _coinIndex;
 			AddressArray _internalChain, _externalChain, _cid;
 			AddressSet _usedAddrs, _allAddrs, _allCID;
+			std::vector<bytes_t> _filterElements;
 			mutable AddressPtr _depositAddress, _ownerAddress, _crDepositAddress;
 
 			AccountPtr _parent;
@@ -23,15 +23,16 @@
 
 namespace Elastos {
 	namespace ElaWallet {
-		ByteStream::ByteStream() : _rpos(0) {
+		ByteStream::ByteStream() : _rpos(0), _view(nullptr), _viewSize(0) {
 
 		}
 
-		ByteStream::ByteStream(const void *buf, size_t size) : _rpos(0), _buf((const unsigned char *) buf, size) {
+		ByteStream::ByteStream(const void *buf, size_t size) :
+			_rpos(0), _buf((const unsigned char *) buf, size), _view(nullptr), _viewSize(0) {
 
 		}
 
-		ByteStream::ByteStream(const bytes_t &buf) : _rpos(0), _buf(buf) {
+		ByteStream::ByteStream(const bytes_t &buf) : _rpos(0), _buf(buf), _view(nullptr), _viewSize(0) {
 
 		}
 
@@ -39,26 +40,43 @@ namespace Elastos {
 
 		}
 
+		ByteStream ByteStream::View(const void *buf, size_t size) {
+			ByteStream stream;
+			stream._view = (const uint8_t *) buf;
+			stream._viewSize = size;
+			return stream;
+		}
+
+		void ByteStream::Detach() const {
+			if (_view) {
+				_buf.assign(_view, _view + _viewSize);
+				_view = nullptr;
+			}
+		}
+
 		void ByteStream::Reset() {
 			_rpos = 0;
+			_view = nullptr;
 			_buf.clear();
 		}
 
 		void ByteStream::clear() {
 			_rpos = 0;
+			_view = nullptr;
 			_buf.clear();
 		}
 
 		uint64_t ByteStream::size() const {
-			return _buf.size();
+			return Size();
 		}
 
 		void ByteStream::Skip(size_t bytes) const {
-			if (_rpos + bytes <= _buf.size())
+			if (_rpos + bytes <= Size())
 				_rpos += bytes;
 		}
 
 		const bytes_t &ByteStream::GetBytes() const {
+			Detach();
 			return _buf;
 		}
 
@@ -83,57 +101,57 @@ namespace Elastos {
 		}
 
 		bool ByteStream::ReadBytes(void *buf, size_t len) const {
-			if (_rpos + len > _buf.size())
+			if (_rpos + len > Size())
 				return false;
 
-			memcpy(buf, &_buf[_rpos], len);
+			memcpy(buf, Data() + _rpos, len);
 			_rpos += len;
 
 			return true;
 		}
 
 		bool ByteStream::ReadBytes(bytes_t &bytes, size_t len) const {
-			if (_rpos + len > _buf.size())
+			if (_rpos + len > Size())
 				return false;
 
-			bytes.assign(_buf.begin() + _rpos, _buf.begin() + _rpos + len);
+			bytes.assign(Data() + _rpos, Data() + _rpos + len);
 
 			_rpos += len;
 			return true;
 		}
 
 		bool ByteStream::ReadBytes(uint128 &u) const {
-			if (_rpos + u.size() > _buf.size())
+			if (_rpos + u.size() > Size())
 				return false;
 
-			memcpy(u.begin(), &_buf[_rpos], u.size());
+			memcpy(u.begin(), Data() + _rpos, u.size());
 			_rpos += u.size();
 			return true;
 		}
 
 		bool ByteStream::ReadBytes(uint160 &u) const {
-			if (_rpos + u.size() > _buf.size())
+			if (_rpos + u.size() > Size())
 				return false;
 
-			memcpy(u.begin(), &_buf[_rpos], u.size());
+			memcpy(u.begin(), Data() + _rpos, u.size());
 			_rpos += u.size();
 			return true;
 		}
 
 		bool ByteStream::ReadBytes(uint168 &u) const {
-			if (_rpos + u.size() > _buf.size())
+			if (_rpos + u.size() > Size())
 				return false;
 
-			memcpy(u.begin(), &_buf[_rpos], u.size());
+			memcpy(u.begin(), Data() + _rpos, u.size());
 			_rpos += u.size();
 			return true;
 		}
 
 		bool ByteStream::ReadBytes(uint256 &u) const {
-			if (_rpos + u.size() > _buf.size())
+			if (_rpos + u.size() > Size())
 				return false;
 
-			memcpy(u.begin(), &_buf[_rpos], u.size());
+			memcpy(u.begin(), Data() + _rpos, u.size());
 			_rpos += u.size();
 			return true;
 		}
@@ -148,30 +166,32 @@ namespace Elastos {
 		}
 
 		bool ByteStream::ReadVarUint(uint64_t &len) const {
-			if (_rpos + 1 > _buf.size())
+			const uint8_t *data = Data();
+			size_t size = Size();
+			if (_rpos + 1 > size)
 				return false;
 
-			uint8_t h = _buf[_rpos++];
+			uint8_t h = data[_rpos++];
 
 			switch (h) {
 				case VAR_INT16_HEADER:
-					if (_rpos + 2 > _buf.size())
+					if (_rpos + 2 > size)
 						return false;
-					len = *(uint16_t *) &_buf[_rpos];
+					len = *(uint16_t *) &data[_rpos];
 					_rpos += 2;
 					break;
 
 				case VAR_INT32_HEADER:
-					if (_rpos + 4 > _buf.size())
+					if (_rpos + 4 > size)
 						return false;
-					len = *(uint32_t *) &_buf[_rpos];
+					len = *(uint32_t *) &data[_rpos];
 					_rpos += 4;
 					break;
 
 				case VAR_INT64_HEADER:
-					if (_rpos + 8 > _buf.size())
+					if (_rpos + 8 > size)
 						return false;
-					len = *(uint64_t *) &_buf[_rpos];
+					len = *(uint64_t *) &data[_rpos];
 					_rpos += 8;
 					break;
 
@@ -194,10 +214,12 @@ namespace Elastos {
 		}
 
 		void ByteStream::WriteByte(uint8_t val) {
+			Detach();
 			_buf.push_back(val);
 		}
 
 		void ByteStream::WriteUint8(uint8_t val) {
+			Detach();
 			_buf.push_back(val);
 		}
 
@@ -214,26 +236,32 @@ namespace Elastos {
 		}
 
 		void ByteStream::WriteBytes(const void *buf, size_t len) {
+			Detach();
 			_buf += bytes_t(buf, len);
 		}
 
 		void ByteStream::WriteBytes(const bytes_t &bytes) {
+			Detach();
 			_buf += bytes;
 		}
 
 		void ByteStream::WriteBytes(const uint128 &u) {
+			Detach();
 			_buf += u.bytes();
 		}
 
 		void ByteStream::WriteBytes(const uint160 &u) {
+			Detach();
 			_buf += u.bytes();
 		}
 
 		void ByteStream::WriteBytes(const uint168 &u) {
+			Detach();
 			_buf += u.bytes();
 		}
 
 		void ByteStream::WriteBytes(const uint256 &u) {
+			Detach();
 			_buf += u.bytes();
 		}
 
@@ -248,6 +276,7 @@ namespace Elastos {
 		}
 
 		size_t ByteStream::WriteVarUint(uint64_t len) {
+			Detach();
 			size_t count;
 			if (len < VAR_INT16_HEADER) {
 				_buf.push_back((uint8_t) len);
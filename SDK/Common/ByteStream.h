@@ -48,6 +48,12 @@ namespace Elastos {
 
 			~ByteStream();
 
+			/**
+			 * Read-only stream over @buf without copying it. The caller keeps @buf alive while the stream
+			 * is in use; writing to the stream, or calling GetBytes(), makes a private copy first.
+			 */
+			static ByteStream View(const void *buf, size_t size);
+
 			void Reset();
 
 			void clear();
@@ -116,9 +122,18 @@ namespace Elastos {
 
 			void WriteVarString(const std::string &str);
 
+		private:
+			const uint8_t *Data() const { return _view ? _view : _buf.data(); }
+
+			size_t Size() const { return _view ? _viewSize : _buf.size(); }
+
+			void Detach() const;
+
 		private:
 			mutable size_t _rpos;
-			bytes_t _buf;
+			mutable bytes_t _buf;
+			mutable const uint8_t *_view;
+			size_t _viewSize;
 		};
 
 	}
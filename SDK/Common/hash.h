@@ -48,6 +48,17 @@ inline uchar_vector sha256_2(const uchar_vector& data)
     return rval;
 }
 
+// First four bytes of sha256_2(data) in host order, as used for p2p message checksums, without allocating
+inline uint32_t sha256_2_checksum(const unsigned char* data, size_t len)
+{
+    unsigned char hash[SHA256_DIGEST_LENGTH], hash2[SHA256_DIGEST_LENGTH];
+    SHA256(data, len, hash);
+    SHA256(hash, SHA256_DIGEST_LENGTH, hash2);
+    uint32_t checksum;
+    memcpy(&checksum, hash2, sizeof(checksum));
+    return checksum;
+}
+
 inline uchar_vector ripemd160(const uchar_vector& data)
 {
     unsigned char hash[RIPEMD160_DIGEST_LENGTH];
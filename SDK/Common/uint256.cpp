@@ -5,6 +5,8 @@
 
 #include "uint256.h"
 
+#include <random>
+
 uint128::uint128() {
 	for (int i = 0; i < WIDTH; i++)
 		pn[i] = 0;
@@ -270,4 +272,72 @@ uint256 uint512::trim256() const {
 		ret.pn[i] = pn[i];
 	}
 	return ret;
-}
\ No newline at end of file
+}
+
+#define ROTL(x, b) (uint64_t)(((x) << (b)) | ((x) >> (64 - (b))))
+
+#define SIPROUND do { \
+	v0 += v1; v1 = ROTL(v1, 13); v1 ^= v0; \
+	v0 = ROTL(v0, 32); \
+	v2 += v3; v3 = ROTL(v3, 16); v3 ^= v2; \
+	v0 += v3; v3 = ROTL(v3, 21); v3 ^= v0; \
+	v2 += v1; v1 = ROTL(v1, 17); v1 ^= v2; \
+	v2 = ROTL(v2, 32); \
+} while (0)
+
+uint64_t SipHashUint256(uint64_t k0, uint64_t k1, const uint256 &val) {
+	uint64_t d = val.Get64(0);
+	uint64_t v0 = 0x736f6d6570736575ULL ^ k0;
+	uint64_t v1 = 0x646f72616e646f6dULL ^ k1;
+	uint64_t v2 = 0x6c7967656e657261ULL ^ k0;
+	uint64_t v3 = 0x7465646279746573ULL ^ k1 ^ d;
+
+	SIPROUND;
+	SIPROUND;
+	v0 ^= d;
+	d = val.Get64(1);
+	v3 ^= d;
+	SIPROUND;
+	SIPROUND;
+	v0 ^= d;
+	d = val.Get64(2);
+	v3 ^= d;
+	SIPROUND;
+	SIPROUND;
+	v0 ^= d;
+	d = val.Get64(3);
+	v3 ^= d;
+	SIPROUND;
+	SIPROUND;
+	v0 ^= d;
+	v3 ^= ((uint64_t) 32) << 56;
+	SIPROUND;
+	SIPROUND;
+	v0 ^= ((uint64_t) 32) << 56;
+	v2 ^= 0xFF;
+	SIPROUND;
+	SIPROUND;
+	SIPROUND;
+	SIPROUND;
+	return v0 ^ v1 ^ v2 ^ v3;
+}
+
+#undef SIPROUND
+#undef ROTL
+
+static const uint64_t *hasherKey() {
+	static uint64_t key[2];
+	static bool init = [] {
+		std::random_device rd;
+		key[0] = ((uint64_t) rd() << 32) | rd();
+		key[1] = ((uint64_t) rd() << 32) | rd();
+		return true;
+	}();
+	(void) init;
+	return key;
+}
+
+uint256Hasher::uint256Hasher() :
+	k0(hasherKey()[0]),
+	k1(hasherKey()[1]) {
+}
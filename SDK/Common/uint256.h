@@ -653,6 +653,26 @@ public:
     explicit uint256(const bytes_t &vch);
 };
 
+/** SipHash-2-4 of the 32 bytes of @val under the key (@k0, @k1). */
+uint64_t SipHashUint256(uint64_t k0, uint64_t k1, const uint256 &val);
+
+/** Hash functor for unordered containers keyed by uint256. The keys include
+ * hashes peers announce in inv messages, which are arbitrary unverified
+ * values a peer can choose to collide in their low bits, so they are hashed
+ * with SipHash under a key drawn at random once per process.
+ */
+struct uint256Hasher
+{
+    uint64_t k0, k1;
+
+    uint256Hasher();
+
+    size_t operator()(const uint256 &h) const
+    {
+        return (size_t)SipHashUint256(k0, k1, h);
+    }
+};
+
 inline bool operator==(const uint256& a, uint64_t b)                           { return (base_uint256)a == b; }
 inline bool operator!=(const uint256& a, uint64_t b)                           { return (base_uint256)a != b; }
 inline const uint256 operator<<(const base_uint256& a, unsigned int shift)   { return uint256(a) <<= shift; }
@@ -28,9 +28,9 @@
 namespace Elastos {
 	namespace ElaWallet {
 
-		DatabaseManager::DatabaseManager(const boost::filesystem::path &path) :
+		DatabaseManager::DatabaseManager(const boost::filesystem::path &path, const SqliteConfig &config) :
 			_path(path),
-			_sqlite(path),
+			_sqlite(path, config),
 			_peerDataSource(&_sqlite),
 			_peerBlackList(&_sqlite),
 			_transactionCoinbase(&_sqlite),
@@ -44,7 +44,8 @@ namespace Elastos {
 			_txHashCRC(&_sqlite),
 			_txHashDPoS(&_sqlite),
 			_txHashProposal(&_sqlite),
-			_txHashDID(&_sqlite) {
+			_txHashDID(&_sqlite),
+			_flushStop(false) {
 			_peerDataSource.InitializeTable();
 			_peerBlackList.InitializeTable();
 			_transactionCoinbase.InitializeTable();
@@ -59,11 +60,42 @@ namespace Elastos {
 			_txHashDPoS.InitializeTable();
 			_txHashProposal.InitializeTable();
 			_txHashDID.InitializeTable();
+
+			// write-behind: the tables write into one transaction, committed when it is big or old enough
+			if (config.groupCommitMilliseconds > 0 && config.groupCommitTransactions > 0) {
+				_sqlite.SetGroupCommit(config.groupCommitTransactions);
+				_flushThread = boost::thread(boost::bind(&DatabaseManager::FlushLoop, this, config.groupCommitMilliseconds));
+			}
 		}
 
 		DatabaseManager::DatabaseManager() : DatabaseManager("spv_wallet.db") {}
 
-		DatabaseManager::~DatabaseManager() {}
+		DatabaseManager::~DatabaseManager() {
+			{
+				boost::mutex::scoped_lock scopedLock(_flushLock);
+				_flushStop = true;
+			}
+			_flushWake.notify_all();
+			if (_flushThread.joinable())
+				_flushThread.join();
+
+			_sqlite.SetGroupCommit(0);
+		}
+
+		void DatabaseManager::FlushLoop(int milliseconds) {
+			boost::mutex::scoped_lock scopedLock(_flushLock);
+
+			while (!_flushStop) {
+				_flushWake.wait_for(scopedLock, boost::chrono::milliseconds(milliseconds));
+				if (_flushStop)
+					break;
+
+				scopedLock.unlock();
+				if (!_sqlite.CommitBatch())
+					Log::error("group commit of {} failed", _path.string());
+				scopedLock.lock();
+			}
+		}
 
 		void DatabaseManager::ClearData() {
 			_transactionCoinbase.DeleteAll();
@@ -97,7 +129,7 @@ namespace Elastos {
 				Log::error("replace tx coinbase");
 				r = false;
 			}
-			_sqlite.EndTransaction();
+			r = _sqlite.EndTransaction() && r;
 
 			return r;
 		}
@@ -161,7 +193,7 @@ namespace Elastos {
 				}
 			}
 
-			_sqlite.EndTransaction();
+			r = _sqlite.EndTransaction() && r;
 
 			return r;
 		}
@@ -209,6 +241,11 @@ namespace Elastos {
 			return _transactionCoinbase.Gets(chainID, offset, limit, asc);
 		}
 
+		std::vector<TransactionPtr> DatabaseManager::GetCoinbaseTxns(const std::string &chainID, const TxnCursor &after,
+																	 size_t limit, bool asc) const {
+			return _transactionCoinbase.Gets(chainID, after, limit, asc);
+		}
+
 		bool DatabaseManager::UpdateCoinbaseTxn(const std::vector<TransactionPtr> &txns) {
 			return _transactionCoinbase.Update(txns);
 		}
@@ -264,6 +301,11 @@ namespace Elastos {
 			return _transactionNormal.Gets(chainID, offset, limit, asc);
 		}
 
+		std::vector<TransactionPtr> DatabaseManager::GetNormalTxns(const std::string &chainID, const TxnCursor &after,
+																   size_t limit, bool asc) const {
+			return _transactionNormal.Gets(chainID, after, limit, asc);
+		}
+
 		bool DatabaseManager::UpdateNormalTxn(const std::vector<TransactionPtr> &txns) {
 			return _transactionNormal.Update(txns);
 		}
@@ -308,6 +350,16 @@ namespace Elastos {
 			return _transactionPending.GetAll(chainID);
 		}
 
+		std::vector<TransactionPtr> DatabaseManager::GetPendingTxns(const std::string &chainID, size_t offset,
+																	size_t limit, bool asc) const {
+			return _transactionPending.Gets(chainID, offset, limit, asc);
+		}
+
+		std::vector<TransactionPtr> DatabaseManager::GetPendingTxns(const std::string &chainID, const TxnCursor &after,
+																	size_t limit, bool asc) const {
+			return _transactionPending.Gets(chainID, after, limit, asc);
+		}
+
 		std::vector<TransactionPtr> DatabaseManager::GetPendingUniqueTxns(const std::string &chainID,
 																		  const std::set<std::string> &hashes) const {
 			return _transactionPending.GetUniqueTxns(chainID, hashes);
@@ -337,6 +389,26 @@ namespace Elastos {
 			return _peerDataSource.GetAllPeers();
 		}
 
+		bool DatabaseManager::PutPeerScores(const std::vector<PeerScoreEntity> &scores) {
+			return _peerDataSource.PutPeerScores(scores);
+		}
+
+		bool DatabaseManager::DeleteAllPeerScores() {
+			return _peerDataSource.DeleteAllPeerScores();
+		}
+
+		std::vector<PeerScoreEntity> DatabaseManager::GetAllPeerScores() const {
+			return _peerDataSource.GetAllPeerScores();
+		}
+
+		bool DatabaseManager::PutSeedPeers(const std::string &seed, const std::vector<PeerEntity> &peers) {
+			return _peerDataSource.PutSeedPeers(seed, peers);
+		}
+
+		std::map<std::string, std::vector<PeerEntity>> DatabaseManager::GetAllSeedPeers() const {
+			return _peerDataSource.GetAllSeedPeers();
+		}
+
 		bool DatabaseManager::DeleteBlackPeer(const PeerEntity &entity) {
 			return _peerBlackList.DeletePeer(entity);
 		}
@@ -514,19 +586,20 @@ namespace Elastos {
 		}
 
 		void DatabaseManager::flush() {
-			_transactionNormal.flush();
-			_transactionCoinbase.flush();
-			_transactionPending.flush();
-			_merkleBlockDataSource.flush();
-			_peerDataSource.flush();
-			_assetDataStore.flush();
-			_didDataStore.flush();
-			_utxoStore.flush();
-			_addressUsed.flush();
-			_txHashProposal.flush();
-			_txHashDPoS.flush();
-			_txHashCRC.flush();
-			_txHashDID.flush();
+			// all tables share one connection
+			_sqlite.flush();
+		}
+
+		uint64_t DatabaseManager::GetCommitCount() const {
+			return _sqlite.GetCommitCount();
+		}
+
+		uint64_t DatabaseManager::GetSyncCount() const {
+			return _sqlite.GetSyncCount();
+		}
+
+		uint64_t DatabaseManager::GetSyncMicroseconds() const {
+			return _sqlite.GetSyncMicroseconds();
 		}
 
 	} // namespace ElaWallet
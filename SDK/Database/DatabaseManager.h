@@ -38,6 +38,8 @@
 #include "TxHashProposal.h"
 #include "TxHashDID.h"
 
+#include <boost/thread.hpp>
+
 namespace Elastos {
 	namespace ElaWallet {
 
@@ -47,7 +49,7 @@ namespace Elastos {
 
 		class DatabaseManager {
 		public:
-			DatabaseManager(const boost::filesystem::path &path);
+			DatabaseManager(const boost::filesystem::path &path, const SqliteConfig &config = SqliteConfig());
 
 			DatabaseManager();
 
@@ -86,6 +88,9 @@ namespace Elastos {
 			std::vector<TransactionPtr>
 			GetCoinbaseTxns(const std::string &chainID, size_t offset, size_t limit, bool asc = false) const;
 
+			std::vector<TransactionPtr>
+			GetCoinbaseTxns(const std::string &chainID, const TxnCursor &after, size_t limit, bool asc = false) const;
+
 			bool UpdateCoinbaseTxn(const std::vector<TransactionPtr> &txns);
 
 			bool DeleteCoinbaseTxn(const uint256 &hash);
@@ -115,6 +120,9 @@ namespace Elastos {
 			std::vector<TransactionPtr>
 			GetNormalTxns(const std::string &chainID, size_t offset, size_t limit, bool asc = false) const;
 
+			std::vector<TransactionPtr>
+			GetNormalTxns(const std::string &chainID, const TxnCursor &after, size_t limit, bool asc = false) const;
+
 			bool UpdateNormalTxn(const std::vector<TransactionPtr> &txns);
 
 			bool DeleteNormalTxn(const uint256 &hash);
@@ -138,6 +146,12 @@ namespace Elastos {
 
 			std::vector<TransactionPtr> GetAllPendingTxns(const std::string &chainID) const;
 
+			std::vector<TransactionPtr>
+			GetPendingTxns(const std::string &chainID, size_t offset, size_t limit, bool asc = false) const;
+
+			std::vector<TransactionPtr>
+			GetPendingTxns(const std::string &chainID, const TxnCursor &after, size_t limit, bool asc = false) const;
+
 			std::vector<TransactionPtr> GetPendingUniqueTxns(const std::string &chainID,
 															 const std::set<std::string> &hashes) const;
 
@@ -156,6 +170,18 @@ namespace Elastos {
 
 			std::vector<PeerEntity> GetAllPeers() const;
 
+			// Peer Score
+			bool PutPeerScores(const std::vector<PeerScoreEntity> &scores);
+
+			bool DeleteAllPeerScores();
+
+			std::vector<PeerScoreEntity> GetAllPeerScores() const;
+
+			// DNS Seed
+			bool PutSeedPeers(const std::string &seed, const std::vector<PeerEntity> &peers);
+
+			std::map<std::string, std::vector<PeerEntity>> GetAllSeedPeers() const;
+
 			// Peer Blacklist
 			bool PutBlackPeer(const PeerEntity &entity);
 
@@ -249,8 +275,18 @@ namespace Elastos {
 			// common
 			const boost::filesystem::path &GetPath() const;
 
+			// commits the writes pending in the group commit and writes the page cache to disk
 			void flush();
 
+			uint64_t GetCommitCount() const;
+
+			uint64_t GetSyncCount() const;
+
+			uint64_t GetSyncMicroseconds() const;
+
+		private:
+			void FlushLoop(int milliseconds);
+
 		private:
 			boost::filesystem::path _path;
 			Sqlite _sqlite;
@@ -268,6 +304,11 @@ namespace Elastos {
 			TxHashDPoS _txHashDPoS;
 			TxHashProposal _txHashProposal;
 			TxHashDID _txHashDID;
+
+			boost::mutex _flushLock;
+			boost::condition_variable _flushWake;
+			bool _flushStop;
+			boost::thread _flushThread;
 		};
 
 		typedef boost::shared_ptr<DatabaseManager> DatabaseManagerPtr;
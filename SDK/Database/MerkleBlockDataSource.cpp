@@ -77,14 +77,9 @@ namespace Elastos {
 
 		bool
 		MerkleBlockDataSource::PutMerkleBlockInternal(const MerkleBlockPtr &blockPtr) {
-			std::string sql;
-
-			sql = "INSERT INTO " + MB_TABLE_NAME + " (" + MB_BUFF + "," + MB_HEIGHT + "," +
-				  MB_ISO + ") VALUES (?, ?, ?);";
-
 			sqlite3_stmt *stmt;
-			if (!_sqlite->Prepare(sql, &stmt, nullptr)) {
-				Log::error("prepare sql: {}", sql);
+			if (!_sqlite->PrepareCached(MB_INSERT, &stmt)) {
+				Log::error("prepare sql: {}", MB_INSERT);
 				return false;
 			}
 
@@ -100,8 +95,8 @@ namespace Elastos {
 				Log::error("step");
 			}
 
-			if (!_sqlite->Finalize(stmt)) {
-				Log::error("mb put finalize");
+			if (!_sqlite->Release(MB_INSERT, stmt)) {
+				Log::error("mb put release");
 				return false;
 			}
 
@@ -110,13 +105,9 @@ namespace Elastos {
 
 		bool MerkleBlockDataSource::DeleteMerkleBlock(long id) {
 			return DoTransaction([&id, this]() {
-				std::string sql;
-
-				sql = "DELETE FROM " + MB_TABLE_NAME + " WHERE " + MB_COLUMN_ID + " = ?;";
-
 				sqlite3_stmt *stmt;
-				if (!_sqlite->Prepare(sql, &stmt, nullptr)) {
-					Log::error("prepare sql: {}", sql);
+				if (!_sqlite->PrepareCached(MB_DELETE, &stmt)) {
+					Log::error("prepare sql: {}", MB_DELETE);
 					return false;
 				}
 
@@ -128,8 +119,8 @@ namespace Elastos {
 					Log::error("step");
 				}
 
-				if (!_sqlite->Finalize(stmt)) {
-					Log::error("mb delete finalize");
+				if (!_sqlite->Release(MB_DELETE, stmt)) {
+					Log::error("mb delete release");
 					return false;
 				}
 
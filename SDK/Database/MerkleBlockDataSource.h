@@ -73,6 +73,10 @@ namespace Elastos {
 				MB_BUFF + " blob, " +
 				MB_HEIGHT + " integer, " +
 				MB_ISO + " text DEFAULT 'ELA');";
+
+			const std::string MB_INSERT = "INSERT INTO " + MB_TABLE_NAME + " (" + MB_BUFF + "," + MB_HEIGHT + "," +
+				MB_ISO + ") VALUES (?, ?, ?);";
+			const std::string MB_DELETE = "DELETE FROM " + MB_TABLE_NAME + " WHERE " + MB_COLUMN_ID + " = ?;";
 		};
 
 	}
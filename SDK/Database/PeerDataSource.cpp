@@ -39,6 +39,8 @@ namespace Elastos {
 
 		void PeerDataSource::InitializeTable() {
 			TableBase::InitializeTable(PEER_DATABASE_CREATE);
+			TableBase::InitializeTable(PEER_SCORE_DATABASE_CREATE);
+			TableBase::InitializeTable(SEED_DATABASE_CREATE);
 		}
 
 		bool PeerDataSource::PutPeer(const PeerEntity &peerEntity) {
@@ -203,6 +205,190 @@ namespace Elastos {
 			return peers;
 		}
 
+		bool PeerDataSource::PutPeerScores(const std::vector<PeerScoreEntity> &scores) {
+			if (scores.empty())
+				return true;
+
+			return DoTransaction([&scores, this]() {
+				std::string sql;
+
+				sql = "INSERT OR REPLACE INTO " + PEER_SCORE_TABLE_NAME + " (" + PEER_SCORE_ADDRESS + "," +
+					  PEER_SCORE_PORT + "," + PEER_SCORE_PING + "," + PEER_SCORE_BPS + "," + PEER_SCORE_MISBEHAVING +
+					  "," + PEER_SCORE_CONNECTS + "," + PEER_SCORE_FAILURES + "," + PEER_SCORE_LAST_SEEN +
+					  ") VALUES (?, ?, ?, ?, ?, ?, ?, ?);";
+
+				for (size_t i = 0; i < scores.size(); ++i) {
+					const PeerScoreEntity &score = scores[i];
+
+					sqlite3_stmt *stmt;
+					if (!_sqlite->Prepare(sql, &stmt, nullptr)) {
+						Log::error("prepare sql: {}", sql);
+						return false;
+					}
+
+					if (!_sqlite->BindBlob(stmt, 1, score.address.begin(), score.address.size(), nullptr) ||
+						!_sqlite->BindInt(stmt, 2, score.port) ||
+						!_sqlite->BindDouble(stmt, 3, score.pingTime) ||
+						!_sqlite->BindDouble(stmt, 4, score.bytesPerSecond) ||
+						!_sqlite->BindInt64(stmt, 5, score.misbehaving) ||
+						!_sqlite->BindInt64(stmt, 6, score.connects) ||
+						!_sqlite->BindInt64(stmt, 7, score.failures) ||
+						!_sqlite->BindInt64(stmt, 8, score.lastSeen)) {
+						Log::error("bind args");
+					}
+
+					if (SQLITE_DONE != _sqlite->Step(stmt)) {
+						Log::error("step");
+					}
+
+					if (!_sqlite->Finalize(stmt)) {
+						Log::error("Peer score put finalize");
+						return false;
+					}
+				}
+
+				return true;
+			});
+		}
+
+		bool PeerDataSource::DeleteAllPeerScores() {
+			return DeleteAll(PEER_SCORE_TABLE_NAME);
+		}
+
+		std::vector<PeerScoreEntity> PeerDataSource::GetAllPeerScores() const {
+			std::vector<PeerScoreEntity> scores;
+
+			PeerScoreEntity score;
+			std::string sql;
+
+			sql = "SELECT " + PEER_SCORE_ADDRESS + ", " + PEER_SCORE_PORT + ", " + PEER_SCORE_PING + ", " +
+				  PEER_SCORE_BPS + ", " + PEER_SCORE_MISBEHAVING + ", " + PEER_SCORE_CONNECTS + ", " +
+				  PEER_SCORE_FAILURES + ", " + PEER_SCORE_LAST_SEEN + " FROM " + PEER_SCORE_TABLE_NAME + ";";
+
+			sqlite3_stmt *stmt;
+			if (!_sqlite->Prepare(sql, &stmt, nullptr)) {
+				Log::error("prepare sql: {}", sql);
+				return {};
+			}
+
+			while (SQLITE_ROW == _sqlite->Step(stmt)) {
+				const uint8_t *paddr = (const uint8_t *) _sqlite->ColumnBlob(stmt, 0);
+				size_t len = _sqlite->ColumnBytes(stmt, 0);
+				if (len != score.address.size())
+					continue;
+				memcpy(score.address.begin(), paddr, len);
+
+				score.port = _sqlite->ColumnInt(stmt, 1);
+				score.pingTime = _sqlite->ColumnDouble(stmt, 2);
+				score.bytesPerSecond = _sqlite->ColumnDouble(stmt, 3);
+				score.misbehaving = (uint32_t) _sqlite->ColumnInt64(stmt, 4);
+				score.connects = (uint32_t) _sqlite->ColumnInt64(stmt, 5);
+				score.failures = (uint32_t) _sqlite->ColumnInt64(stmt, 6);
+				score.lastSeen = _sqlite->ColumnInt64(stmt, 7);
+
+				scores.push_back(score);
+			}
+
+			if (!_sqlite->Finalize(stmt)) {
+				Log::error("Peer score get all finalize");
+				return {};
+			}
+
+			return scores;
+		}
+
+		bool PeerDataSource::PutSeedPeers(const std::string &seed, const std::vector<PeerEntity> &peers) {
+			return DoTransaction([&seed, &peers, this]() {
+				std::string sql;
+				sqlite3_stmt *stmt;
+
+				sql = "DELETE FROM " + SEED_TABLE_NAME + " WHERE " + SEED_HOST + " = ?;";
+				if (!_sqlite->Prepare(sql, &stmt, nullptr)) {
+					Log::error("prepare sql: {}", sql);
+					return false;
+				}
+
+				if (!_sqlite->BindText(stmt, 1, seed, nullptr)) {
+					Log::error("bind args");
+				}
+
+				if (SQLITE_DONE != _sqlite->Step(stmt)) {
+					Log::error("step");
+				}
+
+				if (!_sqlite->Finalize(stmt)) {
+					Log::error("Seed peer delete finalize");
+					return false;
+				}
+
+				sql = "INSERT INTO " + SEED_TABLE_NAME + " (" + SEED_HOST + "," + SEED_ADDRESS + "," + SEED_PORT + "," +
+					  SEED_TIMESTAMP + ") VALUES (?, ?, ?, ?);";
+
+				for (size_t i = 0; i < peers.size(); ++i) {
+					if (!_sqlite->Prepare(sql, &stmt, nullptr)) {
+						Log::error("prepare sql: {}", sql);
+						return false;
+					}
+
+					if (!_sqlite->BindText(stmt, 1, seed, nullptr) ||
+						!_sqlite->BindBlob(stmt, 2, peers[i].address.begin(), peers[i].address.size(), nullptr) ||
+						!_sqlite->BindInt(stmt, 3, peers[i].port) ||
+						!_sqlite->BindInt64(stmt, 4, peers[i].timeStamp)) {
+						Log::error("bind args");
+					}
+
+					if (SQLITE_DONE != _sqlite->Step(stmt)) {
+						Log::error("step");
+					}
+
+					if (!_sqlite->Finalize(stmt)) {
+						Log::error("Seed peer put finalize");
+						return false;
+					}
+				}
+
+				return true;
+			});
+		}
+
+		std::map<std::string, std::vector<PeerEntity>> PeerDataSource::GetAllSeedPeers() const {
+			std::map<std::string, std::vector<PeerEntity>> seeds;
+
+			PeerEntity peer;
+			std::string sql;
+
+			sql = "SELECT " + SEED_HOST + ", " + SEED_ADDRESS + ", " + SEED_PORT + ", " + SEED_TIMESTAMP + " FROM " +
+				  SEED_TABLE_NAME + ";";
+
+			sqlite3_stmt *stmt;
+			if (!_sqlite->Prepare(sql, &stmt, nullptr)) {
+				Log::error("prepare sql: {}", sql);
+				return {};
+			}
+
+			while (SQLITE_ROW == _sqlite->Step(stmt)) {
+				std::string seed = _sqlite->ColumnText(stmt, 0);
+
+				const uint8_t *paddr = (const uint8_t *) _sqlite->ColumnBlob(stmt, 1);
+				size_t len = _sqlite->ColumnBytes(stmt, 1);
+				if (len != peer.address.size())
+					continue;
+				memcpy(peer.address.begin(), paddr, len);
+
+				peer.port = _sqlite->ColumnInt(stmt, 2);
+				peer.timeStamp = _sqlite->ColumnInt64(stmt, 3);
+
+				seeds[seed].push_back(peer);
+			}
+
+			if (!_sqlite->Finalize(stmt)) {
+				Log::error("Seed peer get all finalize");
+				return {};
+			}
+
+			return seeds;
+		}
+
 		size_t PeerDataSource::GetAllPeersCount() const {
 			size_t count = 0;
 
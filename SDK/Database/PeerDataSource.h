@@ -28,6 +28,8 @@
 
 #include <Common/uint256.h>
 
+#include <map>
+
 namespace Elastos {
 	namespace ElaWallet {
 
@@ -53,6 +55,28 @@ namespace Elastos {
 			uint64_t timeStamp;
 		};
 
+		struct PeerScoreEntity {
+			PeerScoreEntity() :
+				port(0),
+				pingTime(0),
+				bytesPerSecond(0),
+				misbehaving(0),
+				connects(0),
+				failures(0),
+				lastSeen(0)
+			{
+			}
+
+			uint128 address;
+			uint16_t port;
+			double pingTime;
+			double bytesPerSecond;
+			uint32_t misbehaving;
+			uint32_t connects;
+			uint32_t failures;
+			uint64_t lastSeen;
+		};
+
 		class PeerDataSource : public TableBase {
 
 		public:
@@ -74,6 +98,18 @@ namespace Elastos {
 
 			std::vector<PeerEntity> GetAllPeers() const;
 
+			// insert or replace by address and port
+			bool PutPeerScores(const std::vector<PeerScoreEntity> &scores);
+
+			bool DeleteAllPeerScores();
+
+			std::vector<PeerScoreEntity> GetAllPeerScores() const;
+
+			// replaces the peers saved for dns seed @seed
+			bool PutSeedPeers(const std::string &seed, const std::vector<PeerEntity> &peers);
+
+			std::map<std::string, std::vector<PeerEntity>> GetAllSeedPeers() const;
+
 		private:
 			bool Contain(const PeerEntity &entity) const;
 
@@ -96,6 +132,45 @@ namespace Elastos {
 				PEER_PORT + " integer," +
 				PEER_TIMESTAMP + " integer," +
 				PEER_ISO + " text default 'ELA');";
+
+			/*
+			 * peer score table
+			 */
+			const std::string PEER_SCORE_TABLE_NAME = "peerScoreTable";
+			const std::string PEER_SCORE_ADDRESS = "peerAddress";
+			const std::string PEER_SCORE_PORT = "peerPort";
+			const std::string PEER_SCORE_PING = "pingTime";
+			const std::string PEER_SCORE_BPS = "bytesPerSecond";
+			const std::string PEER_SCORE_MISBEHAVING = "misbehaving";
+			const std::string PEER_SCORE_CONNECTS = "connects";
+			const std::string PEER_SCORE_FAILURES = "failures";
+			const std::string PEER_SCORE_LAST_SEEN = "lastSeen";
+
+			const std::string PEER_SCORE_DATABASE_CREATE = "create table if not exists " + PEER_SCORE_TABLE_NAME + " (" +
+				PEER_SCORE_ADDRESS + " blob not null," +
+				PEER_SCORE_PORT + " integer not null," +
+				PEER_SCORE_PING + " real," +
+				PEER_SCORE_BPS + " real," +
+				PEER_SCORE_MISBEHAVING + " integer," +
+				PEER_SCORE_CONNECTS + " integer," +
+				PEER_SCORE_FAILURES + " integer," +
+				PEER_SCORE_LAST_SEEN + " integer," +
+				"primary key (" + PEER_SCORE_ADDRESS + ", " + PEER_SCORE_PORT + "));";
+
+			/*
+			 * dns seed table
+			 */
+			const std::string SEED_TABLE_NAME = "seedPeerTable";
+			const std::string SEED_HOST = "seed";
+			const std::string SEED_ADDRESS = "peerAddress";
+			const std::string SEED_PORT = "peerPort";
+			const std::string SEED_TIMESTAMP = "peerTimestamp";
+
+			const std::string SEED_DATABASE_CREATE = "create table if not exists " + SEED_TABLE_NAME + " (" +
+				SEED_HOST + " text not null," +
+				SEED_ADDRESS + " blob not null," +
+				SEED_PORT + " integer not null," +
+				SEED_TIMESTAMP + " integer not null);";
 		};
 
 	}
@@ -51,8 +51,9 @@ namespace Elastos {
 					}
 				}
 
+				std::string sql("INSERT OR REPLACE INTO " + _tableName + "(" + _columnName + ") VALUES (?);");
 				for (const std::string &item : items) {
-					if (!this->PutInternal(item))
+					if (!this->PutInternal(sql, item))
 						return false;
 				}
 
@@ -66,7 +67,7 @@ namespace Elastos {
 			std::string sql("SELECT " + _columnName + " FROM " + _tableName + ";");
 
 			sqlite3_stmt *stmt;
-			if (!_sqlite->Prepare(sql, &stmt, nullptr)) {
+			if (!_sqlite->PrepareCached(sql, &stmt)) {
 				Log::error("prepare sql: {}", sql);
 				return {};
 			}
@@ -77,7 +78,7 @@ namespace Elastos {
 				items.push_back(item);
 			}
 
-			if (!_sqlite->Finalize(stmt)) {
+			if (!_sqlite->Release(sql, stmt)) {
 				Log::error("Tx get all finalize");
 				return {};
 			}
@@ -101,12 +102,10 @@ namespace Elastos {
 			return _columnName;
 		}
 
-		bool SimpleTable::PutInternal(const std::string &item) {
-			std::string sql("INSERT OR REPLACE INTO " + _tableName + "(" + _columnName + ") VALUES (?);");
-
+		bool SimpleTable::PutInternal(const std::string &sql, const std::string &item) {
 			sqlite3_stmt *stmt;
-			if (!_sqlite->Prepare(sql, &stmt, nullptr)) {
-				Log::error("prepare sql: {}" + sql);
+			if (!_sqlite->PrepareCached(sql, &stmt)) {
+				Log::error("prepare sql: {}", sql);
 				return false;
 			}
 
@@ -118,8 +117,8 @@ namespace Elastos {
 				Log::error("step");
 			}
 
-			if (!_sqlite->Finalize(stmt)) {
-				Log::error("utxo put finalize");
+			if (!_sqlite->Release(sql, stmt)) {
+				Log::error("utxo put release");
 				return false;
 			}
 
@@ -49,7 +49,7 @@ namespace Elastos {
 			const std::string &GetTxHashColumnName() const;
 
 		private:
-			bool PutInternal(const std::string &item);
+			bool PutInternal(const std::string &sql, const std::string &item);
 
 		protected:
 			std::string _tableName;
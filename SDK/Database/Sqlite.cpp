@@ -26,12 +26,240 @@
 #include <Common/typedefs.h>
 
 #include <boost/filesystem.hpp>
+#include <boost/algorithm/string.hpp>
+
+#include <atomic>
+#include <chrono>
+
+#define SQLITE_COUNTING_VFS "elawallet-counting"
 
 namespace Elastos {
 	namespace ElaWallet {
 
-		Sqlite::Sqlite(const boost::filesystem::path &path) {
-			open(path);
+		struct SqliteSyncCounter {
+			std::atomic<uint64_t> syncs;
+			std::atomic<uint64_t> microseconds;
+		};
+
+		/*
+		 * A vfs passing everything through to the default one, but counting and timing the xSync calls on the
+		 * files of each database: the database itself, its rollback journal and its WAL. The counters are kept
+		 * for the life of the process, as a closed connection may still sync while sqlite finishes closing it.
+		 */
+		struct CountingFile {
+			sqlite3_file base;
+			sqlite3_file *real;
+			SqliteSyncCounter *counter;
+		};
+
+		static sqlite3_vfs *_rootVfs = NULL;
+		static boost::mutex _syncCountersMutex;
+		static std::map<std::string, SqliteSyncCounter *> _syncCounters;
+
+		static SqliteSyncCounter *GetSyncCounter(const std::string &fullPath) {
+			boost::mutex::scoped_lock scopedLock(_syncCountersMutex);
+			SqliteSyncCounter *&counter = _syncCounters[fullPath];
+			if (counter == NULL) {
+				counter = new SqliteSyncCounter();
+				counter->syncs = 0;
+				counter->microseconds = 0;
+			}
+			return counter;
+		}
+
+		static sqlite3_file *Real(sqlite3_file *pFile) {
+			return ((CountingFile *) pFile)->real;
+		}
+
+		static int CountingClose(sqlite3_file *pFile) {
+			sqlite3_file *real = Real(pFile);
+			int r = SQLITE_OK;
+			if (real->pMethods)
+				r = real->pMethods->xClose(real);
+			pFile->pMethods = NULL;
+			return r;
+		}
+
+		static int CountingRead(sqlite3_file *pFile, void *zBuf, int iAmt, sqlite3_int64 iOfst) {
+			return Real(pFile)->pMethods->xRead(Real(pFile), zBuf, iAmt, iOfst);
+		}
+
+		static int CountingWrite(sqlite3_file *pFile, const void *zBuf, int iAmt, sqlite3_int64 iOfst) {
+			return Real(pFile)->pMethods->xWrite(Real(pFile), zBuf, iAmt, iOfst);
+		}
+
+		static int CountingTruncate(sqlite3_file *pFile, sqlite3_int64 size) {
+			return Real(pFile)->pMethods->xTruncate(Real(pFile), size);
+		}
+
+		static int CountingSync(sqlite3_file *pFile, int flags) {
+			CountingFile *file = (CountingFile *) pFile;
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+			int r = file->real->pMethods->xSync(file->real, flags);
+
+			if (file->counter) {
+				std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - start;
+				file->counter->syncs.fetch_add(1, std::memory_order_relaxed);
+				file->counter->microseconds.fetch_add(
+					std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count(), std::memory_order_relaxed);
+			}
+			return r;
+		}
+
+		static int CountingFileSize(sqlite3_file *pFile, sqlite3_int64 *pSize) {
+			return Real(pFile)->pMethods->xFileSize(Real(pFile), pSize);
+		}
+
+		static int CountingLock(sqlite3_file *pFile, int lock) {
+			return Real(pFile)->pMethods->xLock(Real(pFile), lock);
+		}
+
+		static int CountingUnlock(sqlite3_file *pFile, int lock) {
+			return Real(pFile)->pMethods->xUnlock(Real(pFile), lock);
+		}
+
+		static int CountingCheckReservedLock(sqlite3_file *pFile, int *pResOut) {
+			return Real(pFile)->pMethods->xCheckReservedLock(Real(pFile), pResOut);
+		}
+
+		static int CountingFileControl(sqlite3_file *pFile, int op, void *pArg) {
+			return Real(pFile)->pMethods->xFileControl(Real(pFile), op, pArg);
+		}
+
+		static int CountingSectorSize(sqlite3_file *pFile) {
+			return Real(pFile)->pMethods->xSectorSize(Real(pFile));
+		}
+
+		static int CountingDeviceCharacteristics(sqlite3_file *pFile) {
+			return Real(pFile)->pMethods->xDeviceCharacteristics(Real(pFile));
+		}
+
+		static int CountingShmMap(sqlite3_file *pFile, int iPg, int pgsz, int bExtend, void volatile **pp) {
+			sqlite3_file *real = Real(pFile);
+			if (real->pMethods->iVersion < 2)
+				return SQLITE_IOERR;
+			return real->pMethods->xShmMap(real, iPg, pgsz, bExtend, pp);
+		}
+
+		static int CountingShmLock(sqlite3_file *pFile, int offset, int n, int flags) {
+			sqlite3_file *real = Real(pFile);
+			if (real->pMethods->iVersion < 2)
+				return SQLITE_IOERR;
+			return real->pMethods->xShmLock(real, offset, n, flags);
+		}
+
+		static void CountingShmBarrier(sqlite3_file *pFile) {
+			sqlite3_file *real = Real(pFile);
+			if (real->pMethods->iVersion >= 2)
+				real->pMethods->xShmBarrier(real);
+		}
+
+		static int CountingShmUnmap(sqlite3_file *pFile, int deleteFlag) {
+			sqlite3_file *real = Real(pFile);
+			if (real->pMethods->iVersion < 2)
+				return SQLITE_OK;
+			return real->pMethods->xShmUnmap(real, deleteFlag);
+		}
+
+		static int CountingFetch(sqlite3_file *pFile, sqlite3_int64 iOfst, int iAmt, void **pp) {
+			sqlite3_file *real = Real(pFile);
+			if (real->pMethods->iVersion < 3) {
+				*pp = NULL;
+				return SQLITE_OK;
+			}
+			return real->pMethods->xFetch(real, iOfst, iAmt, pp);
+		}
+
+		static int CountingUnfetch(sqlite3_file *pFile, sqlite3_int64 iOfst, void *p) {
+			sqlite3_file *real = Real(pFile);
+			if (real->pMethods->iVersion < 3)
+				return SQLITE_OK;
+			return real->pMethods->xUnfetch(real, iOfst, p);
+		}
+
+		static const sqlite3_io_methods _countingIoMethods = {
+			3,
+			CountingClose,
+			CountingRead,
+			CountingWrite,
+			CountingTruncate,
+			CountingSync,
+			CountingFileSize,
+			CountingLock,
+			CountingUnlock,
+			CountingCheckReservedLock,
+			CountingFileControl,
+			CountingSectorSize,
+			CountingDeviceCharacteristics,
+			CountingShmMap,
+			CountingShmLock,
+			CountingShmBarrier,
+			CountingShmUnmap,
+			CountingFetch,
+			CountingUnfetch
+		};
+
+		static int CountingOpen(sqlite3_vfs *pVfs, const char *zName, sqlite3_file *pFile, int flags, int *pOutFlags) {
+			(void) pVfs; // the root vfs opens the file
+			CountingFile *file = (CountingFile *) pFile;
+			file->real = (sqlite3_file *) &file[1];
+			file->counter = NULL;
+
+			int r = _rootVfs->xOpen(_rootVfs, zName, file->real, flags, pOutFlags);
+			if (file->real->pMethods == NULL) {
+				pFile->pMethods = NULL;
+				return r;
+			}
+
+			// the journal and the WAL are named after the database, temporary files have no name
+			if (zName != NULL) {
+				std::string name(zName);
+				if (flags & SQLITE_OPEN_WAL)
+					name = name.substr(0, name.rfind("-wal"));
+				else if (flags & SQLITE_OPEN_MAIN_JOURNAL)
+					name = name.substr(0, name.rfind("-journal"));
+				if (flags & (SQLITE_OPEN_MAIN_DB | SQLITE_OPEN_WAL | SQLITE_OPEN_MAIN_JOURNAL))
+					file->counter = GetSyncCounter(name);
+			}
+
+			pFile->pMethods = &_countingIoMethods;
+			return r;
+		}
+
+		static bool RegisterCountingVfs() {
+			static sqlite3_vfs vfs;
+
+			_rootVfs = sqlite3_vfs_find(NULL);
+			if (_rootVfs == NULL)
+				return false;
+
+			vfs = *_rootVfs;
+			vfs.szOsFile = sizeof(CountingFile) + _rootVfs->szOsFile;
+			vfs.pNext = NULL;
+			vfs.zName = SQLITE_COUNTING_VFS;
+			vfs.xOpen = CountingOpen;
+
+			return SQLITE_OK == sqlite3_vfs_register(&vfs, 0);
+		}
+
+		static std::string FullPathname(const boost::filesystem::path &path) {
+			std::string buffer(_rootVfs->mxPathname + 1, '\0');
+			if (SQLITE_OK != _rootVfs->xFullPathname(_rootVfs, path.string().c_str(), (int) buffer.size(), &buffer[0]))
+				return path.string();
+			return std::string(buffer.c_str());
+		}
+
+		Sqlite::Sqlite(const boost::filesystem::path &path, const SqliteConfig &config) :
+			_dataBasePtr(NULL),
+			_syncCounter(NULL),
+			_groupCommitMax(0),
+			_batchOpen(false),
+			_batched(0),
+			_commitCount(0),
+			_cachedStatements(0) {
+			if (open(path))
+				configure(config);
 		}
 
 		Sqlite::~Sqlite() {
@@ -68,15 +296,87 @@ namespace Elastos {
 
 		bool Sqlite::BeginTransaction(SqliteTransactionType type) {
 			_lockMutex.lock();
-			return exec("BEGIN " + GetTxTypeString(type) + " TRANSACTION;", nullptr, nullptr);
+			if (_groupCommitMax == 0)
+				return exec("BEGIN " + GetTxTypeString(type) + " TRANSACTION;", nullptr, nullptr);
+
+			// a statement run outside of BeginTransaction() may have failed and rolled the batch back
+			batchAlive();
+			if (!_batchOpen)
+				_batchOpen = exec("BEGIN IMMEDIATE TRANSACTION;", nullptr, nullptr);
+
+			return exec("SAVEPOINT batched;", nullptr, nullptr) && batchAlive();
 		}
 
 		bool Sqlite::EndTransaction() {
-			bool result = exec("COMMIT;", nullptr, nullptr);
+			bool result;
+
+			if (_batchOpen && !batchAlive()) {
+				// the statements of this transaction run after the rollback were committed on their own
+				result = false;
+			} else if (_batchOpen) {
+				result = exec("RELEASE batched;", nullptr, nullptr) && batchAlive();
+				if (_batchOpen && ++_batched >= _groupCommitMax)
+					result = commit() && result;
+			} else {
+				// without a batch to nest in, a savepoint is a transaction of its own
+				result = exec(_groupCommitMax == 0 ? "COMMIT;" : "RELEASE batched;", nullptr, nullptr);
+				if (result)
+					_commitCount++;
+			}
+
 			_lockMutex.unlock();
 			return result;
 		}
 
+		void Sqlite::SetGroupCommit(size_t maxTransactions) {
+			boost::mutex::scoped_lock scopedLock(_lockMutex);
+			if (maxTransactions == 0)
+				commit();
+			_groupCommitMax = maxTransactions;
+		}
+
+		bool Sqlite::CommitBatch() {
+			boost::mutex::scoped_lock scopedLock(_lockMutex);
+			return commit();
+		}
+
+		size_t Sqlite::BatchedTransactions() const {
+			boost::mutex::scoped_lock scopedLock(_lockMutex);
+			return _batched;
+		}
+
+		uint64_t Sqlite::GetCommitCount() const {
+			return _commitCount;
+		}
+
+		bool Sqlite::commit() {
+			if (!_batchOpen)
+				return true;
+
+			bool result = exec("COMMIT;", nullptr, nullptr);
+			if (result) {
+				_commitCount++;
+				_batchOpen = false;
+				_batched = 0;
+			}
+
+			// a commit failing busy leaves the transaction open, to be committed next time, other errors roll it back
+			return batchAlive() && result;
+		}
+
+		bool Sqlite::batchAlive() {
+			if (!_batchOpen || (IsValid() && !sqlite3_get_autocommit(_dataBasePtr)))
+				return true;
+
+			// SQLITE_FULL, SQLITE_IOERR, SQLITE_NOMEM and SQLITE_BUSY may roll back the whole transaction, not
+			// just the statement that failed
+			Log::error("sqlite rolled back the group commit batch, {} transaction(s) lost: {}", _batched,
+					   IsValid() ? sqlite3_errmsg(_dataBasePtr) : "sqlite is invalid");
+			_batchOpen = false;
+			_batched = 0;
+			return false;
+		}
+
 		bool Sqlite::Prepare(const std::string &sql, sqlite3_stmt **ppStmt, const char **pzTail) {
 			int r = 0;
 
@@ -97,6 +397,46 @@ namespace Elastos {
 			return true;
 		}
 
+		bool Sqlite::PrepareCached(const std::string &sql, sqlite3_stmt **ppStmt) {
+			{
+				boost::mutex::scoped_lock scopedLock(_statementMutex);
+				StatementCache::iterator it = _statements.find(sql);
+				if (it != _statements.end() && !it->second.empty()) {
+					*ppStmt = it->second.back();
+					it->second.pop_back();
+					_cachedStatements--;
+					return true;
+				}
+			}
+
+			return Prepare(sql, ppStmt, nullptr);
+		}
+
+		bool Sqlite::Release(const std::string &sql, sqlite3_stmt *pStmt) {
+			if (!IsValid())
+				return false;
+
+			int r = sqlite3_reset(pStmt);
+			sqlite3_clear_bindings(pStmt);
+
+			boost::mutex::scoped_lock scopedLock(_statementMutex);
+			// keyed by the caller's sql, sqlite3_sql() drops any text past the first statement
+			std::vector<sqlite3_stmt *> &idle = _statements[sql];
+			if (idle.size() < SQLITE_CACHED_STATEMENTS_PER_SQL) {
+				idle.push_back(pStmt);
+				_cachedStatements++;
+			} else {
+				sqlite3_finalize(pStmt);
+			}
+
+			return SQLITE_OK == r;
+		}
+
+		size_t Sqlite::CachedStatementCount() const {
+			boost::mutex::scoped_lock scopedLock(_statementMutex);
+			return _cachedStatements;
+		}
+
 		int Sqlite::Step(sqlite3_stmt *pStmt) {
 			return sqlite3_step(pStmt);
 		}
@@ -134,9 +474,50 @@ namespace Elastos {
 		}
 
 		void Sqlite::flush() {
+			CommitBatch();
+
 			if (SQLITE_OK != sqlite3_db_cacheflush(_dataBasePtr)) {
 				Log::error("sqlite flush to disk error");
 			}
+
+			Checkpoint();
+		}
+
+		bool Sqlite::Checkpoint() {
+			int walPages = 0, checkpointed = 0;
+
+			if (!IsValid())
+				return false;
+
+			int r = sqlite3_wal_checkpoint_v2(_dataBasePtr, NULL, SQLITE_CHECKPOINT_PASSIVE, &walPages, &checkpointed);
+			if (r != SQLITE_OK) {
+				Log::error("sqlite checkpoint error: {}", sqlite3_errmsg(_dataBasePtr));
+				return false;
+			}
+
+			return walPages >= 0;
+		}
+
+		std::string Sqlite::GetJournalMode() {
+			sqlite3_stmt *stmt;
+			std::string mode;
+
+			if (!Prepare("PRAGMA journal_mode;", &stmt, nullptr))
+				return mode;
+
+			if (SQLITE_ROW == Step(stmt))
+				mode = ColumnText(stmt, 0);
+			Finalize(stmt);
+
+			return mode;
+		}
+
+		uint64_t Sqlite::GetSyncCount() const {
+			return _syncCounter ? _syncCounter->syncs.load(std::memory_order_relaxed) : 0;
+		}
+
+		uint64_t Sqlite::GetSyncMicroseconds() const {
+			return _syncCounter ? _syncCounter->microseconds.load(std::memory_order_relaxed) : 0;
 		}
 
 		bytes_ptr Sqlite::ColumnBlobBytes(sqlite3_stmt *pStmt, int iCol) {
@@ -202,17 +583,62 @@ namespace Elastos {
 				}
 			}
 
+			static bool countingVfs = RegisterCountingVfs();
+			if (!countingVfs)
+				Log::warn("sqlite counting vfs not registered, fsyncs are not counted");
+
 //			path.imbue(boost::locale::generator().generate("UTF-8"));
-			int r = sqlite3_open_v2(path.string().c_str(), &_dataBasePtr, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_FULLMUTEX, NULL);
+			int r = sqlite3_open_v2(path.string().c_str(), &_dataBasePtr, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_FULLMUTEX,
+									countingVfs ? SQLITE_COUNTING_VFS : NULL);
 			if (r != SQLITE_OK) {
 				close();
 				return false;
 			}
 
+			if (countingVfs)
+				_syncCounter = GetSyncCounter(FullPathname(path));
+
+			sqlite3_busy_timeout(_dataBasePtr, SQLITE_BUSY_TIMEOUT_MILLISECONDS);
+
 			return true;
 		}
 
+		void Sqlite::configure(const SqliteConfig &config) {
+			static const std::vector<std::string> journalModes = {"DELETE", "TRUNCATE", "PERSIST", "MEMORY", "WAL", "OFF"};
+			static const std::vector<std::string> synchronousModes = {"OFF", "NORMAL", "FULL", "EXTRA"};
+
+			std::string journalMode = boost::to_upper_copy(config.journalMode);
+			if (std::find(journalModes.begin(), journalModes.end(), journalMode) != journalModes.end()) {
+				exec("PRAGMA journal_mode = " + journalMode + ";", nullptr, nullptr);
+				if (!boost::iequals(GetJournalMode(), journalMode))
+					Log::warn("sqlite journal mode {} not taken, {} is used", journalMode, GetJournalMode());
+			} else {
+				Log::error("invalid sqlite journal mode: {}", config.journalMode);
+			}
+
+			std::string synchronous = boost::to_upper_copy(config.synchronous);
+			if (std::find(synchronousModes.begin(), synchronousModes.end(), synchronous) != synchronousModes.end())
+				exec("PRAGMA synchronous = " + synchronous + ";", nullptr, nullptr);
+			else
+				Log::error("invalid sqlite synchronous: {}", config.synchronous);
+
+			// a negative cache size is in KiB rather than in pages
+			exec("PRAGMA cache_size = " + std::to_string(-(int64_t) config.cacheSizeKB) + ";", nullptr, nullptr);
+			exec("PRAGMA mmap_size = " + std::to_string(config.mmapSize) + ";", nullptr, nullptr);
+			exec("PRAGMA wal_autocheckpoint = " + std::to_string(config.checkpointPages) + ";", nullptr, nullptr);
+		}
+
 		void Sqlite::close() {
+			CommitBatch();
+
+			boost::mutex::scoped_lock scopedLock(_statementMutex);
+			for (StatementCache::iterator it = _statements.begin(); it != _statements.end(); ++it) {
+				for (size_t i = 0; i < it->second.size(); ++i)
+					sqlite3_finalize(it->second[i]);
+			}
+			_statements.clear();
+			_cachedStatements = 0;
+
 			if (_dataBasePtr != NULL) {
 				sqlite3_close_v2(_dataBasePtr);
 				_dataBasePtr = NULL;
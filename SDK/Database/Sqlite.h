@@ -28,6 +28,10 @@
 #include <sqlite3.h>
 #include <boost/filesystem.hpp>
 #include <boost/thread/mutex.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <atomic>
+#include <map>
 
 namespace Elastos {
 	namespace ElaWallet {
@@ -48,9 +52,54 @@ namespace Elastos {
 # define SQLITE_MAX_VARIABLE_NUMBER 999
 #endif
 
+#define SQLITE_CACHED_STATEMENTS_PER_SQL 4 // idle statements kept for one sql, for callers on several threads
+
+#define SQLITE_DEFAULT_JOURNAL_MODE "WAL"
+#define SQLITE_DEFAULT_SYNCHRONOUS "NORMAL"
+#define SQLITE_DEFAULT_CACHE_SIZE_KB 8192
+#define SQLITE_DEFAULT_MMAP_SIZE (64 * 1024 * 1024)
+#define SQLITE_DEFAULT_CHECKPOINT_PAGES 1000
+#define SQLITE_DEFAULT_GROUP_COMMIT_MILLISECONDS 500
+#define SQLITE_DEFAULT_GROUP_COMMIT_TRANSACTIONS 1000
+#define SQLITE_BUSY_TIMEOUT_MILLISECONDS 5000 // other connections to the file wait for a group commit to end
+
+		/*
+		 * Pragmas applied to every connection when it is opened. The defaults trade the durability of the last
+		 * commits before a power loss for far fewer fsyncs: in WAL mode with synchronous NORMAL a commit only
+		 * appends to the WAL, which is synced when it is checkpointed, and the database always stays consistent.
+		 */
+		struct SqliteConfig {
+			SqliteConfig() :
+				journalMode(SQLITE_DEFAULT_JOURNAL_MODE),
+				synchronous(SQLITE_DEFAULT_SYNCHRONOUS),
+				cacheSizeKB(SQLITE_DEFAULT_CACHE_SIZE_KB),
+				mmapSize(SQLITE_DEFAULT_MMAP_SIZE),
+				checkpointPages(SQLITE_DEFAULT_CHECKPOINT_PAGES),
+				groupCommitMilliseconds(SQLITE_DEFAULT_GROUP_COMMIT_MILLISECONDS),
+				groupCommitTransactions(SQLITE_DEFAULT_GROUP_COMMIT_TRANSACTIONS)
+			{
+			}
+
+			std::string journalMode; // DELETE, TRUNCATE, PERSIST, MEMORY, WAL or OFF
+			std::string synchronous; // OFF, NORMAL, FULL or EXTRA
+			int cacheSizeKB;         // page cache of the connection
+			int64_t mmapSize;        // bytes of the database file read through mmap, 0 turns mmap off
+			int checkpointPages;     // WAL size in pages that checkpoints it at the next commit, 0 turns it off
+			// DatabaseManager commits the writes of all its tables together this often, or after that many
+			// transactions, whichever comes first. Either being 0 commits every transaction on its own. A crash or
+			// power loss in between loses the writes of up to groupCommitMilliseconds, the database itself stays
+			// consistent and the wallet syncs them again from the last block saved.
+			int groupCommitMilliseconds;
+			int groupCommitTransactions;
+		};
+
+		typedef boost::shared_ptr<SqliteConfig> SqliteConfigPtr;
+
+		struct SqliteSyncCounter;
+
 		class Sqlite {
 		public:
-			Sqlite(const boost::filesystem::path &path);
+			Sqlite(const boost::filesystem::path &path, const SqliteConfig &config = SqliteConfig());
 			~Sqlite();
 
 			bool IsValid();
@@ -66,7 +115,32 @@ namespace Elastos {
 			bool BeginTransaction(SqliteTransactionType type);
 			bool EndTransaction();
 
+			/*
+			 * Group commit. While on, the first BeginTransaction() opens a transaction which the following ones
+			 * only nest a savepoint in, so their writes are seen on this connection at once but reach the disk with
+			 * a single COMMIT: by CommitBatch(), or when @maxTransactions transactions have ended in it. 0 turns it
+			 * off and commits what is pending. A transaction ended in the batch is not durable until then, and an
+			 * error that makes sqlite roll the batch back loses all of them: EndTransaction() or CommitBatch()
+			 * returns false and the error is logged.
+			 */
+			void SetGroupCommit(size_t maxTransactions);
+			bool CommitBatch();
+			// transactions ended in the batch not committed yet
+			size_t BatchedTransactions() const;
+			uint64_t GetCommitCount() const;
+
 			bool Prepare(const std::string &sql, sqlite3_stmt **ppStmt, const char **pzTail);
+			/*
+			 * Hands out a statement of this connection prepared earlier for the same sql, or prepares a new one. A
+			 * statement serves one caller until Release(), so callers on other threads get statements of their own.
+			 */
+			bool PrepareCached(const std::string &sql, sqlite3_stmt **ppStmt);
+			/*
+			 * Resets and unbinds a statement from PrepareCached() and keeps it for the next caller of the same sql.
+			 * Like Finalize(), returns false if the last step of the statement failed.
+			 */
+			bool Release(const std::string &sql, sqlite3_stmt *pStmt);
+			size_t CachedStatementCount() const;
 			int Step(sqlite3_stmt *pStmt);
 			bool Finalize(sqlite3_stmt *pStmt);
 			bool BindBlob(sqlite3_stmt *pStmt, int idx, const bytes_t &blob, BindCallBack callBack);
@@ -79,6 +153,19 @@ namespace Elastos {
 
 			void flush();
 
+			/*
+			 * Copies the WAL back into the database without waiting for readers or writers. Returns false in other
+			 * journal modes as well.
+			 */
+			bool Checkpoint();
+
+			std::string GetJournalMode();
+
+			// fsyncs of the database file and its journal or WAL since the process started, by all connections
+			uint64_t GetSyncCount() const;
+
+			uint64_t GetSyncMicroseconds() const;
+
 			bytes_ptr ColumnBlobBytes(sqlite3_stmt *pStmt, int iCol);
 			const void *ColumnBlob(sqlite3_stmt *pStmt, int iCol);
 			double ColumnDouble(sqlite3_stmt *pStmt, int iCol);
@@ -90,11 +177,25 @@ namespace Elastos {
 		private:
 			std::string GetTxTypeString(SqliteTransactionType type);
 			bool open(const boost::filesystem::path &path);
+			void configure(const SqliteConfig &config);
+			bool commit();
+			// with _lockMutex held: false, and the batch dropped, if sqlite rolled it back after an error
+			bool batchAlive();
 			void close();
 
 		private:
 			sqlite3 *_dataBasePtr;
+			SqliteSyncCounter *_syncCounter;
 			mutable boost::mutex _lockMutex;
+			size_t _groupCommitMax;
+			bool _batchOpen;
+			size_t _batched;
+			std::atomic<uint64_t> _commitCount;
+
+			typedef std::map<std::string, std::vector<sqlite3_stmt *>> StatementCache;
+			StatementCache _statements;
+			size_t _cachedStatements;
+			mutable boost::mutex _statementMutex;
 		};
 
 	}
@@ -86,7 +86,7 @@ namespace Elastos {
 				result = false;
 				Log::error("Unknown data base error.");
 			}
-			_sqlite->EndTransaction();
+			result = _sqlite->EndTransaction() && result;
 
 			return result;
 		}
@@ -50,6 +50,7 @@ namespace Elastos {
 
 			// new table
 			_tableName = "transactionCoinbase";
+			InitializeSql();
 		}
 
 		TransactionCoinbase::~TransactionCoinbase() {
@@ -29,6 +29,7 @@
 #include <Plugin/Registry.h>
 
 #include <string>
+#include <boost/algorithm/string.hpp>
 
 namespace Elastos {
 	namespace ElaWallet {
@@ -43,6 +44,7 @@ namespace Elastos {
 			_iso = "transactionISO";
 			_remark = "transactionRemark";
 			_assetID = "assetID";
+			InitializeSql();
 		}
 
 		TransactionNormal::~TransactionNormal() {
@@ -51,39 +53,137 @@ namespace Elastos {
 		void TransactionNormal::InitializeTable() {
 			_tableCreation = "create table if not exists " +
 							 _tableName + "(" +
-							 _txHash + " text not null, " +
+							 _txHash + " blob not null primary key, " +
 							 _buff + " blob, " +
 							 _blockHeight + " integer, " +
 							 _timestamp + " integer, " +
 							 _remark + " text DEFAULT '', " +
 							 _assetID + " text not null, " +
-							 _iso + " text DEFAULT 'ELA');";
+							 _iso + " text DEFAULT 'ELA');" +
+							 "create index if not exists " + _tableName + "Order on " + _tableName + "(" +
+							 _blockHeight + ", " + _timestamp + ", " + _txHash + ");";
+
+			if (ContainTable(_tableName) && !ContainBlobKey()) {
+				if (!DoTransaction([this]() { return this->_MigrateToBlobKey(); }))
+					Log::error("migrate {} to blob keys", _tableName);
+				return;
+			}
+
 			TableBase::InitializeTable(_tableCreation);
 		}
 
-		bool TransactionNormal::_Put(const TransactionPtr &tx) {
-			std::string sql, txHash;
+		void TransactionNormal::InitializeSql() {
+			std::string columns = _txHash + "," + _buff + "," + _blockHeight + "," + _timestamp + "," + _iso;
+
+			// a hash stored already keeps its first row, like the text key migration does, instead of failing the rest
+			// of a batch on the primary key
+			_sqlInsert = "INSERT OR IGNORE INTO " + _tableName + "(" + _txHash + "," + _buff + "," + _blockHeight + "," +
+						 _timestamp + "," + _remark + "," + _assetID + "," + _iso + ") VALUES (?, ?, ?, ?, ?, ?, ?);";
+			_sqlSelectByHash = "SELECT " + columns + " FROM " + _tableName + " WHERE " + _txHash + " = ?;";
+			_sqlContainHash = "SELECT 1 FROM " + _tableName + " WHERE " + _txHash + " = ?;";
+			_sqlUpdate = "UPDATE " + _tableName + " SET " + _blockHeight + " = ?, " + _timestamp + " = ? " +
+						 " WHERE " + _txHash + " = ?;";
+			_sqlDeleteByHash = "DELETE FROM " + _tableName + " WHERE " + _txHash + " = ?;";
+		}
 
-			sql = "INSERT INTO " + _tableName + "(" +
-				  _txHash + "," +
-				  _buff + "," +
-				  _blockHeight + "," +
-				  _timestamp + "," +
-				  _remark + "," +
-				  _assetID + "," +
-				  _iso + ") VALUES (?, ?, ?, ?, ?, ?, ?);";
+		bool TransactionNormal::ContainBlobKey() const {
+			bool blobKey = false;
+			std::string sql = "PRAGMA table_info(" + _tableName + ");";
 
 			sqlite3_stmt *stmt = NULL;
 			if (!_sqlite->Prepare(sql, &stmt, nullptr)) {
-				Log::error("prepare sql: {}" + sql);
+				Log::error("prepare sql: {}", sql);
+				return false;
+			}
+
+			// cid, name, type, notnull, dflt_value, pk
+			while (SQLITE_ROW == _sqlite->Step(stmt)) {
+				if (_sqlite->ColumnText(stmt, 1) == _txHash) {
+					blobKey = boost::iequals(_sqlite->ColumnText(stmt, 2), "blob") && _sqlite->ColumnInt(stmt, 5) != 0;
+					break;
+				}
+			}
+
+			if (!_sqlite->Finalize(stmt)) {
+				Log::error("Tx table info finalize");
+				return false;
+			}
+
+			return blobKey;
+		}
+
+		bool TransactionNormal::_MigrateToBlobKey() {
+			// tables before the blob keys had the hex string of the hash as key, and no index at all
+			std::string oldTable = _tableName + "Text";
+			std::string columns = _buff + "," + _blockHeight + "," + _timestamp + "," + _remark + "," + _assetID + "," + _iso;
+			std::string sql;
+			size_t count = 0;
+
+			sql = "ALTER TABLE " + _tableName + " RENAME TO " + oldTable + ";";
+			if (!_sqlite->exec(sql, nullptr, nullptr) || !_sqlite->exec(_tableCreation, nullptr, nullptr)) {
+				Log::error("exec sql: {}", sql);
+				return false;
+			}
+
+			sql = "SELECT " + _txHash + "," + columns + " FROM " + oldTable + ";";
+			sqlite3_stmt *select = NULL;
+			if (!_sqlite->Prepare(sql, &select, nullptr)) {
+				Log::error("prepare sql: {}", sql);
+				return false;
+			}
+
+			sql = "INSERT OR IGNORE INTO " + _tableName + "(" + _txHash + "," + columns + ") VALUES (?, ?, ?, ?, ?, ?, ?);";
+			sqlite3_stmt *insert = NULL;
+			if (!_sqlite->Prepare(sql, &insert, nullptr)) {
+				Log::error("prepare sql: {}", sql);
+				_sqlite->Finalize(select);
+				return false;
+			}
+
+			bool ok = true;
+			while (ok && SQLITE_ROW == _sqlite->Step(select)) {
+				uint256 txHash(_sqlite->ColumnText(select, 0));
+
+				ok = _sqlite->BindBlob(insert, 1, txHash.begin(), txHash.size(), nullptr) &&
+					 _sqlite->BindBlob(insert, 2, _sqlite->ColumnBlob(select, 1), _sqlite->ColumnBytes(select, 1), nullptr) &&
+					 _sqlite->BindInt(insert, 3, _sqlite->ColumnInt(select, 2)) &&
+					 _sqlite->BindInt64(insert, 4, _sqlite->ColumnInt64(select, 3)) &&
+					 _sqlite->BindText(insert, 5, _sqlite->ColumnText(select, 4), SQLITE_TRANSIENT) &&
+					 _sqlite->BindText(insert, 6, _sqlite->ColumnText(select, 5), SQLITE_TRANSIENT) &&
+					 _sqlite->BindText(insert, 7, _sqlite->ColumnText(select, 6), SQLITE_TRANSIENT) &&
+					 SQLITE_DONE == _sqlite->Step(insert);
+				sqlite3_reset(insert);
+				count++;
+			}
+
+			if (!_sqlite->Finalize(insert) || !_sqlite->Finalize(select) || !ok) {
+				Log::error("migrate {} row {}", _tableName, count);
+				return false;
+			}
+
+			sql = "DROP TABLE " + oldTable + ";";
+			if (!_sqlite->exec(sql, nullptr, nullptr)) {
+				Log::error("exec sql: {}", sql);
+				return false;
+			}
+
+			Log::info("migrated {} rows of {} to blob keys", count, _tableName);
+			return true;
+		}
+
+		bool TransactionNormal::_Put(const TransactionPtr &tx) {
+			const uint256 &txHash = tx->GetHash();
+
+			sqlite3_stmt *stmt = NULL;
+			if (!_sqlite->PrepareCached(_sqlInsert, &stmt)) {
+				Log::error("prepare sql: {}", _sqlInsert);
 				return false;
 			}
 
 			ByteStream stream;
 			tx->Serialize(stream, true);
 
-			txHash = tx->GetHash().GetHex();
-			if (!_sqlite->BindText(stmt, 1, txHash, nullptr) ||
+			if (!_sqlite->BindBlob(stmt, 1, txHash.begin(), txHash.size(), nullptr) ||
 				!_sqlite->BindBlob(stmt, 2, stream.GetBytes(), nullptr) ||
 				!_sqlite->BindInt(stmt, 3, tx->GetBlockHeight()) ||
 				!_sqlite->BindInt64(stmt, 4, tx->GetTimestamp()) ||
@@ -97,8 +197,8 @@ namespace Elastos {
 				Log::error("step");
 			}
 
-			if (!_sqlite->Finalize(stmt)) {
-				Log::error("Tx put finalize");
+			if (!_sqlite->Release(_sqlInsert, stmt)) {
+				Log::error("Tx put release");
 				return false;
 			}
 
@@ -180,8 +280,12 @@ namespace Elastos {
 			if (uniqueHash.empty())
 				return txns;
 
-			std::set<std::string>::iterator it = uniqueHash.cbegin();
-			size_t cnt, maxCnt = uniqueHash.size(), markCnt;
+			std::vector<uint256> hashes;
+			for (const std::string &hash : uniqueHash)
+				hashes.push_back(uint256(hash));
+
+			std::vector<uint256>::iterator it = hashes.begin();
+			size_t cnt, maxCnt = hashes.size(), markCnt;
 			std::string mark;
 
 			for (cnt = 0; cnt < maxCnt; ) {
@@ -202,7 +306,7 @@ namespace Elastos {
 				}
 
 				for (size_t i = 0; i < markCnt; ++i, ++it) {
-					if (!_sqlite->BindText(stmt, (int)(i + 1), *it, nullptr)) {
+					if (!_sqlite->BindBlob(stmt, (int)(i + 1), it->begin(), it->size(), nullptr)) {
 						Log::error("bind args");
 						break;
 					}
@@ -285,24 +389,26 @@ namespace Elastos {
 			return txns;
 		}
 
+		std::string TransactionNormal::SelectOrdered(bool asc, bool after) const {
+			std::string order = asc ? " ASC" : " DESC";
+			std::string key = "(" + _blockHeight + ", " + _timestamp + ", " + _txHash + ")";
+
+			// the order of the index, with the hash to break ties so that every row has a place of its own
+			return "SELECT " +
+				   _txHash + "," +
+				   _buff + "," +
+				   _blockHeight + "," +
+				   _timestamp + "," +
+				   _iso +
+				   " FROM " + _tableName +
+				   (after ? " WHERE " + key + (asc ? " > " : " < ") + "(?, ?, ?)" : "") +
+				   " ORDER BY " + _blockHeight + order + ", " + _timestamp + order + ", " + _txHash + order;
+		}
+
 		std::vector<TransactionPtr> TransactionNormal::Gets(const std::string &chainID, size_t offset,
 															size_t limit, bool asc) const {
 			std::vector<TransactionPtr> txns;
-			std::string sql, order;
-
-			if (asc) {
-				order = " ASC ";
-			} else {
-				order = " DESC ";
-			}
-
-			sql = "SELECT " +
-				  _txHash + "," +
-				  _buff + "," +
-				  _blockHeight + "," +
-				  _timestamp + "," +
-				  _iso +
-				  " FROM " + _tableName + " ORDER BY " + _blockHeight + order + "LIMIT ? OFFSET ?;";
+			std::string sql = SelectOrdered(asc, false) + " LIMIT ? OFFSET ?;";
 
 			sqlite3_stmt *stmt = NULL;
 			if (!_sqlite->Prepare(sql, &stmt, nullptr)) {
@@ -325,16 +431,42 @@ namespace Elastos {
 			return txns;
 		}
 
+		std::vector<TransactionPtr> TransactionNormal::Gets(const std::string &chainID, const TxnCursor &after,
+															size_t limit, bool asc) const {
+			std::vector<TransactionPtr> txns;
+			std::string sql = SelectOrdered(asc, true) + " LIMIT ?;";
+
+			sqlite3_stmt *stmt = NULL;
+			if (!_sqlite->Prepare(sql, &stmt, nullptr)) {
+				Log::error("prepare sql: {}", sql);
+				return txns;
+			}
+
+			if (!_sqlite->BindInt(stmt, 1, after.blockHeight) ||
+				!_sqlite->BindInt64(stmt, 2, after.timestamp) ||
+				!_sqlite->BindBlob(stmt, 3, after.hash.begin(), after.hash.size(), nullptr) ||
+				!_sqlite->BindInt64(stmt, 4, limit)) {
+				Log::error("bind args");
+			}
+
+			GetSelectedTxns(txns, chainID, stmt);
+
+			if (!_sqlite->Finalize(stmt)) {
+				Log::error("Tx get page finalize");
+				return {};
+			}
+
+			return txns;
+		}
+
 		std::vector<TransactionPtr> TransactionNormal::GetTxnBaseOnHash(const std::string &chainID,
 																		const std::string &tableName,
 																		const std::string &txHashColumnName) const {
-			std::vector<TransactionPtr> txns;
+			std::set<std::string> hashes;
 			std::string sql;
 
-			sql = "SELECT " + _txHash + "," + _buff + "," + _blockHeight + "," + _timestamp + "," + _iso +
-				  " FROM " + _tableName + " WHERE " +
-				  _txHash + " IN (SELECT " + txHashColumnName + " FROM " + tableName + " GROUP BY " +
-				  txHashColumnName + ");";
+			// the other tables keep hex strings, so look them up one by one on the blob key
+			sql = "SELECT " + txHashColumnName + " FROM " + tableName + " GROUP BY " + txHashColumnName + ";";
 
 			sqlite3_stmt *stmt = NULL;
 			if (!_sqlite->Prepare(sql, &stmt, nullptr)) {
@@ -342,15 +474,16 @@ namespace Elastos {
 				return {};
 			}
 
-			GetSelectedTxns(txns, chainID, stmt);
+			while (SQLITE_ROW == _sqlite->Step(stmt))
+				hashes.insert(_sqlite->ColumnText(stmt, 0));
 
 			int r = sqlite3_finalize(stmt);
 			if (SQLITE_OK != r) {
-				Log::error("Tx get txn({}) finalize: r = {}, extend code: {}", txns.size(), r, _sqlite->ExtendedEerrCode());
+				Log::error("Tx get hash({}) finalize: r = {}, extend code: {}", hashes.size(), r, _sqlite->ExtendedEerrCode());
 				return {};
 			}
 
-			return txns;
+			return GetUniqueTxns(chainID, hashes);
 		}
 
 		bool TransactionNormal::Update(const std::vector<TransactionPtr> &txns) {
@@ -377,33 +510,21 @@ namespace Elastos {
 
 		TransactionPtr TransactionNormal::SelectByHash(const uint256 &hash, const std::string &chainID) const {
 			std::vector<TransactionPtr> txns;
-			std::string txHash = hash.GetHex();
-
-			std::string sql;
-
-			sql = "SELECT " +
-				  _txHash + "," +
-				  _buff + "," +
-				  _blockHeight + "," +
-				  _timestamp + "," +
-				  _iso +
-				  " FROM " + _tableName +
-				  " WHERE " + _txHash + " = ?;";
 
 			sqlite3_stmt *stmt = NULL;
-			if (!_sqlite->Prepare(sql, &stmt, nullptr)) {
-				Log::error("prepare sql: {}", sql);
+			if (!_sqlite->PrepareCached(_sqlSelectByHash, &stmt)) {
+				Log::error("prepare sql: {}", _sqlSelectByHash);
 				return nullptr;
 			}
 
-			if (!_sqlite->BindText(stmt, 1, txHash, nullptr)) {
+			if (!_sqlite->BindBlob(stmt, 1, hash.begin(), hash.size(), nullptr)) {
 				Log::error("bind args");
 			}
 
 			GetSelectedTxns(txns, chainID, stmt);
 
-			if (!_sqlite->Finalize(stmt)) {
-				Log::error("Tx select finalize");
+			if (!_sqlite->Release(_sqlSelectByHash, stmt)) {
+				Log::error("Tx select release");
 				return nullptr;
 			}
 
@@ -413,6 +534,13 @@ namespace Elastos {
 		void TransactionNormal::GetSelectedTxns(std::vector<TransactionPtr> &txns, const std::string &chainID,
 												sqlite3_stmt *stmt) const {
 			while (SQLITE_ROW == _sqlite->Step(stmt)) {
+				// the key is a 32-byte blob, an empty one comes back as null
+				bytes_ptr hashBytes = _sqlite->ColumnBlobBytes(stmt, 0);
+				if (hashBytes == nullptr || hashBytes->size() != 32) {
+					Log::error("skip tx with invalid hash of {} bytes", hashBytes ? hashBytes->size() : 0);
+					continue;
+				}
+
 				TransactionPtr tx;
 				if (chainID == CHAINID_MAINCHAIN) {
 					tx = TransactionPtr(new Transaction());
@@ -420,7 +548,7 @@ namespace Elastos {
 					tx = TransactionPtr(new IDTransaction());
 				}
 
-				uint256 txHash(_sqlite->ColumnText(stmt, 0));
+				uint256 txHash(*hashBytes);
 
 				const uint8_t *pdata = (const uint8_t *) _sqlite->ColumnBlob(stmt, 1);
 				size_t len = (size_t) _sqlite->ColumnBytes(stmt, 1);
@@ -447,18 +575,14 @@ namespace Elastos {
 
 		bool TransactionNormal::ContainHash(const uint256 &hash) const {
 			bool contain = false;
-			std::string txHash = hash.GetHex();
-			std::string sql;
-
-			sql = "SELECT " + _txHash + " FROM " + _tableName + " WHERE " + _txHash + " = ?;";
 
 			sqlite3_stmt *stmt = NULL;
-			if (!_sqlite->Prepare(sql, &stmt, nullptr)) {
-				Log::error("prepare sql: {}" + sql);
+			if (!_sqlite->PrepareCached(_sqlContainHash, &stmt)) {
+				Log::error("prepare sql: {}", _sqlContainHash);
 				return false;
 			}
 
-			if (!_sqlite->BindText(stmt, 1, txHash, nullptr)) {
+			if (!_sqlite->BindBlob(stmt, 1, hash.begin(), hash.size(), nullptr)) {
 				Log::error("bind args");
 			}
 
@@ -466,8 +590,8 @@ namespace Elastos {
 				contain = true;
 			}
 
-			if (!_sqlite->Finalize(stmt)) {
-				Log::error("Tx contain finalize");
+			if (!_sqlite->Release(_sqlContainHash, stmt)) {
+				Log::error("Tx contain release");
 				return false;
 			}
 
@@ -475,22 +599,19 @@ namespace Elastos {
 		}
 
 		bool TransactionNormal::_Update(const TransactionPtr &txn) {
-			std::string hash = txn->GetHash().GetHex();
+			const uint256 &hash = txn->GetHash();
 			uint32_t blockHeight = txn->GetBlockHeight();
 			time_t timestamp = txn->GetTimestamp();
 
-			std::string sql = "UPDATE " + _tableName + " SET " + _blockHeight + " = ?, " + _timestamp + " = ? " +
-							  " WHERE " + _txHash + " = ?;";
-
 			sqlite3_stmt *stmt = NULL;
-			if (!_sqlite->Prepare(sql, &stmt, nullptr)) {
-				Log::error("prepare sql: {}", sql);
+			if (!_sqlite->PrepareCached(_sqlUpdate, &stmt)) {
+				Log::error("prepare sql: {}", _sqlUpdate);
 				return false;
 			}
 
 			if (!_sqlite->BindInt(stmt, 1, blockHeight) ||
 				!_sqlite->BindInt64(stmt, 2, timestamp) ||
-				!_sqlite->BindText(stmt, 3, hash, nullptr)) {
+				!_sqlite->BindBlob(stmt, 3, hash.begin(), hash.size(), nullptr)) {
 				Log::error("bind args");
 			}
 
@@ -498,8 +619,8 @@ namespace Elastos {
 				Log::error("step");
 			}
 
-			if (!_sqlite->Finalize(stmt)) {
-				Log::error("Tx update finalize");
+			if (!_sqlite->Release(_sqlUpdate, stmt)) {
+				Log::error("Tx update release");
 				return false;
 			}
 
@@ -516,18 +637,13 @@ namespace Elastos {
 		}
 
 		bool TransactionNormal::_DeleteByHash(const uint256 &hash) {
-			std::string sql;
-			std::string hashString = hash.GetHex();
-
-			sql = "DELETE FROM " + _tableName + " WHERE " + _txHash + " = ?;";
-
 			sqlite3_stmt *stmt = NULL;
-			if (!_sqlite->Prepare(sql, &stmt, nullptr)) {
-				Log::error("prepare sql: {}", sql);
+			if (!_sqlite->PrepareCached(_sqlDeleteByHash, &stmt)) {
+				Log::error("prepare sql: {}", _sqlDeleteByHash);
 				return false;
 			}
 
-			if (!_sqlite->BindText(stmt, 1, hashString, nullptr)) {
+			if (!_sqlite->BindBlob(stmt, 1, hash.begin(), hash.size(), nullptr)) {
 				Log::error("bind args");
 			}
 
@@ -535,8 +651,8 @@ namespace Elastos {
 				Log::error("step");
 			}
 
-			if (!_sqlite->Finalize(stmt)) {
-				Log::error("Tx delete finalize");
+			if (!_sqlite->Release(_sqlDeleteByHash, stmt)) {
+				Log::error("Tx delete release");
 				return false;
 			}
 			return true;
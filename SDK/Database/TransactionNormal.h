@@ -35,6 +35,26 @@ namespace Elastos {
 
 		typedef boost::shared_ptr<Transaction> TransactionPtr;
 
+		// the last transaction of a page, in the order of block height, timestamp and hash
+		struct TxnCursor {
+			TxnCursor() :
+				blockHeight(0),
+				timestamp(0)
+			{
+			}
+
+			TxnCursor(uint32_t height, time_t time, const uint256 &txHash) :
+				blockHeight(height),
+				timestamp(time),
+				hash(txHash)
+			{
+			}
+
+			uint32_t blockHeight;
+			time_t timestamp;
+			uint256 hash;
+		};
+
 		class TransactionNormal : public TableBase {
 		public:
 			TransactionNormal(Sqlite *sqlite, SqliteTransactionType type = IMMEDIATE);
@@ -64,6 +84,10 @@ namespace Elastos {
 
 			std::vector<TransactionPtr> Gets(const std::string &chainID, size_t offset, size_t limit, bool asc = false) const;
 
+			// the page after @after, read along the index so it costs the same however deep it is
+			std::vector<TransactionPtr> Gets(const std::string &chainID, const TxnCursor &after, size_t limit,
+											 bool asc = false) const;
+
 			std::vector<TransactionPtr> GetTxnBaseOnHash(const std::string &chainID,
 														 const std::string &tableName,
 														 const std::string &txHashColumnName) const;
@@ -87,7 +111,16 @@ namespace Elastos {
 			bool _Puts(const std::vector<TransactionPtr> &txns, bool replace);
 
 			bool _Put(const TransactionPtr &tx);
+
+			bool _MigrateToBlobKey();
+		protected:
+			void InitializeSql();
+
 		private:
+			bool ContainBlobKey() const;
+
+			std::string SelectOrdered(bool asc, bool after) const;
+
 			TransactionPtr SelectByHash(const uint256 &hash, const std::string &chainID) const;
 
 			void GetSelectedTxns(std::vector<TransactionPtr> &txns, const std::string &chainID, sqlite3_stmt *stmt) const;
@@ -102,6 +135,12 @@ namespace Elastos {
 			std::string _remark;
 			std::string _assetID;
 			std::string _tableCreation;
+
+			std::string _sqlInsert;
+			std::string _sqlSelectByHash;
+			std::string _sqlContainHash;
+			std::string _sqlUpdate;
+			std::string _sqlDeleteByHash;
 		};
 
 	} // namespace ElaWallet
@@ -29,6 +29,7 @@ namespace Elastos {
 		TransactionPending::TransactionPending(Sqlite *sqlite, SqliteTransactionType type) :
 			TransactionNormal(sqlite, type) {
 			_tableName = "transactionPending";
+			InitializeSql();
 			_tableExist = TableExistInternal();
 		}
 
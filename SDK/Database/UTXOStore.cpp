@@ -31,6 +31,8 @@ namespace Elastos {
 			_tableName = "UTXOTable";
 			_txHash = "txHash";
 			_index = "outputIndex";
+			_sqlInsert = "INSERT INTO " + _tableName + "(" + _txHash + "," + _index + ") VALUES (?, ?);";
+			_sqlDelete = "DELETE FROM " + _tableName + " WHERE " + _txHash + " = ? AND " + _index + " = ?;";
 		}
 
 		UTXOStore::~UTXOStore() {
@@ -43,11 +45,9 @@ namespace Elastos {
 		}
 
 		bool UTXOStore::PutInternal(const UTXOEntity &entity) {
-			std::string sql("INSERT INTO " + _tableName + "(" + _txHash + "," + _index + ") VALUES (?, ?);");
-
 			sqlite3_stmt *stmt;
-			if (!_sqlite->Prepare(sql, &stmt, nullptr)) {
-				Log::error("prepare sql: {}" + sql);
+			if (!_sqlite->PrepareCached(_sqlInsert, &stmt)) {
+				Log::error("prepare sql: {}", _sqlInsert);
 				return false;
 			}
 
@@ -60,8 +60,8 @@ namespace Elastos {
 				Log::error("step");
 			}
 
-			if (!_sqlite->Finalize(stmt)) {
-				Log::error("utxo put finalize");
+			if (!_sqlite->Release(_sqlInsert, stmt)) {
+				Log::error("utxo put release");
 				return false;
 			}
 
@@ -138,11 +138,9 @@ namespace Elastos {
 		}
 
 		bool UTXOStore::DeleteInternal(const UTXOEntity &entity) {
-			std::string sql("DELETE FROM " + _tableName + " WHERE " + _txHash + " = ? AND " + _index + " = ?;");
-
 			sqlite3_stmt *stmt;
-			if (!_sqlite->Prepare(sql, &stmt, nullptr)) {
-				Log::error("prepare sql: {}", sql);
+			if (!_sqlite->PrepareCached(_sqlDelete, &stmt)) {
+				Log::error("prepare sql: {}", _sqlDelete);
 				return false;
 			}
 
@@ -155,8 +153,8 @@ namespace Elastos {
 				Log::error("stmp");
 			}
 
-			if (!_sqlite->Finalize(stmt)) {
-				Log::error("utxo delete finalize");
+			if (!_sqlite->Release(_sqlDelete, stmt)) {
+				Log::error("utxo delete release");
 				return false;
 			}
 
@@ -64,6 +64,8 @@ namespace Elastos {
 			std::string _txHash;
 			std::string _index;
 			std::string _tableCreation;
+			std::string _sqlInsert;
+			std::string _sqlDelete;
 		};
 
 		class UTXOEntity {
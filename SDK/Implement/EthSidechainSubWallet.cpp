@@ -581,6 +581,36 @@ const std::string CALLBACK_IS_NULL_PROMPT = "callback is null";
 			return nlohmann::json();
 		}
 
+		nlohmann::json EthSidechainSubWallet::GetAllTransactionPage(const std::string &cursor, uint32_t count) const {
+			ArgInfo("{} {}", _walletID, GetFunName());
+			ArgInfo("cursor: {}, cnt: {}", cursor, count);
+
+			// transfers are all in memory, the cursor is just the index of the next one
+			uint32_t start = 0;
+			if (!cursor.empty()) {
+				ErrorChecker::CheckParam(cursor.find_first_not_of("0123456789") != std::string::npos ||
+										 cursor.size() > 9, Error::InvalidArgument, "invalid cursor");
+				start = (uint32_t) std::stoul(cursor);
+			}
+
+			nlohmann::json j = GetAllTransaction(start, count, "");
+			size_t maxCount = j["MaxCount"];
+			j.erase("MaxCount");
+			j["Cursor"] = (size_t) start + count < maxCount ? std::to_string(start + count) : "";
+
+			ArgInfo("r => {}", j.dump());
+
+			return j;
+		}
+
+		nlohmann::json EthSidechainSubWallet::GetAllCoinBaseTransactionPage(const std::string &cursor,
+																			uint32_t count) const {
+			ArgInfo("{} {}", _walletID, GetFunName());
+			ArgInfo("cursor: {}, cnt: {}", cursor, count);
+
+			return nlohmann::json();
+		}
+
 		nlohmann::json EthSidechainSubWallet::GetAssetInfo(const std::string &assetID) const {
 			ArgInfo("{} {}", _walletID, GetFunName());
 			ArgInfo("asset: {}", assetID);
@@ -614,6 +644,14 @@ const std::string CALLBACK_IS_NULL_PROMPT = "callback is null";
 
 		}
 
+		nlohmann::json EthSidechainSubWallet::GetSyncMetrics() const {
+			ArgInfo("{} {}", _walletID, GetFunName());
+
+			nlohmann::json j;
+			ArgInfo("r => {}", j.dump());
+			return j;
+		}
+
 		void EthSidechainSubWallet::StartP2P() {
 			_client->_ewm->connect();
 		}
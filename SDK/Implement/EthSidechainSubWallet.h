@@ -174,6 +174,14 @@ namespace Elastos {
 				uint32_t count,
 				const std::string &txID) const;
 
+			virtual nlohmann::json GetAllTransactionPage(
+				const std::string &cursor,
+				uint32_t count) const;
+
+			virtual nlohmann::json GetAllCoinBaseTransactionPage(
+				const std::string &cursor,
+				uint32_t count) const;
+
 			virtual nlohmann::json GetAssetInfo(
 				const std::string &assetID) const;
 
@@ -185,6 +193,8 @@ namespace Elastos {
 
 			virtual void Resync();
 
+			virtual nlohmann::json GetSyncMetrics() const;
+
 			virtual void StartP2P();
 
 			virtual void StopP2P();
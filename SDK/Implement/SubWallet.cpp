@@ -25,6 +25,7 @@
 #include <Common/Utils.h>
 #include <Common/Log.h>
 #include <Common/ErrorChecker.h>
+#include <Common/ByteStream.h>
 #include <Plugin/Transaction/TransactionOutput.h>
 #include <Plugin/Transaction/TransactionInput.h>
 #include <Plugin/Transaction/IDTransaction.h>
@@ -495,6 +496,102 @@ namespace Elastos {
 			return j;
 		}
 
+		nlohmann::json SubWallet::GetAllTransactionPageCommon(const std::string &cursor, uint32_t count,
+															  TxnType type) const {
+			nlohmann::json j;
+			std::vector<nlohmann::json> jsonList;
+			const WalletPtr &wallet = _walletManager->GetWallet();
+
+			// cursor is the last tx of the previous page, and whether it was pending or stored
+			uint8_t stored = 0;
+			TxnCursor after;
+			if (!cursor.empty()) {
+				bool valid = cursor.size() % 2 == 0 && cursor.find_first_not_of("0123456789abcdef") == std::string::npos;
+				ErrorChecker::CheckParam(!valid, Error::InvalidArgument, "invalid cursor");
+
+				bytes_t bytes(cursor);
+				ByteStream stream(bytes);
+				uint64_t timestamp = 0;
+				uint8_t trailing;
+				valid = stream.ReadUint8(stored) && stored <= 1 && stream.ReadUint32(after.blockHeight) &&
+						stream.ReadUint64(timestamp) && stream.ReadBytes(after.hash) && !stream.ReadUint8(trailing);
+				ErrorChecker::CheckParam(!valid, Error::InvalidArgument, "invalid cursor");
+				after.timestamp = (time_t) timestamp;
+			}
+
+			std::vector<TransactionPtr> txns;
+			if (!stored) {
+				// pending tx come first, a page of them at a time from the cursor on, skipping the other type
+				bool first = cursor.empty();
+				while (txns.size() < count) {
+					size_t limit = count - txns.size();
+					std::vector<TransactionPtr> page = first ?
+						_walletManager->LoadTxnDesc(_info->GetChainID(), TXN_PENDING, 0, limit) :
+						_walletManager->LoadTxnDesc(_info->GetChainID(), TXN_PENDING, after, limit);
+					first = false;
+
+					for (size_t i = 0; i < page.size(); ++i) {
+						after = TxnCursor(page[i]->GetBlockHeight(), page[i]->GetTimestamp(), page[i]->GetHash());
+						if (((type & TXN_NORMAL) == TXN_NORMAL && !page[i]->IsCoinBase()) ||
+							((type & TXN_COINBASE) == TXN_COINBASE && page[i]->IsCoinBase()))
+							txns.push_back(page[i]);
+					}
+
+					if (page.size() < limit) break;
+				}
+			}
+
+			size_t pendingCount = txns.size();
+			if (txns.size() < count) {
+				std::vector<TransactionPtr> page;
+				if (stored)
+					page = _walletManager->LoadTxnDesc(_info->GetChainID(), type, after, count - txns.size());
+				else
+					page = _walletManager->LoadTxnDesc(_info->GetChainID(), type, 0, count - txns.size());
+				txns.insert(txns.end(), page.begin(), page.end());
+			}
+
+			for (size_t i = 0; i < txns.size(); ++i) {
+				uint32_t confirms = txns[i]->GetConfirms(wallet->LastBlockHeight());
+				jsonList.push_back(txns[i]->GetSummary(wallet, confirms, false));
+			}
+			j["Transactions"] = jsonList;
+
+			ByteStream next;
+			if (txns.size() == count && count > 0) {
+				const TransactionPtr &last = txns.back();
+				next.WriteUint8(pendingCount == count ? 0 : 1);
+				next.WriteUint32(last->GetBlockHeight());
+				next.WriteUint64((uint64_t) last->GetTimestamp());
+				next.WriteBytes(last->GetHash());
+			}
+			j["Cursor"] = next.GetBytes().getHex();
+
+			return j;
+		}
+
+		nlohmann::json SubWallet::GetAllTransactionPage(const std::string &cursor, uint32_t count) const {
+			ArgInfo("{} {}", _walletManager->GetWallet()->GetWalletID(), GetFunName());
+			ArgInfo("cursor: {}", cursor);
+			ArgInfo("count: {}", count);
+
+			nlohmann::json j = GetAllTransactionPageCommon(cursor, count, TXN_NORMAL);
+
+			ArgInfo("r => {}", j.dump());
+			return j;
+		}
+
+		nlohmann::json SubWallet::GetAllCoinBaseTransactionPage(const std::string &cursor, uint32_t count) const {
+			ArgInfo("{} {}", _walletManager->GetWallet()->GetWalletID(), GetFunName());
+			ArgInfo("cursor: {}", cursor);
+			ArgInfo("count: {}", count);
+
+			nlohmann::json j = GetAllTransactionPageCommon(cursor, count, TXN_COINBASE);
+
+			ArgInfo("r => {}", j.dump());
+			return j;
+		}
+
 		void SubWallet::publishTransaction(const TransactionPtr &tx) {
 			_walletManager->PublishTransaction(tx);
 		}
@@ -666,6 +763,16 @@ namespace Elastos {
 			_walletManager->SyncStart();
 		}
 
+		nlohmann::json SubWallet::GetSyncMetrics() const {
+			ArgInfo("{} {}", _walletManager->GetWallet()->GetWalletID(), GetFunName());
+
+			nlohmann::json j = _walletManager->GetPeerManager()->GetSyncMetricsInfo();
+			j["Database"] = _walletManager->GetDatabaseMetrics();
+
+			ArgInfo("r => {}", j.dump());
+			return j;
+		}
+
 		nlohmann::json SubWallet::GetBasicInfo() const {
 			ArgInfo("{} {}", _walletManager->GetWallet()->GetWalletID(), GetFunName());
 
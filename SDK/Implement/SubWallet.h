@@ -126,6 +126,14 @@ namespace Elastos {
 				uint32_t count,
 				const std::string &txID) const;
 
+			virtual nlohmann::json GetAllTransactionPage(
+				const std::string &cursor,
+				uint32_t count) const;
+
+			virtual nlohmann::json GetAllCoinBaseTransactionPage(
+				const std::string &cursor,
+				uint32_t count) const;
+
 			virtual nlohmann::json GetAssetInfo(
 				const std::string &assetID) const;
 
@@ -137,6 +145,8 @@ namespace Elastos {
 
 			virtual void Resync();
 
+			virtual nlohmann::json GetSyncMetrics() const;
+
 		protected: //implement Wallet::Listener
 			virtual void onBalanceChanged(const uint256 &asset, const BigInt &balance);
 
@@ -164,6 +174,10 @@ namespace Elastos {
 
 			virtual void saveBlackPeer(const PeerInfo &peer) {}
 
+			virtual void savePeerScores(const std::vector<PeerScore> &scores) {}
+
+			virtual void saveSeedPeers(const std::string &seed, const std::vector<PeerInfo> &peers) {}
+
 			virtual bool networkIsReachable() { return true; }
 
 			virtual void txPublished(const std::string &hash, const nlohmann::json &result);
@@ -192,6 +206,10 @@ namespace Elastos {
 												   const std::string &txid,
 												   TxnType type) const;
 
+			nlohmann::json GetAllTransactionPageCommon(const std::string &cursor,
+													   uint32_t count,
+													   TxnType type) const;
+
 			virtual void publishTransaction(const TransactionPtr &tx);
 
 			virtual void fireTransactionStatusChanged(const uint256 &txid, const std::string &status,
@@ -0,0 +1,186 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "BlockDownloadWindow.h"
+
+#include <algorithm>
+
+namespace Elastos {
+	namespace ElaWallet {
+
+		BlockDownloadWindow::BlockDownloadWindow(size_t maxWindow) :
+			_window(BLOCK_WINDOW_INITIAL),
+			_maxWindow(BLOCK_WINDOW_MAX),
+			_received(0),
+			_windowFull(false),
+			_latency(0),
+			_baseLatency(0),
+			_moreHashes(false),
+			_hashesRequested(false) {
+			SetMaxWindow(maxWindow);
+		}
+
+		BlockDownloadWindow::~BlockDownloadWindow() {
+		}
+
+		void BlockDownloadWindow::SetMaxWindow(size_t maxWindow) {
+			_maxWindow = std::max(maxWindow, (size_t) 1);
+			_window = std::min(_window, _maxWindow);
+		}
+
+		void BlockDownloadWindow::Enqueue(const std::vector<uint256> &hashes, bool full) {
+			for (size_t i = 0; i < hashes.size(); ++i) {
+				if (_queued.find(hashes[i]) == _queued.end() && _inFlight.find(hashes[i]) == _inFlight.end()) {
+					_queue.push_back(hashes[i]);
+					_queued.insert(hashes[i]);
+				}
+			}
+
+			if (!hashes.empty()) {
+				_batchFirst = hashes.front();
+				_batchLast = hashes.back();
+				_moreHashes = full;
+				_hashesRequested = false;
+			}
+		}
+
+		void BlockDownloadWindow::Requeue(const std::vector<uint256> &hashes) {
+			_queue.clear();
+			_queued.clear();
+			_inFlight.clear();
+
+			for (size_t i = 0; i < hashes.size(); ++i) {
+				if (_queued.insert(hashes[i]).second)
+					_queue.push_back(hashes[i]);
+			}
+		}
+
+		std::vector<uint256> BlockDownloadWindow::NextRequests(double now) {
+			std::vector<uint256> requests;
+			size_t free = _window > _inFlight.size() ? _window - _inFlight.size() : 0;
+
+			if (_queue.empty())
+				return requests;
+
+			// wait until a quarter of the window is free, rather than sending one getdata per merkleblock
+			if (free == 0 || (!_inFlight.empty() && free < std::max(_window / 4, (size_t) 1))) {
+				_windowFull = true;
+				return requests;
+			}
+
+			size_t count = std::min(free, _queue.size());
+			requests.reserve(count);
+			for (size_t i = 0; i < count; ++i) {
+				const uint256 &hash = _queue.front();
+				requests.push_back(hash);
+				_inFlight[hash] = now;
+				_queued.erase(hash);
+				_queue.pop_front();
+			}
+
+			if (!_queue.empty())
+				_windowFull = true;
+
+			return requests;
+		}
+
+		bool BlockDownloadWindow::NextLocators(std::vector<uint256> &locators) {
+			if (!_moreHashes || _hashesRequested || _queue.size() >= _window)
+				return false;
+
+			locators.clear();
+			locators.push_back(_batchLast);
+			if (_batchFirst != _batchLast)
+				locators.push_back(_batchFirst);
+			_hashesRequested = true;
+
+			return true;
+		}
+
+		bool BlockDownloadWindow::Received(const uint256 &hash, double now) {
+			std::unordered_map<uint256, double, uint256Hasher>::iterator it = _inFlight.find(hash);
+			if (it == _inFlight.end())
+				return false;
+
+			double sample = std::max(now - it->second, 0.0);
+			_inFlight.erase(it);
+
+			if (_latency == 0) {
+				_latency = _baseLatency = sample;
+			} else {
+				_latency = _latency * 0.875 + sample * 0.125;
+				_baseLatency = std::min(_baseLatency, sample);
+			}
+
+			if (++_received >= _window) {
+				Adapt();
+				_received = 0;
+				_windowFull = false;
+			}
+
+			return true;
+		}
+
+		bool BlockDownloadWindow::Remove(const uint256 &hash) {
+			if (_inFlight.erase(hash) > 0)
+				return true;
+
+			if (_queued.erase(hash) > 0) {
+				_queue.erase(std::find(_queue.begin(), _queue.end(), hash));
+				return true;
+			}
+
+			return false;
+		}
+
+		void BlockDownloadWindow::Clear() {
+			_queue.clear();
+			_queued.clear();
+			_inFlight.clear();
+			_window = std::min((size_t) BLOCK_WINDOW_INITIAL, _maxWindow);
+			_received = 0;
+			_windowFull = false;
+			_latency = _baseLatency = 0;
+			_batchFirst = _batchLast = uint256();
+			_moreHashes = _hashesRequested = false;
+		}
+
+		size_t BlockDownloadWindow::Window() const {
+			return _window;
+		}
+
+		size_t BlockDownloadWindow::InFlight() const {
+			return _inFlight.size();
+		}
+
+		size_t BlockDownloadWindow::Queued() const {
+			return _queue.size();
+		}
+
+		double BlockDownloadWindow::Latency() const {
+			return _latency;
+		}
+
+		double BlockDownloadWindow::BaseLatency() const {
+			return _baseLatency;
+		}
+
+		void BlockDownloadWindow::Adapt() {
+			if (_latency <= 0)
+				return;
+
+			// blocks waiting at the peer, the part of the latency that is queueing rather than round trip
+			double waiting = _window * (_latency - _baseLatency) / _latency;
+
+			// requests go out a quarter window at a time, so even on an idle link about an eighth of the window
+			// waits behind the rest of its getdata
+			if (waiting > BLOCK_WINDOW_QUEUE_HIGH && waiting > _window / 2) {
+				_window = std::max(_window - _window / 4, std::min((size_t) BLOCK_WINDOW_MIN, _maxWindow));
+			} else if (waiting < BLOCK_WINDOW_QUEUE_LOW + _window / 8 && _windowFull) {
+				_window = std::min(_window + std::max(_window / 2, (size_t) 1), _maxWindow);
+			}
+		}
+
+	}
+}
@@ -0,0 +1,87 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef __ELASTOS_SDK_BLOCKDOWNLOADWINDOW_H__
+#define __ELASTOS_SDK_BLOCKDOWNLOADWINDOW_H__
+
+#include <Common/uint256.h>
+
+#include <deque>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+#define BLOCK_WINDOW_MIN        16  // merkleblock requests always allowed in flight
+#define BLOCK_WINDOW_INITIAL    64
+#define BLOCK_WINDOW_MAX        500 // default upper bound, one getblocks batch
+#define BLOCK_WINDOW_QUEUE_LOW  4   // estimated blocks waiting at the peer, on top of request batching,
+                                    // below which the window grows
+#define BLOCK_WINDOW_QUEUE_HIGH 32  // and above which it shrinks
+
+namespace Elastos {
+	namespace ElaWallet {
+
+		/**
+		 * Schedules merkleblock getdata requests for one peer. Block hashes announced by inv are queued in chain
+		 * order and only a window of them is kept in flight. The window adapts to the latency between a request
+		 * and its merkleblock: when the latency stays close to the lowest one observed, the link is not saturated
+		 * and the window grows, when blocks start piling up at the peer it shrinks. The next getblocks batch is
+		 * requested before the queue drains, so the peer never waits on an inv round trip.
+		 */
+		class BlockDownloadWindow {
+		public:
+			explicit BlockDownloadWindow(size_t maxWindow = BLOCK_WINDOW_MAX);
+
+			~BlockDownloadWindow();
+
+			void SetMaxWindow(size_t maxWindow);
+
+			// queue hashes from an inv, @full tells if the peer probably has more blocks after them
+			void Enqueue(const std::vector<uint256> &hashes, bool full);
+
+			// forget everything queued or in flight and queue @hashes instead
+			void Requeue(const std::vector<uint256> &hashes);
+
+			// hashes to request now, empty if the free part of the window is too small to be worth a getdata
+			std::vector<uint256> NextRequests(double now);
+
+			// locators for the next getblocks once the queue is about to drain, false if not needed yet
+			bool NextLocators(std::vector<uint256> &locators);
+
+			// a requested block arrived, returns false if it wasn't in flight
+			bool Received(const uint256 &hash, double now);
+
+			bool Remove(const uint256 &hash);
+
+			void Clear();
+
+			size_t Window() const;
+
+			size_t InFlight() const;
+
+			size_t Queued() const;
+
+			// smoothed seconds between getdata and merkleblock
+			double Latency() const;
+
+			double BaseLatency() const;
+
+		private:
+			void Adapt();
+
+		private:
+			std::deque<uint256> _queue;
+			std::unordered_map<uint256, double, uint256Hasher> _inFlight;
+			std::unordered_set<uint256, uint256Hasher> _queued;
+			size_t _window, _maxWindow, _received;
+			bool _windowFull; // requests were held back by the window since the last adaptation
+			double _latency, _baseLatency;
+			uint256 _batchFirst, _batchLast;
+			bool _moreHashes, _hashesRequested;
+		};
+
+	}
+}
+
+#endif //__ELASTOS_SDK_BLOCKDOWNLOADWINDOW_H__
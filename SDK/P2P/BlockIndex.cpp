@@ -0,0 +1,240 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "BlockIndex.h"
+
+#include <Plugin/Block/MerkleBlock.h>
+
+#include <bitcoin/BRMerkleBlock.h>
+
+namespace Elastos {
+	namespace ElaWallet {
+
+		BlockIndex::BlockIndex(const BlockFactory &factory) :
+			_fullBlockCount(0),
+			_factory(factory) {
+		}
+
+		BlockIndex::~BlockIndex() {
+		}
+
+		MerkleBlockPtr BlockIndex::Get(const uint256 &hash) const {
+			SlotMap::const_iterator it = _slots.find(hash);
+			if (it == _slots.end())
+				return nullptr;
+
+			return GetBlock(it->second);
+		}
+
+		const BlockIndex::Header *BlockIndex::GetHeader(const uint256 &hash) const {
+			SlotMap::const_iterator it = _slots.find(hash);
+			if (it == _slots.end())
+				return nullptr;
+
+			return &_headers[it->second];
+		}
+
+		bool BlockIndex::Contains(const MerkleBlockPtr &block) const {
+			return Contains(block->GetHash());
+		}
+
+		bool BlockIndex::Contains(const uint256 &hash) const {
+			return _slots.find(hash) != _slots.end();
+		}
+
+		bool BlockIndex::Insert(const MerkleBlockPtr &block) {
+			const uint256 &hash = block->GetHash();
+			if (_slots.find(hash) != _slots.end())
+				return false;
+
+			Header header;
+			header.hash = hash;
+			header.prevHash = block->GetPrevBlockHash();
+			header.height = block->GetHeight();
+			header.timestamp = block->GetTimestamp();
+			header.target = block->GetTarget();
+
+			const Header *prev = GetHeader(header.prevHash);
+			if (prev && header.height != BLOCK_UNKNOWN_HEIGHT && header.height == prev->height + 1) {
+				const Header *skip = GetAncestorHeader(prev, GetSkipHeight(header.height));
+				if (skip)
+					header.skip = skip->hash;
+			}
+
+			uint32_t slot;
+			if (!_freeSlots.empty()) {
+				slot = _freeSlots.back();
+				_freeSlots.pop_back();
+				_headers[slot] = header;
+				_blocks[slot] = block;
+			} else {
+				slot = (uint32_t) _headers.size();
+				_headers.push_back(header);
+				_blocks.push_back(block);
+			}
+			_fullBlockCount++;
+
+			_slots[hash] = slot;
+			_children.insert(std::make_pair(header.prevHash, hash));
+
+			return true;
+		}
+
+		bool BlockIndex::Remove(const MerkleBlockPtr &block) {
+			return Remove(block->GetHash());
+		}
+
+		bool BlockIndex::Remove(const uint256 &hash) {
+			SlotMap::iterator it = _slots.find(hash);
+			if (it == _slots.end())
+				return false;
+
+			uint32_t slot = it->second;
+			UnlinkPrevHash(_headers[slot].prevHash, hash);
+			if (_blocks[slot] != nullptr) {
+				_blocks[slot].reset();
+				_fullBlockCount--;
+			}
+			_freeSlots.push_back(slot);
+			_slots.erase(it);
+
+			return true;
+		}
+
+		bool BlockIndex::Compact(const uint256 &hash) {
+			SlotMap::const_iterator it = _slots.find(hash);
+			if (it == _slots.end() || _blocks[it->second] == nullptr)
+				return false;
+
+			_blocks[it->second].reset();
+			_fullBlockCount--;
+			return true;
+		}
+
+		MerkleBlockPtr BlockIndex::GetAncestor(const uint256 &hash, uint32_t height) const {
+			const Header *header = GetAncestorHeader(GetHeader(hash), height);
+			if (header == nullptr)
+				return nullptr;
+
+			return GetBlock(_slots.find(header->hash)->second);
+		}
+
+		const BlockIndex::Header *BlockIndex::GetAncestorHeader(const uint256 &hash, uint32_t height) const {
+			return GetAncestorHeader(GetHeader(hash), height);
+		}
+
+		MerkleBlockPtr BlockIndex::GetMatchPrevHash(const uint256 &hash) const {
+			PrevHashMap::const_iterator it = _children.find(hash);
+			if (it == _children.end())
+				return nullptr;
+
+			return Get(it->second);
+		}
+
+		bool BlockIndex::RemoveMatchPrevHash(const uint256 &hash) {
+			PrevHashMap::const_iterator it = _children.find(hash);
+			if (it == _children.end())
+				return false;
+
+			return Remove(uint256(it->second));
+		}
+
+		size_t BlockIndex::Size() const {
+			return _slots.size();
+		}
+
+		size_t BlockIndex::FullBlockCount() const {
+			return _fullBlockCount;
+		}
+
+		size_t BlockIndex::MemoryUsage() const {
+			// node based containers: one allocation per element plus the bucket array
+			size_t slotNode = sizeof(SlotMap::value_type) + 2 * sizeof(void *);
+			size_t childNode = sizeof(PrevHashMap::value_type) + 2 * sizeof(void *);
+
+			return _headers.capacity() * sizeof(Header) +
+				   _blocks.capacity() * sizeof(MerkleBlockPtr) +
+				   _freeSlots.capacity() * sizeof(uint32_t) +
+				   _slots.bucket_count() * sizeof(void *) + _slots.size() * slotNode +
+				   _children.bucket_count() * sizeof(void *) + _children.size() * childNode;
+		}
+
+		void BlockIndex::Clear() {
+			_headers.clear();
+			_blocks.clear();
+			_freeSlots.clear();
+			_fullBlockCount = 0;
+			_slots.clear();
+			_children.clear();
+		}
+
+		MerkleBlockPtr BlockIndex::GetBlock(uint32_t slot) const {
+			if (_blocks[slot] != nullptr)
+				return _blocks[slot];
+
+			const Header &header = _headers[slot];
+			MerkleBlockPtr block = _factory ? _factory() : MerkleBlockPtr(new MerkleBlock());
+			block->SetHash(header.hash);
+			block->SetPrevBlockHash(header.prevHash);
+			block->SetHeight(header.height);
+			block->SetTimestamp(header.timestamp);
+			block->SetTarget(header.target);
+
+			return block;
+		}
+
+		const BlockIndex::Header *BlockIndex::GetAncestorHeader(const Header *header, uint32_t height) const {
+			if (header == nullptr || height > header->height || header->height == BLOCK_UNKNOWN_HEIGHT)
+				return nullptr;
+
+			const Header *walk = header;
+			uint32_t heightWalk = header->height;
+			while (walk && heightWalk > height) {
+				uint32_t heightSkip = GetSkipHeight(heightWalk);
+				uint32_t heightSkipPrev = GetSkipHeight(heightWalk - 1);
+				const Header *skip = nullptr;
+
+				// only take the skip pointer if it does not overshoot, and is not worse than taking it from prev
+				if (walk->skip != 0 && (heightSkip == height || (heightSkip > height &&
+					!(heightSkipPrev + 2 < heightSkip && heightSkipPrev >= height))))
+					skip = GetHeader(walk->skip);
+
+				if (skip) {
+					walk = skip;
+					heightWalk = heightSkip;
+				} else {
+					walk = GetHeader(walk->prevHash);
+					heightWalk--;
+				}
+			}
+
+			return walk;
+		}
+
+		// turn the lowest '1' bit in the binary representation of a number into a '0'
+		static inline uint32_t InvertLowestOne(uint32_t n) {
+			return n & (n - 1);
+		}
+
+		// same skip heights as bitcoin's CBlockIndex, any height can be reached from the tip in O(log n) jumps
+		uint32_t BlockIndex::GetSkipHeight(uint32_t height) {
+			if (height < 2)
+				return 0;
+
+			// determine which height to jump back to, any number strictly lower than height would be fine
+			return (height & 1) ? InvertLowestOne(InvertLowestOne(height - 1)) + 1 : InvertLowestOne(height);
+		}
+
+		void BlockIndex::UnlinkPrevHash(const uint256 &prevHash, const uint256 &hash) {
+			std::pair<PrevHashMap::iterator, PrevHashMap::iterator> range = _children.equal_range(prevHash);
+			for (PrevHashMap::iterator it = range.first; it != range.second; ++it) {
+				if (it->second == hash) {
+					_children.erase(it);
+					break;
+				}
+			}
+		}
+
+	}
+}
@@ -0,0 +1,113 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef __ELASTOS_SDK_BLOCKINDEX_H__
+#define __ELASTOS_SDK_BLOCKINDEX_H__
+
+#include <Plugin/Interface/IMerkleBlock.h>
+#include <Common/uint256.h>
+
+#include <boost/function.hpp>
+#include <unordered_map>
+#include <vector>
+
+namespace Elastos {
+	namespace ElaWallet {
+
+		/**
+		 * In-memory block index with constant time lookup by block hash and by previous block hash.
+		 * Each block is stored as a fixed-size header record in one contiguous array, together with a
+		 * skip-list pointer to an earlier ancestor, so that looking up the ancestor at a given height
+		 * costs O(log n). The full block object is kept until Compact() is called for it; after that
+		 * Get() materializes a header-only block from the record.
+		 */
+		class BlockIndex {
+		public:
+			struct Header {
+				uint256 hash;
+				uint256 prevHash;
+				uint256 skip; // hash of the ancestor at GetSkipHeight(height), zero if unknown
+				uint32_t height;
+				uint32_t timestamp;
+				uint32_t target;
+			};
+
+			typedef boost::function<MerkleBlockPtr()> BlockFactory;
+
+		public:
+			explicit BlockIndex(const BlockFactory &factory = BlockFactory());
+
+			~BlockIndex();
+
+			MerkleBlockPtr Get(const uint256 &hash) const;
+
+			/**
+			 * Get the header record of block @hash, or nullptr if it is not indexed. The pointer is only
+			 * valid until the next Insert().
+			 */
+			const Header *GetHeader(const uint256 &hash) const;
+
+			bool Contains(const MerkleBlockPtr &block) const;
+
+			bool Contains(const uint256 &hash) const;
+
+			bool Insert(const MerkleBlockPtr &block);
+
+			bool Remove(const MerkleBlockPtr &block);
+
+			bool Remove(const uint256 &hash);
+
+			/**
+			 * Drop the full block object of @hash and keep only its header record.
+			 */
+			bool Compact(const uint256 &hash);
+
+			/**
+			 * Get the ancestor at @height of the block @hash, following previous block hashes through this
+			 * index. Returns nullptr if @hash is not indexed or the chain is broken before @height.
+			 */
+			MerkleBlockPtr GetAncestor(const uint256 &hash, uint32_t height) const;
+
+			const Header *GetAncestorHeader(const uint256 &hash, uint32_t height) const;
+
+			MerkleBlockPtr GetMatchPrevHash(const uint256 &hash) const;
+
+			bool RemoveMatchPrevHash(const uint256 &hash);
+
+			size_t Size() const;
+
+			// number of blocks still held as full objects
+			size_t FullBlockCount() const;
+
+			// approximate heap usage of the index itself, not counting the full blocks it holds
+			size_t MemoryUsage() const;
+
+			void Clear();
+
+		private:
+			MerkleBlockPtr GetBlock(uint32_t slot) const;
+
+			const Header *GetAncestorHeader(const Header *header, uint32_t height) const;
+
+			static uint32_t GetSkipHeight(uint32_t height);
+
+			void UnlinkPrevHash(const uint256 &prevHash, const uint256 &hash);
+
+		private:
+			typedef std::unordered_map<uint256, uint32_t, uint256Hasher> SlotMap;
+			typedef std::unordered_multimap<uint256, uint256, uint256Hasher> PrevHashMap;
+
+			std::vector<Header> _headers;
+			std::vector<MerkleBlockPtr> _blocks; // parallel to _headers, null once compacted
+			std::vector<uint32_t> _freeSlots;
+			size_t _fullBlockCount;
+			SlotMap _slots;
+			PrevHashMap _children;
+			BlockFactory _factory;
+		};
+
+	}
+}
+
+#endif //__ELASTOS_SDK_BLOCKINDEX_H__
@@ -0,0 +1,143 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "BlockRangeScheduler.h"
+
+#include <algorithm>
+
+namespace Elastos {
+	namespace ElaWallet {
+
+		BlockRangeScheduler::BlockRangeScheduler(size_t rangeSize) :
+			_rangeSize(std::max(rangeSize, (size_t) 1)),
+			_moreHashes(false),
+			_hashesRequested(false) {
+		}
+
+		BlockRangeScheduler::~BlockRangeScheduler() {
+		}
+
+		void BlockRangeScheduler::AddHashes(const std::vector<uint256> &hashes, bool full) {
+			for (size_t i = 0; i < hashes.size(); ++i) {
+				if (_owners.find(hashes[i]) == _owners.end() && _queued.insert(hashes[i]).second)
+					_queue.push_back(hashes[i]);
+			}
+
+			if (!hashes.empty()) {
+				_batchFirst = hashes.front();
+				_batchLast = hashes.back();
+				_moreHashes = full;
+				_hashesRequested = false;
+			}
+		}
+
+		std::vector<uint256> BlockRangeScheduler::Assign(const PeerInfo &peer, double now) {
+			std::vector<uint256> hashes;
+
+			if (IsAssigned(peer) || _queue.empty())
+				return hashes;
+
+			size_t count = std::min(_rangeSize, _queue.size());
+			hashes.reserve(count);
+			for (size_t i = 0; i < count; ++i) {
+				const uint256 &hash = _queue.front();
+				hashes.push_back(hash);
+				_owners[hash] = peer;
+				_queued.erase(hash);
+				_queue.pop_front();
+			}
+
+			Range &range = _ranges[peer];
+			range.hashes = hashes;
+			range.outstanding = hashes.size();
+			range.lastProgress = now;
+
+			return hashes;
+		}
+
+		bool BlockRangeScheduler::Received(const PeerInfo &peer, const uint256 &hash, double now) {
+			std::unordered_map<uint256, PeerInfo, uint256Hasher>::iterator it = _owners.find(hash);
+			if (it == _owners.end() || it->second != peer)
+				return false;
+
+			_owners.erase(it);
+
+			RangeMap::iterator range = _ranges.find(peer);
+			if (range != _ranges.end()) {
+				range->second.lastProgress = now;
+				if (--range->second.outstanding == 0)
+					_ranges.erase(range);
+			}
+
+			return true;
+		}
+
+		std::vector<PeerInfo> BlockRangeScheduler::Stalled(double now, double timeout) {
+			std::vector<PeerInfo> peers;
+
+			for (RangeMap::iterator it = _ranges.begin(); it != _ranges.end(); ++it) {
+				if (now - it->second.lastProgress > timeout)
+					peers.push_back(it->first);
+			}
+
+			for (size_t i = 0; i < peers.size(); ++i)
+				Release(peers[i]);
+
+			return peers;
+		}
+
+		void BlockRangeScheduler::Release(const PeerInfo &peer) {
+			RangeMap::iterator range = _ranges.find(peer);
+			if (range == _ranges.end())
+				return;
+
+			const std::vector<uint256> &hashes = range->second.hashes;
+			for (size_t i = hashes.size(); i > 0; --i) {
+				std::unordered_map<uint256, PeerInfo, uint256Hasher>::iterator it = _owners.find(hashes[i - 1]);
+				if (it != _owners.end() && it->second == peer) {
+					_owners.erase(it);
+					_queued.insert(hashes[i - 1]);
+					_queue.push_front(hashes[i - 1]);
+				}
+			}
+
+			_ranges.erase(range);
+		}
+
+		bool BlockRangeScheduler::NextLocators(std::vector<uint256> &locators) {
+			if (!_moreHashes || _hashesRequested || _queue.size() >= _rangeSize * 2)
+				return false;
+
+			locators.clear();
+			locators.push_back(_batchLast);
+			if (_batchFirst != _batchLast)
+				locators.push_back(_batchFirst);
+			_hashesRequested = true;
+
+			return true;
+		}
+
+		bool BlockRangeScheduler::IsAssigned(const PeerInfo &peer) const {
+			return _ranges.find(peer) != _ranges.end();
+		}
+
+		size_t BlockRangeScheduler::Unassigned() const {
+			return _queue.size();
+		}
+
+		size_t BlockRangeScheduler::Assigned() const {
+			return _owners.size();
+		}
+
+		void BlockRangeScheduler::Clear() {
+			_queue.clear();
+			_queued.clear();
+			_owners.clear();
+			_ranges.clear();
+			_batchFirst = _batchLast = uint256();
+			_moreHashes = _hashesRequested = false;
+		}
+
+	}
+}
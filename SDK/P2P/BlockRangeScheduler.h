@@ -0,0 +1,84 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef __ELASTOS_SDK_BLOCKRANGESCHEDULER_H__
+#define __ELASTOS_SDK_BLOCKRANGESCHEDULER_H__
+
+#include "PeerInfo.h"
+
+#include <Common/uint256.h>
+
+#include <deque>
+#include <map>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+#define BLOCK_RANGE_SIZE      100  // merkleblocks handed to one peer at a time
+#define BLOCK_RANGE_TIMEOUT   30.0 // seconds a peer may hold a range without delivering a block
+#define BLOCK_RANGE_MAX_AHEAD 1000 // blocks buffered ahead of the chain tip before no more ranges are handed out
+
+namespace Elastos {
+	namespace ElaWallet {
+
+		/**
+		 * Splits the block hashes announced by the download peer into ranges of consecutive blocks and hands them
+		 * to the connected peers, so that merkleblocks for disjoint parts of the chain download in parallel. Each
+		 * peer holds at most one range; a range whose peer stops delivering goes back to the front of the queue
+		 * and is handed to the next idle peer.
+		 */
+		class BlockRangeScheduler {
+		public:
+			explicit BlockRangeScheduler(size_t rangeSize = BLOCK_RANGE_SIZE);
+
+			~BlockRangeScheduler();
+
+			// queue hashes from the download peer's inv, @full tells if the peer probably has more blocks after them
+			void AddHashes(const std::vector<uint256> &hashes, bool full);
+
+			// next range for @peer, empty if it still holds one or nothing is left to hand out
+			std::vector<uint256> Assign(const PeerInfo &peer, double now);
+
+			// @peer delivered block @hash, returns false if the block wasn't assigned to it
+			bool Received(const PeerInfo &peer, const uint256 &hash, double now);
+
+			// take back the ranges of peers that delivered nothing for @timeout seconds, and return those peers
+			std::vector<PeerInfo> Stalled(double now, double timeout);
+
+			// put what @peer hasn't delivered yet back in front of the queue
+			void Release(const PeerInfo &peer);
+
+			// locators for the next getblocks once the queue is about to drain, false if not needed yet
+			bool NextLocators(std::vector<uint256> &locators);
+
+			bool IsAssigned(const PeerInfo &peer) const;
+
+			size_t Unassigned() const;
+
+			size_t Assigned() const;
+
+			void Clear();
+
+		private:
+			struct Range {
+				std::vector<uint256> hashes; // in chain order, delivered ones are only removed from _owners
+				size_t outstanding;
+				double lastProgress;
+			};
+
+			typedef std::map<PeerInfo, Range> RangeMap;
+
+			size_t _rangeSize;
+			std::deque<uint256> _queue;
+			std::unordered_set<uint256, uint256Hasher> _queued;
+			std::unordered_map<uint256, PeerInfo, uint256Hasher> _owners;
+			RangeMap _ranges;
+			uint256 _batchFirst, _batchLast;
+			bool _moreHashes, _hashesRequested;
+		};
+
+	}
+}
+
+#endif //__ELASTOS_SDK_BLOCKRANGESCHEDULER_H__
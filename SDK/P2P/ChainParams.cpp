@@ -20,6 +20,8 @@
  * SOFTWARE.
  */
 #include "ChainParams.h"
+#include "BlockDownloadWindow.h"
+#include "KnownInventory.h"
 
 namespace Elastos {
 	namespace ElaWallet {
@@ -73,16 +75,24 @@ namespace Elastos {
 			_magicNumber(0),
 			_services(0),
 			_targetTimeSpan(0),
-			_targetTimePerBlock(0) {}
+			_targetTimePerBlock(0),
+			_maxBlocksInFlight(BLOCK_WINDOW_MAX),
+			_maxConnections(PEER_MAX_CONNECTIONS),
+			_maxKnownInventory(KNOWN_INVENTORY_MAX) {}
 
 		ChainParams::ChainParams(uint16_t standardPort, uint32_t magic,
 								 const std::vector<std::string> &dnsSeeds,
 								 const std::vector<CheckPoint> &checkpoints) :
+			_checkpoints(checkpoints),
+			_dnsSeeds(dnsSeeds),
 			_standardPort(standardPort),
 			_magicNumber(magic),
 			_services(0),
 			_targetTimeSpan(86400),
-			_targetTimePerBlock(120) {
+			_targetTimePerBlock(120),
+			_maxBlocksInFlight(BLOCK_WINDOW_MAX),
+			_maxConnections(PEER_MAX_CONNECTIONS),
+			_maxKnownInventory(KNOWN_INVENTORY_MAX) {
 
 		}
 
@@ -101,6 +111,9 @@ namespace Elastos {
 			_services = params._services;
 			_targetTimeSpan = params._targetTimeSpan;
 			_targetTimePerBlock = params._targetTimePerBlock;
+			_maxBlocksInFlight = params._maxBlocksInFlight;
+			_maxConnections = params._maxConnections;
+			_maxKnownInventory = params._maxKnownInventory;
 			return *this;
 		}
 
@@ -140,5 +153,17 @@ namespace Elastos {
 			return _targetTimePerBlock;
 		}
 
+		const uint32_t &ChainParams::MaxBlocksInFlight() const {
+			return _maxBlocksInFlight;
+		}
+
+		const uint32_t &ChainParams::MaxConnections() const {
+			return _maxConnections;
+		}
+
+		const uint32_t &ChainParams::MaxKnownInventory() const {
+			return _maxKnownInventory;
+		}
+
 	}
 }
\ No newline at end of file
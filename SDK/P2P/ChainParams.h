@@ -27,6 +27,8 @@
 #include <boost/shared_ptr.hpp>
 #include <string>
 
+#define PEER_MAX_CONNECTIONS 1
+
 namespace Elastos {
 	namespace ElaWallet {
 
@@ -88,6 +90,12 @@ namespace Elastos {
 
 			const uint32_t &TargetTimePerBlock() const;
 
+			const uint32_t &MaxBlocksInFlight() const;
+
+			const uint32_t &MaxConnections() const;
+
+			const uint32_t &MaxKnownInventory() const;
+
 		private:
 			friend class Config;
 
@@ -99,6 +107,9 @@ namespace Elastos {
 
 			uint32_t _targetTimeSpan;
 			uint32_t _targetTimePerBlock;
+			uint32_t _maxBlocksInFlight;
+			uint32_t _maxConnections;
+			uint32_t _maxKnownInventory;
 		};
 
 		typedef boost::shared_ptr<ChainParams> ChainParamsPtr;
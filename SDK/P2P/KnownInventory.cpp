@@ -0,0 +1,94 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "KnownInventory.h"
+
+#include <algorithm>
+
+namespace Elastos {
+	namespace ElaWallet {
+
+		KnownInventory::KnownInventory(size_t capacity) :
+			_capacity(std::max(capacity, (size_t) 1)) {
+		}
+
+		KnownInventory::~KnownInventory() {
+		}
+
+		void KnownInventory::SetCapacity(size_t capacity) {
+			_capacity = std::max(capacity, (size_t) 1);
+
+			while (_order.size() > _capacity) {
+				_index.erase(_order.front());
+				_order.pop_front();
+			}
+		}
+
+		size_t KnownInventory::Capacity() const {
+			return _capacity;
+		}
+
+		bool KnownInventory::Add(const uint256 &hash) {
+			if (_index.find(hash) != _index.end())
+				return false;
+
+			if (_order.size() >= _capacity) {
+				_index.erase(_order.front());
+				_order.pop_front();
+			}
+
+			_index[hash] = _order.insert(_order.end(), hash);
+			return true;
+		}
+
+		bool KnownInventory::Contains(const uint256 &hash) const {
+			return _index.find(hash) != _index.end();
+		}
+
+		bool KnownInventory::Remove(const uint256 &hash) {
+			HashIndex::iterator it = _index.find(hash);
+			if (it == _index.end())
+				return false;
+
+			_order.erase(it->second);
+			_index.erase(it);
+			return true;
+		}
+
+		bool KnownInventory::TrimBefore(const uint256 &hash) {
+			HashIndex::iterator it = _index.find(hash);
+			if (it == _index.end())
+				return false;
+
+			while (_order.begin() != it->second) {
+				_index.erase(_order.front());
+				_order.pop_front();
+			}
+
+			return true;
+		}
+
+		std::vector<uint256> KnownInventory::Hashes() const {
+			return std::vector<uint256>(_order.begin(), _order.end());
+		}
+
+		size_t KnownInventory::Size() const {
+			return _order.size();
+		}
+
+		size_t KnownInventory::MemoryUsage() const {
+			// list node: hash and two links, index node: hash, iterator, link and cached hash code
+			size_t listNode = sizeof(uint256) + 2 * sizeof(void *);
+			size_t indexNode = sizeof(HashIndex::value_type) + 2 * sizeof(void *);
+
+			return _order.size() * (listNode + indexNode) + _index.bucket_count() * sizeof(void *);
+		}
+
+		void KnownInventory::Clear() {
+			_order.clear();
+			_index.clear();
+		}
+
+	}
+}
@@ -0,0 +1,66 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef __ELASTOS_SDK_KNOWNINVENTORY_H__
+#define __ELASTOS_SDK_KNOWNINVENTORY_H__
+
+#include <Common/uint256.h>
+
+#include <list>
+#include <vector>
+#include <unordered_map>
+
+#define KNOWN_INVENTORY_MAX 50000 // hashes remembered per peer for each of tx and block inventory
+
+namespace Elastos {
+	namespace ElaWallet {
+
+		/**
+		 * Rolling set of the inventory hashes a peer announced or was sent, in the order they were added. When the
+		 * capacity is reached the oldest hash is forgotten, so a long lived connection uses bounded memory.
+		 */
+		class KnownInventory {
+		public:
+			explicit KnownInventory(size_t capacity = KNOWN_INVENTORY_MAX);
+
+			~KnownInventory();
+
+			// drops the oldest hashes if there are more than @capacity already
+			void SetCapacity(size_t capacity);
+
+			size_t Capacity() const;
+
+			// returns false if @hash is already known
+			bool Add(const uint256 &hash);
+
+			bool Contains(const uint256 &hash) const;
+
+			bool Remove(const uint256 &hash);
+
+			// forget every hash added before @hash, returns false if @hash isn't known
+			bool TrimBefore(const uint256 &hash);
+
+			// oldest first
+			std::vector<uint256> Hashes() const;
+
+			size_t Size() const;
+
+			// approximate heap bytes used
+			size_t MemoryUsage() const;
+
+			void Clear();
+
+		private:
+			typedef std::list<uint256> HashList;
+			typedef std::unordered_map<uint256, HashList::iterator, uint256Hasher> HashIndex;
+
+			size_t _capacity;
+			HashList _order;
+			HashIndex _index;
+		};
+
+	}
+}
+
+#endif //__ELASTOS_SDK_KNOWNINVENTORY_H__
@@ -0,0 +1,32 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef __ELASTOS_SDK_FILTERADDMESSAGE_H__
+#define __ELASTOS_SDK_FILTERADDMESSAGE_H__
+
+#include "Message.h"
+
+namespace Elastos {
+	namespace ElaWallet {
+
+		struct FilterAddParameter : public SendMessageParameter {
+			bytes_t Data;
+		};
+
+		class FilterAddMessage : public Message {
+		public:
+			explicit FilterAddMessage(const MessagePeerPtr &peer);
+
+			virtual bool Accept(const ByteStream &stream);
+
+			virtual void Send(const SendMessageParameter &param);
+
+			virtual std::string Type() const;
+
+		};
+
+	}
+}
+
+#endif //__ELASTOS_SDK_FILTERADDMESSAGE_H__
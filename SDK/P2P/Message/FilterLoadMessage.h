@@ -19,7 +19,7 @@ namespace Elastos {
 		public:
 			explicit FilterLoadMessage(const MessagePeerPtr &peer);
 
-			virtual bool Accept(const bytes_t &msg);
+			virtual bool Accept(const ByteStream &stream);
 
 			virtual void Send(const SendMessageParameter &param);
 
@@ -15,7 +15,7 @@ namespace Elastos {
 
 		}
 
-		bool GetBlocksMessage::Accept(const bytes_t &msg) {
+		bool GetBlocksMessage::Accept(const ByteStream &stream) {
 			_peer->error("dropping {} message", Type());
 			return false;
 		}
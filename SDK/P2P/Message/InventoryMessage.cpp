@@ -4,7 +4,6 @@
 
 #include "InventoryMessage.h"
 #include "GetDataMessage.h"
-#include "GetBlocksMessage.h"
 #include "PingMessage.h"
 
 #include <P2P/Peer.h>
@@ -24,8 +23,7 @@ namespace Elastos {
 
 		}
 
-		bool InventoryMessage::Accept(const bytes_t &msg) {
-			ByteStream stream(msg);
+		bool InventoryMessage::Accept(const ByteStream &stream) {
 			uint32_t type;
 
 			uint32_t count;
@@ -68,7 +66,7 @@ namespace Elastos {
 				_peer->error("too many transactions, disconnecting");
 				return false;
 			} else if (_peer->GetCurrentBlockHeight() > 0 && blocks.size() > 2 && blocks.size() < MAX_BLOCKS_COUNT &&
-					   _peer->GetCurrentBlockHeight() + _peer->GetKnownBlockHashes().size() + blocks.size() <
+					   _peer->GetCurrentBlockHeight() + _peer->KnownBlockHashes().Size() + blocks.size() <
 					   _peer->GetLastBlock()) {
 				_peer->error("non-standard inv, {} is fewer block hash(es) than expected", blocks.size());
 				return false;
@@ -86,19 +84,16 @@ namespace Elastos {
 				}
 
 				for (i = 0; i < blocks.size(); i++) {
-					// remember blockHashes in case we need to re-request them with an updated bloom filter
+					// remember blockHashes in case we need to re-request them with an updated bloom filter, the oldest
+					// ones are forgotten once the peer's known inventory is full
 					_peer->AddKnownBlockHash(blocks[i]);
 				}
 
-				while (_peer->GetKnownBlockHashes().size() > MAX_GETDATA_HASHES) {
-					_peer->KnownBlockHashesRemoveRange(0, _peer->GetKnownBlockHashes().size() / 3);
-				}
-
 				if (_peer->NeedsFilterUpdate()) blocks.clear();
 
 				std::vector<uint256> txHashes;
 				for (i = 0; i < transactions.size(); i++) {
-					if (_peer->KnownTxHashSet().find(transactions[i]) != _peer->KnownTxHashSet().end()) {
+					if (_peer->KnownTxHashes().Contains(transactions[i])) {
 						FireHasTx(transactions[i]);
 					} else {
 						txHashes.push_back(transactions[i]);
@@ -107,20 +102,15 @@ namespace Elastos {
 
 				_peer->info("got inv with {} tx {} block item(s)", txHashes.size(), blocks.size());
 				_peer->AddKnownTxHashes(txHashes);
-				if (txHashes.size() > 0 || blocks.size() > 0) {
-					GetDataParameter getDataParam(txHashes, blocks);
+				if (txHashes.size() > 0) {
+					GetDataParameter getDataParam(txHashes, {});
 					_peer->SendMessage(MSG_GETDATA, getDataParam);
 				}
 
-				// to improve chain download performance, if we received 500 block hashes, request the next 500 block hashes
-				if (blocks.size() >= MAX_BLOCKS_COUNT) {
-					GetBlocksParameter param;
-					param.locators.push_back(blocks.back());
-					param.locators.push_back(blocks.front());
-					param.hashStop = 0;
-
-					_peer->SendMessage(MSG_GETBLOCKS, param);
-				}
+				// the peer manager requests the blocks, from this peer or spread over all peers during chain sync, if we
+				// received 500 block hashes the next 500 are requested before these run out
+				if (blocks.size() > 0)
+					FireRelayedBlockHashes(blocks, blocks.size() >= MAX_BLOCKS_COUNT);
 
 				if (transactions.size() > 0 && !_peer->GetMemPoolCallback().empty()) {
 					_peer->info("got initial mempool response");
@@ -137,22 +127,18 @@ namespace Elastos {
 		void InventoryMessage::Send(const SendMessageParameter &param) {
 			const InventoryParameter &invParam = static_cast<const InventoryParameter &>(param);
 
-			size_t txCount;
-			size_t knownCount = _peer->KnownTxHashes().size();
-
-			_peer->AddKnownTxHashes(invParam.txHashes);
-			txCount = _peer->KnownTxHashes().size() - knownCount;
+			std::vector<uint256> txHashes = _peer->AddKnownTxHashes(invParam.txHashes);
 
-			if (txCount > 0) {
+			if (txHashes.size() > 0) {
 				ByteStream stream;
 
-				stream.WriteUint32(uint32_t(txCount));
-				for (size_t i = 0; i < txCount; i++) {
+				stream.WriteUint32(uint32_t(txHashes.size()));
+				for (size_t i = 0; i < txHashes.size(); i++) {
 					stream.WriteUint32(uint32_t(inv_tx));  // version
-					stream.WriteBytes(_peer->KnownTxHashes()[knownCount + i]);
+					stream.WriteBytes(txHashes[i]);
 				}
 
-				_peer->info("sending inv tx count={} type={}", txCount, inv_tx);
+				_peer->info("sending inv tx count={} type={}", txHashes.size(), inv_tx);
 				SendMessage(stream.GetBytes(), Type());
 			}
 		}
@@ -14,7 +14,7 @@ namespace Elastos {
 
 		}
 
-		bool MempoolMessage::Accept(const bytes_t &msg) {
+		bool MempoolMessage::Accept(const ByteStream &stream) {
 			_peer->info("drop {} message, not implemented.", Type());
 			return false;
 		}
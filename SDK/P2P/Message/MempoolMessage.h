@@ -21,7 +21,7 @@ namespace Elastos {
 		public:
 			explicit MempoolMessage(const MessagePeerPtr &peer);
 
-			virtual bool Accept(const bytes_t &msg);
+			virtual bool Accept(const ByteStream &stream);
 
 			virtual void Send(const SendMessageParameter &param);
 
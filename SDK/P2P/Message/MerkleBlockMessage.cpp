@@ -22,10 +22,9 @@ namespace Elastos {
 
 		}
 
-		bool MerkleBlockMessage::Accept(const bytes_t &msg) {
+		bool MerkleBlockMessage::Accept(const ByteStream &stream) {
 			std::vector<uint256> txHashes;
 			int version;
-			ByteStream stream(msg);
 
 			PeerManager *manager = _peer->GetPeerManager();
 			MerkleBlockPtr block(Registry::Instance()->CreateMerkleBlock(manager->GetChainID()));
@@ -42,19 +41,27 @@ namespace Elastos {
 #endif
 
 			if (!block->Deserialize(stream, version)) {
-				_peer->debug("merkle block orignal data: {}", msg.getHex());
+				_peer->debug("merkle block orignal data: {}", stream.GetBytes().getHex());
 				_peer->error("merkle block deserialize with type fail");
 				return false;
 			}
 
-			if (!block->IsValid((uint32_t) time(nullptr))) {
+			bool valid;
+			{
+				SyncMetrics::Timer timer(manager->GetSyncMetrics(), SyncMetrics::MerkleRoot);
+				valid = block->IsValid((uint32_t) time(nullptr));
+			}
+
+			if (!valid) {
 				_peer->error("invalid merkleblock: {}", block->GetHash().GetHex());
+				manager->GetSyncMetrics().Add(SyncMetrics::InvalidMerkleBlocks);
 				return false;
 			} else if (!_peer->SentFilter() && !_peer->SentGetdata()) {
 				_peer->error("got merkleblock message before loading a filter");
 				return false;
 			} else {
 				_peer->SetWaitingBlocks(false);
+				_peer->OnBlockReceived(block->GetHash());
 				block->MerkleBlockTxHashes(txHashes);
 
 				for (size_t i = txHashes.size(); i > 0; i--) { // reverse order for more efficient removal as tx arrive
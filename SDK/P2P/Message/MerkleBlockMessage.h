@@ -14,7 +14,7 @@ namespace Elastos {
 		public:
 			explicit MerkleBlockMessage(const MessagePeerPtr &peer);
 
-			virtual bool Accept(const bytes_t &msg);
+			virtual bool Accept(const ByteStream &stream);
 
 			virtual void Send(const SendMessageParameter &param);
 
@@ -54,6 +54,11 @@ namespace Elastos {
 				_peer->_listener->OnRelayedBlock(_peer->shared_from_this(), block);
 		}
 
+		void Message::FireRelayedBlockHashes(const std::vector<uint256> &blockHashes, bool full) {
+			if (_peer->_listener != nullptr)
+				_peer->_listener->OnRelayedBlockHashes(_peer->shared_from_this(), blockHashes, full);
+		}
+
 		void Message::FireRelayedPing() {
 			if (_peer->_listener != nullptr)
 				_peer->_listener->OnRelayedPing(_peer->shared_from_this());
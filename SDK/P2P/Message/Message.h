@@ -68,7 +68,7 @@ namespace Elastos {
 
 			virtual ~Message();
 
-			virtual bool Accept(const bytes_t &msg) = 0;
+			virtual bool Accept(const ByteStream &stream) = 0;
 
 			virtual void Send(const SendMessageParameter &param) = 0;
 
@@ -91,6 +91,8 @@ namespace Elastos {
 
 			void FireRelayedBlock(const MerkleBlockPtr &block);
 
+			void FireRelayedBlockHashes(const std::vector<uint256> &blockHashes, bool full);
+
 			void FireRelayedPing();
 
 			void FireNotfound(const std::vector<uint256> &txHashes, const std::vector<uint256> &blockHashes);
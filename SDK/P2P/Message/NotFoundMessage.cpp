@@ -18,8 +18,7 @@ namespace Elastos {
 
 		}
 
-		bool NotFoundMessage::Accept(const bytes_t &msg) {
-			ByteStream stream(msg);
+		bool NotFoundMessage::Accept(const ByteStream &stream) {
 			uint32_t count = 0;
 
 			if (!stream.ReadUint32(count)) {
@@ -60,6 +59,7 @@ namespace Elastos {
 			}
 
 			_peer->RemoveKnownTxHashes(txHashes);
+			_peer->OnBlocksNotFound(blockHashes);
 			FireNotfound(txHashes, blockHashes);
 
 			return true;
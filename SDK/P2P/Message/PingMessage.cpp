@@ -20,12 +20,11 @@ namespace Elastos {
 
 		}
 
-		bool PingMessage::Accept(const bytes_t &msg) {
-			ByteStream stream(msg);
+		bool PingMessage::Accept(const ByteStream &stream) {
 			uint64_t height;
 
 			if (!stream.ReadUint64(height)) {
-				_peer->error("malformed ping message, length is {}, should be 8", msg.size());
+				_peer->error("malformed ping message, length is {}, should be 8", stream.size());
 				return false;
 			}
 
@@ -16,13 +16,13 @@ namespace Elastos {
 				Message(peer) {
 		}
 
-		bool PongMessage::Accept(const bytes_t &msg) {
+		bool PongMessage::Accept(const ByteStream &stream) {
 			struct timeval tv;
 			double pingTime;
 			bool r = true;
 
-			if (sizeof(uint64_t) > msg.size()) {
-				_peer->warn("malformed pong message, length is {}, should be {}", msg.size(), sizeof(uint64_t));
+			if (sizeof(uint64_t) > stream.size()) {
+				_peer->warn("malformed pong message, length is {}, should be {}", stream.size(), sizeof(uint64_t));
 				r = false;
 			} else if (_peer->GetPongCallbacks().empty()) {
 				_peer->warn("got unexpected pong");
@@ -14,8 +14,7 @@ namespace Elastos {
 			Message(peer) {
 		}
 
-		bool RejectMessage::Accept(const bytes_t &msg) {
-			ByteStream stream(msg);
+		bool RejectMessage::Accept(const ByteStream &stream) {
 
 			std::string type;
 			if (!stream.ReadVarString(type)) {
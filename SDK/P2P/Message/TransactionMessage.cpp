@@ -19,11 +19,9 @@ namespace Elastos {
 
 		}
 
-		bool TransactionMessage::Accept(const bytes_t &msg) {
+		bool TransactionMessage::Accept(const ByteStream &stream) {
 			std::string chainID = _peer->GetPeerManager()->GetChainID();
 
-			ByteStream stream(msg);
-
 			TransactionPtr tx;
 			if (chainID == CHAINID_MAINCHAIN) {
 				tx = TransactionPtr(new Transaction());
@@ -32,7 +30,7 @@ namespace Elastos {
 			}
 
 			if (!tx->Deserialize(stream)) {
-				_peer->error("malformed tx message with length: {}", msg.size());
+				_peer->error("malformed tx message with length: {}", stream.size());
 				return false;
 			} else if (!_peer->SentFilter() && !_peer->SentGetdata()) {
 				_peer->error("got tx message before loading filter");
@@ -15,7 +15,7 @@ namespace Elastos {
 
 		}
 
-		bool VerackMessage::Accept(const bytes_t &msg) {
+		bool VerackMessage::Accept(const ByteStream &stream) {
 			if (_peer->GotVerack()) {
 				_peer->error("got unexcepted verack");
 			} else {
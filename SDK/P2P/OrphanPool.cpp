@@ -0,0 +1,101 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "OrphanPool.h"
+
+#include <Common/ByteStream.h>
+
+#include <algorithm>
+
+namespace Elastos {
+	namespace ElaWallet {
+
+		OrphanPool::OrphanPool(size_t maxBlocks, size_t maxBytes) :
+			_maxBlocks(std::max(maxBlocks, (size_t) 1)),
+			_maxBytes(maxBytes),
+			_bytes(0),
+			_evicted(0) {
+		}
+
+		OrphanPool::~OrphanPool() {
+		}
+
+		void OrphanPool::Insert(const MerkleBlockPtr &block) {
+			Remove(block->GetHash());
+
+			ByteStream stream;
+			block->Serialize(stream, MERKLEBLOCK_VERSION_1);
+
+			Entry &entry = _blocks[block->GetHash()];
+			entry.block = block;
+			entry.bytes = stream.size();
+			entry.order = _order.insert(_order.end(), block->GetHash());
+			_children.insert(std::make_pair(block->GetPrevBlockHash(), block->GetHash()));
+			_bytes += entry.bytes;
+
+			// the block just inserted stays, even if it alone is over the byte cap
+			while (_blocks.size() > _maxBlocks || (_bytes > _maxBytes && _blocks.size() > 1)) {
+				uint256 oldest = _order.front();
+				Remove(oldest);
+				_evicted++;
+			}
+		}
+
+		bool OrphanPool::Remove(const MerkleBlockPtr &block) {
+			return Remove(block->GetHash());
+		}
+
+		bool OrphanPool::Remove(const uint256 &hash) {
+			BlockMap::iterator it = _blocks.find(hash);
+			if (it == _blocks.end())
+				return false;
+
+			std::pair<PrevHashMap::iterator, PrevHashMap::iterator> range =
+				_children.equal_range(it->second.block->GetPrevBlockHash());
+			for (PrevHashMap::iterator child = range.first; child != range.second; ++child) {
+				if (child->second == hash) {
+					_children.erase(child);
+					break;
+				}
+			}
+
+			_bytes -= it->second.bytes;
+			_order.erase(it->second.order);
+			_blocks.erase(it);
+			return true;
+		}
+
+		bool OrphanPool::Contains(const uint256 &hash) const {
+			return _blocks.find(hash) != _blocks.end();
+		}
+
+		MerkleBlockPtr OrphanPool::GetMatchPrevHash(const uint256 &hash) const {
+			PrevHashMap::const_iterator child = _children.find(hash);
+			if (child == _children.end())
+				return nullptr;
+
+			return _blocks.find(child->second)->second.block;
+		}
+
+		size_t OrphanPool::Size() const {
+			return _blocks.size();
+		}
+
+		size_t OrphanPool::Bytes() const {
+			return _bytes;
+		}
+
+		uint64_t OrphanPool::Evicted() const {
+			return _evicted;
+		}
+
+		void OrphanPool::Clear() {
+			_order.clear();
+			_blocks.clear();
+			_children.clear();
+			_bytes = 0;
+		}
+
+	}
+}
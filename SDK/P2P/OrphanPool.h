@@ -0,0 +1,73 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef __ELASTOS_SDK_ORPHANPOOL_H__
+#define __ELASTOS_SDK_ORPHANPOOL_H__
+
+#include <Plugin/Interface/IMerkleBlock.h>
+#include <Common/uint256.h>
+
+#include <list>
+#include <unordered_map>
+
+#define ORPHAN_POOL_MAX_BLOCKS 500               // orphan blocks held at most
+#define ORPHAN_POOL_MAX_BYTES  (4 * 1024 * 1024) // serialized size of the orphan blocks held at most
+
+namespace Elastos {
+	namespace ElaWallet {
+
+		/**
+		 * Blocks whose parent we don't have yet, indexed by hash and by previous block hash. Capped by count and
+		 * by serialized size: when either is exceeded the orphans received first are evicted, so a peer relaying
+		 * made up blocks can't grow it without bounds.
+		 */
+		class OrphanPool {
+		public:
+			explicit OrphanPool(size_t maxBlocks = ORPHAN_POOL_MAX_BLOCKS, size_t maxBytes = ORPHAN_POOL_MAX_BYTES);
+
+			~OrphanPool();
+
+			// replaces an orphan with the same hash, evicts the oldest ones if the pool is full
+			void Insert(const MerkleBlockPtr &block);
+
+			bool Remove(const MerkleBlockPtr &block);
+
+			bool Remove(const uint256 &hash);
+
+			bool Contains(const uint256 &hash) const;
+
+			// an orphan whose previous block is @hash, nullptr if none
+			MerkleBlockPtr GetMatchPrevHash(const uint256 &hash) const;
+
+			size_t Size() const;
+
+			// serialized size of the orphans held
+			size_t Bytes() const;
+
+			// orphans dropped to stay within the caps
+			uint64_t Evicted() const;
+
+			void Clear();
+
+		private:
+			struct Entry {
+				MerkleBlockPtr block;
+				size_t bytes;
+				std::list<uint256>::iterator order;
+			};
+
+			typedef std::unordered_map<uint256, Entry, uint256Hasher> BlockMap;
+			typedef std::unordered_multimap<uint256, uint256, uint256Hasher> PrevHashMap;
+
+			size_t _maxBlocks, _maxBytes, _bytes;
+			uint64_t _evicted;
+			std::list<uint256> _order; // oldest first
+			BlockMap _blocks;
+			PrevHashMap _children;
+		};
+
+	}
+}
+
+#endif //__ELASTOS_SDK_ORPHANPOOL_H__
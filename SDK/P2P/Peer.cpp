@@ -21,6 +21,7 @@
  */
 #include "Peer.h"
 #include "PeerManager.h"
+#include "PeerReactor.h"
 #include "Message/PingMessage.h"
 #include "Message/VersionMessage.h"
 #include "Message/VerackMessage.h"
@@ -34,6 +35,7 @@
 #include "Message/MempoolMessage.h"
 #include "Message/PongMessage.h"
 #include "Message/FilterLoadMessage.h"
+#include "Message/FilterAddMessage.h"
 #include "Message/GetAddressMessage.h"
 #include "Message/RejectMessage.h"
 
@@ -44,20 +46,22 @@
 #include <arpa/inet.h>
 #include <cfloat>
 #include <sys/time.h>
-#include <boost/thread.hpp>
 
-#define HEADER_LENGTH      24
 #define MAX_MSG_LENGTH     0x02000000
 #define MIN_PROTO_VERSION  70002 // peers earlier than this protocol version not supported (need v0.9 txFee relay rules)
 #define LOCAL_HOST         ((UInt128) { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff, 0x7f, 0x00, 0x00, 0x01 })
 #define CONNECT_TIMEOUT    3.0
 #define MESSAGE_TIMEOUT    40.0
 
-#define PTHREAD_STACK_SIZE  (512 * 1024)
-
 namespace Elastos {
 	namespace ElaWallet {
 
+		static double CurrentTime() {
+			struct timeval tv;
+			gettimeofday(&tv, NULL);
+			return tv.tv_sec + (double) tv.tv_usec / 1000000;
+		}
+
 		Peer::Peer(PeerManager *manager, uint32_t magicNumber) :
 				_status(Disconnected),
 				_magicNumber(magicNumber),
@@ -66,6 +70,16 @@ namespace Elastos {
 				_disconnectTime(DBL_MAX),
 				_manager(manager),
 				_socket(-1),
+				_strand(PeerReactor::Instance()->GetService()),
+				_connection(PeerReactor::Instance()->GetService()),
+				_timer(PeerReactor::Instance()->GetService()),
+				_timerTime(DBL_MAX),
+				_msgTimeout(DBL_MAX),
+				_ioActive(false),
+				_recvWanted(HEADER_LENGTH),
+				_sendTimeout(DBL_MAX),
+				_knownInventoryMemory(0),
+				_writeWaiting(false),
 				_waitingForNetwork(0),
 				_needsFilterUpdate(false),
 				_nonce(0),
@@ -177,8 +191,6 @@ namespace Elastos {
 
 		void Peer::Connect() {
 			struct timeval tv;
-			int error = 0;
-			pthread_attr_t attr;
 
 			if (_status == Peer::Disconnected || _waitingForNetwork) {
 				_status = Peer::Connecting;
@@ -192,61 +204,58 @@ namespace Elastos {
 					gettimeofday(&tv, NULL);
 					_disconnectTime = tv.tv_sec + (double) tv.tv_usec / 1000000 + CONNECT_TIMEOUT;
 
-					boost::thread workThread(boost::bind(&Peer::PeerThreadRoutine, this));
+					_strand.post(boost::bind(&Peer::OpenSocket, shared_from_this()));
 				}
 			}
 		}
 
 		void Peer::Disconnect() {
-			int socket = _socket;
-
-			if (socket >= 0) {
-				_socket = -1;
-				if (shutdown(socket, SHUT_RDWR) < 0) {
-					this->error("peer shutdown error: {}", FormatError(errno));
+			{
+				// a send in progress finishes first, and none starts on this socket afterwards
+				boost::mutex::scoped_lock scopedLock(_sendLock);
+				int socket = _socket;
+
+				if (socket >= 0) {
+					_socket = -1;
+					if (shutdown(socket, SHUT_RDWR) < 0) {
+						this->error("peer shutdown error: {}", FormatError(errno));
+					}
 				}
-				close(socket);
 			}
+
+			// the socket is closed on the strand, so that no read handler is left using it
+			_strand.post(boost::bind(&Peer::CloseSocket, shared_from_this(), 0));
 		}
 
-		// sends a bitcoin protocol message to peer
+		// queues a bitcoin protocol message to peer, and writes what the socket takes right away without blocking
 		void Peer::SendMessage(const bytes_t &message, const std::string &type) {
 			if (message.size() > MAX_MSG_LENGTH) {
 				this->error("failed to send {}, length {} is too long", type, message.size());
 			} else {
-				ssize_t n = 0;
-				struct timeval tv;
-				int socket, error = 0;
-				ByteStream stream;
+				int error = 0;
+				ByteStream header;
 
-				stream.WriteUint32(_magicNumber);
-				stream.WriteBytes(bytes_t(type.c_str(), type.size()));
+				header.WriteUint32(_magicNumber);
+				header.WriteBytes(bytes_t(type.c_str(), type.size()));
 				if (type.size() < 12)
-					stream.WriteBytes(bytes_t(12 - type.size(), 0));
-				stream.WriteUint32(message.size());
-				bytes_t hash = sha256_2(message);
-				stream.WriteUint32(*(uint32_t *)hash.data());
-				stream.WriteBytes(message);
-
-				const bytes_t &buf = stream.GetBytes();
+					header.WriteBytes(bytes_t(12 - type.size(), 0));
+				header.WriteUint32(message.size());
+				header.WriteUint32(sha256_2_checksum(message.data(), message.size()));
 
 				this->info("sending {}", type);
-				size_t msgLen = 0;
-				socket = _socket;
-				if (socket < 0) error = ENOTCONN;
 
-				gettimeofday(&tv, NULL);
-				double disconnectTime = tv.tv_sec + (double) tv.tv_usec / 1000000 + MESSAGE_TIMEOUT;
-
-				while (socket >= 0 && !error && msgLen < buf.size()) {
-					n = send(socket, &buf[msgLen], buf.size() - msgLen, MSG_NOSIGNAL);
-					if (n >= 0) {
-						msgLen += n;
+				{
+					boost::mutex::scoped_lock scopedLock(_sendLock);
+					if (_socket < 0) {
+						error = ENOTCONN;
+					} else {
+						bool congested = _sendQueue.Congested();
+						_sendQueue.Push(header.GetBytes(), message);
+						if (!congested && _sendQueue.Congested())
+							this->warn("send queue congested, {} bytes in {} message(s)", _sendQueue.Bytes(),
+									   _sendQueue.Messages());
+						error = FlushSendQueue();
 					}
-					if (n < 0 && errno != EWOULDBLOCK) error = errno;
-					gettimeofday(&tv, NULL);
-					if (!error && tv.tv_sec + (double) tv.tv_usec / 1000000 >= disconnectTime) error = ETIMEDOUT;
-					socket = _socket;
 				}
 
 				if (error) {
@@ -256,17 +265,130 @@ namespace Elastos {
 			}
 		}
 
+		int Peer::FlushSendQueue() {
+			struct iovec iov[SEND_QUEUE_MAX_IOV];
+			struct msghdr msg;
+
+			while (!_sendQueue.Empty()) {
+				int socket = _socket; // cleared under _sendLock before the fd is closed
+				if (socket < 0) return ENOTCONN;
+
+				memset(&msg, 0, sizeof(msg));
+				msg.msg_iov = iov;
+				msg.msg_iovlen = _sendQueue.Gather(iov, SEND_QUEUE_MAX_IOV);
+
+				ssize_t n = sendmsg(socket, &msg, MSG_NOSIGNAL);
+				if (n < 0 && errno == EINTR) continue;
+				if (n < 0 && (errno == EWOULDBLOCK || errno == EAGAIN)) break;
+				if (n < 0) return errno;
+
+				_sendQueue.Consume(n);
+				if (_sendTimeout != DBL_MAX) _sendTimeout = CurrentTime() + MESSAGE_TIMEOUT;
+			}
+
+			if (_sendQueue.Empty()) {
+				_sendTimeout = DBL_MAX;
+			} else if (!_writeWaiting) { // socket is non-blocking, finish on the strand once it's writable again
+				_writeWaiting = true;
+				if (_sendTimeout == DBL_MAX) {
+					_sendTimeout = CurrentTime() + MESSAGE_TIMEOUT;
+					RescheduleTimer(_sendTimeout);
+				}
+				_strand.post(boost::bind(&Peer::WaitWritable, shared_from_this()));
+			}
+
+			return 0;
+		}
+
+		void Peer::WaitWritable() {
+			if (!_ioActive) {
+				boost::mutex::scoped_lock scopedLock(_sendLock);
+				_writeWaiting = false;
+				return;
+			}
+
+			_connection.async_write_some(boost::asio::null_buffers(),
+										 _strand.wrap(boost::bind(&Peer::OnWritable, shared_from_this(),
+																  boost::asio::placeholders::error)));
+		}
+
+		void Peer::OnWritable(const boost::system::error_code &ec) {
+			int error = 0;
+
+			{
+				boost::mutex::scoped_lock scopedLock(_sendLock);
+				_writeWaiting = false;
+				if (ec || !_ioActive) return;
+				error = FlushSendQueue();
+			}
+
+			if (error) {
+				if (_socket != -1) this->error("send error: {}", FormatError(error));
+				CloseSocket(error);
+			}
+		}
+
 		void Peer::RerequestBlocks(const uint256 &fromBlock) {
-			size_t i = _knownBlockHashes.size();
+			if (_knownBlockHashes.TrimBefore(fromBlock)) {
+				UpdateKnownInventoryMemoryUsage();
+				info("re-requesting {} block(s)", _knownBlockHashes.Size());
+				boost::mutex::scoped_lock scopedLock(_blockWindowLock);
+				_blockWindow.Requeue(_knownBlockHashes.Hashes());
+				FillBlockWindow();
+			}
+		}
+
+		void Peer::RequestBlocks(const std::vector<uint256> &blockHashes, bool full) {
+			boost::mutex::scoped_lock scopedLock(_blockWindowLock);
+			_blockWindow.Enqueue(blockHashes, full);
+			FillBlockWindow();
+		}
+
+		void Peer::OnBlockReceived(const uint256 &blockHash) {
+			boost::mutex::scoped_lock scopedLock(_blockWindowLock);
+			size_t window = _blockWindow.Window();
 
-			while (i > 0 && _knownBlockHashes[i - 1] != fromBlock) i--;
+			if (!_blockWindow.Received(blockHash, CurrentTime()))
+				return;
+
+			if (window != _blockWindow.Window())
+				debug("block window {} -> {}, latency {:.3f}s, base {:.3f}s", window, _blockWindow.Window(),
+					  _blockWindow.Latency(), _blockWindow.BaseLatency());
+
+			FillBlockWindow();
+		}
+
+		void Peer::OnBlocksNotFound(const std::vector<uint256> &blockHashes) {
+			boost::mutex::scoped_lock scopedLock(_blockWindowLock);
+			for (size_t i = 0; i < blockHashes.size(); ++i)
+				_blockWindow.Remove(blockHashes[i]);
+
+			FillBlockWindow();
+		}
+
+		void Peer::CancelBlockRequests() {
+			boost::mutex::scoped_lock scopedLock(_blockWindowLock);
+			_blockWindow.Requeue(std::vector<uint256>());
+		}
+
+		void Peer::SetMaxBlocksInFlight(size_t count) {
+			boost::mutex::scoped_lock scopedLock(_blockWindowLock);
+			_blockWindow.SetMaxWindow(count);
+		}
 
-			if (i > 0) {
-				_knownBlockHashes.erase(_knownBlockHashes.begin(), _knownBlockHashes.begin() + i - 1);
-				info("re-requesting {} block(s)", _knownBlockHashes.size());
-				GetDataParameter getDataParameter({}, _knownBlockHashes);
+		void Peer::FillBlockWindow() {
+			// the caller holds _blockWindowLock, which also keeps getdata messages in chain order
+			if (_needsFilterUpdate) return;
+
+			std::vector<uint256> blockHashes = _blockWindow.NextRequests(CurrentTime());
+			if (!blockHashes.empty()) {
+				GetDataParameter getDataParameter({}, blockHashes);
 				SendMessage(MSG_GETDATA, getDataParameter);
 			}
+
+			GetBlocksParameter getBlocksParameter;
+			if (_blockWindow.NextLocators(getBlocksParameter.locators))
+				SendMessage(MSG_GETBLOCKS, getBlocksParameter);
 		}
 
 		void Peer::ScheduleDisconnect(double seconds) {
@@ -274,6 +396,7 @@ namespace Elastos {
 
 			gettimeofday(&tv, NULL);
 			_disconnectTime = (seconds < 0) ? DBL_MAX : tv.tv_sec + (double) tv.tv_usec / 1000000 + seconds;
+			RescheduleTimer(_disconnectTime);
 		}
 
 		bool Peer::NeedsFilterUpdate() const {
@@ -329,127 +452,261 @@ namespace Elastos {
 			return _info.IsIPv4();
 		}
 
-		void Peer::PeerThreadRoutine() {
-
-			int socket, error = 0;
-
-			if (OpenSocket(PF_INET6, CONNECT_TIMEOUT, &error)) {
-				struct timeval tv;
-				double time = 0, msgTimeout;
-				uint8_t header[HEADER_LENGTH];
-				bytes_t payload;
-				size_t len = 0;
-				ssize_t n = 0;
-
-				gettimeofday(&tv, NULL);
-				_startTime = tv.tv_sec + (double) tv.tv_usec / 1000000;
-				SendMessage(MSG_VERSION, Message::DefaultParam);
-
-				while (_socket >= 0 && !error) {
-					len = 0;
-					socket = _socket;
-
-					while (socket >= 0 && !error && len < HEADER_LENGTH) {
-						n = read(socket, &header[len], sizeof(header) - len);
-						if (n > 0) len += n;
-						if (n == 0)
-							error = ECONNRESET;
-						if (n < 0 && errno != EWOULDBLOCK) {
-							error = errno;
-							if (error == EINTR) {
-								error = 0;
-								continue;
-							}
-						}
-
-						gettimeofday(&tv, NULL);
-						time = tv.tv_sec + (double) tv.tv_usec / 1000000;
-						if (!error && time >= _disconnectTime) error = ETIMEDOUT;
-
-						if (!error && time >= _mempoolTime) {
-							info("done waiting for mempool response");
-							PingParameter pingParameter(_manager->GetLastBlockHeight(), _mempoolCallback);
-							SendMessage(MSG_PING, pingParameter);
-							_mempoolCallback = PeerCallback();
-							_mempoolTime = DBL_MAX;
-						}
-
-						while (sizeof(uint32_t) <= len && UInt32GetLE(header) != _magicNumber) {
-							memmove(header, &header[1],
-									--len); // consume one byte at a time until we find the magic number
-						}
-
-						socket = _socket;
-					}
+		void Peer::OpenSocket() {
+			boost::system::error_code ec;
+			boost::asio::ip::tcp::endpoint endpoint;
+
+			if (IsIPv4()) {
+				boost::asio::ip::address_v4::bytes_type bytes;
+				memcpy(bytes.data(), &_info.Address.begin()[12], bytes.size());
+				endpoint = boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4(bytes), _info.Port);
+			} else {
+				boost::asio::ip::address_v6::bytes_type bytes;
+				memcpy(bytes.data(), _info.Address.begin(), bytes.size());
+				endpoint = boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v6(bytes), _info.Port);
+			}
+
+			_ioActive = true;
+			_recvBuffer.Clear();
+			_recvWanted = HEADER_LENGTH;
+			_msgTimeout = DBL_MAX;
+
+			_connection.open(endpoint.protocol(), ec);
+			if (!ec) _connection.set_option(boost::asio::socket_base::keep_alive(true), ec);
+			if (!ec) _connection.native_non_blocking(true, ec);
+			if (ec) {
+				this->error("connect error: {}", ec.message());
+				CloseSocket(ec.value());
+				return;
+			}
+
+#ifdef SO_NOSIGPIPE // BSD based systems have a SO_NOSIGPIPE socket option to supress SIGPIPE signals
+			int on = 1;
+			setsockopt(_connection.native_handle(), SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+			{
+				boost::mutex::scoped_lock scopedLock(_sendLock);
+				_socket = _connection.native_handle();
+			}
+
+			_connection.async_connect(endpoint, _strand.wrap(boost::bind(&Peer::OnConnected, shared_from_this(),
+																		 boost::asio::placeholders::error)));
+			ScheduleTimer(); // connect timeout
+		}
+
+		void Peer::OnConnected(const boost::system::error_code &ec) {
+			if (!_ioActive) return;
+
+			if (ec) {
+				if (_socket != -1) this->error("connect error: {}", ec.message());
+				CloseSocket(ec.value());
+				return;
+			}
+
+			info("socket connected");
+			_startTime = CurrentTime();
+			SendMessage(MSG_VERSION, Message::DefaultParam);
+			Read();
+		}
+
+		void Peer::Read() {
+			uint8_t *buf = _recvBuffer.Prepare(_recvWanted);
+			_connection.async_read_some(boost::asio::buffer(buf, _recvBuffer.Writable()),
+										_strand.wrap(boost::bind(&Peer::OnRead, shared_from_this(),
+																 boost::asio::placeholders::error,
+																 boost::asio::placeholders::bytes_transferred)));
+		}
+
+		void Peer::OnRead(const boost::system::error_code &ec, size_t bytes) {
+			if (!_ioActive) return;
+
+			if (ec) {
+				int error = (ec == boost::asio::error::eof) ? ECONNRESET : ec.value();
+				if (_socket != -1)
+					this->error("read {} error: {}", _msgTimeout != DBL_MAX ? "message" : "header", FormatError(error));
+				CloseSocket(error);
+				return;
+			}
+
+			_recvBuffer.Commit(bytes);
+			if (bytes > 0 && _msgTimeout != DBL_MAX) _msgTimeout = CurrentTime() + MESSAGE_TIMEOUT; // timer catches up lazily
+
+			int error = ProcessMessages();
+			if (error) {
+				CloseSocket(error);
+			} else if (_ioActive) {
+				Read();
+			}
+		}
 
-					if (error) {
-						if (_socket != -1) {
-							this->error("read header error: {}", FormatError(error));
-						}
-					} else if (header[15] != 0) { // verify header type field is NULL terminated
-						this->error("malformed message header: type not NULL terminated");
-						error = EPROTO;
-					} else if (len == HEADER_LENGTH) {
-						std::string type = (const char *) (&header[4]);
-						uint32_t msgLen = *(uint32_t*)&header[16];
-						uint32_t checksum = *(uint32_t*)(&header[20]);
-
-						if (msgLen > MAX_MSG_LENGTH) { // check message length
-							this->error("error reading {}, message length {} is too long", type, msgLen);
-							error = EPROTO;
-						} else {
-							payload.resize(size_t(msgLen));
-							len = 0;
-							socket = _socket;
-							msgTimeout = time + MESSAGE_TIMEOUT;
-
-							while (socket >= 0 && !error && len < msgLen) {
-								n = read(socket, &payload[len], msgLen - len);
-								if (n > 0) len += n;
-								if (n == 0)
-									error = ECONNRESET;
-								if (n < 0 && errno != EWOULDBLOCK) {
-									error = errno;
-									if (error == EINTR) {
-										error = 0;
-										continue;
-									}
-								}
-
-								gettimeofday(&tv, NULL);
-								time = tv.tv_sec + (double) tv.tv_usec / 1000000;
-								if (n > 0) msgTimeout = time + MESSAGE_TIMEOUT;
-								if (!error && time >= msgTimeout)
-									error = ETIMEDOUT;
-								socket = _socket;
-							}
-
-							if (error) {
-								if (_socket != -1) {
-									this->error("read message error: {}", FormatError(error));
-								}
-							} else if (len == msgLen) {
-								bytes_t hash = sha256_2(payload);;
-
-								if (*(uint32_t *)(&hash[0]) != checksum) { // verify checksum
-									this->error("reading {}, invalid checksum {:x}, expected {:x}, payload length:{},",
-												type, UInt32GetLE(&hash), checksum, msgLen);
-									error = EPROTO;
-								} else if (!AcceptMessage(payload, type)) error = EPROTO;
-							}
-						}
+		int Peer::ProcessMessages() {
+			while (_ioActive) {
+				// consume one byte at a time until we find the magic number
+				while (_recvBuffer.Size() >= sizeof(uint32_t) && UInt32GetLE(_recvBuffer.Data()) != _magicNumber)
+					_recvBuffer.Consume(1);
+
+				const uint8_t *header = _recvBuffer.Data();
+				if (_recvBuffer.Size() < HEADER_LENGTH) {
+					_recvWanted = HEADER_LENGTH;
+					return 0;
+				}
+
+				if (header[15] != 0) { // verify header type field is NULL terminated
+					this->error("malformed message header: type not NULL terminated");
+					return EPROTO;
+				}
+
+				std::string type = (const char *) (&header[4]);
+				uint32_t msgLen = UInt32GetLE(&header[16]);
+				uint32_t checksum = *(uint32_t *) (&header[20]);
+
+				if (msgLen > MAX_MSG_LENGTH) { // check message length
+					this->error("error reading {}, message length {} is too long", type, msgLen);
+					return EPROTO;
+				}
+
+				if (_recvBuffer.Size() < HEADER_LENGTH + msgLen) { // wait for the rest of the payload
+					if (_msgTimeout == DBL_MAX) {
+						_msgTimeout = CurrentTime() + MESSAGE_TIMEOUT;
+						ScheduleTimer();
 					}
+					_recvWanted = HEADER_LENGTH + msgLen;
+					return 0;
+				}
+
+				SyncMetrics &metrics = _manager->GetSyncMetrics();
+				const uint8_t *payload = header + HEADER_LENGTH;
+				uint32_t payloadChecksum;
+				{
+					SyncMetrics::Timer timer(metrics, SyncMetrics::Checksum);
+					payloadChecksum = sha256_2_checksum(payload, msgLen);
+				}
+				if (payloadChecksum != checksum) { // verify checksum
+					this->error("reading {}, invalid checksum {:x}, expected {:x}, payload length:{},",
+								type, payloadChecksum, checksum, msgLen);
+					metrics.Add(SyncMetrics::ChecksumFailures);
+					return EPROTO;
 				}
+
+				if (_msgTimeout != DBL_MAX) {
+					_msgTimeout = DBL_MAX;
+					ScheduleTimer();
+				}
+
+				// parse the payload in place, it stays in the buffer until the message is accepted
+				ByteStream stream = ByteStream::View(payload, msgLen);
+				metrics.Add(SyncMetrics::MessagesReceived);
+				metrics.Add(SyncMetrics::BytesReceived, HEADER_LENGTH + msgLen);
+				{
+					SyncMetrics::Timer timer(metrics, SyncMetrics::MessageReceive);
+					if (!AcceptMessage(stream, type))
+						return EPROTO;
+				}
+
+				_recvBuffer.Consume(HEADER_LENGTH + msgLen);
+			}
+
+			return 0;
+		}
+
+		void Peer::ScheduleTimer() {
+			if (!_ioActive) return;
+
+			// while a message is being read only its own timeout applies, as in the header/payload reads before
+			double time = (_msgTimeout != DBL_MAX) ? _msgTimeout : _disconnectTime;
+			if (_mempoolTime < time) time = _mempoolTime;
+			{
+				boost::mutex::scoped_lock scopedLock(_sendLock);
+				if (_sendTimeout < time) time = _sendTimeout;
 			}
 
+			_timerTime = time;
+			if (time == DBL_MAX) {
+				boost::system::error_code ec;
+				_timer.cancel(ec);
+				return;
+			}
+
+			double delay = time - CurrentTime();
+			_timer.expires_from_now(boost::posix_time::microseconds(delay > 0 ? (int64_t) (delay * 1000000) : 0));
+			_timer.async_wait(_strand.wrap(boost::bind(&Peer::OnTimer, shared_from_this(),
+													   boost::asio::placeholders::error)));
+			PeerReactor::Instance()->PeerTimerArmed();
+		}
+
+		void Peer::OnTimer(const boost::system::error_code &ec) {
+			PeerReactor::Instance()->PeerTimerDone();
+			if (ec == boost::asio::error::operation_aborted || !_ioActive) return;
+
+			double time = CurrentTime(), sendTimeout;
+			double timeout = (_msgTimeout != DBL_MAX) ? _msgTimeout : _disconnectTime;
+
+			{
+				boost::mutex::scoped_lock scopedLock(_sendLock);
+				sendTimeout = _sendTimeout;
+			}
+
+			if (time >= timeout) {
+				if (_socket != -1) this->error("read {} error: {}", _msgTimeout != DBL_MAX ? "message" : "header",
+											   FormatError(ETIMEDOUT));
+				CloseSocket(ETIMEDOUT);
+				return;
+			}
+
+			if (time >= sendTimeout) {
+				if (_socket != -1) this->error("send error: {}", FormatError(ETIMEDOUT));
+				CloseSocket(ETIMEDOUT);
+				return;
+			}
+
+			if (time >= _mempoolTime) {
+				info("done waiting for mempool response");
+				PingParameter pingParameter(_manager->GetLastBlockHeight(), _mempoolCallback);
+				SendMessage(MSG_PING, pingParameter);
+				_mempoolCallback = PeerCallback();
+				_mempoolTime = DBL_MAX;
+			}
+
+			ScheduleTimer();
+		}
+
+		void Peer::RescheduleTimer(double time) {
+			if (time < _timerTime)
+				_strand.post(boost::bind(&Peer::ScheduleTimer, shared_from_this()));
+		}
+
+		void Peer::CloseSocket(int error) {
+			if (!_ioActive) return;
+			_ioActive = false;
+
 			if (_socket == -1)
 				error = 0;
 
-			socket = _socket;
-			_socket = -1;
+			boost::system::error_code ec;
 			_status = Peer::Disconnected;
-			if (socket >= 0) close(socket);
-			info("disconnected");
+			_timerTime = DBL_MAX;
+			_timer.cancel(ec);
+			{
+				// closing under _sendLock, so no sendmsg can still reach the fd, or the next socket that reuses it
+				boost::mutex::scoped_lock scopedLock(_sendLock);
+				_socket = -1;
+				_connection.close(ec);
+			}
+			info("disconnected, known inventory {} tx {} block(s) {} bytes", _knownTxHashes.Size(),
+				 _knownBlockHashes.Size(), KnownInventoryMemoryUsage());
+
+			{
+				boost::mutex::scoped_lock scopedLock(_sendLock);
+				info("send queue peak {} bytes, congested {} time(s), {} bytes unsent", _sendQueue.PeakBytes(),
+					 _sendQueue.CongestedCount(), _sendQueue.Bytes());
+				_sendQueue.Clear();
+				_sendTimeout = DBL_MAX;
+			}
+
+			{
+				boost::mutex::scoped_lock scopedLock(_blockWindowLock);
+				_blockWindow.Clear();
+			}
 
 			while (!_pongCallbackList.empty()) {
 				Peer::PeerCallback pongCallback = PopPongCallback();
@@ -482,12 +739,13 @@ namespace Elastos {
 			InitSingleMessage(new PingMessage(shared_from_this()));
 			InitSingleMessage(new PongMessage(shared_from_this()));
 			InitSingleMessage(new FilterLoadMessage(shared_from_this()));
+			InitSingleMessage(new FilterAddMessage(shared_from_this()));
 			InitSingleMessage(new MerkleBlockMessage(shared_from_this()));
 			InitSingleMessage(new GetAddressMessage(shared_from_this()));
 			InitSingleMessage(new RejectMessage(shared_from_this()));
 		}
 
-		bool Peer::AcceptMessage(const bytes_t &msg, const std::string &type) {
+		bool Peer::AcceptMessage(const ByteStream &msg, const std::string &type) {
 			bool r = false;
 
 			if (_currentBlock != nullptr && MSG_TX != type) { // if we receive a non-tx message, merkleblock is done
@@ -588,22 +846,16 @@ namespace Elastos {
 			}
 		}
 
-		const std::vector<uint256> &Peer::GetKnownBlockHashes() const {
+		const KnownInventory &Peer::KnownBlockHashes() const {
 			return _knownBlockHashes;
 		}
 
-		void Peer::KnownBlockHashesRemoveRange(size_t index, size_t len) {
-			for (size_t i = len; i > index; --i) {
-				_knownBlockHashes.erase(_knownBlockHashes.begin() + i - 1);
-			}
-		}
-
 		void Peer::AddKnownBlockHash(const uint256 &hash) {
-			_knownBlockHashes.push_back(hash);
+			_knownBlockHashes.Add(hash);
+			UpdateKnownInventoryMemoryUsage();
 		}
 
-
-		const std::vector<uint256>& Peer::KnownTxHashes() const {
+		const KnownInventory &Peer::KnownTxHashes() const {
 			return _knownTxHashes;
 		}
 
@@ -615,108 +867,55 @@ namespace Elastos {
 			_lastBlockHash = hash;
 		}
 
-		const std::set<uint256> &Peer::KnownTxHashSet() const {
-			return _knownTxHashSet;
-		}
+		std::vector<uint256> Peer::AddKnownTxHashes(const std::vector<uint256> &txHashes) {
+			std::vector<uint256> added;
 
-		void Peer::AddKnownTxHashes(const std::vector<uint256> &txHashes) {
 			for (size_t i = 0; i < txHashes.size(); i++) {
-				if (_knownTxHashSet.find(txHashes[i]) == _knownTxHashSet.end()) {
-					_knownTxHashes.push_back(txHashes[i]);
-					_knownTxHashSet.insert(txHashes[i]);
-				}
+				if (_knownTxHashes.Add(txHashes[i]))
+					added.push_back(txHashes[i]);
 			}
+			UpdateKnownInventoryMemoryUsage();
+
+			return added;
 		}
 
 		void Peer::RemoveKnownTxHashes(const std::vector<uint256> &txHashes) {
-			for (size_t i = 0; i < txHashes.size(); ++i) {
-				if (_knownTxHashSet.find(txHashes[i]) != _knownTxHashSet.end()) {
-					_knownTxHashSet.erase(txHashes[i]);
-				}
-
-				for (std::vector<uint256>::iterator it = _knownTxHashes.begin(); it != _knownTxHashes.end();) {
-					if ((*it) == txHashes[i]) {
-						it = _knownTxHashes.erase(it);
-					} else {
-						++it;
-					}
-				}
-			}
+			for (size_t i = 0; i < txHashes.size(); ++i)
+				_knownTxHashes.Remove(txHashes[i]);
+			UpdateKnownInventoryMemoryUsage();
 		}
 
-		std::string Peer::FormatError(int errnum) {
-			return std::string(strerror(errnum));
+		void Peer::SetMaxKnownInventory(size_t count) {
+			_knownTxHashes.SetCapacity(count);
+			_knownBlockHashes.SetCapacity(count);
+			UpdateKnownInventoryMemoryUsage();
 		}
 
-		int Peer::OpenSocket(int domain, double timeout, int *error) {
-			struct sockaddr_storage addr;
-			struct timeval tv;
-			fd_set fds;
-			socklen_t addrLen, optLen;
-			int count, arg = 0, err = 0, on = 1, r = 1;
-
-			_socket = socket(domain, SOCK_STREAM, 0);
-
-			if (_socket < 0) {
-				err = errno;
-				r = 0;
-			} else {
-				tv.tv_sec = 1; // one second timeout for send/receive, so thread doesn't block for too long
-				tv.tv_usec = 0;
-				setsockopt(_socket, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
-				setsockopt(_socket, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
-				setsockopt(_socket, SOL_SOCKET, SO_KEEPALIVE, &on, sizeof(on));
-#ifdef SO_NOSIGPIPE // BSD based systems have a SO_NOSIGPIPE socket option to supress SIGPIPE signals
-				setsockopt(_socket, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
-#endif
-				arg = fcntl(_socket, F_GETFL, NULL);
-				if (arg < 0 || fcntl(_socket, F_SETFL, arg | O_NONBLOCK) < 0)
-					r = 0; // temporarily set socket non-blocking
-				if (!r) err = errno;
-			}
+		size_t Peer::KnownInventoryMemoryUsage() const {
+			return _knownInventoryMemory;
+		}
 
-			if (r) {
-				memset(&addr, 0, sizeof(addr));
+		void Peer::UpdateKnownInventoryMemoryUsage() {
+			_knownInventoryMemory = _knownTxHashes.MemoryUsage() + _knownBlockHashes.MemoryUsage();
+		}
 
-				if (domain == PF_INET6) {
-					((struct sockaddr_in6 *) &addr)->sin6_family = AF_INET6;
-					((struct sockaddr_in6 *) &addr)->sin6_addr = *(struct in6_addr *) &_info.Address;
-					((struct sockaddr_in6 *) &addr)->sin6_port = htons(_info.Port);
-					addrLen = sizeof(struct sockaddr_in6);
-				} else {
-					((struct sockaddr_in *) &addr)->sin_family = AF_INET;
-					((struct sockaddr_in *) &addr)->sin_addr = *(struct in_addr *) &_info.Address.begin()[12];
-					((struct sockaddr_in *) &addr)->sin_port = htons(_info.Port);
-					addrLen = sizeof(struct sockaddr_in);
-				}
+		size_t Peer::GetSendQueueBytes() const {
+			boost::mutex::scoped_lock scopedLock(_sendLock);
+			return _sendQueue.Bytes();
+		}
 
-				if (connect(_socket, (struct sockaddr *) &addr, addrLen) < 0) err = errno;
-
-				if (err == EINPROGRESS) {
-					err = 0;
-					optLen = sizeof(err);
-					tv.tv_sec = timeout;
-					tv.tv_usec = (long) (timeout * 1000000) % 1000000;
-					FD_ZERO(&fds);
-					FD_SET(_socket, &fds);
-					count = select(_socket + 1, NULL, &fds, NULL, &tv);
-
-					if (count <= 0 || getsockopt(_socket, SOL_SOCKET, SO_ERROR, &err, &optLen) < 0 || err) {
-						if (count == 0) err = ETIMEDOUT;
-						if (count < 0 || !err) err = errno;
-						r = 0;
-					}
-				} else if (err && domain == PF_INET6 && IsIPv4()) {
-					return OpenSocket(PF_INET, timeout, error); // fallback to IPv4
-				} else if (err) r = 0;
+		size_t Peer::GetSendQueuePeakBytes() const {
+			boost::mutex::scoped_lock scopedLock(_sendLock);
+			return _sendQueue.PeakBytes();
+		}
 
-				if (r) info("socket connected");
-				fcntl(_socket, F_SETFL, arg); // restore socket non-blocking status
-			}
+		uint64_t Peer::GetSendQueueCongestedCount() const {
+			boost::mutex::scoped_lock scopedLock(_sendLock);
+			return _sendQueue.CongestedCount();
+		}
 
-			if (!r && err) this->error("connect error: {}", FormatError(err));
-			if (error && err) *error = err;
-			return r;
+		std::string Peer::FormatError(int errnum) {
+			return std::string(strerror(errnum));
 		}
 
 		void Peer::SendMessage(const std::string &msgType, const SendMessageParameter &parameter) {
@@ -761,6 +960,7 @@ namespace Elastos {
 
 		void Peer::SetDisconnectTime(double time) {
 			_disconnectTime = time;
+			RescheduleTimer(time);
 		}
 
 		Peer::PeerCallback Peer::PopPongCallback() {
@@ -808,6 +1008,7 @@ namespace Elastos {
 
 		void Peer::SetMempoolTime(double time) {
 			_mempoolTime = time;
+			RescheduleTimer(time);
 		}
 
 		void Peer::InitSingleMessage(Message *message) {
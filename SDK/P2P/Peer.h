@@ -23,16 +23,23 @@
 #define __ELASTOS_SDK_PEER_H__
 
 #include "PeerInfo.h"
+#include "ReceiveBuffer.h"
+#include "SendQueue.h"
+#include "BlockDownloadWindow.h"
+#include "KnownInventory.h"
 #include "Message/Message.h"
 
 #include <Common/Log.h>
 #include <Common/ElementSet.h>
 #include <Common/uint256.h>
 
+#include <atomic>
 #include <deque>
+#include <boost/asio.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/enable_shared_from_this.hpp>
 #include <boost/function.hpp>
+#include <boost/thread/mutex.hpp>
 #include <sys/types.h>
 #include <sys/socket.h>
 
@@ -42,6 +49,8 @@
 #define REJECT_DUST        0x41 // one or more output amounts are below the 'dust' threshold
 #define REJECT_LOWFEE      0x42 // transaction does not have enough fee/priority to be relayed or mined
 
+#define HEADER_LENGTH      24
+
 #ifndef MSG_NOSIGNAL   // linux based systems have a MSG_NOSIGNAL send flag, useful for supressing SIGPIPE signals
 #define MSG_NOSIGNAL 0 // set to 0 if undefined (BSD has the SO_NOSIGPIPE sockopt, and windows has no signals at all)
 #endif
@@ -85,6 +94,9 @@ namespace Elastos {
 
 				virtual void OnRelayedBlock(const PeerPtr &peer, const MerkleBlockPtr &block) = 0;
 
+				virtual void
+				OnRelayedBlockHashes(const PeerPtr &peer, const std::vector<uint256> &blockHashes, bool full) = 0;
+
 				virtual void OnRelayedPing(const PeerPtr &peer) = 0;
 
 				virtual void
@@ -165,6 +177,18 @@ namespace Elastos {
 
 			void RerequestBlocks(const uint256 &fromBlock);
 
+			// queue block hashes from an inv and request as many of them as the download window allows
+			void RequestBlocks(const std::vector<uint256> &blockHashes, bool full);
+
+			void OnBlockReceived(const uint256 &blockHash);
+
+			void OnBlocksNotFound(const std::vector<uint256> &blockHashes);
+
+			// drop queued and in flight block requests, blocks that still arrive for them are not expected anymore
+			void CancelBlockRequests();
+
+			void SetMaxBlocksInFlight(size_t count);
+
 			void ScheduleDisconnect(double time);
 
 			bool NeedsFilterUpdate() const;
@@ -225,24 +249,35 @@ namespace Elastos {
 
 			void CurrentBlockTxHashesRemove(const uint256 &hash);
 
-			const std::vector<uint256> &GetKnownBlockHashes() const;
-
-			void KnownBlockHashesRemoveRange(size_t index, size_t len);
+			const KnownInventory &KnownBlockHashes() const;
 
 			void AddKnownBlockHash(const uint256 &hash);
 
-			const std::vector<uint256> &KnownTxHashes() const;
+			const KnownInventory &KnownTxHashes() const;
 
 			const uint256 &LastBlockHash() const;
 
 			void SetLastBlockHash(const uint256 &hash);
 
-			const std::set<uint256> &KnownTxHashSet() const;
-
-			void AddKnownTxHashes(const std::vector<uint256> &txHashes);
+			// returns the hashes that weren't known yet, in the order given
+			std::vector<uint256> AddKnownTxHashes(const std::vector<uint256> &txHashes);
 
 			void RemoveKnownTxHashes(const std::vector<uint256> &txHashes);
 
+			// capacity of the known tx and known block hash sets each
+			void SetMaxKnownInventory(size_t count);
+
+			// approximate bytes held by the known tx and block hash sets, as of their last change; safe from any thread
+			size_t KnownInventoryMemoryUsage() const;
+
+			// bytes queued for sending that the socket hasn't taken yet
+			size_t GetSendQueueBytes() const;
+
+			size_t GetSendQueuePeakBytes() const;
+
+			// times the send queue grew past SEND_QUEUE_HIGH_WATER
+			uint64_t GetSendQueueCongestedCount() const;
+
 			bool IsIPv4() const;
 
 			double GetStartTime() const;
@@ -363,13 +398,44 @@ namespace Elastos {
 
 			void InitSingleMessage(Message *message);
 
+			// send getdata for the free part of the block window, and getblocks if the queue is about to drain
+			void FillBlockWindow();
+
 			bool NetworkIsReachable() const;
 
-			bool AcceptMessage(const bytes_t &msg, const std::string &type);
+			bool AcceptMessage(const ByteStream &msg, const std::string &type);
+
+			// the handlers below run on the peer's strand of PeerReactor
+			void OpenSocket();
+
+			void OnConnected(const boost::system::error_code &ec);
+
+			void Read();
+
+			void OnRead(const boost::system::error_code &ec, size_t bytes);
+
+			// parse and accept every complete message in the receive buffer, returns the socket error if any
+			int ProcessMessages();
 
-			int OpenSocket(int domain, double timeout, int *error);
+			// write as much of the send queue as the socket takes without blocking, and wait for it to become
+			// writable if anything is left, returns the socket error if any; called with _sendLock held
+			int FlushSendQueue();
 
-			void PeerThreadRoutine();
+			void WaitWritable();
+
+			void OnWritable(const boost::system::error_code &ec);
+
+			void ScheduleTimer();
+
+			void OnTimer(const boost::system::error_code &ec);
+
+			void CloseSocket(int error);
+
+			// re-arm the timer from any thread if @time is earlier than what it's currently waiting for
+			void RescheduleTimer(double time);
+
+			// called after the known tx or block hashes change
+			void UpdateKnownInventoryMemoryUsage();
 
 		private:
 			friend class Message;
@@ -392,10 +458,26 @@ namespace Elastos {
 			bool _sentVerack, _gotVerack, _sentGetaddr, _sentFilter, _sentGetdata, _sentMempool, _sentGetblocks, _waitingBlocks;
 			uint256 _lastBlockHash;
 			MerkleBlockPtr _currentBlock;
-			std::vector<uint256> _currentBlockTxHashes, _knownBlockHashes, _knownTxHashes;
-			std::set<uint256> _knownTxHashSet;
+			std::vector<uint256> _currentBlockTxHashes;
+			KnownInventory _knownBlockHashes, _knownTxHashes;
+			std::atomic<size_t> _knownInventoryMemory;
 			volatile int _socket;
 
+			boost::asio::io_service::strand _strand;
+			boost::asio::ip::tcp::socket _connection;
+			boost::asio::deadline_timer _timer;
+			std::atomic<double> _timerTime; // set on the strand, compared from any thread by RescheduleTimer
+			double _msgTimeout;
+			bool _ioActive;
+			ReceiveBuffer _recvBuffer;
+			size_t _recvWanted; // bytes needed in _recvBuffer to complete the current message
+			mutable boost::mutex _sendLock;
+			SendQueue _sendQueue;
+			double _sendTimeout; // guarded by _sendLock, like the queue it times
+			bool _writeWaiting;
+			boost::mutex _blockWindowLock;
+			BlockDownloadWindow _blockWindow;
+
 			PeerCallback _mempoolCallback;
 			std::deque<PeerCallback> _pongCallbackList;
 
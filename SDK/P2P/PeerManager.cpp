@@ -3,9 +3,11 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "PeerManager.h"
+#include "PeerReactor.h"
 #include "Message/PingMessage.h"
 #include "Message/GetBlocksMessage.h"
 #include "Message/FilterLoadMessage.h"
+#include "Message/FilterAddMessage.h"
 #include "Message/MempoolMessage.h"
 #include "Message/GetDataMessage.h"
 #include "Message/InventoryMessage.h"
@@ -20,76 +22,96 @@
 #include <Wallet/Wallet.h>
 #include <P2P/ChainParams.h>
 
-#include <netdb.h>
 #include <netinet/in.h>
+#include <sys/time.h>
 #include <boost/bind.hpp>
 #include <boost/thread.hpp>
 #include <arpa/inet.h>
 
-#define PROTOCOL_TIMEOUT      40.0
-#define MAX_CONNECT_FAILURES  1000 // notify user of network problems after this many connect failures in a row
-#define PEER_FLAG_SYNCED      0x01
-#define PEER_FLAG_NEEDSUPDATE 0x02
+#define PROTOCOL_TIMEOUT       40.0
+#define MAX_CONNECT_FAILURES   1000 // notify user of network problems after this many connect failures in a row
+#define PEER_FLAG_SYNCED       0x01
+#define PEER_FLAG_NEEDSUPDATE  0x02
+#define BLOOM_FILTER_SPARE     100 // room for elements added with filteradd before the filter degrades
+#define BLOOM_FILTER_MAX_SPARE 10000
+#define POW_LIMIT              0x207fffff // 2^255 - 1, the main and test net proof of work limit, in compact form
+#define BLOOM_FILTER_MAX_ADDS  20 // more new elements than this are sent with a filterload instead of a filteradd each
 
 namespace Elastos {
 	namespace ElaWallet {
 
+		static double CurrentTime() {
+			struct timeval tv;
+			gettimeofday(&tv, NULL);
+			return tv.tv_sec + (double) tv.tv_usec / 1000000;
+		}
+
 		void PeerManager::FireSyncStarted() {
+			SyncMetrics::Timer timer(_syncMetrics, SyncMetrics::ListenerDispatch);
 			if (!_listener.expired()) {
 				_listener.lock()->syncStarted();
 			}
 		}
 
-		void PeerManager::FireSyncProgress(double progress, const PeerPtr &peer, const MerkleBlockPtr &block) {
-			struct timeval tv;
-			gettimeofday(&tv, NULL);
-
-			uint64_t now = tv.tv_sec * 1000 + tv.tv_usec / 1000;
-			uint64_t milliseconds = now - peer->GetDownloadStartTime();
-			uint32_t bytesPerSecond = 0;
-
-			if (milliseconds != 0)
-				bytesPerSecond = peer->GetDownloadBytes() * 1000 / milliseconds;
-
-			peer->ScheduleDownloadStartTime();
-			peer->SetDownloadBytes(0);
-
+		void PeerManager::FireSyncProgress(double progress, uint32_t bytesPerSecond, const PeerPtr &peer,
+										   const MerkleBlockPtr &block) {
+			SyncMetrics::Timer timer(_syncMetrics, SyncMetrics::ListenerDispatch);
 			if (!_listener.expired()) {
 				_listener.lock()->syncProgress((uint32_t)(progress * 100), block->GetTimestamp(), bytesPerSecond, peer->GetHost());
 			}
 		}
 
 		void PeerManager::FireSyncStopped(int error) {
+			SyncMetrics::Timer timer(_syncMetrics, SyncMetrics::ListenerDispatch);
 			if (!_listener.expired()) {
 				_listener.lock()->syncStopped(error == 0 ? "" : strerror(error));
 			}
 		}
 
 		void PeerManager::FireTxStatusUpdate() {
+			SyncMetrics::Timer timer(_syncMetrics, SyncMetrics::ListenerDispatch);
 			if (!_listener.expired()) {
 				_listener.lock()->txStatusUpdate();
 			}
 		}
 
 		void PeerManager::FireSaveBlocks(bool replace, const std::vector<MerkleBlockPtr> &blocks) {
+			SyncMetrics::Timer timer(_syncMetrics, SyncMetrics::ListenerDispatch);
 			if (!_listener.expired()) {
 				_listener.lock()->saveBlocks(replace, blocks);
 			}
 		}
 
 		void PeerManager::FireSavePeers(bool replace, const std::vector<PeerInfo> &peers) {
+			SyncMetrics::Timer timer(_syncMetrics, SyncMetrics::ListenerDispatch);
 			if (!_listener.expired()) {
 				_listener.lock()->savePeers(replace, peers);
 			}
 		}
 
 		void PeerManager::FireSaveBlackPeer(const PeerInfo &peer) {
+			SyncMetrics::Timer timer(_syncMetrics, SyncMetrics::ListenerDispatch);
 			if (!_listener.expired()) {
 				_listener.lock()->saveBlackPeer(peer);
 			}
 		}
 
+		void PeerManager::FireSavePeerScores(const std::vector<PeerScore> &scores) {
+			SyncMetrics::Timer timer(_syncMetrics, SyncMetrics::ListenerDispatch);
+			if (!_listener.expired()) {
+				_listener.lock()->savePeerScores(scores);
+			}
+		}
+
+		void PeerManager::FireSaveSeedPeers(const std::string &seed, const std::vector<PeerInfo> &peers) {
+			SyncMetrics::Timer timer(_syncMetrics, SyncMetrics::ListenerDispatch);
+			if (!_listener.expired()) {
+				_listener.lock()->saveSeedPeers(seed, peers);
+			}
+		}
+
 		bool PeerManager::FireNetworkIsReachable() {
+			SyncMetrics::Timer timer(_syncMetrics, SyncMetrics::ListenerDispatch);
 			bool result = false;
 			if (!_listener.expired()) {
 				result = _listener.lock()->networkIsReachable();
@@ -98,6 +120,7 @@ namespace Elastos {
 		}
 
 		void PeerManager::FireTxPublished(const uint256 &hash, int code, const std::string &reason) {
+			SyncMetrics::Timer timer(_syncMetrics, SyncMetrics::ListenerDispatch);
 			nlohmann::json result;
 			result["Code"] = code;
 			result["Reason"] = reason;
@@ -109,6 +132,7 @@ namespace Elastos {
 		}
 
 		void PeerManager::FireConnectStatusChanged(Peer::ConnectStatus status) {
+			SyncMetrics::Timer timer(_syncMetrics, SyncMetrics::ListenerDispatch);
 			if (!_listener.expired()) {
 				std::string st = status == Peer::Connecting ? "Connecting" :
 								 (status == Peer::Connected ? "Connected" : "Disconnected");
@@ -131,10 +155,14 @@ namespace Elastos {
 								 const std::vector<MerkleBlockPtr> &blocks,
 								 const std::vector<PeerInfo> &peers,
 								 const std::set<PeerInfo> &blackPeers,
+								 const std::vector<PeerScore> &peerScores,
+								 const SeedPeerMap &seedPeers,
 								 const boost::shared_ptr<PeerManager::Listener> &listener,
 								 const std::string &chainID,
 								 const std::string &netType) :
 				_wallet(wallet),
+				_blocks([chainID]() { return Registry::Instance()->CreateMerkleBlock(chainID); }),
+				_checkpoints([chainID]() { return Registry::Instance()->CreateMerkleBlock(chainID); }),
 				_lastBlock(nullptr),
 				_lastOrphan(nullptr),
 				_chainID(chainID),
@@ -147,8 +175,7 @@ namespace Elastos {
 				_isConnected(0),
 				_connectFailureCount(0),
 				_misbehavinCount(0),
-				_dnsThreadCount(0),
-				_maxConnectCount(PEER_MAX_CONNECTIONS),
+				_maxConnectCount(params->MaxConnections()),
 				_connectStatus(Peer::Disconnected),
 
 				_keepAliveTimestamp(0),
@@ -158,20 +185,41 @@ namespace Elastos {
 				_filterUpdateHeight(0),
 				_estimatedHeight(0),
 
+				_isSideWallet(false),
+				_bloomFilterElements(0),
+				_bloomFilterCapacity(0),
+				_bloomFilterSpare(BLOOM_FILTER_SPARE),
+				_bloomFilterRebuilds(0),
+				_bloomFilterAdds(0),
 				_fpRate(0),
-				_averageTxPerBlock(1400) {
+				_averageTxPerBlock(1400),
+				_parallelSync(false),
+				_syncTimer(0),
+				_downloadPeerTime(0),
+				_downloadPeerSwitches(0),
+				_reconnectTimer(0),
+				_reconnectPending(false),
+				_reconnectDelay(0),
+				_seedTimer(0),
+				_timersStopped(false) {
 
 			assert(listener != nullptr);
 			_listener = boost::weak_ptr<Listener>(listener);
 
 			_peers = peers;
 			_blackPeers.insert(blackPeers.begin(), blackPeers.end());
+			_peerScores.Load(peerScores, time(NULL));
+			_seedResolver.Load(seedPeers, time(NULL));
 			SortPeers();
 
 			InitBlocks(blocks);
 		}
 
 		void PeerManager::InitBlocks(const std::vector<MerkleBlockPtr> &blocks) {
+			struct timeval tv;
+			gettimeofday(&tv, NULL);
+			uint64_t startTime = tv.tv_sec * 1000 + tv.tv_usec / 1000;
+
 			const std::vector<CheckPoint> &Checkpoints = _chainParams->Checkpoints();
 			for (size_t i = 0; i < Checkpoints.size(); i++) {
 				MerkleBlockPtr checkBlock = Registry::Instance()->CreateMerkleBlock(_chainID);
@@ -181,15 +229,22 @@ namespace Elastos {
 				checkBlock->SetTarget(Checkpoints[i].Target());
 				_checkpoints.Insert(checkBlock);
 				_blocks.Insert(checkBlock);
+				// checkpoints are only headers, there's nothing to keep besides the index record
+				_checkpoints.Compact(checkBlock->GetHash());
+				_blocks.Compact(checkBlock->GetHash());
 				if (i == 0 || checkBlock->GetTimestamp() + 1 * 24 * 60 * 60 < _earliestKeyTime)
 					_lastBlock = checkBlock;
 			}
 
+			// link stored blocks by previous block hash, so the chain can be rebuilt in a single pass, keeping
+			// every child of a fork
+			typedef std::unordered_multimap<uint256, MerkleBlockPtr, uint256Hasher> NextBlockMap;
+			NextBlockMap nextBlocks(blocks.size());
 			MerkleBlockPtr block = nullptr, earlistBlock = nullptr;
 			for (size_t i = 0; i < blocks.size(); i++) {
 				assert(blocks[i]->GetHeight() !=
 					   BLOCK_UNKNOWN_HEIGHT); // height must be saved/restored along with serialized block
-				_orphans.Insert(blocks[i]);
+				nextBlocks.insert(std::make_pair(blocks[i]->GetPrevBlockHash(), blocks[i]));
 
 				if ((blocks[i]->GetHeight() % BLOCK_DIFFICULTY_INTERVAL) == 0 &&
 					(block == nullptr || blocks[i]->GetHeight() > block->GetHeight()))
@@ -201,21 +256,62 @@ namespace Elastos {
 			if (block == nullptr)
 				block = earlistBlock;
 
-			while (block != nullptr) {
-				_blocks.Insert(block);
+			// the last block is the highest one linked, whichever branch of a fork it is on
+			size_t chainCount = 0;
+			std::vector<MerkleBlockPtr> linked;
+			if (block != nullptr) {
 				_lastBlock = block;
-				_orphans.Remove(block);
-				block = _orphans.GetMatchPrevHash(block->GetHash());
+				linked.push_back(block);
+			}
+			while (!linked.empty()) {
+				block = linked.back();
+				linked.pop_back();
+				_blocks.Insert(block);
+				chainCount++;
+				if (block->GetHeight() > _lastBlock->GetHeight())
+					_lastBlock = block;
+
+				std::pair<NextBlockMap::iterator, NextBlockMap::iterator> next = nextBlocks.equal_range(block->GetHash());
+				for (NextBlockMap::iterator it = next.first; it != next.second; ++it)
+					linked.push_back(it->second);
+				nextBlocks.erase(next.first, next.second);
 			}
+
+			gettimeofday(&tv, NULL);
+			uint64_t elapsed = tv.tv_sec * 1000 + tv.tv_usec / 1000 - startTime;
+			if (_lastBlock == nullptr) // no checkpoints configured, and nothing stored
+				Log::warn("{} has no checkpoint or stored block to start the chain from", _chainID);
+			Log::info("{} init {} stored block(s), {} linked, last block #{}, took {} ms", _chainID, blocks.size(),
+					  chainCount, _lastBlock ? _lastBlock->GetHeight() : 0, elapsed);
 		}
 
 		PeerManager::~PeerManager() {
+			_seedResolver.Cancel();
+
+			{
+				// a task already running may not schedule another one that would outlive this
+				boost::mutex::scoped_lock scopedLock(lock);
+				_timersStopped = true;
+				PeerReactor::Instance()->Cancel(_syncTimer);
+				PeerReactor::Instance()->Cancel(_reconnectTimer);
+				PeerReactor::Instance()->Cancel(_seedTimer);
+			}
+
+			// and one that was taken off the timer queue before the cancel still uses this until it returns
+			PeerReactor::Instance()->WaitForRunningTask();
+
+			// only now, a task still running above may have posted to it
+			_walletApply.Stop();
 		}
 
 		void PeerManager::SetWallet(const WalletPtr &wallet) {
 			_wallet = wallet;
 		}
 
+		void PeerManager::SetDNSResolver(const DNSResolverPtr &resolver) {
+			_seedResolver.SetResolver(resolver);
+		}
+
 		Peer::ConnectStatus PeerManager::GetConnectStatusInternal() const {
 			Peer::ConnectStatus status = Peer::Disconnected;
 			if (_isConnected != 0) status = Peer::Connected;
@@ -275,8 +371,10 @@ namespace Elastos {
 				time_t now = time(NULL);
 				std::vector<PeerInfo> peers;
 
-				if (_peers.size() < _maxConnectCount ||
-					_peers[_maxConnectCount - 1].Timestamp + 60 * 24 * 60 * 60 < now) {
+				size_t freshPeers = std::count_if(_peers.begin(), _peers.end(), [now](const PeerInfo &p) {
+					return p.Timestamp + 60 * 24 * 60 * 60 >= (uint64_t) now;
+				});
+				if (freshPeers < _maxConnectCount) {
 					FindPeers();
 				}
 
@@ -285,7 +383,7 @@ namespace Elastos {
 				while (!peers.empty() && _connectedPeers.size() < _maxConnectCount) {
 					size_t i = BRRand((uint32_t) peers.size()); // index of random peer
 
-					i = i * i / peers.size(); // bias random peer selection toward peers with more recent timestamp
+					i = i * i / peers.size(); // bias random peer selection toward peers with a better score
 
 					for (size_t j = _connectedPeers.size(); i != SIZE_MAX && j > 0; j--) {
 						if (peers[i] != _connectedPeers[j - 1]->GetPeerInfo()) continue;
@@ -298,6 +396,8 @@ namespace Elastos {
 						newPeer->InitDefaultMessages();
 						newPeer->SetPeerInfo(peers[i]);
 						newPeer->setEarliestKeyTime(_earliestKeyTime);
+						newPeer->SetMaxBlocksInFlight(_chainParams->MaxBlocksInFlight());
+						newPeer->SetMaxKnownInventory(_chainParams->MaxKnownInventory());
 						peers.erase(peers.begin() + i);
 
 						_connectedPeers.push_back(newPeer);
@@ -312,7 +412,10 @@ namespace Elastos {
 				connectionStatusChanged = true;
 			}
 
-			if (_connectedPeers.empty()) {
+			if (_connectedPeers.empty() && _seedResolver.Pending(time(NULL)) > 0) {
+				Log::info("{} waiting for dns seeds", GetID());
+				lock.unlock();
+			} else if (_connectedPeers.empty()) {
 				Log::error("{} sync failed: {}", GetID(), std::string(strerror(ENETUNREACH)));
 				SyncStopped();
 				lock.unlock();
@@ -324,38 +427,24 @@ namespace Elastos {
 			if (connectionStatusChanged) FireConnectStatusChanged(status);
 		}
 
-		void PeerManager::AsyncConnect(const boost::system::error_code &e) {
-			if (e != boost::asio::error::operation_aborted) {
-				if (GetConnectStatus() != Peer::Connected)
-					Connect();
-			} else {
-				Log::warn("{} async connect err.value: {} err.msg: {}", GetID(), e.value(), e.message());
-			}
+		void PeerManager::AsyncConnect() {
+			if (GetConnectStatus() != Peer::Connected)
+				Connect();
 		}
 
 		void PeerManager::ConnectLaster(time_t seconds) {
-			lock.lock();
+			boost::mutex::scoped_lock scopedLock(lock);
 			_enableReconnect = true;
-			lock.unlock();
 
-			if (_reconnectTimer) {
-				_reconnectTimer->expires_from_now(boost::posix_time::seconds(seconds));
-				_reconnectService.restart();
-			} else {
-				_reconnectTimer = boost::shared_ptr<boost::asio::deadline_timer>(new boost::asio::deadline_timer(
-					_reconnectService, boost::posix_time::seconds(seconds)));
-			}
-
-			Log::debug("{} connect {} seconds later", GetID(), seconds);
-			_reconnectTimer->async_wait(boost::bind(&PeerManager::AsyncConnect, this, boost::asio::placeholders::error));
-			_reconnectService.run();
+			ResetTimer(_reconnectTimer, seconds, boost::bind(&PeerManager::AsyncConnect, this));
+			Log::debug("{} connect {} seconds later, {} timer(s) pending", GetID(), seconds,
+					   PeerReactor::Instance()->PendingTimers());
 		}
 
 		void PeerManager::CancelTimer() {
 			boost::mutex::scoped_lock scopedLock(lock);
-			if (_reconnectTimer) {
-				_reconnectTimer->cancel();
-			}
+			_reconnectPending = false;
+			PeerReactor::Instance()->Cancel(_reconnectTimer);
 		}
 
 		void PeerManager::ClearData() {
@@ -369,21 +458,62 @@ namespace Elastos {
 			_connectedPeers.clear();
 			_syncStartHeight = 0;
 			_fpRate = 0;
+			_bloomFilterSpare = BLOOM_FILTER_SPARE;
 			_averageTxPerBlock = 1400;
 			_blocks.Clear();
 			_orphans.Clear();
 			_checkpoints.Clear();
-			_txRelays.clear();
-			_txRequests.clear();
-			_publishedTx.clear();
-			_publishedTxHashes.clear();
+			_txRelays.Clear();
+			_txRequests.Clear();
+			_publishedTx.Clear();
 
 			InitBlocks({});
 		}
 
-		void PeerManager::ReconnectLaster(time_t seconds) {
-			Disconnect();
-			ConnectLaster(seconds);
+		void PeerManager::ScheduleReconnect(time_t seconds) {
+			bool connect;
+
+			lock.lock();
+			_enableReconnect = false;
+			_reconnectPending = false;
+			PeerReactor::Instance()->Cancel(_seedTimer);
+			PeerReactor::Instance()->Cancel(_reconnectTimer);
+			lock.unlock();
+
+			// lookups still running only fill the seed cache from now on
+			_seedResolver.Cancel();
+
+			// nothing waits for the peers to go away here, OnDisconnected connects again once the last one has
+			lock.lock();
+			connect = _connectedPeers.empty();
+			if (!connect) {
+				_reconnectPending = true;
+				_reconnectDelay = seconds;
+			}
+
+			for (size_t i = _connectedPeers.size(); i > 0; i--) {
+				_connectedPeers[i - 1]->Disconnect();
+			}
+			lock.unlock();
+
+			if (connect) ConnectLaster(seconds);
+		}
+
+		uint32_t PeerManager::TakeDownloadRate(const PeerPtr &peer) {
+			struct timeval tv;
+			gettimeofday(&tv, NULL);
+
+			uint64_t now = tv.tv_sec * 1000 + tv.tv_usec / 1000;
+			uint64_t milliseconds = now - peer->GetDownloadStartTime();
+			uint32_t bytesPerSecond = 0;
+
+			if (milliseconds != 0)
+				bytesPerSecond = peer->GetDownloadBytes() * 1000 / milliseconds;
+
+			peer->ScheduleDownloadStartTime();
+			peer->SetDownloadBytes(0);
+
+			return bytesPerSecond;
 		}
 
 		double PeerManager::GetSyncProgressInternal(uint32_t startHeight) {
@@ -407,35 +537,23 @@ namespace Elastos {
 		}
 
 		void PeerManager::Disconnect() {
-			struct timespec ts;
-			size_t peerCount = 0;
-			int dnsThreadCount;
-
 			lock.lock();
 			_enableReconnect = false;
+			_reconnectPending = false;
+			PeerReactor::Instance()->Cancel(_seedTimer);
 			lock.unlock();
 
-			usleep(1000);
-
-			lock.lock();
-			peerCount = _connectedPeers.size();
-			dnsThreadCount = _dnsThreadCount;
+			// lookups still running only fill the seed cache from now on
+			_seedResolver.Cancel();
 
-			for (size_t i = peerCount; i > 0; i--) {
+			boost::mutex::scoped_lock scopedLock(lock);
+			for (size_t i = _connectedPeers.size(); i > 0; i--) {
 				_connectedPeers[i - 1]->Disconnect();
 			}
-			lock.unlock();
 
-			ts.tv_sec = 0;
-			ts.tv_nsec = 1000;
-
-			while (peerCount > 0 || dnsThreadCount > 0) {
-				nanosleep(&ts, NULL); // pthread_yield() isn't POSIX standard :(
-				lock.lock();
-				peerCount = _connectedPeers.size();
-				dnsThreadCount = _dnsThreadCount;
-				lock.unlock();
-			}
+			// OnDisconnected removes each peer and signals once none is left
+			while (!_connectedPeers.empty())
+				_peersDisconnected.wait(scopedLock);
 		}
 
 		void PeerManager::Rescan() {
@@ -484,6 +602,11 @@ namespace Elastos {
 			return _lastBlock->GetHeight();
 		}
 
+		size_t PeerManager::GetBlockCount() const {
+			boost::mutex::scoped_lock scoped_lock(lock);
+			return _blocks.Size();
+		}
+
 		uint32_t PeerManager::GetLastBlockTimestamp() const {
 			uint32_t timestamp;
 
@@ -521,12 +644,12 @@ namespace Elastos {
 
 			{
 				boost::mutex::scoped_lock scoped_lock(lock);
-				_maxConnectCount = (addrList[0] == 0) ? PEER_MAX_CONNECTIONS : 1;
+				_maxConnectCount = (addrList[0] == 0) ? _chainParams->MaxConnections() : 1;
 				_fixedPeer = PeerInfo(addrList[0], port, 0, 0);
 				_peers.clear();
 			}
 
-			boost::thread workThread(boost::bind(&PeerManager::ReconnectLaster, this, 1));
+			ScheduleReconnect(1);
 			return true;
 		}
 
@@ -552,6 +675,16 @@ namespace Elastos {
 			return _downloadPeer;
 		}
 
+		uint64_t PeerManager::GetBloomFilterRebuildCount() const {
+			boost::mutex::scoped_lock scoped_lock(lock);
+			return _bloomFilterRebuilds;
+		}
+
+		uint64_t PeerManager::GetBloomFilterAddCount() const {
+			boost::mutex::scoped_lock scoped_lock(lock);
+			return _bloomFilterAdds;
+		}
+
 		size_t PeerManager::GetPeerCount() const {
 			size_t count = 0;
 
@@ -625,143 +758,47 @@ namespace Elastos {
 
 			{
 				boost::mutex::scoped_lock scoped_lock(lock);
-				for (size_t i = _txRelays.size(); i > 0; i--) {
-					if (_txRelays[i - 1].GetTransactionHash() != txHash)
-						continue;
-					count = _txRelays[i - 1].GetPeers().size();
-					break;
-				}
+				count = _txRelays.PeerCount(txHash);
 			}
 
 			return count;
 		}
 
-		int PeerManager::VerifyDifficulty(const ChainParamsPtr &params, const MerkleBlockPtr &block,
-										  const BlockSet &blockSet) {
-			MerkleBlockPtr previous, b = nullptr;
-			uint32_t i;
-			const uint32_t &targetTimeSpan = params->TargetTimeSpan();
-			const uint32_t &targetTimePerBlock = params->TargetTimePerBlock();
-
-			assert(block != nullptr);
-
-			uint64_t blocksPerRetarget = targetTimeSpan / targetTimePerBlock;
+		size_t PeerManager::GetTxRelaysSize() const {
+			boost::mutex::scoped_lock scoped_lock(lock);
+			return _txRelays.Size();
+		}
 
-			// check if we hit a difficulty transition, and find previous transition block
-			if ((block->GetHeight() % blocksPerRetarget) == 0) {
-				for (i = 0, b = block; b && i < blocksPerRetarget; i++) {
-					b = blockSet.Get(b->GetPrevBlockHash());
-				}
-			}
+		size_t PeerManager::GetTxRequestsSize() const {
+			boost::mutex::scoped_lock scoped_lock(lock);
+			return _txRequests.Size();
+		}
 
-			previous = blockSet.Get(block->GetPrevBlockHash());
-			return VerifyDifficultyInner(block, previous, (b != nullptr) ? b->GetTimestamp() : 0, targetTimeSpan,
-										 targetTimePerBlock);
+		size_t PeerManager::GetPublishedTxSize() const {
+			boost::mutex::scoped_lock scoped_lock(lock);
+			return _publishedTx.Size();
 		}
 
-		int PeerManager::VerifyDifficultyInner(const MerkleBlockPtr &block, const MerkleBlockPtr &previous,
-											   uint32_t transitionTime, uint32_t targetTimeSpan,
-											   uint32_t targetTimePerBlock) {
-			int r = 1;
+		void PeerManager::CollectBloomFilterElements() {
+			uint32_t lastBlockHeight;
+			std::vector<bytes_t> elements;
 
-//			assert(block != nullptr);
-//			assert(previous != nullptr);
-//
-//			uint64_t blocksPerRetarget = targetTimeSpan / targetTimePerBlock;
-//
-//			if (!previous || !uint256Eq(&(block->GetPrevBlockHash()), &(previous->GetHash())) ||
-//				block->GetHeight() != previous->GetHeight() + 1)
-//				r = 0;
-//			if (r && (block->GetHeight() % blocksPerRetarget) == 0 && transitionTime == 0) r = 0;
-//
-//			if (r && (block->GetHeight() % blocksPerRetarget) == 0) {
-//				uint32_t timespan = previous->GetTimestamp() - transitionTime;
-//
-//				arith_uint256 target;
-//				target.SetCompact(previous->GetTarget());
-//
-				// limit difficulty transition to -75% or +400%
-//				if (timespan < targetTimeSpan / 4) timespan = uint32_t(targetTimeSpan) / 4;
-//				if (timespan > targetTimeSpan * 4) timespan = uint32_t(targetTimeSpan) * 4;
-
-				// TARGET_TIMESPAN happens to be a multiple of 256, and since timespan is at least TARGET_TIMESPAN/4, we don't
-				// lose precision when target is multiplied by timespan and then divided by TARGET_TIMESPAN/256
-//				target *= timespan;
-//				target /= targetTimeSpan;
-
-//				uint32_t actualTargetCompact = target.GetCompact();
-//				if (block->GetTarget() != actualTargetCompact) r = 0;
-//			} else if (r && previous->GetHeight() != 0 && block->GetTarget() != previous->GetTarget()) r = 0;
-//
-			return r;
-		}
+			{
+				boost::mutex::scoped_lock scopedLock(lock);
+				lastBlockHeight = _lastBlock->GetHeight();
+			}
 
-		void PeerManager::LoadBloomFilter(const PeerPtr &peer) {
 			// every time a new wallet address is added, the bloom filter has to be rebuilt, and each address is only used
 			// for one transaction, so here we generate some spare addresses to avoid rebuilding the filter each time a
 			// wallet transaction is encountered during the chain sync
 			_wallet->UnusedAddresses(SEQUENCE_GAP_LIMIT_EXTERNAL + 100, 0);
 			_wallet->UnusedAddresses(SEQUENCE_GAP_LIMIT_INTERNAL + 100, 1);
 
-			_orphans.Clear(); // clear out orphans that may have been received on an old filter
-			_lastOrphan = nullptr;
-			_filterUpdateHeight = _lastBlock->GetHeight();
-			_fpRate = BLOOM_REDUCED_FALSEPOSITIVE_RATE;
+			_wallet->GetBloomFilterElements(elements);
 
-			AddressArray specialAddresses = _wallet->GetAllSpecialAddresses();
-
-			AddressArray addrs, addrInternal, allCID;
-			_wallet->GetAllAddresses(addrs, 0, UINT32_MAX, false);
-			_wallet->GetAllAddresses(addrInternal, 0, UINT32_MAX, true);
-			addrs.insert(addrs.end(), addrInternal.begin(), addrInternal.end());
-			_wallet->GetAllCID(allCID, 0, UINT32_MAX);
-
-			UTXOArray utxos = _wallet->GetAllUTXO("");
-			uint32_t blockHeight = (_lastBlock->GetHeight() > 100) ? _lastBlock->GetHeight() - 100 : 0;
+			uint32_t blockHeight = (lastBlockHeight > 100) ? lastBlockHeight - 100 : 0;
 
 			std::vector<TransactionPtr> transactions = _wallet->TxUnconfirmedBefore(blockHeight);
-
-			size_t elementCount = specialAddresses.size() + addrs.size() + allCID.size() +
-				utxos.size() + transactions.size();
-
-			bool is_side_wallet = addrs.size() == 1 && addrs[0]->ProgramHash().prefix() == PrefixCrossChain;
-			uint32_t tweak = is_side_wallet ? UINT32_MAX : (uint32_t) peer->GetPeerInfo().GetHash();
-			BloomFilterPtr filter = BloomFilterPtr(new BloomFilter(_fpRate, elementCount + 100, tweak,
-																   BLOOM_UPDATE_ALL)); // BUG: XXX txCount not the same as number of spent wallet outputs
-
-			bytes_t hash;
-
-			for (size_t i = 0; i < specialAddresses.size(); ++i) {
-				if (specialAddresses[i]->Valid()) {
-					hash = specialAddresses[i]->ProgramHash().bytes();
-					if (!filter->ContainsData(hash))
-						filter->InsertData(hash);
-				}
-			}
-
-			for (size_t i = 0; i < addrs.size(); i++) { // add addresses to watch for tx receiveing money to the wallet
-				if (addrs[i]->Valid()) {
-					hash = addrs[i]->ProgramHash().bytes();
-					if (!filter->ContainsData(hash))
-						filter->InsertData(hash);
-				}
-			}
-
-			for (size_t i = 0; i < allCID.size(); ++i) {
-				hash = allCID[i]->ProgramHash().bytes();
-				if (!filter->ContainsData(hash)) {
-					filter->InsertData(hash);
-				}
-			}
-
-			for (size_t i = 0; i < utxos.size(); i++) { // add UTXOs to watch for tx sending money from the wallet
-				bytes_t o = utxos[i]->Hash().bytes();
-				o.append(utxos[i]->Index());
-
-				if (!filter->ContainsData(o))
-					filter->InsertData(o);
-			}
-
 			for (size_t i = 0; i < transactions.size(); i++) { // also add TXOs spent within the last 100 blocks
 				const InputArray &inputs = transactions[i]->GetInputs();
 				for (InputArray::const_iterator in = inputs.cbegin(); in != inputs.cend(); ++in) {
@@ -771,14 +808,42 @@ namespace Elastos {
 						if (output && _wallet->ContainsAddress(output->Addr())) {
 							bytes_t o = (*in)->TxHash().bytes();
 							o.append((*in)->Index());
-							if (!filter->ContainsData(o))
-								filter->InsertData(o);
+							elements.push_back(o);
 						}
 					}
 				}
 			}
 
+			AddressArray addrs, addrInternal;
+			size_t addrCount = _wallet->GetAllAddresses(addrs, 0, 1, false) +
+							   _wallet->GetAllAddresses(addrInternal, 0, 0, true);
+			bool isSideWallet = addrCount == 1 && addrs[0]->ProgramHash().prefix() == PrefixCrossChain;
+
+			boost::mutex::scoped_lock scopedLock(lock);
+			_walletElements.swap(elements);
+			_isSideWallet = isSideWallet;
+		}
+
+		void PeerManager::LoadBloomFilter(const PeerPtr &peer) {
+			_orphans.Clear(); // clear out orphans that may have been received on an old filter
+			_lastOrphan = nullptr;
+			_filterUpdateHeight = _lastBlock->GetHeight();
+			_fpRate = BLOOM_REDUCED_FALSEPOSITIVE_RATE;
+
+			const std::vector<bytes_t> &elements = _walletElements;
+			uint32_t tweak = _isSideWallet ? UINT32_MAX : (uint32_t) peer->GetPeerInfo().GetHash();
+			BloomFilterPtr filter = BloomFilterPtr(new BloomFilter(_fpRate, elements.size() + _bloomFilterSpare, tweak,
+																   BLOOM_UPDATE_ALL));
+
+			for (size_t i = 0; i < elements.size(); ++i) {
+				if (!filter->ContainsData(elements[i]))
+					filter->InsertData(elements[i]);
+			}
+
 			_bloomFilter = filter;
+			_bloomFilterElements = elements.size();
+			_bloomFilterCapacity = elements.size() + _bloomFilterSpare;
+			_bloomFilterRebuilds++;
 			// TODO: XXX if already synced, recursively add inputs of unconfirmed receives
 			FilterLoadParameter bloomFilterParameter;
 			bloomFilterParameter.Filter = filter;
@@ -786,49 +851,83 @@ namespace Elastos {
 		}
 
 		void PeerManager::SortPeers() {
-			// comparator for sorting peers by timestamp, most recent first
-			std::sort(_peers.begin(), _peers.end(), [](const PeerInfo &first, const PeerInfo &second) {
-				return first.Timestamp > second.Timestamp;
+			// best score first, peers scoring the same (never connected to) by timestamp, most recent first
+			std::vector<std::pair<double, PeerInfo>> ranked;
+			ranked.reserve(_peers.size());
+			for (size_t i = 0; i < _peers.size(); ++i)
+				ranked.push_back(std::make_pair(_peerScores.Rank(_peers[i]), _peers[i]));
+
+			std::sort(ranked.begin(), ranked.end(), [](const std::pair<double, PeerInfo> &first,
+													   const std::pair<double, PeerInfo> &second) {
+				if (first.first != second.first)
+					return first.first > second.first;
+				return first.second.Timestamp > second.second.Timestamp;
 			});
+
+			for (size_t i = 0; i < ranked.size(); ++i)
+				_peers[i] = ranked[i].second;
 		}
 
 		void PeerManager::FindPeers() {
 			uint64_t services = SERVICES_NODE_NETWORK | SERVICES_NODE_BLOOM | _chainParams->Services();
 			time_t now = time(NULL);
-			struct timespec ts;
-
-			_peers.clear();
 
 			if (_fixedPeer.Address != 0) {
+				_peers.clear();
 				_peers.push_back(_fixedPeer);
 				_peers[0].Services = services;
 				_peers[0].Timestamp = now;
 			} else {
+				// cached seeds race with the peers we already know, the others are added as their lookups finish
 				const std::vector<std::string> &dnsSeeds = _chainParams->DNSSeeds();
-				for (size_t i = 1; i < dnsSeeds.size(); i++) {
-					boost::thread workThread(boost::bind(&PeerManager::FindPeersThreadRoutine, this, dnsSeeds[i], services));
-					_dnsThreadCount++;
+				size_t lookups = 0;
+				for (size_t i = 0; i < dnsSeeds.size(); i++) {
+					std::vector<PeerInfo> cached = _seedResolver.Cached(dnsSeeds[i], now);
+					if (!cached.empty()) {
+						AddPeers(cached, services);
+					} else if (_seedResolver.Resolve(dnsSeeds[i], _chainParams->StandardPort(), DNS_SEED_TIMEOUT,
+													 boost::bind(&PeerManager::OnSeedResolved, this, _1, _2))) {
+						lookups++;
+					}
 				}
 
-				std::vector<uint128> addrList = AddressLookup(dnsSeeds[0]);
-				for (std::vector<uint128>::iterator addr = addrList.begin();
-					 addr != addrList.end() && (*addr) != 0; addr++) {
-					_peers.emplace_back(*addr, _chainParams->StandardPort(), now, services);
+				// connect attempt without any dns seed answer in time reports the failure then
+				if (lookups > 0) {
+					ResetTimer(_seedTimer, DNS_SEED_TIMEOUT + 1, boost::bind(&PeerManager::AsyncConnect, this));
 				}
 
-				ts.tv_sec = 0;
-				ts.tv_nsec = 1;
+				Log::debug("{} found {} peers, {} dns seed lookup(s) started", GetID(), _peers.size(), lookups);
+			}
+		}
 
-				do {
-					Unlock();
-					nanosleep(&ts, NULL); // pthread_yield() isn't POSIX standard :(
-					Lock();
-				} while (_dnsThreadCount > 0 && _peers.size() < PEER_MAX_CONNECTIONS);
+		void PeerManager::AddPeers(const std::vector<PeerInfo> &peers, uint64_t services) {
+			std::set<PeerInfo> known(_peers.begin(), _peers.end());
 
-				SortPeers();
+			for (size_t i = 0; i < peers.size(); ++i) {
+				if (_blackPeers.find(peers[i]) == _blackPeers.end() && known.insert(peers[i]).second) {
+					_peers.push_back(peers[i]);
+					_peers.back().Services = services;
+				}
+			}
 
-				Log::debug("{} found {} peers", GetID(), _peers.size());
+			SortPeers();
+		}
+
+		void PeerManager::OnSeedResolved(const std::string &seed, const std::vector<PeerInfo> &peers) {
+			uint64_t services = SERVICES_NODE_NETWORK | SERVICES_NODE_BLOOM | _chainParams->Services();
+			bool connect;
+
+			{
+				boost::mutex::scoped_lock scopedLock(lock);
+				Log::debug("{} dns seed {} returned {} peer(s)", GetID(), seed, peers.size());
+
+				if (_fixedPeer.Address == 0)
+					AddPeers(peers, services);
+				connect = _enableReconnect && _connectedPeers.size() < _maxConnectCount;
 			}
+
+			if (!peers.empty()) FireSaveSeedPeers(seed, peers);
+			if (connect) AsyncConnect();
 		}
 
 		void PeerManager::SyncStopped() {
@@ -836,22 +935,96 @@ namespace Elastos {
 
 			if (_downloadPeer != nullptr) {
 				// don't cancel timeout if there's a pending tx publish callback
-				for (size_t i = _publishedTx.size(); i > 0; i--) {
-					if (_publishedTx[i - 1].HasCallback()) return;
-				}
+				if (_publishedTx.HasPendingCallbacks()) return;
 
 				_downloadPeer->ScheduleDisconnect(-1); // cancel sync timeout
 			}
 		}
 
+		void PeerManager::StartParallelSync() {
+			_syncScheduler.Clear();
+			_syncBlocks.Clear();
+			_parallelSync = _maxConnectCount > 1;
+			if (!_parallelSync) return;
+
+			// other peers need the bloom filter before they can send merkleblocks
+			for (size_t i = _connectedPeers.size(); i > 0; i--) {
+				const PeerPtr &p = _connectedPeers[i - 1];
+				if (p == _downloadPeer || p->GetConnectStatus() != Peer::Connected) continue;
+
+				p->CancelBlockRequests();
+				if (!p->SentFilter()) LoadBloomFilter(p);
+			}
+
+			ResetTimer(_syncTimer, BLOCK_RANGE_TIMEOUT / 3, boost::bind(&PeerManager::OnSyncTimer, this));
+		}
+
+		void PeerManager::StopParallelSync() {
+			if (!_parallelSync) return;
+
+			_parallelSync = false;
+			for (size_t i = _connectedPeers.size(); i > 0; i--) {
+				const PeerPtr &p = _connectedPeers[i - 1];
+				if (p != _downloadPeer && _syncScheduler.IsAssigned(p->GetPeerInfo()))
+					p->CancelBlockRequests();
+			}
+
+			_syncScheduler.Clear();
+			_syncBlocks.Clear();
+
+			PeerReactor::Instance()->Cancel(_syncTimer);
+		}
+
+		void PeerManager::AssignSyncRanges() {
+			if (!_parallelSync || !_downloadPeer) return;
+
+			double now = CurrentTime();
+			std::vector<PeerInfo> stalled = _syncScheduler.Stalled(now, BLOCK_RANGE_TIMEOUT);
+
+			for (size_t i = _connectedPeers.size(); i > 0; i--) {
+				const PeerPtr &p = _connectedPeers[i - 1];
+				if (std::find(stalled.begin(), stalled.end(), p->GetPeerInfo()) == stalled.end()) continue;
+
+				// the download peer is covered by the sync timeout
+				p->warn("no merkleblock for {}s, block range handed to another peer", BLOCK_RANGE_TIMEOUT);
+				p->CancelBlockRequests();
+				if (p != _downloadPeer) p->Disconnect();
+			}
+
+			for (size_t i = 0; i < _connectedPeers.size() && _syncBlocks.Size() < BLOCK_RANGE_MAX_AHEAD; i++) {
+				const PeerPtr &p = _connectedPeers[i];
+				if (p->GetConnectStatus() != Peer::Connected || !p->SentFilter() || p->NeedsFilterUpdate() ||
+					std::find(stalled.begin(), stalled.end(), p->GetPeerInfo()) != stalled.end())
+					continue;
+
+				std::vector<uint256> blockHashes = _syncScheduler.Assign(p->GetPeerInfo(), now);
+				if (!blockHashes.empty()) p->RequestBlocks(blockHashes, false);
+			}
+
+			GetBlocksParameter getBlocksParameter;
+			if (_syncScheduler.NextLocators(getBlocksParameter.locators))
+				_downloadPeer->SendMessage(MSG_GETBLOCKS, getBlocksParameter);
+		}
+
+		void PeerManager::OnSyncTimer() {
+			boost::mutex::scoped_lock scopedLock(lock);
+			if (!_parallelSync) return;
+
+			AssignSyncRanges();
+
+			ResetTimer(_syncTimer, BLOCK_RANGE_TIMEOUT / 3, boost::bind(&PeerManager::OnSyncTimer, this));
+		}
+
+		void PeerManager::ResetTimer(uint64_t &timer, double delay, const boost::function<void()> &task) {
+			PeerReactor::Instance()->Cancel(timer);
+			timer = 0;
+			if (!_timersStopped)
+				timer = PeerReactor::Instance()->Schedule(delay, task);
+		}
+
 		void PeerManager::AddTxToPublishList(const TransactionPtr &tx, const Peer::PeerPubTxCallback &callback) {
 			if (tx && tx->GetBlockHeight() == TX_UNCONFIRMED) {
-				for (size_t i = _publishedTx.size(); i > 0; i--) {
-					if (_publishedTx[i - 1].GetTransaction()->IsEqual(*tx)) return;
-				}
-
-				_publishedTx.emplace_back(tx, callback);
-				_publishedTxHashes.push_back(tx->GetHash());
+				if (!_publishedTx.Add(PublishedTransaction(tx, callback), time(NULL))) return;
 
 				for (size_t i = 0; i < tx->GetInputs().size(); i++) {
 					AddTxToPublishList(_wallet->TransactionForHash(tx->GetInputs()[i]->TxHash()),
@@ -867,8 +1040,13 @@ namespace Elastos {
 			bool connectionStatusChanged = false;
 			PeerPtr peer = peerPtr;
 
+			CollectBloomFilterElements();
+
 			lock.lock();
 
+			_peerScores.Connected(peer->GetPeerInfo(), peer->GetPingTime(), now);
+			peer->ScheduleDownloadStartTime();
+			peer->SetDownloadBytes(0);
 
 			// TODO: XXX does this work with 0.11 pruned nodes?
 			if ((peer->GetServices() & _chainParams->Services()) != _chainParams->Services()) {
@@ -907,18 +1085,22 @@ namespace Elastos {
 					PingParameter pingParameter(_lastBlock->GetHeight(),
 												boost::bind(&PeerManager::LoadBloomFilterDone, this, peer, _1));
 					peer->SendMessage(MSG_PING, pingParameter);
+				} else if (_parallelSync) { // help the download peer with the chain sync
+					LoadBloomFilter(peer);
+					AssignSyncRanges();
 				}
 
 				if (peer->GetTimestamp() > now + 2 * 60 * 60 || peer->GetTimestamp() < now - 2 * 60 * 60)
 					peer->SetTimestamp(now); // sanity check
-			} else { // select the peer with the lowest ping time to download the chain from if we're behind
+			} else { // select the best scoring peer to download the chain from if we're behind
 				// BUG: XXX a malicious peer can report a higher lastblock to make us select them as the download peer, if
 				// two peers agree on lastblock, use one of those two instead
 				for (size_t i = _connectedPeers.size(); i > 0; i--) {
 					const PeerPtr &p = _connectedPeers[i - 1];
 
 					if (p->GetConnectStatus() != Peer::Connected) continue;
-					if ((p->GetPingTime() < peer->GetPingTime() && p->GetLastBlock() >= peer->GetLastBlock()) ||
+					if ((_peerScores.Rank(p->GetPeerInfo()) > _peerScores.Rank(peer->GetPeerInfo()) &&
+						 p->GetLastBlock() >= peer->GetLastBlock()) ||
 						p->GetLastBlock() > peer->GetLastBlock())
 						peer = p;
 				}
@@ -933,6 +1115,7 @@ namespace Elastos {
 
 				peer->SetWaitingBlocks(false);
 				_downloadPeer = peer;
+				_downloadPeerTime = now;
 				_syncSucceeded = false;
 				_keepAliveTimestamp = time(nullptr);
 				_isConnected = 1;
@@ -947,6 +1130,7 @@ namespace Elastos {
 
 				if (_lastBlock->GetHeight() < peer->GetLastBlock()) { // start blockchain sync
 					peer->ScheduleDisconnect(PROTOCOL_TIMEOUT); // schedule sync timeout
+					StartParallelSync();
 					// request just block headers up to a week before earliestKeyTime, and then merkleblocks after that
 					// we do not reset connect failure count yet incase this request times out
 					peer->SendMessage(MSG_GETBLOCKS, GetBlocksParameter(GetBlockLocators(), uint256()));
@@ -968,11 +1152,15 @@ namespace Elastos {
 		void PeerManager::OnDisconnected(const PeerPtr &peer, int error) {
 			int willSave = 0, txError = 0;
 			bool willReconnect = false, isBlack = false, connectionStatusChanged = false;
+			time_t reconnectSeconds = 1;
 			Peer::ConnectStatus status = Peer::Disconnected;
+			std::vector<PeerScore> scores;
 
 			{
 				boost::mutex::scoped_lock scopedLock(lock);
 
+				_peerScores.Disconnected(peer->GetPeerInfo(), error != 0);
+
 				if (error == EPROTO) { // if it's protocol error, the peer isn't following standard policy
 					_connectFailureCount++;
 					PeerMisbehaving(peer);
@@ -987,9 +1175,7 @@ namespace Elastos {
 						txError = ETIMEDOUT;
 				}
 
-				for (size_t i = _txRelays.size(); i > 0; i--) {
-					_txRelays[i - 1].RemovePeer(peer);
-				}
+				_txRelays.RemovePeer(peer->GetPeerInfo());
 
 				if (_blackPeers.find(peer->GetPeerInfo()) != _blackPeers.end()) {
 					RemovePeer(peer);
@@ -997,10 +1183,13 @@ namespace Elastos {
 				}
 
 				if (peer == _downloadPeer) { // download peer disconnected
+					StopParallelSync();
 					_isConnected = 0;
 					_downloadPeer = NULL;
 					if (_connectFailureCount > MAX_CONNECT_FAILURES)
 						_connectFailureCount = MAX_CONNECT_FAILURES;
+				} else if (_parallelSync) {
+					_syncScheduler.Release(peer->GetPeerInfo());
 				}
 
 				if (!_isConnected && _connectFailureCount >= MAX_CONNECT_FAILURES) {
@@ -1024,6 +1213,16 @@ namespace Elastos {
 						++p;
 					}
 				}
+				if (_connectedPeers.empty())
+					_peersDisconnected.notify_all();
+
+				if (_reconnectPending && _connectedPeers.empty()) { // the last peer a reconnect waited for is gone
+					_reconnectPending = false;
+					reconnectSeconds = _reconnectDelay;
+					willReconnect = true;
+				}
+
+				AssignSyncRanges();
 
 				status = GetConnectStatusInternal();
 				if (_connectStatus != status) {
@@ -1031,13 +1230,15 @@ namespace Elastos {
 					connectionStatusChanged	= true;
 				}
 				PEER_INFO(peer, "connected peer size: {}", _connectedPeers.size());
+				scores = _peerScores.TakeChanged();
 			}
 
 			if (connectionStatusChanged) FireConnectStatusChanged(status);
+			if (!scores.empty()) FireSavePeerScores(scores);
 			if (willSave) FireSavePeers(true, {});
 			if (willSave) FireSyncStopped(error);
 			if (isBlack) FireSaveBlackPeer(peer->GetPeerInfo());
-			if (willReconnect) ConnectLaster(1);
+			if (willReconnect) ConnectLaster(reconnectSeconds);
 			FireTxStatusUpdate();
 		}
 
@@ -1081,6 +1282,7 @@ namespace Elastos {
 				save.resize(peersCount);
 
 				_peers = save;
+				SortPeers();
 			}
 
 			if (!save.empty()) {
@@ -1090,10 +1292,9 @@ namespace Elastos {
 		}
 
 		void PeerManager::OnRelayedTx(const PeerPtr &peer, const TransactionPtr &transaction) {
-			int isWalletTx = 0, hasPendingCallbacks = 0;
+			int hasPendingCallbacks = 0;
 			size_t relayCount = 0;
 			TransactionPtr tx = transaction;
-			UTXOPtr coinBase;
 			PublishedTransaction pubTx;
 
 			{
@@ -1101,154 +1302,162 @@ namespace Elastos {
 				boost::mutex::scoped_lock scopedLock(lock);
 				peer->info("relayed tx");
 
-				for (size_t i = _publishedTx.size(); i > 0; i--) { // see if tx is in list of published tx
-					if (_publishedTxHashes[i - 1] == tx->GetHash()) {
-						pubTx = _publishedTx[i - 1];
-						_publishedTx[i - 1].ResetCallback();
-						relayCount = AddPeerToList(peer, tx->GetHash(), _txRelays);
-					} else if (_publishedTx[i - 1].HasCallback()) hasPendingCallbacks = 1;
+				if (_publishedTx.Contains(tx->GetHash())) { // see if tx is in list of published tx
+					pubTx = _publishedTx.TakeCallback(tx->GetHash());
+					relayCount = _txRelays.AddPeer(tx->GetHash(), peer->GetPeerInfo(), time(NULL), true);
 				}
+				hasPendingCallbacks = _publishedTx.HasPendingCallbacks();
 
 				// cancel tx publish timeout if no publish callbacks are pending, and syncing is done or this is not downloadPeer
 				if (!hasPendingCallbacks && (_syncStartHeight == 0 || peer != _downloadPeer)) {
 					peer->ScheduleDisconnect(-1); // cancel publish tx timeout
 				}
 
-				if (_syncStartHeight == 0 || _wallet->ContainsTransaction(tx)) {
-					isWalletTx = _wallet->RegisterTransaction(tx);
-					if (isWalletTx)
-						tx = _wallet->TransactionForHash(tx->GetHash());
-				} else {
-					tx = nullptr;
-				}
+				// matched behind the tx queued before it, which may generate the addresses it pays, and registered
+				// ahead of the block that confirms it, which is posted only once all its tx were relayed
+				_walletApply.Post(boost::bind(&PeerManager::RegisterRelayedTx, this, peer, tx, relayCount,
+											  _syncStartHeight > 0));
+			}
 
-				if (tx && isWalletTx) {
-					// reschedule sync timeout
-					if (_syncStartHeight > 0 && peer == _downloadPeer) {
-						peer->ScheduleDisconnect(PROTOCOL_TIMEOUT);
-					}
+			if (pubTx.HasCallback()) pubTx.FireCallback(0, "success");
+		}
 
-					if (_syncSucceeded && _wallet->AmountSentByTx(tx) > 0 &&
-						_wallet->TransactionIsValid(tx)) {
-						AddTxToPublishList(tx, Peer::PeerPubTxCallback());  // add valid send tx to mempool
-					}
+		void PeerManager::RegisterRelayedTx(const PeerPtr &peer, const TransactionPtr &transaction, size_t relayCount,
+											bool syncing) {
+			TransactionPtr tx = transaction;
+			bool isWalletTx = false, verified = false;
+
+			{
+				SyncMetrics::Timer timer(_syncMetrics, SyncMetrics::WalletMatch);
+				if (!syncing || _wallet->ContainsTransaction(tx))
+					isWalletTx = _wallet->RegisterTransaction(tx);
+			}
 
-					// keep track of how many peers have or relay a tx, this indicates how likely the tx is to confirm
-					// (we only need to track this after syncing is complete)
-					if (_syncStartHeight == 0)
-						relayCount = AddPeerToList(peer, tx->GetHash(), _txRelays);
+			if (!isWalletTx) return;
 
-					RemovePeerFromList(peer, tx->GetHash(), _txRequests);
+			tx = _wallet->TransactionForHash(tx->GetHash());
+			if (!tx) return;
 
-					if (_bloomFilter != nullptr) { // check if bloom filter is already being updated
+			bool validSend = _wallet->AmountSentByTx(tx) > 0 && _wallet->TransactionIsValid(tx);
 
-						// the transaction likely consumed one or more wallet addresses, so check that at least the next <gap limit>
-						// unused addresses are still matched by the bloom filter
-						AddressArray unusedAddrs = _wallet->UnusedAddresses(SEQUENCE_GAP_LIMIT_EXTERNAL, 0);
-						AddressArray internalAddrs = _wallet->UnusedAddresses(SEQUENCE_GAP_LIMIT_INTERNAL, 1);
-						unusedAddrs.insert(unusedAddrs.end(), internalAddrs.begin(), internalAddrs.end());
+			// the transaction likely consumed one or more wallet addresses, so check that at least the next <gap limit>
+			// unused addresses are still matched by the bloom filter
+			AddressArray unusedAddrs = _wallet->UnusedAddresses(SEQUENCE_GAP_LIMIT_EXTERNAL, 0);
+			AddressArray internalAddrs = _wallet->UnusedAddresses(SEQUENCE_GAP_LIMIT_INTERNAL, 1);
+			unusedAddrs.insert(unusedAddrs.end(), internalAddrs.begin(), internalAddrs.end());
 
-						bytes_t hash;
+			std::vector<bytes_t> elements;
+			for (AddressArray::iterator it = unusedAddrs.begin(); it != unusedAddrs.end(); ++it)
+				elements.push_back((*it)->ProgramHash().bytes());
 
-						for (AddressArray::iterator it = unusedAddrs.begin(); it != unusedAddrs.end(); ++it) {
-							hash = (*it)->ProgramHash().bytes();
-							if (!_bloomFilter->ContainsData(hash)) {
-								_bloomFilter.reset();
-								UpdateBloomFilter();
-								break;
-							}
-						}
-					}
+			{
+				boost::mutex::scoped_lock scopedLock(lock);
+				_syncMetrics.Add(SyncMetrics::WalletTxMatched);
+
+				// reschedule sync timeout
+				if (_syncStartHeight > 0 && peer == _downloadPeer) {
+					peer->ScheduleDisconnect(PROTOCOL_TIMEOUT);
 				}
 
-				// set timestamp when tx is verified
-				if (tx && relayCount >= _maxConnectCount && tx->GetBlockHeight() == TX_UNCONFIRMED &&
-					tx->GetTimestamp() == 0) {
-					_wallet->UpdateTransactions({tx->GetHash()}, TX_UNCONFIRMED, time(NULL));
-				} else if (coinBase && coinBase->BlockHeight() == TX_UNCONFIRMED && coinBase->Timestamp() == 0) {
-					_wallet->UpdateTransactions({coinBase->Hash()}, TX_UNCONFIRMED, time(NULL));
+				if (_syncSucceeded && validSend) {
+					AddTxToPublishList(tx, Peer::PeerPubTxCallback());  // add valid send tx to mempool
 				}
+
+				// keep track of how many peers have or relay a tx, this indicates how likely the tx is to confirm
+				// (we only need to track this after syncing is complete), a wallet tx is never evicted, as
+				// RemoveUnrelayedTx() would take it for one no peer relays any more
+				if (_syncStartHeight == 0)
+					relayCount = _txRelays.AddPeer(tx->GetHash(), peer->GetPeerInfo(), time(NULL), true);
+
+				_txRequests.RemovePeer(tx->GetHash(), peer->GetPeerInfo());
+
+				if (_bloomFilter != nullptr) // check if bloom filter is already being updated
+					AddBloomFilterElements(elements);
+
+				verified = relayCount >= _maxConnectCount;
 			}
 
-			if (pubTx.HasCallback()) pubTx.FireCallback(0, "success");
+			// set timestamp when tx is verified
+			if (verified && tx->GetBlockHeight() == TX_UNCONFIRMED && tx->GetTimestamp() == 0)
+				_wallet->UpdateTransactions({tx->GetHash()}, TX_UNCONFIRMED, time(NULL));
 		}
 
 		void PeerManager::OnHasTx(const PeerPtr &peer, const uint256 &txHash) {
-			int isWalletTx = 0, hasPendingCallbacks = 0;
+			int hasPendingCallbacks = 0;
 			size_t relayCount = 0;
 			PublishedTransaction pubTx;
 
+			TransactionPtr tx = _wallet->TransactionForHash(txHash);
+
 			{
 				boost::mutex::scoped_lock scopedLock(lock);
-				TransactionPtr tx = _wallet->TransactionForHash(txHash);
 				peer->info("has tx");
 
-				for (size_t i = _publishedTx.size(); i > 0; i--) { // see if tx is in list of published tx
-					if (_publishedTxHashes[i - 1] == txHash) {
-						if (!tx) tx = _publishedTx[i - 1].GetTransaction();
-						pubTx = _publishedTx[i - 1];
-						_publishedTx[i - 1].ResetCallback();
-						relayCount = AddPeerToList(peer, txHash, _txRelays);
-					} else if (_publishedTx[i - 1].HasCallback()) hasPendingCallbacks = 1;
+				if (_publishedTx.Contains(txHash)) { // see if tx is in list of published tx
+					pubTx = _publishedTx.TakeCallback(txHash);
+					if (!tx) tx = pubTx.GetTransaction();
+					relayCount = _txRelays.AddPeer(txHash, peer->GetPeerInfo(), time(NULL), true);
 				}
+				hasPendingCallbacks = _publishedTx.HasPendingCallbacks();
 
 				// cancel tx publish timeout if no publish callbacks are pending, and syncing is done or this is not downloadPeer
 				if (!hasPendingCallbacks && (_syncStartHeight == 0 || peer != _downloadPeer)) {
 					peer->ScheduleDisconnect(-1);  // cancel publish tx timeout
 				}
 
-				if (tx) {
-					isWalletTx = _wallet->RegisterTransaction(tx);
-					if (isWalletTx) tx = _wallet->TransactionForHash(tx->GetHash());
+				if (tx)
+					_walletApply.Post(boost::bind(&PeerManager::RegisterHasTx, this, peer, tx, relayCount));
+			}
 
-					// reschedule sync timeout
-					if (_syncStartHeight > 0 && peer == _downloadPeer && isWalletTx) {
-						peer->ScheduleDisconnect(PROTOCOL_TIMEOUT);
-					}
+			if (pubTx.HasCallback()) pubTx.FireCallback(0, "has tx");
+		}
 
-					// keep track of how many peers have or relay a tx, this indicates how likely the tx is to confirm
-					// (we only need to track this after syncing is complete)
-					if (_syncStartHeight == 0)
-						relayCount = AddPeerToList(peer, txHash, _txRelays);
+		void PeerManager::RegisterHasTx(const PeerPtr &peer, const TransactionPtr &transaction, size_t relayCount) {
+			TransactionPtr tx = transaction;
+			const uint256 txHash = tx->GetHash();
+			bool isWalletTx = _wallet->RegisterTransaction(tx);
+			bool verified = false;
 
-					// set timestamp when tx is verified
-					if (relayCount >= _maxConnectCount && tx && tx->GetBlockHeight() == TX_UNCONFIRMED &&
-						tx->GetTimestamp() == 0) {
-						std::vector<uint256> hashes = {txHash};
-						_wallet->UpdateTransactions(hashes, TX_UNCONFIRMED, (uint32_t) time(NULL));
-					}
+			if (isWalletTx) tx = _wallet->TransactionForHash(txHash);
 
-					RemovePeerFromList(peer, txHash, _txRequests);
+			{
+				boost::mutex::scoped_lock scopedLock(lock);
+
+				// reschedule sync timeout
+				if (_syncStartHeight > 0 && peer == _downloadPeer && isWalletTx) {
+					peer->ScheduleDisconnect(PROTOCOL_TIMEOUT);
 				}
+
+				// keep track of how many peers have or relay a tx, this indicates how likely the tx is to confirm
+				// (we only need to track this after syncing is complete), the tx is the wallet's or being published
+				if (_syncStartHeight == 0)
+					relayCount = _txRelays.AddPeer(txHash, peer->GetPeerInfo(), time(NULL), true);
+
+				_txRequests.RemovePeer(txHash, peer->GetPeerInfo());
+
+				verified = relayCount >= _maxConnectCount;
 			}
 
-			if (pubTx.HasCallback()) pubTx.FireCallback(0, "has tx");
+			// set timestamp when tx is verified
+			if (verified && tx && tx->GetBlockHeight() == TX_UNCONFIRMED && tx->GetTimestamp() == 0)
+				_wallet->UpdateTransactions({txHash}, TX_UNCONFIRMED, (uint32_t) time(NULL));
 		}
 
 		void PeerManager::OnRejectedTx(const PeerPtr &peer, const uint256 &txHash, uint8_t code, const std::string &reason) {
-			TransactionPtr tx;
+			TransactionPtr tx = _wallet->TransactionForHash(txHash);
 			PublishedTransaction pubTx;
+			bool unverified = false;
 			{
 				boost::mutex::scoped_lock scopedLock(lock);
 				peer->info("rejected tx: code {}, reason {}", code, reason);
-				tx = _wallet->TransactionForHash(txHash);
-				RemovePeerFromList(peer, txHash, _txRequests);
-
-				for (size_t i = _publishedTx.size(); i > 0; --i) { // see if tx is in list of published tx
-					if (_publishedTxHashes[i - 1] == txHash) {
-						pubTx = _publishedTx[i - 1];
-						_publishedTx[i - 1].ResetCallback();
-						_publishedTx.erase(_publishedTx.begin() + (i - 1));
-						_publishedTxHashes.erase(_publishedTxHashes.begin() + (i - 1));
-						break;
-					}
-				}
+				_txRequests.RemovePeer(txHash, peer->GetPeerInfo());
+
+				pubTx = _publishedTx.TakeCallback(txHash); // see if tx is in list of published tx
+				_publishedTx.Remove(txHash);
 
 				if (tx) {
-					if (RemovePeerFromList(peer, txHash, _txRelays) && tx->GetBlockHeight() == TX_UNCONFIRMED) {
-						// set timestamp 0 to mark tx as unverified
-						_wallet->UpdateTransactions({txHash}, TX_UNCONFIRMED, 0);
-					}
+					if (_txRelays.RemovePeer(txHash, peer->GetPeerInfo()) && tx->GetBlockHeight() == TX_UNCONFIRMED)
+						unverified = true;
 
 					// if we get rejected for any reason other than double-spend, the peer is likely misconfigured
 #if 0 // TODO enable this after node error code refactored.
@@ -1268,13 +1477,56 @@ namespace Elastos {
 				}
 			}
 
+			// set timestamp 0 to mark tx as unverified
+			if (unverified)
+				_wallet->UpdateTransactions({txHash}, TX_UNCONFIRMED, 0);
+
 			FireTxStatusUpdate();
 			if (pubTx.HasCallback()) pubTx.FireCallback(code, reason);
 		}
 
 		void PeerManager::OnRelayedBlock(const PeerPtr &peer, const MerkleBlockPtr &block) {
-			size_t i, j, fpCount = 0, saveCount = 0;
-			MerkleBlockPtr b, b2, prev, next;
+			bool scheduled = false;
+
+			{
+				boost::mutex::scoped_lock scopedLock(lock);
+				if (_parallelSync) {
+					scheduled = _syncScheduler.Received(peer->GetPeerInfo(), block->GetHash(), CurrentTime());
+					if (!scheduled && peer != _downloadPeer) {
+						peer->info("dropping block {} that is no longer expected", block->GetHash().GetHex());
+						return;
+					}
+				}
+			}
+
+			// blocks fetched ahead by other peers are connected in chain order as soon as their parent is
+			for (MerkleBlockPtr next = block; next; )
+				next = AcceptBlock(peer, next, scheduled);
+
+			if (scheduled) {
+				boost::mutex::scoped_lock scopedLock(lock);
+				AssignSyncRanges();
+			}
+		}
+
+		void PeerManager::OnRelayedBlockHashes(const PeerPtr &peer, const std::vector<uint256> &blockHashes,
+											   bool full) {
+			{
+				boost::mutex::scoped_lock scopedLock(lock);
+				if (_parallelSync && peer == _downloadPeer) {
+					_syncScheduler.AddHashes(blockHashes, full);
+					AssignSyncRanges();
+					return;
+				}
+			}
+
+			peer->RequestBlocks(blockHashes, full);
+		}
+
+		MerkleBlockPtr PeerManager::AcceptBlock(const PeerPtr &peer, const MerkleBlockPtr &block, bool &scheduled) {
+			size_t i, j, saveCount = 0;
+			bool replace = false; // the blocks saved replace the stored ones
+			MerkleBlockPtr b, prev, next;
 			std::vector<MerkleBlockPtr> saveBlocks;
 			std::vector<uint256> txHashes;
 			static uint32_t txTotal = 0; // for test
@@ -1288,35 +1540,10 @@ namespace Elastos {
 					block->SetHeight(prev->GetHeight() + 1);
 				}
 
-				// track the observed bloom filter false positive rate using a low pass filter to smooth out variance
-				if (peer == _downloadPeer && block->GetTransactionCount() > 0) {
-					for (i = 0; i < txHashes.size(); i++) { // wallet tx are not false-positives
-						if (!_wallet->ContainsTransaction(txHashes[i]))
-							fpCount++;
-					}
-
-					// moving average number of tx-per-block
-					_averageTxPerBlock = _averageTxPerBlock * 0.999 + block->GetTransactionCount() * 0.001;
-
-					// 1% low pass filter, also weights each block by total transactions, compared to the avarage
-					_fpRate = _fpRate * (1.0 - 0.01 * block->GetTransactionCount() / _averageTxPerBlock) +
-							 0.01 * fpCount / _averageTxPerBlock;
-
-					// false positive rate sanity check
-					if (peer->GetConnectStatus() == Peer::Connected &&
-						_fpRate > BLOOM_DEFAULT_FALSEPOSITIVE_RATE * 10.0) {
-						peer->warn(
-							"bloom filter false positive rate {} too high after {} blocks, disconnecting...",
-							_fpRate, _lastBlock->GetHeight() + 1 - _filterUpdateHeight);
-						_fpRate = 0;
-						_averageTxPerBlock = 1400;
-						peer->Disconnect();
-						return;
-					} else if (_lastBlock->GetHeight() + 500 < peer->GetLastBlock() &&
-							   _fpRate > BLOOM_REDUCED_FALSEPOSITIVE_RATE * 10.0) {
-						UpdateBloomFilter(); // rebuild bloom filter when it starts to degrade
-					}
-				}
+				// the wallet tells false positives apart, so the rate is tracked once it's done with earlier blocks
+				if (peer == _downloadPeer && block->GetTransactionCount() > 0)
+					_walletApply.Post(boost::bind(&PeerManager::UpdateFpRate, this, peer, txHashes,
+												  block->GetTransactionCount()));
 
 				// ignore block headers that are newer than one week before earliestKeyTime (it's a header if it has 0 totalTx)
 				if (block->GetTransactionCount() == 0 &&
@@ -1328,6 +1555,8 @@ namespace Elastos {
 						peer->ScheduleDisconnect(PROTOCOL_TIMEOUT); // reschedule sync timeout
 						_connectFailureCount = 0; // reset failure count once we know our initial request didn't timeout
 					}
+				} else if (!prev && scheduled) { // fetched ahead of the chain tip, connected once its parent arrives
+					_syncBlocks.Insert(block);
 				} else if (!prev) { // block is an orphan
 					PEER_DEBUG(peer, "relayed orphan block {}:{}, previous {}, last block is {}:{}",
 							   block->GetHash().GetHex(),
@@ -1347,7 +1576,7 @@ namespace Elastos {
 							peer->SendMessage(MSG_GETBLOCKS, getBlocksParameter);
 						}
 
-						_orphans.Insert(block); // BUG: limit total orphans to avoid memory exhaustion attack
+						_orphans.Insert(block);
 						_lastOrphan = block;
 						peer->ScheduleDisconnect(PROTOCOL_TIMEOUT); // reschedule sync timeout
 					}
@@ -1357,32 +1586,39 @@ namespace Elastos {
 				} else if (block->GetPrevBlockHash() == _lastBlock->GetHash()) { // new block extends main chain
 					_blocks.Insert(block);
 					_lastBlock = block;
-					_wallet->SetBlockHeight(_lastBlock->GetHeight());
+					_walletApply.Post(boost::bind(&Wallet::SetBlockHeight, _wallet, _lastBlock->GetHeight()));
 
 					txTotal += block->GetTotalTx();
 					if ((block->GetHeight() % 500) == 0 || txHashes.size() > 0 ||
 						block->GetHeight() >= peer->GetLastBlock()) {
 						peer->info("adding block #{}, {}, false positive rate: {}",
 								   block->GetHeight(), txTotal, _fpRate);
-						FireSyncProgress(GetSyncProgressInternal(0), peer, block);
+						RecordThroughput(peer);
+						_walletApply.Post(boost::bind(&PeerManager::FireSyncProgress, this, GetSyncProgressInternal(0),
+													  TakeDownloadRate(peer), peer, block));
 						txTotal = 0;
 					}
 
 					if (txHashes.size() > 0)
-						_wallet->UpdateTransactions(txHashes, block->GetHeight(), block->GetTimestamp());
+						_walletApply.Post(boost::bind(&Wallet::UpdateTransactions, _wallet, txHashes,
+													  block->GetHeight(), block->GetTimestamp()));
 					if (_downloadPeer) _downloadPeer->SetCurrentBlockHeight(block->GetHeight());
 
-					if (block->GetHeight() < _estimatedHeight && peer == _downloadPeer) {
-						peer->ScheduleDisconnect(PROTOCOL_TIMEOUT); // reschedule sync timeout
+					if (block->GetHeight() < _estimatedHeight && _downloadPeer && (peer == _downloadPeer || scheduled)) {
+						_downloadPeer->ScheduleDisconnect(PROTOCOL_TIMEOUT); // reschedule sync timeout
 						_connectFailureCount = 0; // reset failure count once we know our initial request didn't timeout
 					}
 
-					if ((block->GetHeight() % BLOCK_DIFFICULTY_INTERVAL) == 0)
+					if ((block->GetHeight() % BLOCK_DIFFICULTY_INTERVAL) == 0) {
 						saveCount = 1; // save transition block immediately
+						CompactInterval(block);
+					}
 
 					if (block->GetHeight() == _estimatedHeight) { // chain download is complete
-						saveCount = (block->GetHeight() % BLOCK_DIFFICULTY_INTERVAL) + BLOCK_DIFFICULTY_INTERVAL + 1;
-						LoadMempools();
+						saveCount = (block->GetHeight() % BLOCK_DIFFICULTY_INTERVAL) + 1;
+						replace = true;
+						StopParallelSync();
+						_walletApply.Post(boost::bind(&PeerManager::ReloadBloomFilters, this));
 					}
 				} else if (_blocks.Contains(block)) { // we already have the block (or at least the header)
 					if ((block->GetHeight() % 500) == 0 || txHashes.size() > 0 ||
@@ -1390,13 +1626,13 @@ namespace Elastos {
 						peer->info("relayed existing block #{}", block->GetHeight());
 					}
 
-					b = _lastBlock;
-					while (b && b->GetHeight() > block->GetHeight())
-						b = _blocks.Get(b->GetPrevBlockHash()); // is block in main chain?
+					// is block in main chain? if it's not on a fork, set block heights for its transactions
+					const BlockIndex::Header *h = _blocks.GetAncestorHeader(_lastBlock->GetHash(), block->GetHeight());
 
-					if (b->IsEqual(block.get())) { // if it's not on a fork, set block heights for its transactions
+					if (h && h->hash == block->GetHash()) {
 						if (txHashes.size() > 0)
-							_wallet->UpdateTransactions(txHashes, block->GetHeight(), block->GetTimestamp());
+							_walletApply.Post(boost::bind(&Wallet::UpdateTransactions, _wallet, txHashes,
+														  block->GetHeight(), block->GetTimestamp()));
 						if (block->GetHeight() == _lastBlock->GetHeight()) _lastBlock = block;
 					}
 
@@ -1422,40 +1658,59 @@ namespace Elastos {
 					_blocks.Insert(block);
 
 					if (block->GetHeight() > _lastBlock->GetHeight()) { // check if fork is now longer than main chain
-						b = block;
-						b2 = _lastBlock;
+						// walk back to where the fork joins the main chain, on the header records, older blocks of
+						// either chain may be compacted
+						const BlockIndex::Header *h = _blocks.GetHeader(block->GetHash());
+						const BlockIndex::Header *h2 = _blocks.GetHeader(_lastBlock->GetHash());
 						std::vector<MerkleBlockPtr> longerChain;
-						while (b && b2 && !b->IsEqual(b2.get())) { // walk back to where the fork joins the main chain
-							longerChain.insert(longerChain.begin(), b);
-							b = _blocks.Get(b->GetPrevBlockHash());
-							if (b && b->GetHeight() < b2->GetHeight()) b2 = _blocks.Get(b2->GetPrevBlockHash());
+						while (h && h2 && h->hash != h2->hash) {
+							MerkleBlockPtr forkBlock = _blocks.Get(h->hash);
+							if (!forkBlock) break;
+							longerChain.push_back(forkBlock);
+							h = _blocks.GetHeader(h->prevHash);
+							if (h && h->height < h2->height)
+								h2 = _blocks.GetAncestorHeader(h2->hash, h->height);
+						}
+
+						// a header pruned from either chain leaves no join point to reorganize from
+						if (!h || !h2 || h->hash != h2->hash) {
+							peer->warn("fork at height {} doesn't join the main chain, keeping it as orphan",
+									   block->GetHeight());
+							_blocks.Remove(block->GetHash());
+							_orphans.Insert(block);
+							_lastOrphan = block;
+							return next;
 						}
+						std::reverse(longerChain.begin(), longerChain.end());
 
-						peer->info("reorganizing chain from height {}, new height is {}", b->GetHeight(),
+						peer->info("reorganizing chain from height {}, new height is {}", h->height,
 								   block->GetHeight());
 
-						_wallet->SetTxUnconfirmedAfter(b->GetHeight());  // mark tx after the join point as unconfirmed
+						// mark tx after the join point as unconfirmed
+						_walletApply.Post(boost::bind(&Wallet::SetTxUnconfirmedAfter, _wallet, h->height));
 
+						uint256 joinHash = h->hash;
 						for (std::vector<MerkleBlockPtr>::iterator it = longerChain.begin(); it != longerChain.end(); ++it) {
 							b = *it;
-							if (b2->GetHash() == b->GetPrevBlockHash()) {
+							if (joinHash == b->GetPrevBlockHash()) {
 								uint32_t height = b->GetHeight();
 								uint32_t timestamp = b->GetTimestamp();
 								txHashes.clear();
 								b->MerkleBlockTxHashes(txHashes);
 								if (!txHashes.empty())
-									_wallet->UpdateTransactions(txHashes, height, timestamp);
-								b2 = b;
+									_walletApply.Post(boost::bind(&Wallet::UpdateTransactions, _wallet, txHashes,
+																  height, timestamp));
+								joinHash = b->GetHash();
 							}
 						}
 
 						_lastBlock = block;
-						_wallet->SetBlockHeight(_lastBlock->GetHeight());
+						_walletApply.Post(boost::bind(&Wallet::SetBlockHeight, _wallet, _lastBlock->GetHeight()));
 
 						if (block->GetHeight() == _estimatedHeight) { // chain download is complete
-							saveCount =
-									(block->GetHeight() % BLOCK_DIFFICULTY_INTERVAL) + BLOCK_DIFFICULTY_INTERVAL + 1;
-							LoadMempools();
+							saveCount = (block->GetHeight() % BLOCK_DIFFICULTY_INTERVAL) + 1;
+							replace = true;
+							_walletApply.Post(boost::bind(&PeerManager::ReloadBloomFilters, this));
 						}
 					}
 				}
@@ -1463,22 +1718,29 @@ namespace Elastos {
 				if (block && block->GetHeight() != BLOCK_UNKNOWN_HEIGHT) {
 					if (block->GetHeight() > _estimatedHeight) _estimatedHeight = block->GetHeight();
 
-					// check if the next block was received as an orphan
+					// check if the next block was received as an orphan, or fetched ahead by parallel sync
 					MerkleBlockPtr nextBlock = _orphans.GetMatchPrevHash(block->GetHash());
 					if (nextBlock) {
 						next = nextBlock;
 						_orphans.Remove(nextBlock);
+						scheduled = false;
+					} else if ((nextBlock = _syncBlocks.GetMatchPrevHash(block->GetHash())) != nullptr) {
+						next = nextBlock;
+						_syncBlocks.Remove(nextBlock);
+						scheduled = true;
 					}
 				}
 
 				saveBlocks.clear();
 
+				// the blocks saved are in the interval since the last transition, which is never compacted, only the
+				// block before them is checked by its header
 				for (i = 0, b = block; b && i < saveCount; i++) {
 					assert(b->GetHeight() != BLOCK_UNKNOWN_HEIGHT); // verify all blocks to be saved are in the chain
-					MerkleBlockPtr prvBlock = _blocks.Get(b->GetPrevBlockHash());
-					if (prvBlock)
-						saveBlocks.push_back(b);
-					b = prvBlock;
+					if (!_blocks.Contains(b->GetPrevBlockHash()))
+						break;
+					saveBlocks.push_back(b);
+					b = (i + 1 < saveCount) ? _blocks.Get(b->GetPrevBlockHash()) : nullptr;
 				}
 
 				// make sure the set of blocks to be saved starts at a difficulty interval
@@ -1493,14 +1755,14 @@ namespace Elastos {
 //				assert(saveBlocks.size() == 0 || (saveBlocks.back()->GetHeight() % BLOCK_DIFFICULTY_INTERVAL) == 0);
 			}
 
-			if (saveBlocks.size() > 0)
-				FireSaveBlocks(saveBlocks.size() > 1, saveBlocks);
+			if (saveBlocks.size() > 0) // the database is written behind the wallet updates of these blocks
+				_walletApply.Post(boost::bind(&PeerManager::FireSaveBlocks, this, replace, saveBlocks));
 
 			if (block && block->GetHeight() != BLOCK_UNKNOWN_HEIGHT) {
-				_wallet->UpdateLockedBalance();
+				_walletApply.Post(boost::bind(&Wallet::UpdateLockedBalance, _wallet));
 			}
 
-			if (next) OnRelayedBlock(peer, next);
+			return next;
 		}
 
 		void PeerManager::OnRelayedPing(const PeerPtr &peer) {
@@ -1514,17 +1776,15 @@ namespace Elastos {
 			}
 			lock.unlock();
 
-			if (needReconnect) {
-				boost::thread workThread(boost::bind(&PeerManager::ReconnectLaster, this, seconds));
-			}
+			if (needReconnect) ScheduleReconnect(seconds);
 		}
 
 		void PeerManager::OnNotfound(const PeerPtr &peer, const std::vector<uint256> &txHashes,
 									 const std::vector<uint256> &blockHashes) {
 			boost::mutex::scoped_lock scopedLock(lock);
 			for (size_t i = 0; i < txHashes.size(); i++) {
-				RemovePeerFromList(peer, txHashes[i], _txRelays);
-				RemovePeerFromList(peer, txHashes[i], _txRequests);
+				_txRelays.RemovePeer(txHashes[i], peer->GetPeerInfo());
+				_txRequests.RemovePeer(txHashes[i], peer->GetPeerInfo());
 			}
 		}
 
@@ -1538,13 +1798,12 @@ namespace Elastos {
 					if (p->GetConnectStatus() != Peer::Connected) continue;
 					if (p->GetFeePerKb() > maxFeePerKb) secondFeePerKb = maxFeePerKb, maxFeePerKb = p->GetFeePerKb();
 				}
+			}
 
-				if (secondFeePerKb * 3 / 2 > DEFAULT_FEE_PER_KB && secondFeePerKb * 3 / 2 <= MAX_FEE_PER_KB &&
-					secondFeePerKb * 3 / 2 > _wallet->GetFeePerKb()) {
-					peer->info("increasing feePerKb to {} based on feefilter messages from peers",
-							   secondFeePerKb * 3 / 2);
-					_wallet->SetFeePerKb(secondFeePerKb * 3 / 2);
-				}
+			if (secondFeePerKb * 3 / 2 > DEFAULT_FEE_PER_KB && secondFeePerKb * 3 / 2 <= MAX_FEE_PER_KB &&
+				secondFeePerKb * 3 / 2 > _wallet->GetFeePerKb()) {
+				peer->info("increasing feePerKb to {} based on feefilter messages from peers", secondFeePerKb * 3 / 2);
+				_wallet->SetFeePerKb(secondFeePerKb * 3 / 2);
 			}
 		}
 
@@ -1554,23 +1813,20 @@ namespace Elastos {
 
 			{
 				boost::mutex::scoped_lock scopedLock(lock);
-				for (size_t i = _publishedTx.size(); i > 0; i--) {
-					if (_publishedTx[i - 1].GetTransaction()->GetHash() == txHash) {
-						pubTx = _publishedTx[i - 1];
-						//_publishedTx[i - 1].ResetCallback();
-					} else if (_publishedTx[i - 1].HasCallback())
-						hasPendingCallbacks = 1;
-				}
+				pubTx = _publishedTx.Get(txHash);
+				hasPendingCallbacks = _publishedTx.PendingCallbacks() > (pubTx.HasCallback() ? 1 : 0);
 
 				// cancel tx publish timeout if no publish callbacks are pending, and syncing is done or this is not downloadPeer
 				if (!hasPendingCallbacks && (_syncStartHeight == 0 || peer != _downloadPeer)) {
 					peer->ScheduleDisconnect(-1); // cancel publish tx timeout
 				}
 
-				//AddPeerToList(peer, txHash, _txRelays);
-				if (pubTx.GetTransaction() != nullptr)
-					_wallet->RegisterTransaction(pubTx.GetTransaction());
-				if (pubTx.GetTransaction() != nullptr && !_wallet->TransactionIsValid(pubTx.GetTransaction()))
+				//_txRelays.AddPeer(txHash, peer->GetPeerInfo(), time(NULL));
+			}
+
+			if (pubTx.GetTransaction() != nullptr) {
+				_wallet->RegisterTransaction(pubTx.GetTransaction());
+				if (!_wallet->TransactionIsValid(pubTx.GetTransaction()))
 					error = 0x10; // RejectInvalid by node
 			}
 
@@ -1597,15 +1853,10 @@ namespace Elastos {
 		}
 
 		size_t PeerManager::PublishPendingTx(const PeerPtr &peer) {
-			std::vector<uint256> pendingHashes;
+			std::vector<uint256> pendingHashes = _publishedTx.PendingHashes();
 
-			for (size_t i = _publishedTx.size(); i > 0; i--) {
-				if (!_publishedTx[i - 1].HasCallback() ||
-					_publishedTx[i - 1].GetTransaction()->GetBlockHeight() != TX_UNCONFIRMED)
-					continue;
+			if (!pendingHashes.empty())
 				peer->ScheduleDisconnect(PROTOCOL_TIMEOUT);  // schedule publish timeout
-				pendingHashes.push_back(_publishedTx[i - 1].GetTransaction()->GetHash());
-			}
 
 			InventoryParameter inventoryParameter;
 			inventoryParameter.txHashes = pendingHashes;
@@ -1614,48 +1865,150 @@ namespace Elastos {
 			return pendingHashes.size();
 		}
 
-		size_t
-		PeerManager::AddPeerToList(const PeerPtr &peer, const uint256 &txHash, std::vector<TransactionPeerList> &list) {
-			for (size_t i = list.size(); i > 0; i--) {
-				if (list[i - 1].GetTransactionHash() != txHash)
-					continue;
+		void PeerManager::PeerMisbehaving(const PeerPtr &peer) {
+			_peerScores.Misbehaved(peer->GetPeerInfo());
+			RemovePeer(peer);
 
-				for (size_t j = list[i - 1].GetPeers().size(); j > 0; j--) {
-					if (list[i - 1].GetPeers()[j - 1]->IsEqual(peer.get()))
-						return list[i - 1].GetPeers().size();
-				}
+			if (++_misbehavinCount >= 10) { // clear out stored peers so we get a fresh list from DNS for next connect
+				_misbehavinCount = 0;
+				_peers.clear();
+				FireSavePeers(true, {});
+			}
+
+			peer->Disconnect();
+		}
+
+		void PeerManager::RecordThroughput(const PeerPtr &peer) {
+			struct timeval tv;
+			gettimeofday(&tv, NULL);
 
-				list[i - 1].AddPeer(peer);
-				return list[i - 1].GetPeers().size();
+			uint64_t now = tv.tv_sec * 1000 + tv.tv_usec / 1000;
+			uint64_t milliseconds = now - peer->GetDownloadStartTime();
+
+			if (milliseconds < 1000) return; // too short to tell anything
+
+			_peerScores.Throughput(peer->GetPeerInfo(), peer->GetDownloadBytes() * 1000.0 / milliseconds);
+
+			if (peer != _downloadPeer || _lastBlock->GetHeight() + PEER_SCORE_SWITCH_BLOCKS > _estimatedHeight ||
+				_downloadPeerTime + PEER_SCORE_SWITCH_DELAY > tv.tv_sec)
+				return;
+
+			size_t connected = 0;
+			for (size_t i = _connectedPeers.size(); i > 0; i--) {
+				if (_connectedPeers[i - 1]->GetConnectStatus() == Peer::Connected) connected++;
 			}
+			if (connected < 2) return; // nothing to switch to
 
-			list.push_back(TransactionPeerList(txHash, {peer}));
-			return 1;
+			double bytesPerSecond = _peerScores.Get(peer->GetPeerInfo()).BytesPerSecond;
+			double best = _peerScores.BestThroughput();
+			if (bytesPerSecond < best * PEER_SCORE_SWITCH_RATIO) {
+				peer->info("download peer throughput {} B/s, best seen {} B/s, switching download peer",
+						   (uint64_t) bytesPerSecond, (uint64_t) best);
+				_downloadPeerSwitches++;
+				peer->Disconnect();
+			}
 		}
 
-		bool PeerManager::RemovePeerFromList(const PeerPtr &peer, const uint256 &txHash,
-											 std::vector<TransactionPeerList> &list) {
-			bool removed = false;
-			for (size_t i = list.size(); i > 0; i--) {
-				if (list[i - 1].GetTransactionHash() == txHash) {
-					removed = list[i - 1].RemovePeer(peer);
-					break;
+		void PeerManager::UpdateFpRate(const PeerPtr &peer, const std::vector<uint256> &txHashes, uint32_t txCount) {
+			size_t fpCount = 0;
+
+			{
+				SyncMetrics::Timer timer(_syncMetrics, SyncMetrics::WalletMatch);
+				for (size_t i = 0; i < txHashes.size(); i++) { // wallet tx are not false-positives
+					if (!_wallet->ContainsTransaction(txHashes[i]))
+						fpCount++;
 				}
 			}
 
-			return removed;
-		}
+			boost::mutex::scoped_lock scopedLock(lock);
+			if (peer != _downloadPeer) return; // the download peer changed in the meantime
 
-		void PeerManager::PeerMisbehaving(const PeerPtr &peer) {
-			RemovePeer(peer);
+			// moving average number of tx-per-block
+			_averageTxPerBlock = _averageTxPerBlock * 0.999 + txCount * 0.001;
 
-			if (++_misbehavinCount >= 10) { // clear out stored peers so we get a fresh list from DNS for next connect
-				_misbehavinCount = 0;
-				_peers.clear();
-				FireSavePeers(true, {});
+			// 1% low pass filter, also weights each block by total transactions, compared to the avarage
+			_fpRate = _fpRate * (1.0 - 0.01 * txCount / _averageTxPerBlock) + 0.01 * fpCount / _averageTxPerBlock;
+
+			// false positive rate sanity check
+			if (peer->GetConnectStatus() == Peer::Connected && _fpRate > BLOOM_DEFAULT_FALSEPOSITIVE_RATE * 10.0) {
+				peer->warn("bloom filter false positive rate {} too high after {} blocks, disconnecting...",
+						   _fpRate, _lastBlock->GetHeight() + 1 - _filterUpdateHeight);
+				_fpRate = 0;
+				_averageTxPerBlock = 1400;
+				peer->Disconnect();
+			} else if (_lastBlock->GetHeight() + 500 < peer->GetLastBlock() &&
+					   _fpRate > BLOOM_REDUCED_FALSEPOSITIVE_RATE * 10.0) {
+				// rebuild bloom filter when it starts to degrade, with more room for elements added later
+				if (!peer->NeedsFilterUpdate())
+					_bloomFilterSpare = std::min(_bloomFilterSpare * 2, (size_t) BLOOM_FILTER_MAX_SPARE);
+				UpdateBloomFilter();
 			}
+		}
 
-			peer->Disconnect();
+		PeerScore PeerManager::GetPeerScore(const PeerInfo &peer) const {
+			boost::mutex::scoped_lock scoped_lock(lock);
+			return _peerScores.Get(peer);
+		}
+
+		uint64_t PeerManager::GetDownloadPeerSwitchCount() const {
+			boost::mutex::scoped_lock scoped_lock(lock);
+			return _downloadPeerSwitches;
+		}
+
+		size_t PeerManager::GetOrphanCount() const {
+			boost::mutex::scoped_lock scoped_lock(lock);
+			return _orphans.Size();
+		}
+
+		uint64_t PeerManager::GetOrphanEvictedCount() const {
+			boost::mutex::scoped_lock scoped_lock(lock);
+			return _orphans.Evicted();
+		}
+
+		size_t PeerManager::GetWalletApplyPending() const {
+			return _walletApply.Pending();
+		}
+
+		size_t PeerManager::GetWalletApplyPeak() const {
+			return _walletApply.PeakPending();
+		}
+
+		void PeerManager::FlushWalletApply() {
+			_walletApply.Flush();
+		}
+
+		void PeerManager::StopWalletApply() {
+			_walletApply.Stop();
+		}
+
+		SyncMetrics &PeerManager::GetSyncMetrics() {
+			return _syncMetrics;
+		}
+
+		nlohmann::json PeerManager::GetSyncMetricsInfo() const {
+			nlohmann::json j = _syncMetrics.ToJson();
+
+			j["Counters"]["WalletApplyPending"] = _walletApply.Pending();
+			j["Counters"]["WalletApplyPeak"] = _walletApply.PeakPending();
+			j["Counters"]["WalletApplied"] = _walletApply.Applied();
+
+			boost::mutex::scoped_lock scoped_lock(lock);
+			j["Counters"]["OrphanBlocks"] = _orphans.Size();
+			j["Counters"]["OrphanEvicted"] = _orphans.Evicted();
+			j["Counters"]["DownloadPeerSwitches"] = _downloadPeerSwitches;
+			j["Counters"]["BloomFilterRebuilds"] = _bloomFilterRebuilds;
+			j["Counters"]["BloomFilterAdds"] = _bloomFilterAdds;
+			j["FalsePositiveRate"] = _fpRate;
+			j["LastBlockHeight"] = _lastBlock->GetHeight();
+			j["EstimatedHeight"] = _estimatedHeight;
+			j["ConnectedPeers"] = _connectedPeers.size();
+
+			size_t knownInventoryBytes = 0;
+			for (size_t i = 0; i < _connectedPeers.size(); ++i)
+				knownInventoryBytes += _connectedPeers[i]->KnownInventoryMemoryUsage();
+			j["KnownInventoryBytes"] = knownInventoryBytes;
+
+			return j;
 		}
 
 		const std::string &PeerManager::GetChainID() const {
@@ -1687,6 +2040,77 @@ namespace Elastos {
 			}
 		}
 
+		void PeerManager::AddBloomFilterElements(const std::vector<bytes_t> &elements) {
+			if (_bloomFilter == nullptr) return; // a pending filter update picks them up
+
+			std::vector<bytes_t> missing;
+			for (size_t i = 0; i < elements.size(); ++i) {
+				if (!_bloomFilter->ContainsData(elements[i]))
+					missing.push_back(elements[i]);
+			}
+
+			if (missing.empty()) return;
+
+			for (size_t i = 0; i < missing.size(); ++i)
+				_bloomFilter->InsertData(missing[i]);
+
+			// the next filter loaded has them too, for a new connection or in place of the filteradds below
+			_walletElements.insert(_walletElements.end(), missing.begin(), missing.end());
+
+			// filteradd never grows the filter, rebuild it with more room once the elements added, or the false
+			// positives seen in blocks, push its false positive rate to where OnRelayedBlock would rebuild it
+			double fpRate = std::max(_fpRate, _bloomFilter->FalsePositiveRate());
+			if (fpRate > BLOOM_REDUCED_FALSEPOSITIVE_RATE * 10.0) {
+				Log::info("bloom filter false positive rate {} with {} elements added, rebuilding", fpRate,
+						  missing.size());
+				_bloomFilterSpare = std::min(_bloomFilterSpare * 2, (size_t) BLOOM_FILTER_MAX_SPARE);
+				_bloomFilter.reset();
+				UpdateBloomFilter();
+				return;
+			}
+
+			if (missing.size() > BLOOM_FILTER_MAX_ADDS) {
+				// one filterload per peer is less traffic than a filteradd for each element
+				for (size_t j = _connectedPeers.size(); j > 0; j--) {
+					const PeerPtr &p = _connectedPeers[j - 1];
+					if (p->GetConnectStatus() == Peer::Connected && p->SentFilter())
+						LoadBloomFilter(p);
+				}
+
+				Log::debug("loaded bloom filter with {} elements added", missing.size());
+				RerequestFilteredBlocks();
+				return;
+			}
+
+			for (size_t i = 0; i < missing.size(); ++i) {
+				FilterAddParameter filterAddParameter;
+				filterAddParameter.Data = missing[i];
+				for (size_t j = _connectedPeers.size(); j > 0; j--) {
+					const PeerPtr &p = _connectedPeers[j - 1];
+					if (p->GetConnectStatus() == Peer::Connected && p->SentFilter())
+						p->SendMessage(MSG_FILTERADD, filterAddParameter);
+				}
+			}
+
+			_bloomFilterElements += missing.size();
+			_bloomFilterAdds += missing.size();
+			Log::debug("added {} elements to bloom filter, {}/{} used", missing.size(), _bloomFilterElements,
+					   _bloomFilterCapacity);
+			RerequestFilteredBlocks();
+		}
+
+		void PeerManager::RerequestFilteredBlocks() {
+			if (!_downloadPeer || _lastBlock->GetHeight() >= _estimatedHeight) return;
+
+			// the merkleblocks in flight, and those fetched ahead by other peers, were filtered before the elements
+			// were added and may miss wallet transactions, fetch them again past the last block connected
+			StopParallelSync();
+			_downloadPeer->RerequestBlocks(_lastBlock->GetHash());
+			PingParameter pingParam(_lastBlock->GetHeight(),
+									boost::bind(&PeerManager::UpdateFilterRerequestDone, this, _downloadPeer, _1));
+			_downloadPeer->SendMessage(MSG_PING, pingParam);
+		}
+
 		void PeerManager::UpdateFilterRerequestDone(const PeerPtr &peer, int success) {
 			if (!success) return;
 
@@ -1700,15 +2124,14 @@ namespace Elastos {
 			if (!success) return;
 
 			peer->info("update filter load done");
+			CollectBloomFilterElements(); // a parallel sync loads the filter on the other peers
+
 			boost::mutex::scoped_lock scopedLock(lock);
 			peer->SetNeedsFilterUpdate(false);
 			peer->SetFlags(peer->GetFlags() & (uint8_t)(~PEER_FLAG_NEEDSUPDATE));
 
 			if (_lastBlock->GetHeight() < _estimatedHeight) { // if syncing, rerequest blocks
-				_downloadPeer->RerequestBlocks(_lastBlock->GetHash());
-				PingParameter pingParam(_lastBlock->GetHeight(),
-										boost::bind(&PeerManager::UpdateFilterRerequestDone, this, _downloadPeer, _1));
-				_downloadPeer->SendMessage(MSG_PING, pingParam);
+				RerequestFilteredBlocks();
 			} else {
 				MempoolParameter mempoolParameter;
 				mempoolParameter.KnownTxHashes = {};
@@ -1720,11 +2143,14 @@ namespace Elastos {
 		void PeerManager::UpdateFilterPingDone(const PeerPtr &peer, int success) {
 			if (!success) return;
 
+			CollectBloomFilterElements();
+
 			boost::mutex::scoped_lock scopedLock(lock);
 			peer->info("updating filter with newly created wallet addresses");
 			_bloomFilter = nullptr;
 
 			if (_lastBlock->GetHeight() < _estimatedHeight) { // if we're syncing, only update download peer
+				StopParallelSync(); // the other peers still have the old filter
 				if (_downloadPeer) {
 					LoadBloomFilter(_downloadPeer);
 					PingParameter pingParam(_lastBlock->GetHeight(),
@@ -1754,7 +2180,7 @@ namespace Elastos {
 			lock.lock();
 			if (success) {
 				MempoolParameter mempoolParameter;
-				mempoolParameter.KnownTxHashes = _publishedTxHashes;
+				mempoolParameter.KnownTxHashes = _publishedTx.Hashes();
 				mempoolParameter.CompletionCallback = boost::bind(&PeerManager::MempoolDone, this, peer, _1);
 				peer->SendMessage(MSG_MEMPOOL, mempoolParameter);
 				lock.unlock();
@@ -1772,51 +2198,29 @@ namespace Elastos {
 		}
 
 		std::vector<uint128> PeerManager::AddressLookup(const std::string &hostname) {
-			struct addrinfo hints, *servinfo, *p;
-			std::vector<uint128> addrList;
-
-			memset(&hints, 0, sizeof(hints));
-			hints.ai_socktype = SOCK_STREAM;
-			hints.ai_family = PF_UNSPEC;
-			if (getaddrinfo(hostname.c_str(), NULL, &hints, &servinfo) == 0) {
-				for (p = servinfo; p != NULL; p = p->ai_next) {
-					uint128 addr;
-					char host[INET6_ADDRSTRLEN];
-					if (p->ai_family == AF_INET) {
-						*(uint16_t *)&addr.begin()[10] = 0xffff;
-						*(uint32_t *)&addr.begin()[12] = ((struct sockaddr_in *) p->ai_addr)->sin_addr.s_addr;
-						inet_ntop(AF_INET, &addr.begin()[12], host, sizeof(host));
-					} else if (p->ai_family == AF_INET6) {
-						memcpy(addr.begin(), &((struct sockaddr_in6 *) p->ai_addr)->sin6_addr, addr.size());
-						inet_ntop(AF_INET6, addr.begin(), host, sizeof(host));
-					}
-					Log::debug("{} {} -> {}", GetID(), hostname, host);
-					addrList.push_back(addr);
-				}
-
-				freeaddrinfo(servinfo);
-			}
-
-			addrList.shrink_to_fit();
-			return addrList;
+			return _seedResolver.GetResolver()->Lookup(hostname);
 		}
 
 		bool PeerManager::VerifyBlock(const MerkleBlockPtr &block, const MerkleBlockPtr &prev, const PeerPtr &peer) {
+			SyncMetrics::Timer timer(_syncMetrics, SyncMetrics::VerifyBlock);
 			bool r = true;
 
 			if (!prev || block->GetPrevBlockHash() != prev->GetHash() ||
 				block->GetHeight() != prev->GetHeight() + 1)
 				r = false;
 
-			// check if we hit a difficulty transition, and find previous transition time
+			if (r && !VerifyDifficulty(block, prev)) {
+				peer->error("relayed block with invalid difficulty target {}, blockHash: {}", block->GetTarget(),
+							block->GetHash().GetHex());
+				r = false;
+			}
+
+			// check if we hit a difficulty transition, and free up the index behind the previous one
 			if (r && (block->GetHeight() % BLOCK_DIFFICULTY_INTERVAL) == 0) {
-				MerkleBlockPtr b = block;
+				MerkleBlockPtr b = _blocks.GetAncestor(block->GetPrevBlockHash(),
+														block->GetHeight() - BLOCK_DIFFICULTY_INTERVAL);
 				uint256 prevBlock;
 
-				for (uint32_t i = 0; b && i < BLOCK_DIFFICULTY_INTERVAL; i++) {
-					b = _blocks.Get(b->GetPrevBlockHash());
-				}
-
 				if (!b) {
 					peer->warn("missing previous difficulty tansition, block height: {}", block->GetHeight());
 //					peer->warn("missing previous difficulty tansition, can't verify block: {}",
@@ -1824,21 +2228,20 @@ namespace Elastos {
 					//r = false;
 				} else prevBlock = b->GetPrevBlockHash();
 
-				while (b) { // free up some memory
-					b = _blocks.Get(prevBlock);
-					if (b) prevBlock = b->GetPrevBlockHash();
+				// free up some memory, older transitions are only needed as headers for difficulty and locators
+				const BlockIndex::Header *h = b ? _blocks.GetHeader(prevBlock) : nullptr;
+				while (h) {
+					uint256 hash = h->hash;
+					prevBlock = h->prevHash;
 
-					if (b && (b->GetHeight() % BLOCK_DIFFICULTY_INTERVAL) != 0) {
-						_blocks.Remove(b);
+					if ((h->height % BLOCK_DIFFICULTY_INTERVAL) != 0) {
+						_blocks.Remove(hash);
+					} else {
+						_blocks.Compact(hash);
 					}
-				}
-			}
 
-			//fixme figure out why difficult validation fails occasionally
-			if (0 && VerifyDifficulty(_chainParams, block, _blocks)) {
-				peer->error("relayed block with invalid difficulty target {}, blockHash: {}", block->GetTarget(),
-							block->GetHash().GetHex());
-				r = false;
+					h = _blocks.GetHeader(prevBlock);
+				}
 			}
 
 			if (r) {
@@ -1856,20 +2259,84 @@ namespace Elastos {
 			return r;
 		}
 
+		bool PeerManager::VerifyDifficulty(const MerkleBlockPtr &block, const MerkleBlockPtr &prev) const {
+			uint32_t targetTimeSpan = _chainParams->TargetTimeSpan();
+			uint32_t targetTimePerBlock = _chainParams->TargetTimePerBlock();
+
+			if (targetTimeSpan == 0 || targetTimePerBlock == 0) // chain without difficulty retargeting
+				return true;
+
+			uint32_t blocksPerRetarget = targetTimeSpan / targetTimePerBlock;
+
+			// the target only changes at a difficulty transition
+			if ((block->GetHeight() % blocksPerRetarget) != 0)
+				return prev->GetHeight() == 0 || block->GetTarget() == prev->GetTarget();
+
+			// private and regression nets mine at a proof of work limit of their own, which isn't a chain parameter
+			if (_netType != "MainNet" && _netType != "TestNet")
+				return true;
+
+			// the previous transition is not indexed if the chain was loaded after it, the new target can't be
+			// verified then
+			const BlockIndex::Header *transition = block->GetHeight() >= blocksPerRetarget ?
+				_blocks.GetAncestorHeader(block->GetPrevBlockHash(), block->GetHeight() - blocksPerRetarget) : nullptr;
+			if (!transition) {
+				Log::debug("missing previous difficulty transition, block height: {}", block->GetHeight());
+				return true;
+			}
+
+			// block timestamps aren't ordered, the interval may have taken a negative time
+			int64_t timespan = (int64_t) prev->GetTimestamp() - (int64_t) transition->timestamp;
+			return block->GetTarget() == RetargetCompact(prev->GetTarget(), timespan, targetTimeSpan);
+		}
+
+		uint32_t PeerManager::RetargetCompact(uint32_t target, int64_t timespan, uint32_t targetTimeSpan) {
+			int32_t size = target >> 24;
+			uint64_t t = target & 0x007fffff;
+
+			// limit difficulty transition to -75% or +400%
+			if (timespan < targetTimeSpan / 4) timespan = targetTimeSpan / 4;
+			if (timespan > (int64_t) targetTimeSpan * 4) timespan = (int64_t) targetTimeSpan * 4;
+
+			// the target timespan isn't a multiple of 256, so shift the mantissa up a byte before dividing by it, that
+			// keeps the bits the compact form truncates to
+			t = t * (uint64_t) timespan * 256 / targetTimeSpan;
+			size--;
+
+			while (size < 1 || t > 0x007fffff) t >>= 8, size++; // normalize target for "compact" format
+			t |= (uint64_t) size << 24;
+
+			return t > POW_LIMIT ? POW_LIMIT : (uint32_t) t;
+		}
+
+		void PeerManager::CompactInterval(const MerkleBlockPtr &transition) {
+			// the save window starts at the last transition, and that's where InitBlocks links stored blocks from, so the
+			// blocks before it are only needed as headers for locators and fork joins
+			uint32_t height = transition->GetHeight() > BLOCK_DIFFICULTY_INTERVAL ?
+							  transition->GetHeight() - BLOCK_DIFFICULTY_INTERVAL : 0;
+			const BlockIndex::Header *h = _blocks.GetHeader(transition->GetPrevBlockHash());
+			while (h && h->height >= height) {
+				uint256 prevBlock = h->prevHash;
+				_blocks.Compact(h->hash);
+				h = _blocks.GetHeader(prevBlock);
+			}
+		}
+
 		std::vector<uint256> PeerManager::GetBlockLocators() {
 			// append 10 most recent block hashes, decending, then continue appending, doubling the step back each time,
 			// finishing with the genesis block (top, -1, -2, -3, -4, -5, -6, -7, -8, -9, -11, -15, -23, -39, -71, -135, ..., 0)
-			MerkleBlockPtr block = _lastBlock;
-			int32_t step = 1, i = 0, j;
+			const BlockIndex::Header *header = _lastBlock ? _blocks.GetHeader(_lastBlock->GetHash()) : nullptr;
+			int32_t step = 1, i = 0;
 
 			std::vector<uint256> locators;
-			while (block != nullptr && block->GetHeight() > 0) {
-				locators.push_back(block->GetHash());
+			while (header != nullptr && header->height > 0) {
+				locators.push_back(header->hash);
 				if (++i >= 10) step *= 2;
 
-				for (j = 0; block && j < step; j++) {
-					block = _blocks.Get(block->GetPrevBlockHash());
-				}
+				if (header->height > (uint32_t) step)
+					header = _blocks.GetAncestorHeader(header->hash, header->height - step);
+				else
+					header = nullptr;
 			}
 
 			locators.push_back(_chainParams->FirstCheckpoint().Hash());
@@ -1891,19 +2358,30 @@ namespace Elastos {
 					peer->SendMessage(MSG_PING, pingParameter);
 				} else {
 					MempoolParameter mempoolParameter;
-					mempoolParameter.KnownTxHashes = _publishedTxHashes;
+					mempoolParameter.KnownTxHashes = _publishedTx.Hashes();
 					mempoolParameter.CompletionCallback = boost::bind(&PeerManager::MempoolDone, this, peer, _1);
 					peer->SendMessage(MSG_MEMPOOL, mempoolParameter);
 				}
 			}
 		}
 
+		void PeerManager::ReloadBloomFilters() {
+			// the filters of the other peers go out once the wallet has seen every block of the chain sync
+			CollectBloomFilterElements();
+
+			boost::mutex::scoped_lock scopedLock(lock);
+			LoadMempools();
+		}
+
 		void PeerManager::MempoolDone(const PeerPtr &peer, int success) {
 			bool syncFinished = false;
 
 			if (success) {
 				peer->info("mempool request finished");
 				MerkleBlockPtr block;
+				double progress;
+				uint32_t bytesPerSecond;
+				std::vector<TransactionPtr> unconfirmed = _wallet->TxUnconfirmedBefore(TX_UNCONFIRMED);
 
 				{
 					boost::mutex::scoped_lock scopedLock(lock);
@@ -1916,25 +2394,29 @@ namespace Elastos {
 					}
 
 					block = _lastBlock;
-					RequestUnrelayedTx(peer);
+					progress = GetSyncProgressInternal(0);
+					bytesPerSecond = TakeDownloadRate(peer);
+					RequestUnrelayedTx(peer, unconfirmed);
 					peer->SendMessage(MSG_GETADDR, Message::DefaultParam);
 				}
 
-				FireTxStatusUpdate();
-				FireSyncProgress(GetSyncProgressInternal(0), peer, block);
-				if (syncFinished) FireSyncStopped(0);
+				// report the sync done once the wallet caught up with the blocks queued for it
+				_walletApply.Post([this, peer, block, progress, bytesPerSecond, syncFinished]() {
+					FireTxStatusUpdate();
+					FireSyncProgress(progress, bytesPerSecond, peer, block);
+					if (syncFinished) FireSyncStopped(0);
+				});
 			} else peer->info("mempool request failed");
 		}
 
-		void PeerManager::RequestUnrelayedTx(const PeerPtr &peer) {
-			std::vector<TransactionPtr> tx = _wallet->TxUnconfirmedBefore(TX_UNCONFIRMED);
+		void PeerManager::RequestUnrelayedTx(const PeerPtr &peer, const std::vector<TransactionPtr> &tx) {
 			std::vector<uint256> txHashes;
 
 			for (size_t i = 0; i < tx.size(); i++) {
-				if (!PeerListHasPeer(_txRelays, tx[i]->GetHash(), peer) &&
-					!PeerListHasPeer(_txRequests, tx[i]->GetHash(), peer)) {
+				if (!_txRelays.HasPeer(tx[i]->GetHash(), peer->GetPeerInfo()) &&
+					!_txRequests.HasPeer(tx[i]->GetHash(), peer->GetPeerInfo())) {
 					txHashes.push_back(tx[i]->GetHash());
-					AddPeerToList(peer, tx[i]->GetHash(), _txRequests);
+					_txRequests.AddPeer(tx[i]->GetHash(), peer->GetPeerInfo(), time(NULL), true);
 				}
 			}
 
@@ -1951,24 +2433,7 @@ namespace Elastos {
 			} else peer->SetFlags(peer->GetFlags() | PEER_FLAG_SYNCED);
 		}
 
-		bool PeerManager::PeerListHasPeer(const std::vector<TransactionPeerList> &peerList, const uint256 &txhash,
-										  const PeerPtr &peer) {
-			for (size_t i = peerList.size(); i > 0; i--) {
-				if (peerList[i - 1].GetTransactionHash() != txhash) continue;
-
-				for (size_t j = peerList[i - 1].GetPeers().size(); j > 0; j--) {
-					if (peerList[i - 1].GetPeers()[j - 1]->IsEqual(peer.get()))
-						return true;
-				}
-
-				break;
-			}
-
-			return false;
-		}
-
 		void PeerManager::RequestUnrelayedTxGetDataDone(const PeerPtr &callbackPeer, int success) {
-			bool isPublishing;
 			size_t count = 0;
 			PeerPtr peer = callbackPeer;
 
@@ -1985,56 +2450,45 @@ namespace Elastos {
 
 			// don't remove transactions until we're connected to maxConnectCount peers, and all peers have finished
 			// relaying their mempools
-			if (count >= _maxConnectCount) {
-				uint256 hash;
-				std::vector<TransactionPtr> tx = _wallet->TxUnconfirmedBefore(TX_UNCONFIRMED);
+			if (count >= _maxConnectCount)
+				_walletApply.Post(boost::bind(&PeerManager::RemoveUnrelayedTx, this, peer));
+		}
+
+		void PeerManager::RemoveUnrelayedTx(const PeerPtr &peer) {
+			bool isPublishing;
+			uint256 hash;
+			std::vector<uint256> removed, unverified;
+			std::vector<TransactionPtr> tx = _wallet->TxUnconfirmedBefore(TX_UNCONFIRMED);
+
+			{
+				boost::mutex::scoped_lock scopedLock(lock);
 
 				for (size_t i = tx.size(); i > 0; i--) {
 					hash = tx[i - 1]->GetHash();
-					isPublishing = false;
-
-					for (size_t j = _publishedTx.size(); !isPublishing && j > 0; j--) {
-						if (_publishedTx[j - 1].GetTransaction()->IsEqual(*tx[i - 1]) &&
-							_publishedTx[j - 1].HasCallback())
-							isPublishing = true;
-						break;
-					}
+					isPublishing = _publishedTx.Get(hash).HasCallback();
 
-					if (!isPublishing && PeerListCount(_txRelays, hash) == 0 &&
-						PeerListCount(_txRequests, hash) == 0) {
+					if (!isPublishing && _txRelays.PeerCount(hash) == 0 && _txRequests.PeerCount(hash) == 0) {
 						peer->info("removing tx unconfirmed at: {}, txHash: {}", _lastBlock->GetHeight(), hash.GetHex());
-						_wallet->RemoveTransaction(hash);
-					} else if (!isPublishing && PeerListCount(_txRelays, hash) < _maxConnectCount) {
-						// set timestamp 0 to mark as unverified
-						_wallet->UpdateTransactions({hash}, TX_UNCONFIRMED, 0);
+						removed.push_back(hash);
+					} else if (!isPublishing && _txRelays.PeerCount(hash) < _maxConnectCount) {
+						unverified.push_back(hash);
 					}
 				}
 			}
-		}
 
-		size_t PeerManager::PeerListCount(const std::vector<TransactionPeerList> &list, const uint256 &txhash) {
-			for (size_t i = list.size(); i > 0; i--) {
-				if (list[i - 1].GetTransactionHash() == txhash)
-					return list[i - 1].GetPeers().size();
-			}
+			for (size_t i = 0; i < removed.size(); ++i)
+				_wallet->RemoveTransaction(removed[i]);
 
-			return 0;
+			// set timestamp 0 to mark as unverified
+			if (!unverified.empty())
+				_wallet->UpdateTransactions(unverified, TX_UNCONFIRMED, 0);
 		}
 
 		void PeerManager::PublishTxInvDone(const PeerPtr &peer, int success) {
-			boost::mutex::scoped_lock scopedLock(lock);
-			RequestUnrelayedTx(peer);
-		}
-
-		void PeerManager::FindPeersThreadRoutine(const std::string &hostname, uint64_t services) {
-			std::vector<uint128> addrList = AddressLookup(hostname);
-			time_t now = time(NULL);
+			std::vector<TransactionPtr> unconfirmed = _wallet->TxUnconfirmedBefore(TX_UNCONFIRMED);
 
 			boost::mutex::scoped_lock scopedLock(lock);
-			for (std::vector<uint128>::iterator addr = addrList.begin(); addr != addrList.end() && (*addr) != 0; addr++) {
-				_peers.emplace_back(*addr, _chainParams->StandardPort(), now, services);
-			}
-			_dnsThreadCount--;
+			RequestUnrelayedTx(peer, unconfirmed);
 		}
 
 	}
@@ -6,8 +6,15 @@
 #define __ELASTOS_SDK_PEERMANAGER_H__
 
 #include "Peer.h"
-#include "TransactionPeerList.h"
-#include "PublishedTransaction.h"
+#include "BlockIndex.h"
+#include "BlockRangeScheduler.h"
+#include "OrphanPool.h"
+#include "TransactionPeerMap.h"
+#include "PublishedTransactionQueue.h"
+#include "PeerScoreBoard.h"
+#include "SeedResolver.h"
+#include "WalletApplyQueue.h"
+#include "SyncMetrics.h"
 
 #include <Common/Lockable.h>
 #include <WalletCore/BloomFilter.h>
@@ -19,12 +26,11 @@
 #include <vector>
 #include <boost/weak_ptr.hpp>
 #include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
 #include <boost/function.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/asio.hpp>
 
-#define PEER_MAX_CONNECTIONS 1
-
 namespace Elastos {
 	namespace ElaWallet {
 
@@ -33,7 +39,6 @@ namespace Elastos {
 
 		typedef boost::shared_ptr<Wallet> WalletPtr;
 		typedef boost::shared_ptr<ChainParams> ChainParamsPtr;
-		typedef ElementSet<MerkleBlockPtr> BlockSet;
 
 		class PeerManager :
 				public Lockable,
@@ -60,6 +65,10 @@ namespace Elastos {
 
 				virtual void saveBlackPeer(const PeerInfo &peer) = 0;
 
+				virtual void savePeerScores(const std::vector<PeerScore> &scores) = 0;
+
+				virtual void saveSeedPeers(const std::string &seed, const std::vector<PeerInfo> &peers) = 0;
+
 				virtual bool networkIsReachable() = 0;
 
 				virtual void txPublished(const std::string &hash, const nlohmann::json &result) = 0;
@@ -75,6 +84,8 @@ namespace Elastos {
 						const std::vector<MerkleBlockPtr> &blocks,
 						const std::vector<PeerInfo> &peers,
 						const std::set<PeerInfo> &blackPeers,
+						const std::vector<PeerScore> &peerScores,
+						const SeedPeerMap &seedPeers,
 						const boost::shared_ptr<Listener> &listener,
 						const std::string &chainID,
 						const std::string &netType);
@@ -82,14 +93,18 @@ namespace Elastos {
 			~PeerManager();
 
 			void SetWallet(const WalletPtr &wallet);
+
+			// resolver of the dns seeds and fixed peer addresses, the system resolver by default
+			void SetDNSResolver(const DNSResolverPtr &resolver);
 			/**
 			* Connect to bitcoin peer-to-peer network (also call this whenever networkIsReachable()
 			* status changes)
 			*/
 			void Connect();
 
-			void AsyncConnect(const boost::system::error_code &error);
+			void AsyncConnect();
 
+			// connect after @second seconds on the peer reactor's timer thread, returns right away
 			void ConnectLaster(time_t second);
 
 			void CancelTimer();
@@ -110,6 +125,9 @@ namespace Elastos {
 
 			uint32_t GetLastBlockHeight() const;
 
+			// blocks of the chain index, every branch of a fork included
+			size_t GetBlockCount() const;
+
 			uint32_t GetLastBlockTimestamp() const;
 
 			time_t GetKeepAliveTimestamp() const;
@@ -138,12 +156,52 @@ namespace Elastos {
 
 			size_t GetPeerCount() const;
 
+			// full bloom filter builds sent with filterload
+			uint64_t GetBloomFilterRebuildCount() const;
+
+			// wallet elements sent to peers with filteradd instead of a rebuild
+			uint64_t GetBloomFilterAddCount() const;
+
 			void PublishTransaction(const TransactionPtr &transaction);
 
 			void PublishTransaction(const TransactionPtr &transaction, const Peer::PeerPubTxCallback &callback);
 
 			uint64_t GetRelayCount(const uint256 &txHash) const;
 
+			// transactions tracked for relays, outstanding getdata and publishing
+			size_t GetTxRelaysSize() const;
+
+			size_t GetTxRequestsSize() const;
+
+			size_t GetPublishedTxSize() const;
+
+			PeerScore GetPeerScore(const PeerInfo &peer) const;
+
+			// download peers dropped mid-sync for falling behind the best observed throughput
+			uint64_t GetDownloadPeerSwitchCount() const;
+
+			// orphan blocks held, and dropped to keep the orphan pool within its caps
+			size_t GetOrphanCount() const;
+
+			uint64_t GetOrphanEvictedCount() const;
+
+			// wallet updates queued behind the chain sync, and the most that were ever queued at once
+			size_t GetWalletApplyPending() const;
+
+			size_t GetWalletApplyPeak() const;
+
+			// wait until the wallet updates queued so far are applied, not from a listener callback
+			void FlushWalletApply();
+
+			// apply the wallet updates left and drop any posted after, before the wallet and listener go away
+			void StopWalletApply();
+
+			// latency histograms and counters of the sync hot path, recorded without taking the lock
+			SyncMetrics &GetSyncMetrics();
+
+			// the sync metrics together with the PeerManager's own sync counters
+			nlohmann::json GetSyncMetricsInfo() const;
+
 			const std::string &GetChainID() const;
 
 			const std::vector<PeerInfo> &GetPeers() const;
@@ -152,6 +210,10 @@ namespace Elastos {
 
 			const std::string &GetID() const;
 
+			// the compact target of a difficulty transition whose previous interval, ending with a block of compact
+			// @target, took @timespan seconds
+			static uint32_t RetargetCompact(uint32_t target, int64_t timespan, uint32_t targetTimeSpan);
+
 		public:
 			virtual void OnConnected(const PeerPtr &peer);
 
@@ -167,6 +229,9 @@ namespace Elastos {
 
 			virtual void OnRelayedBlock(const PeerPtr &peer, const MerkleBlockPtr &block);
 
+			virtual void
+			OnRelayedBlockHashes(const PeerPtr &peer, const std::vector<uint256> &blockHashes, bool full);
+
 			virtual void OnRelayedPing(const PeerPtr &peer);
 
 			virtual void OnNotfound(const PeerPtr &peer, const std::vector<uint256> &txHashes,
@@ -180,6 +245,15 @@ namespace Elastos {
 
 			virtual void OnThreadCleanup(const PeerPtr &peer);
 
+		protected:
+			// runs on the wallet apply thread, once the blocks queued before it updated the wallet
+			void RemoveUnrelayedTx(const PeerPtr &peer);
+
+			// called with lock held: the block's target against the previous block's, or the retarget at a transition
+			bool VerifyDifficulty(const MerkleBlockPtr &block, const MerkleBlockPtr &prev) const;
+
+			TransactionPeerMap _txRelays, _txRequests;
+
 		private:
 			void InitBlocks(const std::vector<MerkleBlockPtr> &blocks);
 
@@ -190,7 +264,8 @@ namespace Elastos {
 		private:
 			void FireSyncStarted();
 
-			void FireSyncProgress(double progress, const PeerPtr &peer, const MerkleBlockPtr &block);
+			void FireSyncProgress(double progress, uint32_t bytesPerSecond, const PeerPtr &peer,
+								  const MerkleBlockPtr &block);
 
 			void FireSyncStopped(int error);
 
@@ -202,6 +277,10 @@ namespace Elastos {
 
 			void FireSaveBlackPeer(const PeerInfo &peer);
 
+			void FireSavePeerScores(const std::vector<PeerScore> &scores);
+
+			void FireSaveSeedPeers(const std::string &seed, const std::vector<PeerInfo> &peers);
+
 			bool FireNetworkIsReachable();
 
 			void FireTxPublished(const uint256 &hash, int code, const std::string &reason);
@@ -210,48 +289,86 @@ namespace Elastos {
 
 			void FireThreadCleanup();
 
-			int VerifyDifficulty(const ChainParamsPtr &params, const MerkleBlockPtr &block,
-								 const BlockSet &blockSet);
-
-			int VerifyDifficultyInner(const MerkleBlockPtr &block, const MerkleBlockPtr &previous,
-									  uint32_t transitionTime, uint32_t targetTimeSpan, uint32_t targetTimePerBlock);
+			// gather the wallet's filter elements, called without the lock, as the wallet takes its own and reads the db
+			void CollectBloomFilterElements();
 
+			// called with lock held: load a filter of the elements last collected on @peer
 			void LoadBloomFilter(const PeerPtr &peer);
 
 			void UpdateBloomFilter();
 
+			// insert elements the filter doesn't match yet and send them to the peers with filteradd
+			void AddBloomFilterElements(const std::vector<bytes_t> &elements);
+
+			// called with lock held: while syncing, fetch the blocks past the last one connected again with the
+			// current filter
+			void RerequestFilteredBlocks();
+
+			// add cached dns seed peers and start looking up the seeds not cached, returns without waiting
 			void FindPeers();
 
+			// merge @peers into the known peers
+			void AddPeers(const std::vector<PeerInfo> &peers, uint64_t services);
+
+			void OnSeedResolved(const std::string &seed, const std::vector<PeerInfo> &peers);
+
 			void SortPeers();
 
 			void SyncStopped();
 
+			// connect @block to the chain, returns the block buffered to follow it, if any. @scheduled tells if
+			// @block was fetched by parallel sync, and is set for the returned block
+			MerkleBlockPtr AcceptBlock(const PeerPtr &peer, const MerkleBlockPtr &block, bool &scheduled);
+
+			// fetch merkleblocks from all connected peers while the download peer provides the block hashes
+			void StartParallelSync();
+
+			void StopParallelSync();
+
+			// take ranges back from stalled peers and hand out ranges to idle ones
+			void AssignSyncRanges();
+
+			void OnSyncTimer();
+
+			// cancel @timer and schedule @task in its place on the timer thread, unless the manager is going away;
+			// called with lock held
+			void ResetTimer(uint64_t &timer, double delay, const boost::function<void()> &task);
+
 			void AddTxToPublishList(const TransactionPtr &tx, const Peer::PeerPubTxCallback &callback);
 
 			size_t PublishPendingTx(const PeerPtr &peer);
 
-			size_t
-			AddPeerToList(const PeerPtr &peer, const uint256 &txHash, std::vector<TransactionPeerList> &peerList);
+			void PeerMisbehaving(const PeerPtr &peer);
 
-			bool
-			RemovePeerFromList(const PeerPtr &peer, const uint256 &txHash, std::vector<TransactionPeerList> &peerList);
+			// feed @peer's merkleblock throughput to its score, and drop the download peer if it falls far behind
+			void RecordThroughput(const PeerPtr &peer);
 
-			void PeerMisbehaving(const PeerPtr &peer);
+			// runs on the wallet apply thread: count the false positives of a block from the download peer
+			void UpdateFpRate(const PeerPtr &peer, const std::vector<uint256> &txHashes, uint32_t txCount);
+
+			// run on the wallet apply thread: add a tx @peer relayed or announced to the wallet, and track its relays.
+			// While @syncing only a tx the wallet already knows or pays one of its addresses is kept
+			void RegisterRelayedTx(const PeerPtr &peer, const TransactionPtr &transaction, size_t relayCount,
+								   bool syncing);
+
+			void RegisterHasTx(const PeerPtr &peer, const TransactionPtr &transaction, size_t relayCount);
 
 			std::vector<uint128> AddressLookup(const std::string &hostname);
 
 			bool VerifyBlock(const MerkleBlockPtr &block, const MerkleBlockPtr &prev, const PeerPtr &peer);
 
+			// keep only the header records of the interval closed by the transition block @transition
+			void CompactInterval(const MerkleBlockPtr &transition);
+
 			std::vector<uint256> GetBlockLocators();
 
 			void LoadMempools();
 
-			void RequestUnrelayedTx(const PeerPtr &peer);
-
-			bool PeerListHasPeer(const std::vector<TransactionPeerList> &peerList, const uint256 &txhash,
-								 const PeerPtr &peer);
+			// runs on the wallet apply thread: LoadMempools() once the chain sync is complete
+			void ReloadBloomFilters();
 
-			size_t PeerListCount(const std::vector<TransactionPeerList> &list, const uint256 &txhash);
+			// called with lock held: ask @peer for the unconfirmed wallet tx @tx it hasn't relayed yet
+			void RequestUnrelayedTx(const PeerPtr &peer, const std::vector<TransactionPtr> &tx);
 
 			void UpdateAddressOnlyDone(const PeerPtr &peer, int success);
 
@@ -269,14 +386,16 @@ namespace Elastos {
 
 			void PublishTxInvDone(const PeerPtr &peer, int success);
 
-			void FindPeersThreadRoutine(const std::string &hostname, uint64_t services);
-
-			void ReconnectLaster(time_t seconds);
+			// disconnect all peers, and connect again @seconds after the last one is gone, without blocking the caller
+			void ScheduleReconnect(time_t seconds);
 
 			double GetSyncProgressInternal(uint32_t startHeight);
 
+			// called with lock held: merkleblock bytes per second @peer sent since the last call
+			uint32_t TakeDownloadRate(const PeerPtr &peer);
+
 		private:
-			int _isConnected, _connectFailureCount, _misbehavinCount, _dnsThreadCount, _maxConnectCount;
+			int _isConnected, _connectFailureCount, _misbehavinCount, _maxConnectCount;
 			bool _syncSucceeded, _enableReconnect;
 
 			Peer::ConnectStatus _connectStatus;
@@ -285,28 +404,44 @@ namespace Elastos {
 			PeerInfo _fixedPeer;
 
 			std::vector<PeerPtr> _connectedPeers;
+			boost::condition_variable _peersDisconnected; // signalled when the last connected peer is gone
 			PeerPtr _downloadPeer;
 
 			mutable std::string _downloadPeerName;
 			time_t _keepAliveTimestamp, _earliestKeyTime;
 			uint32_t _reconnectSeconds, _syncStartHeight, _filterUpdateHeight, _estimatedHeight;
 			BloomFilterPtr _bloomFilter;
+			std::vector<bytes_t> _walletElements;
+			bool _isSideWallet;
+			size_t _bloomFilterElements, _bloomFilterCapacity, _bloomFilterSpare;
+			uint64_t _bloomFilterRebuilds, _bloomFilterAdds;
 			double _fpRate, _averageTxPerBlock;
-			BlockSet _blocks;
-			BlockSet _orphans;
-			BlockSet _checkpoints;
+			BlockIndex _blocks;
+			OrphanPool _orphans;
+			BlockIndex _checkpoints;
+			BlockIndex _syncBlocks; // fetched ahead of the chain tip by parallel sync
+			BlockRangeScheduler _syncScheduler;
+			bool _parallelSync;
+			uint64_t _syncTimer;
 			MerkleBlockPtr _lastBlock, _lastOrphan;
-			std::vector<TransactionPeerList> _txRelays, _txRequests;
-			std::vector<PublishedTransaction> _publishedTx;
-			std::vector<uint256> _publishedTxHashes;
+			PublishedTransactionQueue _publishedTx;
+			PeerScoreBoard _peerScores;
+			time_t _downloadPeerTime;
+			uint64_t _downloadPeerSwitches;
 
 			std::string _chainID;
 			std::string _netType;
 			WalletPtr _wallet;
 			ChainParamsPtr _chainParams;
 
-			boost::asio::io_service _reconnectService;
-			boost::shared_ptr<boost::asio::deadline_timer> _reconnectTimer;
+			uint64_t _reconnectTimer;
+			bool _reconnectPending;
+			time_t _reconnectDelay;
+			SeedResolver _seedResolver;
+			uint64_t _seedTimer;
+			bool _timersStopped;
+			WalletApplyQueue _walletApply;
+			SyncMetrics _syncMetrics;
 
 			boost::weak_ptr<Listener> _listener;
 		};
@@ -0,0 +1,132 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "PeerReactor.h"
+
+#include <Common/Log.h>
+
+namespace Elastos {
+	namespace ElaWallet {
+
+		PeerReactor *PeerReactor::Instance() {
+			static PeerReactor instance(PEER_REACTOR_THREADS);
+			return &instance;
+		}
+
+		PeerReactor::PeerReactor(size_t threadCount) :
+			_work(new boost::asio::io_service::work(_service)),
+			_timerWork(new boost::asio::io_service::work(_timerService)),
+			_nextTimerID(1),
+			_runningTimerID(0),
+			_peerTimers(0) {
+			for (size_t i = 0; i < threadCount; ++i)
+				_threads.create_thread(boost::bind(&boost::asio::io_service::run, &_service));
+			_threads.create_thread(boost::bind(&boost::asio::io_service::run, &_timerService));
+
+			Log::info("peer reactor started with {} thread(s)", threadCount);
+		}
+
+		PeerReactor::~PeerReactor() {
+			_work.reset();
+			_timerWork.reset();
+			_service.stop();
+			_timerService.stop();
+			_threads.join_all();
+		}
+
+		boost::asio::io_service &PeerReactor::GetService() {
+			return _service;
+		}
+
+		size_t PeerReactor::GetThreadCount() const {
+			return _threads.size() - 1;
+		}
+
+		PeerReactor::TimerID PeerReactor::Schedule(double delay, const Task &task) {
+			boost::mutex::scoped_lock scopedLock(_tasksLock);
+			TimerID id = _nextTimerID++;
+
+			ScheduledTask &scheduled = _tasks[id];
+			scheduled.timer = boost::shared_ptr<boost::asio::deadline_timer>(
+				new boost::asio::deadline_timer(_timerService));
+			scheduled.task = task;
+
+			scheduled.timer->expires_from_now(boost::posix_time::microseconds(delay > 0 ? (int64_t) (delay * 1000000) : 0));
+			scheduled.timer->async_wait(boost::bind(&PeerReactor::OnScheduled, this, id, boost::asio::placeholders::error));
+
+			return id;
+		}
+
+		bool PeerReactor::Cancel(TimerID id) {
+			boost::mutex::scoped_lock scopedLock(_tasksLock);
+			std::map<TimerID, ScheduledTask>::iterator it = _tasks.find(id);
+			if (it == _tasks.end())
+				return false;
+
+			boost::system::error_code ec;
+			it->second.timer->cancel(ec);
+			_tasks.erase(it);
+			return true;
+		}
+
+		void PeerReactor::WaitForRunningTask() {
+			boost::mutex::scoped_lock scopedLock(_tasksLock);
+			if (boost::this_thread::get_id() == _timerThread)
+				return;
+
+			TimerID running = _runningTimerID;
+			while (running != 0 && _runningTimerID == running)
+				_taskDone.wait(scopedLock);
+		}
+
+		size_t PeerReactor::PendingTasks() const {
+			boost::mutex::scoped_lock scopedLock(_tasksLock);
+			return _tasks.size();
+		}
+
+		void PeerReactor::PeerTimerArmed() {
+			_peerTimers++;
+		}
+
+		void PeerReactor::PeerTimerDone() {
+			_peerTimers--;
+		}
+
+		size_t PeerReactor::PendingTimers() const {
+			return PendingTasks() + _peerTimers;
+		}
+
+		void PeerReactor::OnScheduled(TimerID id, const boost::system::error_code &ec) {
+			Task task;
+
+			{
+				boost::mutex::scoped_lock scopedLock(_tasksLock);
+				std::map<TimerID, ScheduledTask>::iterator it = _tasks.find(id);
+				if (it == _tasks.end()) // cancelled
+					return;
+
+				task = it->second.task;
+				_tasks.erase(it);
+				_runningTimerID = id;
+				_timerThread = boost::this_thread::get_id();
+			}
+
+			// a throwing task must not take down the timer thread or leave WaitForRunningTask blocked on it
+			if (!ec && task) {
+				try {
+					task();
+				} catch (const std::exception &e) {
+					Log::error("scheduled task {}: {}", id, e.what());
+				} catch (...) {
+					Log::error("scheduled task {}: unknown exception", id);
+				}
+			}
+
+			boost::mutex::scoped_lock scopedLock(_tasksLock);
+			_runningTimerID = 0;
+			_taskDone.notify_all();
+		}
+
+	}
+}
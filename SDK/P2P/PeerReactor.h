@@ -0,0 +1,88 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef __ELASTOS_SDK_PEERREACTOR_H__
+#define __ELASTOS_SDK_PEERREACTOR_H__
+
+#include <boost/asio.hpp>
+#include <boost/thread.hpp>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <atomic>
+#include <map>
+
+#define PEER_REACTOR_THREADS 2
+
+namespace Elastos {
+	namespace ElaWallet {
+
+		/**
+		 * Process wide event loop for peer sockets and timers. Every Peer of every PeerManager runs its
+		 * socket reads and timeouts on this io_service, through its own strand, instead of owning a thread.
+		 * Delayed PeerManager work (reconnects, sync range checks) is scheduled on a separate timer thread,
+		 * since it may block for a while on DNS or on peers disconnecting without holding up socket I/O.
+		 */
+		class PeerReactor : public boost::noncopyable {
+		public:
+			typedef uint64_t TimerID;
+			typedef boost::function<void()> Task;
+
+			static PeerReactor *Instance();
+
+			~PeerReactor();
+
+			boost::asio::io_service &GetService();
+
+			size_t GetThreadCount() const;
+
+			// run @task on the timer thread after @delay seconds, returns an id to cancel it with
+			TimerID Schedule(double delay, const Task &task);
+
+			// returns false if the task already ran or is running
+			bool Cancel(TimerID id);
+
+			// wait until the task running on the timer thread, if any, is done. Returns at once when called from a task,
+			// and must not be called holding a lock a task may take
+			void WaitForRunningTask();
+
+			// tasks waiting in Schedule()
+			size_t PendingTasks() const;
+
+			// a peer armed or is done with its own timer on GetService()
+			void PeerTimerArmed();
+
+			void PeerTimerDone();
+
+			// every timer waiting on the reactor, scheduled tasks and peer timers
+			size_t PendingTimers() const;
+
+		private:
+			PeerReactor(size_t threadCount);
+
+			void OnScheduled(TimerID id, const boost::system::error_code &ec);
+
+		private:
+			struct ScheduledTask {
+				boost::shared_ptr<boost::asio::deadline_timer> timer;
+				Task task;
+			};
+
+			boost::asio::io_service _service, _timerService;
+			boost::shared_ptr<boost::asio::io_service::work> _work, _timerWork;
+			boost::thread_group _threads;
+
+			mutable boost::mutex _tasksLock;
+			boost::condition_variable _taskDone;
+			std::map<TimerID, ScheduledTask> _tasks;
+			TimerID _nextTimerID;
+			TimerID _runningTimerID; // task taken off _tasks and running, 0 if none
+			boost::thread::id _timerThread;
+			std::atomic<size_t> _peerTimers;
+		};
+
+	}
+}
+
+#endif //__ELASTOS_SDK_PEERREACTOR_H__
@@ -0,0 +1,143 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "PeerScoreBoard.h"
+
+#include <algorithm>
+
+namespace Elastos {
+	namespace ElaWallet {
+
+		static double Average(double average, double sample) {
+			return average == 0 ? sample : average * (1 - PEER_SCORE_WEIGHT) + sample * PEER_SCORE_WEIGHT;
+		}
+
+		PeerScore::PeerScore() :
+			PingTime(0),
+			BytesPerSecond(0),
+			Misbehaving(0),
+			Connects(0),
+			Failures(0),
+			LastSeen(0) {
+		}
+
+		PeerScore::PeerScore(const PeerInfo &info) :
+			Info(info),
+			PingTime(0),
+			BytesPerSecond(0),
+			Misbehaving(0),
+			Connects(0),
+			Failures(0),
+			LastSeen(0) {
+		}
+
+		double PeerScore::Rank() const {
+			double rank = BytesPerSecond > 0 ? BytesPerSecond : PEER_SCORE_DEFAULT_BPS;
+
+			rank /= 1 + (PingTime > 0 ? PingTime : PEER_SCORE_DEFAULT_PING);
+			rank *= (Connects + 1.0) / (Connects + 1.0 + 2.0 * Failures);
+			rank /= 1 + Misbehaving;
+
+			return rank;
+		}
+
+		PeerScoreBoard::PeerScoreBoard() {
+		}
+
+		PeerScoreBoard::~PeerScoreBoard() {
+		}
+
+		void PeerScoreBoard::Load(const std::vector<PeerScore> &scores, uint64_t now) {
+			for (size_t i = 0; i < scores.size(); ++i) {
+				if (scores[i].LastSeen + PEER_SCORE_MAX_AGE >= now)
+					_scores[scores[i].Info] = scores[i];
+			}
+		}
+
+		void PeerScoreBoard::Connected(const PeerInfo &peer, double pingTime, uint64_t now) {
+			PeerScore &score = Entry(peer);
+
+			score.Connects++;
+			score.LastSeen = now;
+			if (pingTime > 0 && pingTime < 60) score.PingTime = Average(score.PingTime, pingTime);
+
+			if (_scores.size() > PEER_SCORE_MAX_PEERS) { // forget the peer seen longest ago
+				ScoreMap::iterator oldest = _scores.begin();
+				for (ScoreMap::iterator it = _scores.begin(); it != _scores.end(); ++it) {
+					if (it->second.LastSeen < oldest->second.LastSeen) oldest = it;
+				}
+				_scores.erase(oldest);
+			}
+		}
+
+		void PeerScoreBoard::Disconnected(const PeerInfo &peer, bool failed) {
+			if (failed) Entry(peer).Failures++;
+		}
+
+		void PeerScoreBoard::Misbehaved(const PeerInfo &peer) {
+			Entry(peer).Misbehaving++;
+		}
+
+		void PeerScoreBoard::Throughput(const PeerInfo &peer, double bytesPerSecond) {
+			PeerScore &score = Entry(peer);
+			score.BytesPerSecond = Average(score.BytesPerSecond, bytesPerSecond);
+			_measured.insert(peer);
+		}
+
+		PeerScore PeerScoreBoard::Get(const PeerInfo &peer) const {
+			ScoreMap::const_iterator it = _scores.find(peer);
+			return it == _scores.end() ? PeerScore(peer) : it->second;
+		}
+
+		double PeerScoreBoard::Rank(const PeerInfo &peer) const {
+			return Get(peer).Rank();
+		}
+
+		double PeerScoreBoard::BestThroughput() const {
+			double best = 0;
+
+			for (std::set<PeerInfo>::const_iterator it = _measured.begin(); it != _measured.end(); ++it) {
+				ScoreMap::const_iterator score = _scores.find(*it);
+				if (score != _scores.end()) best = std::max(best, score->second.BytesPerSecond);
+			}
+
+			return best;
+		}
+
+		std::vector<PeerScore> PeerScoreBoard::TakeChanged() {
+			std::vector<PeerScore> scores;
+
+			std::sort(_changed.begin(), _changed.end());
+			_changed.erase(std::unique(_changed.begin(), _changed.end()), _changed.end());
+
+			for (size_t i = 0; i < _changed.size(); ++i) {
+				ScoreMap::const_iterator it = _scores.find(_changed[i]);
+				if (it != _scores.end()) scores.push_back(it->second);
+			}
+
+			_changed.clear();
+			return scores;
+		}
+
+		size_t PeerScoreBoard::Size() const {
+			return _scores.size();
+		}
+
+		void PeerScoreBoard::Clear() {
+			_scores.clear();
+			_changed.clear();
+			_measured.clear();
+		}
+
+		PeerScore &PeerScoreBoard::Entry(const PeerInfo &peer) {
+			ScoreMap::iterator it = _scores.find(peer);
+			if (it == _scores.end())
+				it = _scores.insert(std::make_pair(peer, PeerScore(peer))).first;
+
+			_changed.push_back(peer);
+			return it->second;
+		}
+
+	}
+}
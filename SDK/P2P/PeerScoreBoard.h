@@ -0,0 +1,95 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef __ELASTOS_SDK_PEERSCOREBOARD_H__
+#define __ELASTOS_SDK_PEERSCOREBOARD_H__
+
+#include "PeerInfo.h"
+
+#include <map>
+#include <set>
+#include <vector>
+
+#define PEER_SCORE_WEIGHT       0.3                  // weight of a new sample in the moving averages
+#define PEER_SCORE_DEFAULT_BPS  (64 * 1024.0)        // assumed throughput of a peer never downloaded from
+#define PEER_SCORE_DEFAULT_PING 0.5                  // assumed ping time of a peer never connected to
+#define PEER_SCORE_SWITCH_RATIO 0.25                 // download peer below this share of the best throughput is replaced
+#define PEER_SCORE_SWITCH_DELAY 60                   // seconds a download peer is measured before it may be replaced
+#define PEER_SCORE_SWITCH_BLOCKS 2000                // blocks left to sync below which the download peer is kept
+#define PEER_SCORE_MAX_PEERS    1000
+#define PEER_SCORE_MAX_AGE      (30 * 24 * 60 * 60) // seconds since last connect before a score is forgotten
+
+namespace Elastos {
+	namespace ElaWallet {
+
+		struct PeerScore {
+			PeerInfo Info;
+			double PingTime;       // seconds, moving average, 0 if never measured
+			double BytesPerSecond; // merkleblock download throughput, moving average, 0 if never measured
+			uint32_t Misbehaving;
+			uint32_t Connects;
+			uint32_t Failures;     // connections that ended with an error
+			uint64_t LastSeen;
+
+			PeerScore();
+
+			explicit PeerScore(const PeerInfo &info);
+
+			// expected usefulness as a download peer, higher is better
+			double Rank() const;
+		};
+
+		/**
+		 * Quality of the peers we connected to: latency, merkleblock throughput, misbehavior and how often the
+		 * connection fails. Used to pick and replace the download peer, and saved so that the next start
+		 * prefers the peers that did well before.
+		 */
+		class PeerScoreBoard {
+		public:
+			PeerScoreBoard();
+
+			~PeerScoreBoard();
+
+			// drops scores older than PEER_SCORE_MAX_AGE
+			void Load(const std::vector<PeerScore> &scores, uint64_t now);
+
+			void Connected(const PeerInfo &peer, double pingTime, uint64_t now);
+
+			void Disconnected(const PeerInfo &peer, bool failed);
+
+			void Misbehaved(const PeerInfo &peer);
+
+			void Throughput(const PeerInfo &peer, double bytesPerSecond);
+
+			// PeerScore(peer) if unknown
+			PeerScore Get(const PeerInfo &peer) const;
+
+			double Rank(const PeerInfo &peer) const;
+
+			// best throughput of the peers measured since this board was created or cleared, loaded scores
+			// may be weeks old and don't count
+			double BestThroughput() const;
+
+			// scores changed since the last call
+			std::vector<PeerScore> TakeChanged();
+
+			size_t Size() const;
+
+			void Clear();
+
+		private:
+			PeerScore &Entry(const PeerInfo &peer);
+
+		private:
+			typedef std::map<PeerInfo, PeerScore> ScoreMap;
+
+			ScoreMap _scores;
+			std::vector<PeerInfo> _changed;
+			std::set<PeerInfo> _measured;
+		};
+
+	}
+}
+
+#endif //__ELASTOS_SDK_PEERSCOREBOARD_H__
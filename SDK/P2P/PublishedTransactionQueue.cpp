@@ -0,0 +1,139 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "PublishedTransactionQueue.h"
+
+#include <Wallet/Wallet.h>
+
+#include <algorithm>
+
+namespace Elastos {
+	namespace ElaWallet {
+
+		PublishedTransactionQueue::PublishedTransactionQueue(size_t maxSize, time_t maxAge) :
+			_maxSize(std::max(maxSize, (size_t) 1)),
+			_maxAge(maxAge),
+			_pendingCallbacks(0),
+			_evicted(0) {
+		}
+
+		PublishedTransactionQueue::~PublishedTransactionQueue() {
+		}
+
+		bool PublishedTransactionQueue::Add(const PublishedTransaction &tx, time_t now) {
+			const uint256 &txHash = tx.GetTransaction()->GetHash();
+			if (_entries.find(txHash) != _entries.end())
+				return false;
+
+			Evict(now);
+
+			Entry &entry = _entries[txHash];
+			entry.tx = tx;
+			entry.published = now;
+			entry.order = _order.insert(_order.end(), txHash);
+			if (tx.HasCallback())
+				_pendingCallbacks++;
+
+			return true;
+		}
+
+		bool PublishedTransactionQueue::Contains(const uint256 &txHash) const {
+			return _entries.find(txHash) != _entries.end();
+		}
+
+		PublishedTransaction PublishedTransactionQueue::Get(const uint256 &txHash) const {
+			EntryMap::const_iterator it = _entries.find(txHash);
+			return it == _entries.end() ? PublishedTransaction() : it->second.tx;
+		}
+
+		PublishedTransaction PublishedTransactionQueue::TakeCallback(const uint256 &txHash) {
+			EntryMap::iterator it = _entries.find(txHash);
+			if (it == _entries.end())
+				return PublishedTransaction();
+
+			PublishedTransaction tx = it->second.tx;
+			if (tx.HasCallback()) {
+				it->second.tx.ResetCallback();
+				_pendingCallbacks--;
+			}
+
+			return tx;
+		}
+
+		bool PublishedTransactionQueue::Remove(const uint256 &txHash) {
+			EntryMap::iterator it = _entries.find(txHash);
+			if (it == _entries.end())
+				return false;
+
+			if (it->second.tx.HasCallback())
+				_pendingCallbacks--;
+			_order.erase(it->second.order);
+			_entries.erase(it);
+
+			return true;
+		}
+
+		bool PublishedTransactionQueue::HasPendingCallbacks() const {
+			return _pendingCallbacks > 0;
+		}
+
+		size_t PublishedTransactionQueue::PendingCallbacks() const {
+			return _pendingCallbacks;
+		}
+
+		std::vector<uint256> PublishedTransactionQueue::PendingHashes() const {
+			std::vector<uint256> hashes;
+
+			if (_pendingCallbacks == 0)
+				return hashes;
+
+			for (std::list<uint256>::const_iterator it = _order.begin(); it != _order.end(); ++it) {
+				const PublishedTransaction &tx = _entries.find(*it)->second.tx;
+				if (tx.HasCallback() && tx.GetTransaction()->GetBlockHeight() == TX_UNCONFIRMED)
+					hashes.push_back(*it);
+			}
+
+			return hashes;
+		}
+
+		std::vector<uint256> PublishedTransactionQueue::Hashes() const {
+			return std::vector<uint256>(_order.begin(), _order.end());
+		}
+
+		size_t PublishedTransactionQueue::Size() const {
+			return _entries.size();
+		}
+
+		uint64_t PublishedTransactionQueue::Evicted() const {
+			return _evicted;
+		}
+
+		void PublishedTransactionQueue::Clear() {
+			_entries.clear();
+			_order.clear();
+			_pendingCallbacks = 0;
+		}
+
+		void PublishedTransactionQueue::Evict(time_t now) {
+			for (std::list<uint256>::iterator it = _order.begin(); it != _order.end();) {
+				EntryMap::iterator entry = _entries.find(*it);
+				bool expired = entry->second.published + _maxAge <= now;
+
+				// entries are in publish order, only waiting callbacks are skipped
+				if (!expired && _entries.size() < _maxSize)
+					break;
+
+				if (entry->second.tx.HasCallback()) {
+					++it;
+					continue;
+				}
+
+				_entries.erase(entry);
+				it = _order.erase(it);
+				_evicted++;
+			}
+		}
+
+	}
+}
@@ -0,0 +1,84 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef __ELASTOS_SDK_PUBLISHEDTRANSACTIONQUEUE_H__
+#define __ELASTOS_SDK_PUBLISHEDTRANSACTIONQUEUE_H__
+
+#include "PublishedTransaction.h"
+
+#include <list>
+#include <vector>
+#include <unordered_map>
+
+#define PUBLISHED_TX_MAX_SIZE 1000
+#define PUBLISHED_TX_MAX_AGE  (24 * 60 * 60)
+
+namespace Elastos {
+	namespace ElaWallet {
+
+		/**
+		 * Transactions published by the wallet, keyed by hash and kept in publish order. Once its callback has
+		 * fired, a transaction is dropped after the max age, or oldest first when the queue is full. Transactions
+		 * still waiting for their callback are never dropped.
+		 */
+		class PublishedTransactionQueue {
+		public:
+			explicit PublishedTransactionQueue(size_t maxSize = PUBLISHED_TX_MAX_SIZE,
+											   time_t maxAge = PUBLISHED_TX_MAX_AGE);
+
+			~PublishedTransactionQueue();
+
+			// false if a transaction with the same hash was already published
+			bool Add(const PublishedTransaction &tx, time_t now);
+
+			bool Contains(const uint256 &txHash) const;
+
+			// the published transaction for @txHash, empty if unknown
+			PublishedTransaction Get(const uint256 &txHash) const;
+
+			// like Get(), and reset the stored callback so it fires only once
+			PublishedTransaction TakeCallback(const uint256 &txHash);
+
+			bool Remove(const uint256 &txHash);
+
+			bool HasPendingCallbacks() const;
+
+			size_t PendingCallbacks() const;
+
+			// unconfirmed transactions still waiting for their callback
+			std::vector<uint256> PendingHashes() const;
+
+			// all hashes in publish order
+			std::vector<uint256> Hashes() const;
+
+			size_t Size() const;
+
+			uint64_t Evicted() const;
+
+			void Clear();
+
+		private:
+			void Evict(time_t now);
+
+		private:
+			struct Entry {
+				PublishedTransaction tx;
+				time_t published;
+				std::list<uint256>::iterator order;
+			};
+
+			typedef std::unordered_map<uint256, Entry, uint256Hasher> EntryMap;
+
+			size_t _maxSize;
+			time_t _maxAge;
+			EntryMap _entries;
+			std::list<uint256> _order;
+			size_t _pendingCallbacks;
+			uint64_t _evicted;
+		};
+
+	}
+}
+
+#endif //__ELASTOS_SDK_PUBLISHEDTRANSACTIONQUEUE_H__
@@ -0,0 +1,77 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "ReceiveBuffer.h"
+
+#include <cstring>
+
+namespace Elastos {
+	namespace ElaWallet {
+
+		ReceiveBuffer::ReceiveBuffer(size_t capacity) :
+			_buf(capacity),
+			_capacity(capacity),
+			_begin(0),
+			_end(0) {
+		}
+
+		ReceiveBuffer::~ReceiveBuffer() {
+		}
+
+		uint8_t *ReceiveBuffer::Prepare(size_t bytes) {
+			if (bytes < _capacity) bytes = _capacity;
+
+			if (_begin == _end && _buf.size() > bytes) { // a big message was read, give the memory back
+				_buf.resize(bytes);
+				_buf.shrink_to_fit();
+			}
+
+			if (_begin + bytes > _buf.size() || _end == _buf.size()) {
+				size_t size = _end - _begin;
+				if (size > 0 && _begin > 0)
+					memmove(&_buf[0], &_buf[_begin], size);
+				_begin = 0;
+				_end = size;
+
+				if (bytes > _buf.size())
+					_buf.resize(bytes);
+				if (_end == _buf.size())
+					_buf.resize(_buf.size() + _capacity);
+			}
+
+			return &_buf[_end];
+		}
+
+		size_t ReceiveBuffer::Writable() const {
+			return _buf.size() - _end;
+		}
+
+		void ReceiveBuffer::Commit(size_t bytes) {
+			_end += bytes;
+		}
+
+		const uint8_t *ReceiveBuffer::Data() const {
+			return &_buf[_begin];
+		}
+
+		size_t ReceiveBuffer::Size() const {
+			return _end - _begin;
+		}
+
+		void ReceiveBuffer::Consume(size_t bytes) {
+			_begin += bytes;
+			if (_begin == _end)
+				_begin = _end = 0;
+		}
+
+		size_t ReceiveBuffer::Capacity() const {
+			return _buf.size();
+		}
+
+		void ReceiveBuffer::Clear() {
+			_begin = _end = 0;
+		}
+
+	}
+}
@@ -0,0 +1,55 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef __ELASTOS_SDK_RECEIVEBUFFER_H__
+#define __ELASTOS_SDK_RECEIVEBUFFER_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+#define RECEIVE_BUFFER_SIZE (64 * 1024)
+
+namespace Elastos {
+	namespace ElaWallet {
+
+		/**
+		 * Per-peer socket receive buffer. Reads land directly after the unread bytes and whole messages are
+		 * parsed in place from Data(). Instead of wrapping around, the unread tail is moved back to the front
+		 * once the free space runs out, so a message is always contiguous; that happens at most once per
+		 * buffer's worth of data.
+		 */
+		class ReceiveBuffer {
+		public:
+			ReceiveBuffer(size_t capacity = RECEIVE_BUFFER_SIZE);
+
+			~ReceiveBuffer();
+
+			// make at least @bytes of unread data fit, and return the free space to read into
+			uint8_t *Prepare(size_t bytes);
+
+			size_t Writable() const;
+
+			// @bytes were read into the space returned by Prepare()
+			void Commit(size_t bytes);
+
+			const uint8_t *Data() const;
+
+			size_t Size() const;
+
+			void Consume(size_t bytes);
+
+			size_t Capacity() const;
+
+			void Clear();
+
+		private:
+			std::vector<uint8_t> _buf;
+			size_t _capacity, _begin, _end;
+		};
+
+	}
+}
+
+#endif //__ELASTOS_SDK_RECEIVEBUFFER_H__
@@ -0,0 +1,157 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "SeedResolver.h"
+
+#include <Common/Log.h>
+
+#include <netdb.h>
+#include <cstring>
+#include <arpa/inet.h>
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
+namespace Elastos {
+	namespace ElaWallet {
+
+		std::vector<uint128> SystemDNSResolver::Lookup(const std::string &hostname) {
+			struct addrinfo hints, *servinfo, *p;
+			std::vector<uint128> addrList;
+
+			memset(&hints, 0, sizeof(hints));
+			hints.ai_socktype = SOCK_STREAM;
+			hints.ai_family = PF_UNSPEC;
+			if (getaddrinfo(hostname.c_str(), NULL, &hints, &servinfo) == 0) {
+				for (p = servinfo; p != NULL; p = p->ai_next) {
+					uint128 addr;
+					char host[INET6_ADDRSTRLEN];
+					if (p->ai_family == AF_INET) {
+						*(uint16_t *)&addr.begin()[10] = 0xffff;
+						*(uint32_t *)&addr.begin()[12] = ((struct sockaddr_in *) p->ai_addr)->sin_addr.s_addr;
+						inet_ntop(AF_INET, &addr.begin()[12], host, sizeof(host));
+					} else if (p->ai_family == AF_INET6) {
+						memcpy(addr.begin(), &((struct sockaddr_in6 *) p->ai_addr)->sin6_addr, addr.size());
+						inet_ntop(AF_INET6, addr.begin(), host, sizeof(host));
+					} else {
+						continue;
+					}
+					Log::debug("{} -> {}", hostname, host);
+					addrList.push_back(addr);
+				}
+
+				freeaddrinfo(servinfo);
+			}
+
+			addrList.shrink_to_fit();
+			return addrList;
+		}
+
+		SeedResolver::SeedResolver(uint64_t ttl) :
+			_state(new State()) {
+			_state->resolver = DNSResolverPtr(new SystemDNSResolver());
+			_state->generation = 0;
+			_state->callbacks = 0;
+			_state->ttl = ttl;
+		}
+
+		SeedResolver::~SeedResolver() {
+			Cancel();
+		}
+
+		void SeedResolver::SetResolver(const DNSResolverPtr &resolver) {
+			boost::mutex::scoped_lock scopedLock(_state->lock);
+			_state->resolver = resolver;
+		}
+
+		DNSResolverPtr SeedResolver::GetResolver() const {
+			boost::mutex::scoped_lock scopedLock(_state->lock);
+			return _state->resolver;
+		}
+
+		void SeedResolver::Load(const SeedPeerMap &seeds, uint64_t now) {
+			boost::mutex::scoped_lock scopedLock(_state->lock);
+
+			for (SeedPeerMap::const_iterator it = seeds.begin(); it != seeds.end(); ++it) {
+				if (!it->second.empty() && it->second.front().Timestamp + _state->ttl > now)
+					_state->cache[it->first] = it->second;
+			}
+		}
+
+		std::vector<PeerInfo> SeedResolver::Cached(const std::string &seed, uint64_t now) const {
+			boost::mutex::scoped_lock scopedLock(_state->lock);
+
+			SeedPeerMap::const_iterator it = _state->cache.find(seed);
+			if (it == _state->cache.end() || it->second.empty() || it->second.front().Timestamp + _state->ttl <= now)
+				return {};
+
+			return it->second;
+		}
+
+		bool SeedResolver::Resolve(const std::string &seed, uint16_t port, uint64_t timeout, const Callback &callback) {
+			boost::mutex::scoped_lock scopedLock(_state->lock);
+
+			if (_state->deadlines.find(seed) != _state->deadlines.end())
+				return false;
+
+			_state->deadlines[seed] = time(NULL) + timeout;
+			boost::thread(boost::bind(&SeedResolver::Lookup, _state, _state->resolver, _state->generation, seed, port,
+									  callback)).detach();
+			return true;
+		}
+
+		size_t SeedResolver::Pending(uint64_t now) const {
+			boost::mutex::scoped_lock scopedLock(_state->lock);
+			size_t count = 0;
+
+			for (std::map<std::string, uint64_t>::const_iterator it = _state->deadlines.begin();
+				 it != _state->deadlines.end(); ++it) {
+				if (it->second >= now) count++;
+			}
+
+			return count;
+		}
+
+		void SeedResolver::Cancel() {
+			boost::mutex::scoped_lock scopedLock(_state->lock);
+
+			_state->generation++;
+			_state->deadlines.clear();
+			while (_state->callbacks > 0)
+				_state->idle.wait(scopedLock);
+		}
+
+		void SeedResolver::Lookup(boost::shared_ptr<State> state, DNSResolverPtr resolver, uint64_t generation,
+								  std::string seed, uint16_t port, Callback callback) {
+			std::vector<uint128> addrList = resolver->Lookup(seed);
+			uint64_t now = time(NULL);
+			std::vector<PeerInfo> peers;
+
+			for (size_t i = 0; i < addrList.size(); ++i) {
+				if (addrList[i] != 0)
+					peers.push_back(PeerInfo(addrList[i], port, now));
+			}
+
+			{
+				boost::mutex::scoped_lock scopedLock(state->lock);
+
+				// results of a cancelled lookup are still worth keeping
+				if (!peers.empty())
+					state->cache[seed] = peers;
+
+				if (generation != state->generation)
+					return;
+
+				state->deadlines.erase(seed);
+				state->callbacks++;
+			}
+
+			callback(seed, peers);
+
+			boost::mutex::scoped_lock scopedLock(state->lock);
+			if (--state->callbacks == 0)
+				state->idle.notify_all();
+		}
+
+	}
+}
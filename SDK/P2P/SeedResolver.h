@@ -0,0 +1,98 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef __ELASTOS_SDK_SEEDRESOLVER_H__
+#define __ELASTOS_SDK_SEEDRESOLVER_H__
+
+#include "PeerInfo.h"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/function.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#define DNS_SEED_TIMEOUT 5                // seconds to wait for dns seeds before giving up on a connect attempt
+#define DNS_SEED_TTL     (12 * 60 * 60)   // seconds the addresses of a dns seed are used before it's looked up again
+
+namespace Elastos {
+	namespace ElaWallet {
+
+		class DNSResolver {
+		public:
+			virtual ~DNSResolver() {}
+
+			// blocking, returns the IPv6 (or IPv4 mapped) addresses of @hostname, empty on failure
+			virtual std::vector<uint128> Lookup(const std::string &hostname) = 0;
+		};
+
+		typedef boost::shared_ptr<DNSResolver> DNSResolverPtr;
+
+		class SystemDNSResolver : public DNSResolver {
+		public:
+			virtual std::vector<uint128> Lookup(const std::string &hostname);
+		};
+
+		// peers found behind each dns seed, Timestamp is the time of the lookup
+		typedef std::map<std::string, std::vector<PeerInfo>> SeedPeerMap;
+
+		/**
+		 * Looks up dns seeds in the background, each on a thread of its own, and caches what they return for
+		 * DNS_SEED_TTL seconds. A lookup never blocks the caller: its peers are handed to a callback as soon as
+		 * they arrive, and the caller only waits for a lookup until its deadline.
+		 */
+		class SeedResolver {
+		public:
+			typedef boost::function<void(const std::string &seed, const std::vector<PeerInfo> &peers)> Callback;
+
+			explicit SeedResolver(uint64_t ttl = DNS_SEED_TTL);
+
+			~SeedResolver();
+
+			void SetResolver(const DNSResolverPtr &resolver);
+
+			DNSResolverPtr GetResolver() const;
+
+			// cache peers saved before, leaving out the expired ones
+			void Load(const SeedPeerMap &seeds, uint64_t now);
+
+			// peers of @seed looked up less than ttl seconds ago, empty if none
+			std::vector<PeerInfo> Cached(const std::string &seed, uint64_t now) const;
+
+			// look up @seed unless it's already being looked up, and call @callback with the peers found. The
+			// lookup counts as pending for @timeout seconds. Returns false if no lookup was started
+			bool Resolve(const std::string &seed, uint16_t port, uint64_t timeout, const Callback &callback);
+
+			// lookups started and not done before their deadline
+			size_t Pending(uint64_t now) const;
+
+			// lookups still running won't call back any more, waits for callbacks in progress
+			void Cancel();
+
+		private:
+			struct State {
+				boost::mutex lock;
+				boost::condition_variable idle;
+				DNSResolverPtr resolver;
+				SeedPeerMap cache;
+				std::map<std::string, uint64_t> deadlines; // seed -> deadline of the lookup running
+				uint64_t generation;
+				size_t callbacks;
+				uint64_t ttl;
+			};
+
+			static void Lookup(boost::shared_ptr<State> state, DNSResolverPtr resolver, uint64_t generation,
+							   std::string seed, uint16_t port, Callback callback);
+
+		private:
+			boost::shared_ptr<State> _state;
+		};
+
+	}
+}
+
+#endif //__ELASTOS_SDK_SEEDRESOLVER_H__
@@ -0,0 +1,98 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "SendQueue.h"
+
+namespace Elastos {
+	namespace ElaWallet {
+
+		SendQueue::SendQueue(size_t highWater) :
+			_offset(0),
+			_bytes(0),
+			_highWater(highWater),
+			_peakBytes(0),
+			_congestedCount(0) {
+		}
+
+		SendQueue::~SendQueue() {
+		}
+
+		void SendQueue::Push(const bytes_t &header, const bytes_t &payload) {
+			bool congested = Congested();
+
+			_frames.push_back(Frame());
+			_frames.back().header = header;
+			_frames.back().payload = payload;
+			_bytes += header.size() + payload.size();
+
+			if (_bytes > _peakBytes)
+				_peakBytes = _bytes;
+			if (!congested && Congested())
+				_congestedCount++;
+		}
+
+		size_t SendQueue::Gather(struct iovec *iov, size_t count) const {
+			size_t n = 0, skip = _offset;
+
+			for (std::deque<Frame>::const_iterator it = _frames.begin(); it != _frames.end() && n < count; ++it) {
+				const bytes_t *bufs[] = {&it->header, &it->payload};
+
+				for (size_t i = 0; i < 2 && n < count; ++i) {
+					if (skip >= bufs[i]->size()) {
+						skip -= bufs[i]->size();
+						continue;
+					}
+
+					iov[n].iov_base = (void *) (bufs[i]->data() + skip);
+					iov[n].iov_len = bufs[i]->size() - skip;
+					skip = 0;
+					n++;
+				}
+			}
+
+			return n;
+		}
+
+		void SendQueue::Consume(size_t bytes) {
+			_bytes -= bytes;
+			_offset += bytes;
+
+			while (!_frames.empty() && _offset >= _frames.front().header.size() + _frames.front().payload.size()) {
+				_offset -= _frames.front().header.size() + _frames.front().payload.size();
+				_frames.pop_front();
+			}
+		}
+
+		bool SendQueue::Empty() const {
+			return _frames.empty();
+		}
+
+		size_t SendQueue::Bytes() const {
+			return _bytes;
+		}
+
+		size_t SendQueue::Messages() const {
+			return _frames.size();
+		}
+
+		bool SendQueue::Congested() const {
+			return _bytes > _highWater;
+		}
+
+		size_t SendQueue::PeakBytes() const {
+			return _peakBytes;
+		}
+
+		uint64_t SendQueue::CongestedCount() const {
+			return _congestedCount;
+		}
+
+		void SendQueue::Clear() {
+			_frames.clear();
+			_offset = 0;
+			_bytes = 0;
+		}
+
+	}
+}
@@ -0,0 +1,68 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef __ELASTOS_SDK_SENDQUEUE_H__
+#define __ELASTOS_SDK_SENDQUEUE_H__
+
+#include <Common/typedefs.h>
+
+#include <deque>
+#include <sys/uio.h>
+
+#define SEND_QUEUE_HIGH_WATER (1024 * 1024) // queued bytes past which the peer is reading slower than we send
+#define SEND_QUEUE_MAX_IOV    64            // buffers gathered into one sendmsg()
+
+namespace Elastos {
+	namespace ElaWallet {
+
+		/**
+		 * Per-peer outbound message queue. A message's header and payload are kept as separate buffers and
+		 * handed to the socket together with the ones queued after them in a single scatter-gather write, so
+		 * bursts of small messages go out in one syscall and nothing is concatenated. Tracks how far the queue
+		 * backs up when the peer doesn't read fast enough.
+		 */
+		class SendQueue {
+		public:
+			explicit SendQueue(size_t highWater = SEND_QUEUE_HIGH_WATER);
+
+			~SendQueue();
+
+			void Push(const bytes_t &header, const bytes_t &payload);
+
+			// fill at most @count entries of @iov with the unsent data from the front, returns the number filled
+			size_t Gather(struct iovec *iov, size_t count) const;
+
+			// @bytes of the gathered data were written to the socket
+			void Consume(size_t bytes);
+
+			bool Empty() const;
+
+			size_t Bytes() const;
+
+			size_t Messages() const;
+
+			bool Congested() const;
+
+			size_t PeakBytes() const;
+
+			// times the queue grew past the high water mark
+			uint64_t CongestedCount() const;
+
+			void Clear();
+
+		private:
+			struct Frame {
+				bytes_t header, payload;
+			};
+
+			std::deque<Frame> _frames;
+			size_t _offset; // bytes of the front frame already written
+			size_t _bytes, _highWater, _peakBytes;
+			uint64_t _congestedCount;
+		};
+
+	}
+}
+
+#endif //__ELASTOS_SDK_SENDQUEUE_H__
@@ -0,0 +1,151 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "SyncMetrics.h"
+
+#include <algorithm>
+
+namespace Elastos {
+	namespace ElaWallet {
+
+		SyncMetrics::StageStats::StageStats() :
+			Count(0),
+			TotalMicroseconds(0),
+			MaxMicroseconds(0) {
+			for (size_t i = 0; i < SYNC_METRICS_BUCKETS; ++i)
+				Buckets[i] = 0;
+		}
+
+		uint64_t SyncMetrics::StageStats::Percentile(double percent) const {
+			uint64_t seen = 0, wanted = (uint64_t) (Count * percent / 100.0);
+
+			if (Count == 0) return 0;
+			if (wanted >= Count) wanted = Count - 1;
+
+			for (size_t i = 0; i < SYNC_METRICS_BUCKETS - 1; ++i) {
+				seen += Buckets[i];
+				if (seen > wanted)
+					return std::min((uint64_t) 1 << i, MaxMicroseconds);
+			}
+
+			return MaxMicroseconds;
+		}
+
+		SyncMetrics::Timer::Timer(SyncMetrics &metrics, Stage stage) :
+			_metrics(metrics),
+			_stage(stage),
+			_start(std::chrono::steady_clock::now()) {
+		}
+
+		SyncMetrics::Timer::~Timer() {
+			std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - _start;
+			_metrics.Record(_stage, std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+		}
+
+		SyncMetrics::SyncMetrics() {
+			Reset();
+		}
+
+		void SyncMetrics::Record(Stage stage, uint64_t microseconds) {
+			Histogram &h = _stages[stage];
+			size_t bucket = 0;
+
+			while (bucket < SYNC_METRICS_BUCKETS - 1 && microseconds >= ((uint64_t) 1 << bucket))
+				bucket++;
+
+			h.count.fetch_add(1, std::memory_order_relaxed);
+			h.total.fetch_add(microseconds, std::memory_order_relaxed);
+			h.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+
+			uint64_t max = h.max.load(std::memory_order_relaxed);
+			while (microseconds > max && !h.max.compare_exchange_weak(max, microseconds, std::memory_order_relaxed));
+		}
+
+		void SyncMetrics::Add(Counter counter, uint64_t n) {
+			_counters[counter].fetch_add(n, std::memory_order_relaxed);
+		}
+
+		SyncMetrics::StageStats SyncMetrics::Get(Stage stage) const {
+			const Histogram &h = _stages[stage];
+			StageStats stats;
+
+			stats.Count = h.count.load(std::memory_order_relaxed);
+			stats.TotalMicroseconds = h.total.load(std::memory_order_relaxed);
+			stats.MaxMicroseconds = h.max.load(std::memory_order_relaxed);
+			for (size_t i = 0; i < SYNC_METRICS_BUCKETS; ++i)
+				stats.Buckets[i] = h.buckets[i].load(std::memory_order_relaxed);
+
+			return stats;
+		}
+
+		uint64_t SyncMetrics::Get(Counter counter) const {
+			return _counters[counter].load(std::memory_order_relaxed);
+		}
+
+		void SyncMetrics::Reset() {
+			for (size_t i = 0; i < StageCount; ++i) {
+				_stages[i].count = 0;
+				_stages[i].total = 0;
+				_stages[i].max = 0;
+				for (size_t j = 0; j < SYNC_METRICS_BUCKETS; ++j)
+					_stages[i].buckets[j] = 0;
+			}
+
+			for (size_t i = 0; i < CounterCount; ++i)
+				_counters[i] = 0;
+		}
+
+		nlohmann::json SyncMetrics::ToJson() const {
+			nlohmann::json j, stages, counters;
+
+			for (size_t i = 0; i < StageCount; ++i) {
+				StageStats stats = Get((Stage) i);
+				nlohmann::json stage;
+
+				stage["Count"] = stats.Count;
+				stage["TotalMicroseconds"] = stats.TotalMicroseconds;
+				stage["AverageMicroseconds"] = stats.Count == 0 ? 0 : stats.TotalMicroseconds / stats.Count;
+				stage["MaxMicroseconds"] = stats.MaxMicroseconds;
+				stage["P50Microseconds"] = stats.Percentile(50);
+				stage["P90Microseconds"] = stats.Percentile(90);
+				stage["P99Microseconds"] = stats.Percentile(99);
+				stages[StageName((Stage) i)] = stage;
+			}
+
+			for (size_t i = 0; i < CounterCount; ++i)
+				counters[CounterName((Counter) i)] = Get((Counter) i);
+
+			j["Stages"] = stages;
+			j["Counters"] = counters;
+			return j;
+		}
+
+		std::string SyncMetrics::StageName(Stage stage) {
+			switch (stage) {
+				case MessageReceive: return "MessageReceive";
+				case Checksum: return "Checksum";
+				case MerkleRoot: return "MerkleRoot";
+				case VerifyBlock: return "VerifyBlock";
+				case WalletMatch: return "WalletMatch";
+				case SaveBlocks: return "SaveBlocks";
+				case UpdateTxns: return "UpdateTxns";
+				case ListenerDispatch: return "ListenerDispatch";
+				default: return "Unknown";
+			}
+		}
+
+		std::string SyncMetrics::CounterName(Counter counter) {
+			switch (counter) {
+				case MessagesReceived: return "MessagesReceived";
+				case BytesReceived: return "BytesReceived";
+				case ChecksumFailures: return "ChecksumFailures";
+				case InvalidMerkleBlocks: return "InvalidMerkleBlocks";
+				case WalletTxMatched: return "WalletTxMatched";
+				case BlocksSaved: return "BlocksSaved";
+				default: return "Unknown";
+			}
+		}
+
+	}
+}
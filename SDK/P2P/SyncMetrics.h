@@ -0,0 +1,104 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef __ELASTOS_SDK_SYNCMETRICS_H__
+#define __ELASTOS_SDK_SYNCMETRICS_H__
+
+#include <nlohmann/json.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+#define SYNC_METRICS_BUCKETS 24 // bucket i counts durations below 2^i microseconds, the last one the rest
+
+namespace Elastos {
+	namespace ElaWallet {
+
+		/**
+		 * Counters and latency histograms of the chain sync hot path. Recording only touches atomics, so peer
+		 * threads, the wallet apply thread and the listener executor all record without taking a lock.
+		 */
+		class SyncMetrics : public boost::noncopyable {
+		public:
+			enum Stage {
+				MessageReceive,   // a peer message parsed and handled, everything below included
+				Checksum,         // payload checksum of a peer message
+				MerkleRoot,       // merkle root, proof of work and timestamp of a merkleblock
+				VerifyBlock,      // linkage, difficulty and checkpoints of a block connected to the chain
+				WalletMatch,      // relayed tx checked against and registered to the wallet
+				SaveBlocks,       // merkleblocks written to the database
+				UpdateTxns,       // tx confirmations written to the database
+				ListenerDispatch, // PeerManager listener callbacks, as seen by the thread firing them
+				StageCount
+			};
+
+			enum Counter {
+				MessagesReceived,
+				BytesReceived,
+				ChecksumFailures,
+				InvalidMerkleBlocks,
+				WalletTxMatched,
+				BlocksSaved,
+				CounterCount
+			};
+
+			struct StageStats {
+				StageStats();
+
+				uint64_t Count;
+				uint64_t TotalMicroseconds;
+				uint64_t MaxMicroseconds;
+				uint64_t Buckets[SYNC_METRICS_BUCKETS];
+
+				// upper bound in microseconds of the bucket holding the @percent-th percentile, 0 if nothing recorded
+				uint64_t Percentile(double percent) const;
+			};
+
+			// records the time from its construction to its destruction
+			class Timer : public boost::noncopyable {
+			public:
+				Timer(SyncMetrics &metrics, Stage stage);
+
+				~Timer();
+
+			private:
+				SyncMetrics &_metrics;
+				Stage _stage;
+				std::chrono::steady_clock::time_point _start;
+			};
+
+			SyncMetrics();
+
+			void Record(Stage stage, uint64_t microseconds);
+
+			void Add(Counter counter, uint64_t n = 1);
+
+			StageStats Get(Stage stage) const;
+
+			uint64_t Get(Counter counter) const;
+
+			void Reset();
+
+			nlohmann::json ToJson() const;
+
+			static std::string StageName(Stage stage);
+
+			static std::string CounterName(Counter counter);
+
+		private:
+			struct Histogram {
+				std::atomic<uint64_t> count, total, max;
+				std::atomic<uint64_t> buckets[SYNC_METRICS_BUCKETS];
+			};
+
+			Histogram _stages[StageCount];
+			std::atomic<uint64_t> _counters[CounterCount];
+		};
+
+	}
+}
+
+#endif //__ELASTOS_SDK_SYNCMETRICS_H__
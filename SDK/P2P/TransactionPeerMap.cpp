@@ -0,0 +1,119 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "TransactionPeerMap.h"
+
+#include <algorithm>
+
+namespace Elastos {
+	namespace ElaWallet {
+
+		TransactionPeerMap::TransactionPeerMap(size_t maxSize, time_t maxAge) :
+			_maxSize(std::max(maxSize, (size_t) 1)),
+			_maxAge(maxAge),
+			_evicted(0) {
+		}
+
+		TransactionPeerMap::~TransactionPeerMap() {
+		}
+
+		size_t TransactionPeerMap::AddPeer(const uint256 &txHash, const PeerInfo &peer, time_t now, bool keep) {
+			EntryMap::iterator it = _entries.find(txHash);
+
+			if (it == _entries.end()) {
+				Evict(now);
+				it = _entries.insert(std::make_pair(txHash, Entry())).first;
+				it->second.keep = keep;
+				if (!keep)
+					it->second.order = _order.insert(_order.end(), txHash);
+			} else if (keep && !it->second.keep) {
+				_order.erase(it->second.order);
+				it->second.keep = true;
+			} else if (!it->second.keep) {
+				_order.splice(_order.end(), _order, it->second.order);
+			}
+
+			Entry &entry = it->second;
+			entry.lastSeen = now;
+			if (std::find(entry.peers.begin(), entry.peers.end(), peer) == entry.peers.end())
+				entry.peers.push_back(peer);
+
+			return entry.peers.size();
+		}
+
+		bool TransactionPeerMap::RemovePeer(const uint256 &txHash, const PeerInfo &peer) {
+			EntryMap::iterator it = _entries.find(txHash);
+			if (it == _entries.end())
+				return false;
+
+			std::vector<PeerInfo> &peers = it->second.peers;
+			std::vector<PeerInfo>::iterator p = std::find(peers.begin(), peers.end(), peer);
+			if (p == peers.end())
+				return false;
+
+			peers.erase(p);
+			if (peers.empty()) {
+				if (!it->second.keep)
+					_order.erase(it->second.order);
+				_entries.erase(it);
+			}
+
+			return true;
+		}
+
+		void TransactionPeerMap::RemovePeer(const PeerInfo &peer) {
+			for (EntryMap::iterator it = _entries.begin(); it != _entries.end();) {
+				std::vector<PeerInfo> &peers = it->second.peers;
+				peers.erase(std::remove(peers.begin(), peers.end(), peer), peers.end());
+
+				if (peers.empty()) {
+					if (!it->second.keep)
+						_order.erase(it->second.order);
+					it = _entries.erase(it);
+				} else {
+					++it;
+				}
+			}
+		}
+
+		bool TransactionPeerMap::HasPeer(const uint256 &txHash, const PeerInfo &peer) const {
+			EntryMap::const_iterator it = _entries.find(txHash);
+			if (it == _entries.end())
+				return false;
+
+			return std::find(it->second.peers.begin(), it->second.peers.end(), peer) != it->second.peers.end();
+		}
+
+		size_t TransactionPeerMap::PeerCount(const uint256 &txHash) const {
+			EntryMap::const_iterator it = _entries.find(txHash);
+			return it == _entries.end() ? 0 : it->second.peers.size();
+		}
+
+		size_t TransactionPeerMap::Size() const {
+			return _entries.size();
+		}
+
+		uint64_t TransactionPeerMap::Evicted() const {
+			return _evicted;
+		}
+
+		void TransactionPeerMap::Clear() {
+			_entries.clear();
+			_order.clear();
+		}
+
+		void TransactionPeerMap::Evict(time_t now) {
+			while (!_order.empty()) {
+				EntryMap::iterator it = _entries.find(_order.front());
+				if (_order.size() < _maxSize && it->second.lastSeen + _maxAge > now)
+					break;
+
+				_entries.erase(it);
+				_order.pop_front();
+				_evicted++;
+			}
+		}
+
+	}
+}
@@ -0,0 +1,75 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef __ELASTOS_SDK_TRANSACTIONPEERMAP_H__
+#define __ELASTOS_SDK_TRANSACTIONPEERMAP_H__
+
+#include "PeerInfo.h"
+
+#include <Common/uint256.h>
+
+#include <list>
+#include <vector>
+#include <unordered_map>
+
+#define TX_PEER_MAP_MAX_SIZE 10000
+#define TX_PEER_MAP_MAX_AGE  (6 * 60 * 60) // seconds since a peer was last added for the tx
+
+namespace Elastos {
+	namespace ElaWallet {
+
+		/**
+		 * Peers that relayed or were asked for each tx, keyed by tx hash. The map is bounded, a tx nobody
+		 * announced for longer than the max age, or the least recently announced one when the map is full, is
+		 * forgotten. A tx added to be kept, one of the wallet's or one being published, is never evicted, and is
+		 * only forgotten once no peer is left for it.
+		 */
+		class TransactionPeerMap {
+		public:
+			explicit TransactionPeerMap(size_t maxSize = TX_PEER_MAP_MAX_SIZE, time_t maxAge = TX_PEER_MAP_MAX_AGE);
+
+			~TransactionPeerMap();
+
+			// returns the number of peers for @txHash after adding @peer, @keep leaves @txHash out of eviction
+			size_t AddPeer(const uint256 &txHash, const PeerInfo &peer, time_t now, bool keep = false);
+
+			bool RemovePeer(const uint256 &txHash, const PeerInfo &peer);
+
+			// remove @peer from every tx
+			void RemovePeer(const PeerInfo &peer);
+
+			bool HasPeer(const uint256 &txHash, const PeerInfo &peer) const;
+
+			size_t PeerCount(const uint256 &txHash) const;
+
+			size_t Size() const;
+
+			uint64_t Evicted() const;
+
+			void Clear();
+
+		private:
+			void Evict(time_t now);
+
+		private:
+			struct Entry {
+				std::vector<PeerInfo> peers;
+				time_t lastSeen;
+				bool keep;
+				std::list<uint256>::iterator order; // only set if not kept
+			};
+
+			typedef std::unordered_map<uint256, Entry, uint256Hasher> EntryMap;
+
+			size_t _maxSize;
+			time_t _maxAge;
+			EntryMap _entries;
+			std::list<uint256> _order; // least recently announced first, kept tx left out
+			uint64_t _evicted;
+		};
+
+	}
+}
+
+#endif //__ELASTOS_SDK_TRANSACTIONPEERMAP_H__
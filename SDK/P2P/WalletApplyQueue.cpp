@@ -0,0 +1,112 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "WalletApplyQueue.h"
+
+#include <Common/Log.h>
+
+#include <algorithm>
+#include <boost/bind.hpp>
+
+namespace Elastos {
+	namespace ElaWallet {
+
+		WalletApplyQueue::WalletApplyQueue() :
+			_busy(false),
+			_stopped(false),
+			_peakPending(0),
+			_applied(0) {
+		}
+
+		WalletApplyQueue::~WalletApplyQueue() {
+			Stop();
+		}
+
+		void WalletApplyQueue::Post(const Task &task) {
+			boost::mutex::scoped_lock scopedLock(_lock);
+			if (_stopped) {
+				// running it here instead would take locks the caller may already hold
+				Log::warn("wallet apply: stopped, task dropped");
+				return;
+			}
+
+			if (_thread.get_id() == boost::thread::id())
+				_thread = boost::thread(boost::bind(&WalletApplyQueue::Run, this));
+
+			_tasks.push_back(task);
+			_peakPending = std::max(_peakPending, _tasks.size());
+			_ready.notify_one();
+		}
+
+		void WalletApplyQueue::Flush() {
+			boost::mutex::scoped_lock scopedLock(_lock);
+			while (!_tasks.empty() || _busy)
+				_idle.wait(scopedLock);
+		}
+
+		void WalletApplyQueue::Stop() {
+			{
+				boost::mutex::scoped_lock scopedLock(_lock);
+				if (_stopped)
+					return;
+				_stopped = true;
+				_ready.notify_one();
+			}
+
+			if (_thread.joinable())
+				_thread.join();
+		}
+
+		size_t WalletApplyQueue::Pending() const {
+			boost::mutex::scoped_lock scopedLock(_lock);
+			return _tasks.size() + (_busy ? 1 : 0);
+		}
+
+		size_t WalletApplyQueue::PeakPending() const {
+			boost::mutex::scoped_lock scopedLock(_lock);
+			return _peakPending;
+		}
+
+		uint64_t WalletApplyQueue::Applied() const {
+			boost::mutex::scoped_lock scopedLock(_lock);
+			return _applied;
+		}
+
+		void WalletApplyQueue::Run() {
+			boost::mutex::scoped_lock scopedLock(_lock);
+
+			for (;;) {
+				while (_tasks.empty() && !_stopped)
+					_ready.wait(scopedLock);
+
+				if (_tasks.empty())
+					break; // stopped, and nothing left to apply
+
+				Task task = _tasks.front();
+				_tasks.pop_front();
+				_busy = true;
+
+				scopedLock.unlock();
+				Apply(task);
+				scopedLock.lock();
+
+				_busy = false;
+				if (_tasks.empty())
+					_idle.notify_all();
+			}
+		}
+
+		void WalletApplyQueue::Apply(const Task &task) {
+			try {
+				task();
+			} catch (const std::exception &e) {
+				Log::error("wallet apply: {}", e.what());
+			}
+
+			boost::mutex::scoped_lock scopedLock(_lock);
+			_applied++;
+		}
+
+	}
+}
@@ -0,0 +1,64 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef __ELASTOS_SDK_WALLETAPPLYQUEUE_H__
+#define __ELASTOS_SDK_WALLETAPPLYQUEUE_H__
+
+#include <boost/thread.hpp>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <deque>
+
+namespace Elastos {
+	namespace ElaWallet {
+
+		/**
+		 * Applies what the chain sync found out to the wallet on a thread of its own, one task at a time and in
+		 * the order they were posted. Peer threads post under the PeerManager lock and go on, instead of waiting
+		 * for the wallet and its database with the lock held.
+		 */
+		class WalletApplyQueue : public boost::noncopyable {
+		public:
+			typedef boost::function<void()> Task;
+
+			WalletApplyQueue();
+
+			~WalletApplyQueue();
+
+			// run @task after every task posted before it, dropped once stopped
+			void Post(const Task &task);
+
+			// wait until every task posted so far ran, must not be called from a task
+			void Flush();
+
+			// run the tasks left and end the thread
+			void Stop();
+
+			size_t Pending() const;
+
+			// most tasks waiting at once
+			size_t PeakPending() const;
+
+			uint64_t Applied() const;
+
+		private:
+			void Run();
+
+			void Apply(const Task &task);
+
+		private:
+			mutable boost::mutex _lock;
+			boost::condition_variable _ready, _idle;
+			std::deque<Task> _tasks;
+			bool _busy, _stopped;
+			size_t _peakPending;
+			uint64_t _applied;
+			boost::thread _thread;
+		};
+
+	}
+}
+
+#endif //__ELASTOS_SDK_WALLETAPPLYQUEUE_H__
@@ -11,6 +11,7 @@
 #include <Common/Log.h>
 #include <Common/ErrorChecker.h>
 #include <P2P/ChainParams.h>
+#include <Database/Sqlite.h>
 #include <Plugin/Registry.h>
 #include <WalletCore/Address.h>
 
@@ -22,7 +23,8 @@ namespace Elastos {
 			_minFee(0),
 			_feePerKB(0),
 			_disconnectionTime(0),
-			_chainParameters(nullptr) {
+			_chainParameters(nullptr),
+			_databaseConfig(new SqliteConfig()) {
 		}
 
 		const uint32_t &ChainConfig::Index() const {
@@ -49,6 +51,10 @@ namespace Elastos {
 			return _chainParameters;
 		}
 
+		const SqliteConfigPtr &ChainConfig::DatabaseConfig() const {
+			return _databaseConfig;
+		}
+
 		Config::Config(const Config &cfg) {
 			this->operator=(cfg);
 		}
@@ -113,6 +119,32 @@ namespace Elastos {
 					if (chainConfigJson.find("DisconnectionTime") != chainConfigJson.end())
 						chainConfig->_disconnectionTime = chainConfigJson["DisconnectionTime"].get<uint32_t>();
 
+					if (chainConfigJson.find("Database") != chainConfigJson.end()) {
+						nlohmann::json databaseJson = chainConfigJson["Database"];
+						SqliteConfigPtr databaseConfig = chainConfig->_databaseConfig;
+
+						if (databaseJson.find("JournalMode") != databaseJson.end())
+							databaseConfig->journalMode = databaseJson["JournalMode"].get<std::string>();
+
+						if (databaseJson.find("Synchronous") != databaseJson.end())
+							databaseConfig->synchronous = databaseJson["Synchronous"].get<std::string>();
+
+						if (databaseJson.find("CacheSizeKB") != databaseJson.end())
+							databaseConfig->cacheSizeKB = databaseJson["CacheSizeKB"].get<int>();
+
+						if (databaseJson.find("MmapSize") != databaseJson.end())
+							databaseConfig->mmapSize = databaseJson["MmapSize"].get<int64_t>();
+
+						if (databaseJson.find("CheckpointPages") != databaseJson.end())
+							databaseConfig->checkpointPages = databaseJson["CheckpointPages"].get<int>();
+
+						if (databaseJson.find("GroupCommitMilliseconds") != databaseJson.end())
+							databaseConfig->groupCommitMilliseconds = databaseJson["GroupCommitMilliseconds"].get<int>();
+
+						if (databaseJson.find("GroupCommitTransactions") != databaseJson.end())
+							databaseConfig->groupCommitTransactions = databaseJson["GroupCommitTransactions"].get<int>();
+					}
+
 					if (chainConfigJson.find("ChainParameters") != chainConfigJson.end()) {
 						nlohmann::json chainParamsJson = chainConfigJson["ChainParameters"];
 						ChainParamsPtr chainParams(new ChainParams());
@@ -132,6 +164,15 @@ namespace Elastos {
 						if (chainParamsJson.find("TargetTimePerBlock") != chainParamsJson.end())
 							chainParams->_targetTimePerBlock = chainParamsJson["TargetTimePerBlock"].get<uint32_t>();
 
+						if (chainParamsJson.find("MaxBlocksInFlight") != chainParamsJson.end())
+							chainParams->_maxBlocksInFlight = chainParamsJson["MaxBlocksInFlight"].get<uint32_t>();
+
+						if (chainParamsJson.find("MaxConnections") != chainParamsJson.end())
+							chainParams->_maxConnections = chainParamsJson["MaxConnections"].get<uint32_t>();
+
+						if (chainParamsJson.find("MaxKnownInventory") != chainParamsJson.end())
+							chainParams->_maxKnownInventory = chainParamsJson["MaxKnownInventory"].get<uint32_t>();
+
 						if (chainParamsJson.find("DNSSeeds") != chainParamsJson.end())
 							chainParams->_dnsSeeds = chainParamsJson["DNSSeeds"].get<std::vector<std::string>>();
 
@@ -187,7 +228,7 @@ namespace Elastos {
 			bool changed = false;
 
 			const std::vector<std::string> configNames = {"Index", "MinFee", "FeePerKB", "GenesisAddress",
-														  "DisconnectionTime"};
+														  "DisconnectionTime", "Database"};
 
 			for (const std::string &configName : configNames) {
 				if (newConfig.find(configName) != newConfig.end()) {
@@ -202,7 +243,8 @@ namespace Elastos {
 
 				const std::vector<std::string> chainParameterConfigNames = {
 					"Services", "MagicNumber", "StandardPort", "TargetTimeSpan",
-					"TargetTimePerBlock", "DNSSeeds", "CheckPoints"
+					"TargetTimePerBlock", "MaxBlocksInFlight", "MaxConnections",
+					"MaxKnownInventory", "DNSSeeds", "CheckPoints"
 				};
 
 				for (const std::string &cpConfigName : chainParameterConfigNames) {
@@ -22,6 +22,10 @@ namespace Elastos {
 
 		typedef boost::shared_ptr<ChainParams> ChainParamsPtr;
 
+		struct SqliteConfig;
+
+		typedef boost::shared_ptr<SqliteConfig> SqliteConfigPtr;
+
 		class ChainConfig {
 		public:
 			ChainConfig();
@@ -38,6 +42,8 @@ namespace Elastos {
 
 			const ChainParamsPtr &ChainParameters() const;
 
+			const SqliteConfigPtr &DatabaseConfig() const;
+
 		private:
 			friend class Config;
 
@@ -47,6 +53,7 @@ namespace Elastos {
 			uint32_t _disconnectionTime;
 			std::string _genesisAddress;
 			ChainParamsPtr _chainParameters;
+			SqliteConfigPtr _databaseConfig;
 		};
 
 		typedef boost::shared_ptr<ChainConfig> ChainConfigPtr;
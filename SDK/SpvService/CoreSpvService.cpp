@@ -46,6 +46,8 @@ namespace Elastos {
 						loadBlocks(chainID),
 						peers,
 						loadBlackPeers(),
+						loadPeerScores(),
+						loadSeedPeers(),
 						createPeerManagerListener(),
 						chainID,
 						netType));
@@ -108,6 +110,12 @@ namespace Elastos {
 		void CoreSpvService::saveBlackPeer(const PeerInfo &peer) {
 		}
 
+		void CoreSpvService::savePeerScores(const std::vector<PeerScore> &scores) {
+		}
+
+		void CoreSpvService::saveSeedPeers(const std::string &seed, const std::vector<PeerInfo> &peers) {
+		}
+
 		bool CoreSpvService::networkIsReachable() {
 			return true;
 		}
@@ -145,6 +153,14 @@ namespace Elastos {
 			return {};
 		}
 
+		std::vector<PeerScore> CoreSpvService::loadPeerScores() {
+			return {};
+		}
+
+		SeedPeerMap CoreSpvService::loadSeedPeers() {
+			return {};
+		}
+
 		std::vector<AssetPtr> CoreSpvService::loadAssets() {
 			return {};
 		}
@@ -225,6 +241,23 @@ namespace Elastos {
 			}
 		}
 
+		void WrappedExceptionPeerManagerListener::savePeerScores(const std::vector<PeerScore> &scores) {
+			try {
+				_listener->savePeerScores(scores);
+			} catch (const std::exception &e) {
+				Log::error("{} e: {}", GetFunName(), e.what());
+			}
+		}
+
+		void WrappedExceptionPeerManagerListener::saveSeedPeers(const std::string &seed,
+																const std::vector<PeerInfo> &peers) {
+			try {
+				_listener->saveSeedPeers(seed, peers);
+			} catch (const std::exception &e) {
+				Log::error("{} e: {}", GetFunName(), e.what());
+			}
+		}
+
 		bool WrappedExceptionPeerManagerListener::networkIsReachable() {
 			try {
 				return _listener->networkIsReachable();
@@ -328,6 +361,27 @@ namespace Elastos {
 			}));
 		}
 
+		void WrappedExecutorPeerManagerListener::savePeerScores(const std::vector<PeerScore> &scores) {
+			_executor->Execute(Runnable([this, scores]() -> void {
+				try {
+					_listener->savePeerScores(scores);
+				} catch (const std::exception &e) {
+					Log::error("{} e: {}", GetFunName(), e.what());
+				}
+			}));
+		}
+
+		void WrappedExecutorPeerManagerListener::saveSeedPeers(const std::string &seed,
+															   const std::vector<PeerInfo> &peers) {
+			_executor->Execute(Runnable([this, seed, peers]() -> void {
+				try {
+					_listener->saveSeedPeers(seed, peers);
+				} catch (const std::exception &e) {
+					Log::error("{} e: {}", GetFunName(), e.what());
+				}
+			}));
+		}
+
 		bool WrappedExecutorPeerManagerListener::networkIsReachable() {
 			bool result = true;
 			_executor->Execute(Runnable([this, result]() -> void {
@@ -68,6 +68,10 @@ namespace Elastos {
 
 			virtual void saveBlackPeer(const PeerInfo &peer);
 
+			virtual void savePeerScores(const std::vector<PeerScore> &scores);
+
+			virtual void saveSeedPeers(const std::string &seed, const std::vector<PeerInfo> &peers);
+
 			virtual bool networkIsReachable();
 
 			virtual void txPublished(const std::string &hash, const nlohmann::json &result);
@@ -89,6 +93,10 @@ namespace Elastos {
 
 			virtual std::set<PeerInfo> loadBlackPeers();
 
+			virtual std::vector<PeerScore> loadPeerScores();
+
+			virtual SeedPeerMap loadSeedPeers();
+
 			virtual std::vector<AssetPtr> loadAssets();
 
 			typedef boost::shared_ptr<PeerManager::Listener> PeerManagerListenerPtr;
@@ -130,6 +138,10 @@ namespace Elastos {
 
 			virtual void saveBlackPeer(const PeerInfo &peer);
 
+			virtual void savePeerScores(const std::vector<PeerScore> &scores);
+
+			virtual void saveSeedPeers(const std::string &seed, const std::vector<PeerInfo> &peers);
+
 			virtual bool networkIsReachable();
 
 			virtual void txPublished(const std::string &hash, const nlohmann::json &result);
@@ -162,6 +174,10 @@ namespace Elastos {
 
 			virtual void saveBlackPeer(const PeerInfo &peer);
 
+			virtual void savePeerScores(const std::vector<PeerScore> &scores);
+
+			virtual void saveSeedPeers(const std::string &seed, const std::vector<PeerInfo> &peers);
+
 			virtual bool networkIsReachable();
 
 			virtual void txPublished(const std::string &hash, const nlohmann::json &result);
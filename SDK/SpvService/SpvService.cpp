@@ -11,6 +11,7 @@
 #include <Plugin/Transaction/TransactionOutput.h>
 #include <Wallet/UTXO.h>
 #include <Database/DatabaseManager.h>
+#include <SpvService/Config.h>
 
 #define BACKGROUND_THREAD_COUNT 1
 
@@ -25,11 +26,13 @@ namespace Elastos {
 							   const ChainConfigPtr &config,
 							   const std::string &netType) :
 				_executor(BACKGROUND_THREAD_COUNT),
-				_databaseManager(new DatabaseManager(dbPath)) {
+				_databaseManager(new DatabaseManager(dbPath, *config->DatabaseConfig())) {
 			Init(walletID, chainID, subAccount, earliestPeerTime, config, netType, _databaseManager);
 		}
 
 		SpvService::~SpvService() {
+			// queued wallet updates call back into this and the executor, apply them while both are still here
+			_peerManager->StopWalletApply();
 			_executor.StopThread();
 		}
 
@@ -41,6 +44,7 @@ namespace Elastos {
 		void SpvService::SyncStop() {
 			_peerManager->CancelTimer();
 			_peerManager->Disconnect();
+			_peerManager->FlushWalletApply();
 		}
 
 		void SpvService::ExecutorStop() {
@@ -57,9 +61,24 @@ namespace Elastos {
 		}
 
 		void SpvService::DatabaseFlush() {
+			_peerManager->FlushWalletApply();
 			_databaseManager->flush();
 		}
 
+		nlohmann::json SpvService::GetDatabaseMetrics() const {
+			uint64_t commits = _databaseManager->GetCommitCount();
+			uint64_t syncs = _databaseManager->GetSyncCount();
+			uint64_t blocks = _peerManager->GetSyncMetrics().Get(SyncMetrics::BlocksSaved);
+			nlohmann::json j;
+
+			j["Commits"] = commits;
+			j["CommitsPerBlock"] = blocks == 0 ? 0.0 : (double) commits / blocks;
+			j["Syncs"] = syncs;
+			j["SyncMicroseconds"] = _databaseManager->GetSyncMicroseconds();
+			j["SyncsPerBlock"] = blocks == 0 ? 0.0 : (double) syncs / blocks;
+			return j;
+		}
+
 		void SpvService::onBalanceChanged(const uint256 &asset, const BigInt &balance) {
 			std::for_each(_walletListeners.begin(), _walletListeners.end(),
 						  [&asset, &balance](Wallet::Listener *listener) {
@@ -83,7 +102,10 @@ namespace Elastos {
 		}
 
 		void SpvService::onTxUpdated(const std::vector<TransactionPtr> &txns) {
-			_databaseManager->UpdateTxns(txns);
+			{
+				SyncMetrics::Timer timer(_peerManager->GetSyncMetrics(), SyncMetrics::UpdateTxns);
+				_databaseManager->UpdateTxns(txns);
+			}
 
 			std::for_each(_walletListeners.begin(), _walletListeners.end(),
 						  [&txns](Wallet::Listener *listener) {
@@ -158,7 +180,11 @@ namespace Elastos {
 				           blocks[0]->GetTarget());
 			}
 
-			_databaseManager->PutMerkleBlocks(replace, blocks);
+			{
+				SyncMetrics::Timer timer(_peerManager->GetSyncMetrics(), SyncMetrics::SaveBlocks);
+				_databaseManager->PutMerkleBlocks(replace, blocks);
+				_peerManager->GetSyncMetrics().Add(SyncMetrics::BlocksSaved, blocks.size());
+			}
 
 			std::for_each(_peerManagerListeners.begin(), _peerManagerListeners.end(),
 						  [replace, &blocks](PeerManager::Listener *listener) {
@@ -198,6 +224,37 @@ namespace Elastos {
 			_databaseManager->DeletePeer(entity);
 		}
 
+		void SpvService::savePeerScores(const std::vector<PeerScore> &scores) {
+			std::vector<PeerScoreEntity> entities;
+			PeerScoreEntity entity;
+			for (size_t i = 0; i < scores.size(); ++i) {
+				entity.address = scores[i].Info.Address;
+				entity.port = scores[i].Info.Port;
+				entity.pingTime = scores[i].PingTime;
+				entity.bytesPerSecond = scores[i].BytesPerSecond;
+				entity.misbehaving = scores[i].Misbehaving;
+				entity.connects = scores[i].Connects;
+				entity.failures = scores[i].Failures;
+				entity.lastSeen = scores[i].LastSeen;
+				entities.push_back(entity);
+			}
+
+			_databaseManager->PutPeerScores(entities);
+		}
+
+		void SpvService::saveSeedPeers(const std::string &seed, const std::vector<PeerInfo> &peers) {
+			std::vector<PeerEntity> entities;
+			PeerEntity entity;
+			for (size_t i = 0; i < peers.size(); ++i) {
+				entity.address = peers[i].Address;
+				entity.port = peers[i].Port;
+				entity.timeStamp = peers[i].Timestamp;
+				entities.push_back(entity);
+			}
+
+			_databaseManager->PutSeedPeers(seed, entities);
+		}
+
 		bool SpvService::networkIsReachable() {
 
 			bool reachable = true;
@@ -246,6 +303,21 @@ namespace Elastos {
 				return _databaseManager->GetNormalTxns(chainID, offset, limit);
 			} else if (type == TXN_COINBASE) {
 				return _databaseManager->GetCoinbaseTxns(chainID, offset, limit);
+			} else if (type == TXN_PENDING) {
+				return _databaseManager->GetPendingTxns(chainID, offset, limit);
+			}
+
+			return {};
+		}
+
+		std::vector<TransactionPtr> SpvService::LoadTxnDesc(const std::string &chainID, TxnType type, const TxnCursor &after,
+															size_t limit) const {
+			if (type == TXN_NORMAL) {
+				return _databaseManager->GetNormalTxns(chainID, after, limit);
+			} else if (type == TXN_COINBASE) {
+				return _databaseManager->GetCoinbaseTxns(chainID, after, limit);
+			} else if (type == TXN_PENDING) {
+				return _databaseManager->GetPendingTxns(chainID, after, limit);
 			}
 
 			return {};
@@ -298,6 +370,40 @@ namespace Elastos {
 			return peers;
 		}
 
+		std::vector<PeerScore> SpvService::loadPeerScores() {
+			std::vector<PeerScore> scores;
+
+			std::vector<PeerScoreEntity> entities = _databaseManager->GetAllPeerScores();
+
+			for (size_t i = 0; i < entities.size(); ++i) {
+				PeerScore score(PeerInfo(entities[i].address, entities[i].port, 0));
+				score.PingTime = entities[i].pingTime;
+				score.BytesPerSecond = entities[i].bytesPerSecond;
+				score.Misbehaving = entities[i].misbehaving;
+				score.Connects = entities[i].connects;
+				score.Failures = entities[i].failures;
+				score.LastSeen = entities[i].lastSeen;
+				scores.push_back(score);
+			}
+
+			return scores;
+		}
+
+		SeedPeerMap SpvService::loadSeedPeers() {
+			SeedPeerMap seeds;
+
+			std::map<std::string, std::vector<PeerEntity>> entities = _databaseManager->GetAllSeedPeers();
+
+			for (std::map<std::string, std::vector<PeerEntity>>::iterator it = entities.begin();
+				 it != entities.end(); ++it) {
+				std::vector<PeerInfo> &peers = seeds[it->first];
+				for (size_t i = 0; i < it->second.size(); ++i)
+					peers.push_back(PeerInfo(it->second[i].address, it->second[i].port, it->second[i].timeStamp));
+			}
+
+			return seeds;
+		}
+
 		std::vector<AssetPtr> SpvService::loadAssets() {
 			std::vector<AssetPtr> assets;
 
@@ -50,6 +50,9 @@ namespace Elastos {
 
 			std::vector<TransactionPtr> LoadTxnDesc(const std::string &chainID, TxnType type, size_t offset, size_t limit) const;
 
+			std::vector<TransactionPtr> LoadTxnDesc(const std::string &chainID, TxnType type, const TxnCursor &after,
+													size_t limit) const;
+
 			void RegisterWalletListener(Wallet::Listener *listener);
 
 			void RegisterPeerManagerListener(PeerManager::Listener *listener);
@@ -58,6 +61,9 @@ namespace Elastos {
 
 			void DatabaseFlush();
 
+			// commits and fsyncs of the wallet database, and how many of them each saved block cost on average
+			nlohmann::json GetDatabaseMetrics() const;
+
 		public:
 			virtual void onBalanceChanged(const uint256 &asset, const BigInt &balance);
 
@@ -84,6 +90,10 @@ namespace Elastos {
 
 			virtual void saveBlackPeer(const PeerInfo &peer);
 
+			virtual void savePeerScores(const std::vector<PeerScore> &scores);
+
+			virtual void saveSeedPeers(const std::string &seed, const std::vector<PeerInfo> &peers);
+
 			virtual bool networkIsReachable();
 
 			virtual void txPublished(const std::string &hash, const nlohmann::json &result);
@@ -105,6 +115,10 @@ namespace Elastos {
 
 			virtual std::set<PeerInfo> loadBlackPeers();
 
+			virtual std::vector<PeerScore> loadPeerScores();
+
+			virtual SeedPeerMap loadSeedPeers();
+
 			virtual std::vector<AssetPtr> loadAssets();
 
 			virtual const PeerManagerListenerPtr &createPeerManagerListener();
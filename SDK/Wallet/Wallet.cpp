@@ -46,6 +46,7 @@ namespace Elastos {
 
 			std::vector<UTXOPtr> utxo = LoadUTXOs();
 			std::vector<AssetPtr> assetArray = LoadAssets();
+			UTXOArray utxoLoaded;
 
 			if (assetArray.empty()) {
 				InstallDefaultAsset();
@@ -98,6 +99,7 @@ namespace Elastos {
 							} else {
 								groupedAsset->AddUTXO(u);
 							}
+							utxoLoaded.push_back(u);
 						} else {
 							Log::error("asset {} not found", o->AssetID().GetHex());
 						}
@@ -105,6 +107,7 @@ namespace Elastos {
 						Log::error("utxo hash {} not found", u->Hash().GetHex());
 					}
 				}
+				UpdateUTXOElements(utxoLoaded, {}, true);
 				if (saveTxHash)
 					SaveSpecialTxHash(txHashDPoS, txHashCRC, txHashProposal, txHashDID, _chainID == CHAINID_IDCHAIN);
 			} else {
@@ -192,6 +195,7 @@ namespace Elastos {
 				it->second->ClearData();
 			}
 			_spendingOutputs.clear();
+			_utxoElements.clear();
 			_database.lock()->ClearData();
 		}
 
@@ -741,6 +745,24 @@ namespace Elastos {
 			return _subAccount->ContainsAddress(address);
 		}
 
+		void Wallet::GetBloomFilterElements(std::vector<bytes_t> &elements) const {
+			AddressArray specialAddresses = GetAllSpecialAddresses();
+
+			boost::mutex::scoped_lock scopedLock(lock);
+			const std::vector<bytes_t> &addressElements = _subAccount->BloomFilterElements();
+
+			elements.reserve(elements.size() + specialAddresses.size() + addressElements.size() + _utxoElements.size());
+			for (size_t i = 0; i < specialAddresses.size(); ++i) {
+				if (specialAddresses[i]->Valid())
+					elements.push_back(specialAddresses[i]->ProgramHash().bytes());
+			}
+
+			elements.insert(elements.end(), addressElements.begin(), addressElements.end());
+
+			for (UTXOElementMap::const_iterator it = _utxoElements.begin(); it != _utxoElements.end(); ++it)
+				elements.push_back(it->second);
+		}
+
 		void Wallet::GenerateCID() {
 			_subAccount->InitCID();
 		}
@@ -1148,7 +1170,26 @@ namespace Elastos {
 			return _spendingOutputs.find(utxo) != _spendingOutputs.end();
 		}
 
+		void Wallet::UpdateUTXOElements(const UTXOArray &added, const UTXOArray &deleted, bool replace) {
+			if (replace)
+				_utxoElements.clear();
+
+			for (const UTXOPtr &u : deleted)
+				_utxoElements.erase(u);
+
+			for (const UTXOPtr &u : added) {
+				bytes_t o = u->Hash().bytes();
+				o.append(u->Index());
+				_utxoElements[u] = o;
+			}
+		}
+
 		void Wallet::UTXOUpdated(const UTXOArray &utxoAdded, const UTXOArray &utxoDeleted, bool replace) {
+			{
+				boost::mutex::scoped_lock scopedLock(lock);
+				UpdateUTXOElements(utxoAdded, utxoDeleted, replace);
+			}
+
 			if (!_database.expired()) {
 				std::vector<UTXOEntity> added, deleted;
 
@@ -124,6 +124,10 @@ namespace Elastos {
 			// true if the address was previously generated by BRWalletUnusedAddrs() (even if it's now used)
 			bool ContainsAddress(const AddressPtr &address);
 
+			// append the keys a bloom filter has to match for this wallet: special addresses, every address and CID,
+			// and the outpoint of every UTXO. all but the special addresses are kept ready as they are generated
+			void GetBloomFilterElements(std::vector<bytes_t> &elements) const;
+
 			BigInt GetBalance(const uint256 &assetID) const;
 
 			uint64_t GetFeePerKb() const;
@@ -232,6 +236,8 @@ namespace Elastos {
 
 			bool IsUTXOSpending(const UTXOPtr &utxo) const;
 
+			void UpdateUTXOElements(const UTXOArray &added, const UTXOArray &deleted, bool replace);
+
 		private:
 			void UTXOUpdated(const UTXOArray &added, const UTXOArray &deleted, bool replace = false);
 
@@ -291,6 +297,9 @@ namespace Elastos {
 
 			UTXOSet _spendingOutputs;
 
+			typedef std::map<UTXOPtr, bytes_t, UTXOCompare> UTXOElementMap;
+			UTXOElementMap _utxoElements; // serialized outpoints, the bloom filter keys of UTXOs
+
 			uint64_t _feePerKb;
 
 			uint32_t _blockHeight;
@@ -15,7 +15,8 @@ namespace Elastos {
 
 		BloomFilter::BloomFilter(double falsePositiveRate, size_t elemCount, uint32_t tweak, uint8_t flags) :
 				_flags(flags),
-				_tweak(tweak) {
+				_tweak(tweak),
+				_elemCount(0) {
 
 			size_t length = (falsePositiveRate < DBL_EPSILON) ? BLOOM_MAX_FILTER_LENGTH :
 							(-1.0 / (M_LN2 * M_LN2)) * elemCount * log(falsePositiveRate) / 8.0;
@@ -153,5 +154,9 @@ namespace Elastos {
 
 			return !data.empty();
 		}
+
+		double BloomFilter::FalsePositiveRate() const {
+			return pow(1 - pow(M_E, -1.0 * _hashFuncs * _elemCount / (_filter.size() * 8)), _hashFuncs);
+		}
 	}
 }
@@ -37,6 +37,9 @@ namespace Elastos {
 
 			bool ContainsData(const bytes_t &data);
 
+			// the false positive rate expected with the elements inserted so far
+			double FalsePositiveRate() const;
+
 		private:
 			inline uint32_t ROTL32(uint32_t x, int8_t r) {
 				return (x << r) | (x >> (32 - r));
@@ -0,0 +1,156 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#define CATCH_CONFIG_MAIN
+
+#include <catch.hpp>
+#include "TestHelper.h"
+
+#include <P2P/BlockDownloadWindow.h>
+#include <Common/Log.h>
+
+using namespace Elastos::ElaWallet;
+
+static std::vector<uint256> createHashes(size_t count) {
+	std::vector<uint256> hashes;
+	for (size_t i = 0; i < count; ++i)
+		hashes.push_back(getRanduint256());
+	return hashes;
+}
+
+// the peer answers requests one at a time, each merkleblock taking @serve seconds on a link with @rtt
+static double download(BlockDownloadWindow &window, const std::vector<uint256> &hashes, double rtt, double serve) {
+	std::deque<std::pair<uint256, double>> arrivals;
+	double now = 0, peerFree = 0;
+
+	window.Enqueue(hashes, false);
+	do {
+		std::vector<uint256> requests = window.NextRequests(now);
+		for (size_t i = 0; i < requests.size(); ++i) {
+			peerFree = std::max(peerFree, now + rtt / 2) + serve;
+			arrivals.push_back(std::make_pair(requests[i], peerFree + rtt / 2));
+		}
+
+		if (arrivals.empty())
+			break;
+
+		now = arrivals.front().second;
+		REQUIRE(window.Received(arrivals.front().first, now));
+		arrivals.pop_front();
+	} while (true);
+
+	return now;
+}
+
+TEST_CASE("BlockDownloadWindow test", "[BlockDownloadWindow]") {
+	Log::registerMultiLogger();
+	srand(time(nullptr));
+
+	SECTION("window") {
+		BlockDownloadWindow window;
+		std::vector<uint256> hashes = createHashes(500);
+
+		window.Enqueue(hashes, true);
+		REQUIRE(window.Queued() == 500);
+
+		std::vector<uint256> requests = window.NextRequests(0);
+		REQUIRE(requests.size() == BLOCK_WINDOW_INITIAL);
+		REQUIRE(requests == std::vector<uint256>(hashes.begin(), hashes.begin() + BLOCK_WINDOW_INITIAL));
+		REQUIRE(window.InFlight() == BLOCK_WINDOW_INITIAL);
+		REQUIRE(window.Queued() == 500 - BLOCK_WINDOW_INITIAL);
+
+		// window is full, and one free slot is not worth a getdata
+		REQUIRE(window.NextRequests(0).empty());
+		REQUIRE(window.Received(hashes[0], 1));
+		REQUIRE(!window.Received(hashes[0], 1));
+		REQUIRE(window.NextRequests(1).empty());
+
+		for (size_t i = 1; i < BLOCK_WINDOW_INITIAL / 4; ++i)
+			REQUIRE(window.Received(hashes[i], 1));
+		requests = window.NextRequests(1);
+		REQUIRE(requests.size() == BLOCK_WINDOW_INITIAL / 4);
+		REQUIRE(requests.front() == hashes[BLOCK_WINDOW_INITIAL]);
+
+		// duplicates from an overlapping inv are not queued again
+		window.Enqueue(std::vector<uint256>(hashes.begin() + BLOCK_WINDOW_INITIAL / 4, hashes.begin() + 100), false);
+		REQUIRE(window.Queued() == 500 - BLOCK_WINDOW_INITIAL - BLOCK_WINDOW_INITIAL / 4);
+
+		REQUIRE(window.Remove(hashes[BLOCK_WINDOW_INITIAL]));
+		REQUIRE(window.Remove(hashes[499]));
+		REQUIRE(!window.Remove(hashes[0]));
+		REQUIRE(window.InFlight() == BLOCK_WINDOW_INITIAL - 1);
+		REQUIRE(window.Queued() == 500 - BLOCK_WINDOW_INITIAL - BLOCK_WINDOW_INITIAL / 4 - 1);
+
+		window.Requeue(std::vector<uint256>(hashes.begin() + 10, hashes.end()));
+		REQUIRE(window.InFlight() == 0);
+		REQUIRE(window.Queued() == 490);
+		REQUIRE(window.NextRequests(2).front() == hashes[10]);
+
+		window.Clear();
+		REQUIRE(window.InFlight() == 0);
+		REQUIRE(window.Queued() == 0);
+		REQUIRE(window.Window() == BLOCK_WINDOW_INITIAL);
+	}
+
+	SECTION("next batch") {
+		BlockDownloadWindow window;
+		std::vector<uint256> hashes = createHashes(500), locators;
+
+		window.Enqueue(hashes, true);
+		REQUIRE(!window.NextLocators(locators));
+
+		while (window.Queued() >= window.Window()) {
+			std::vector<uint256> requests = window.NextRequests(0);
+			for (size_t i = 0; i < requests.size(); ++i)
+				REQUIRE(window.Received(requests[i], 0));
+		}
+
+		// requested before the queue drains, and only once per batch
+		REQUIRE(window.Queued() > 0);
+		REQUIRE(window.NextLocators(locators));
+		REQUIRE(locators.size() == 2);
+		REQUIRE(locators[0] == hashes.back());
+		REQUIRE(locators[1] == hashes.front());
+		REQUIRE(!window.NextLocators(locators));
+
+		// the last batch of the chain is short, nothing more to ask for
+		window.Enqueue(createHashes(100), false);
+		REQUIRE(!window.NextLocators(locators));
+	}
+
+	SECTION("adapt to latency") {
+		const double rtt = 0.2, serve = 0.002;
+
+		// an idle link grows the window until the blocks in flight cover the round trip
+		BlockDownloadWindow window;
+		download(window, createHashes(5000), rtt, serve);
+		REQUIRE(window.Window() > rtt / serve);
+		REQUIRE(window.Window() <= BLOCK_WINDOW_MAX);
+
+		// a slower peer makes blocks pile up, the window shrinks back
+		size_t grown = window.Window();
+		download(window, createHashes(5000), rtt, serve * 10);
+		REQUIRE(window.Window() < grown);
+		REQUIRE(window.Window() >= BLOCK_WINDOW_MIN);
+
+		BlockDownloadWindow limited(32);
+		download(limited, createHashes(2000), rtt, serve);
+		REQUIRE(limited.Window() == 32);
+	}
+
+	SECTION("pipelined download") {
+		const double rtt = 0.2, serve = 0.002;
+		const size_t count = 5000;
+
+		// one request at a time pays a round trip per block
+		BlockDownloadWindow lockstep(1);
+		double lockstepTime = download(lockstep, createHashes(count), rtt, serve);
+		REQUIRE(lockstepTime > count * rtt);
+
+		// the window keeps the peer busy, close to the time it needs to serve the blocks
+		BlockDownloadWindow window;
+		double windowTime = download(window, createHashes(count), rtt, serve);
+		REQUIRE(windowTime < count * serve * 2);
+	}
+}
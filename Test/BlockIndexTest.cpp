@@ -0,0 +1,312 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#define CATCH_CONFIG_MAIN
+
+#include <catch.hpp>
+#include "TestHelper.h"
+
+#include <P2P/BlockIndex.h>
+#include <Common/ElementSet.h>
+#include <Common/Log.h>
+
+#include <chrono>
+#include <malloc.h>
+
+using namespace Elastos::ElaWallet;
+
+static std::vector<MerkleBlockPtr> createChain(size_t count, const uint256 &prevBlock = uint256(),
+											   uint32_t startHeight = 0) {
+	std::vector<MerkleBlockPtr> chain;
+	uint256 prevHash = prevBlock == 0 ? getRanduint256() : prevBlock;
+
+	chain.reserve(count);
+	for (size_t i = 0; i < count; ++i) {
+		MerkleBlockPtr block(new MerkleBlock());
+		block->SetHash(getRanduint256());
+		block->SetPrevBlockHash(prevHash);
+		block->SetHeight(startHeight + (uint32_t) i);
+		block->SetTimestamp((startHeight + (uint32_t) i) * 120);
+		prevHash = block->GetHash();
+		chain.push_back(block);
+	}
+
+	return chain;
+}
+
+// walk back to where the fork joins the main chain, the way PeerManager::OnRelayedBlock used to
+static size_t forkLength(const ElementSet<MerkleBlockPtr> &set, const MerkleBlockPtr &forkTip,
+						 const MerkleBlockPtr &mainTip) {
+	MerkleBlockPtr b = forkTip, b2 = mainTip;
+	size_t length = 0;
+
+	while (b && b2 && !b->IsEqual(b2.get())) {
+		length++;
+		b = set.Get(b->GetPrevBlockHash());
+		if (b && b->GetHeight() < b2->GetHeight())
+			b2 = set.Get(b2->GetPrevBlockHash());
+	}
+
+	return length;
+}
+
+static size_t forkLength(const BlockIndex &index, const MerkleBlockPtr &forkTip, const MerkleBlockPtr &mainTip) {
+	MerkleBlockPtr b = forkTip, b2 = mainTip;
+	size_t length = 0;
+
+	while (b && b2 && !b->IsEqual(b2.get())) {
+		length++;
+		b = index.Get(b->GetPrevBlockHash());
+		if (b && b->GetHeight() < b2->GetHeight())
+			b2 = index.GetAncestor(b2->GetHash(), b->GetHeight());
+	}
+
+	return length;
+}
+
+TEST_CASE("BlockIndex test", "[BlockIndex]") {
+	Log::registerMultiLogger();
+	srand(time(nullptr));
+
+	std::vector<MerkleBlockPtr> chain = createChain(1000);
+	BlockIndex index;
+
+	SECTION("insert and lookup") {
+		for (size_t i = 0; i < chain.size(); ++i)
+			REQUIRE(index.Insert(chain[i]));
+		REQUIRE(index.Size() == chain.size());
+		REQUIRE(!index.Insert(chain[0]));
+
+		for (size_t i = 0; i < chain.size(); ++i) {
+			REQUIRE(index.Contains(chain[i]));
+			REQUIRE(index.Get(chain[i]->GetHash()) == chain[i]);
+			REQUIRE(index.GetHeader(chain[i]->GetHash())->height == i);
+			if (i + 1 < chain.size())
+				REQUIRE(index.GetMatchPrevHash(chain[i]->GetHash()) == chain[i + 1]);
+		}
+
+		REQUIRE(index.Get(getRanduint256()) == nullptr);
+		REQUIRE(index.GetMatchPrevHash(chain.back()->GetHash()) == nullptr);
+	}
+
+	SECTION("remove") {
+		for (size_t i = 0; i < chain.size(); ++i)
+			index.Insert(chain[i]);
+
+		REQUIRE(index.Remove(chain[10]));
+		REQUIRE(!index.Remove(chain[10]));
+		REQUIRE(!index.Contains(chain[10]->GetHash()));
+		REQUIRE(index.GetMatchPrevHash(chain[9]->GetHash()) == nullptr);
+
+		REQUIRE(index.RemoveMatchPrevHash(chain[10]->GetHash()));
+		REQUIRE(!index.Contains(chain[11]));
+		REQUIRE(index.Size() == chain.size() - 2);
+
+		index.Clear();
+		REQUIRE(index.Size() == 0);
+		REQUIRE(index.GetMatchPrevHash(chain[0]->GetHash()) == nullptr);
+	}
+
+	SECTION("ancestor lookup") {
+		for (size_t i = 0; i < chain.size(); ++i)
+			index.Insert(chain[i]);
+
+		const uint256 &tip = chain.back()->GetHash();
+		for (size_t h = 0; h < chain.size(); ++h)
+			REQUIRE(index.GetAncestor(tip, (uint32_t) h) == chain[h]);
+		REQUIRE(index.GetAncestor(chain[500]->GetHash(), 501) == nullptr);
+		REQUIRE(index.GetAncestor(getRanduint256(), 0) == nullptr);
+
+		// a gap in the chain makes everything below it unreachable, but not the blocks above it
+		index.Remove(chain[300]);
+		REQUIRE(index.GetAncestor(tip, 299) == nullptr);
+		for (size_t h = 301; h < chain.size(); ++h)
+			REQUIRE(index.GetAncestor(tip, (uint32_t) h) == chain[h]);
+	}
+
+	SECTION("compact") {
+		for (size_t i = 0; i < chain.size(); ++i)
+			index.Insert(chain[i]);
+		REQUIRE(index.FullBlockCount() == chain.size());
+
+		REQUIRE(index.Compact(chain[20]->GetHash()));
+		REQUIRE(!index.Compact(chain[20]->GetHash()));
+		REQUIRE(index.FullBlockCount() == chain.size() - 1);
+		REQUIRE(index.Contains(chain[20]));
+
+		MerkleBlockPtr header = index.Get(chain[20]->GetHash());
+		REQUIRE(header != chain[20]);
+		REQUIRE(header->IsEqual(chain[20].get()));
+		REQUIRE(header->GetPrevBlockHash() == chain[20]->GetPrevBlockHash());
+		REQUIRE(header->GetHeight() == chain[20]->GetHeight());
+		REQUIRE(header->GetTimestamp() == chain[20]->GetTimestamp());
+		REQUIRE(header->GetTarget() == chain[20]->GetTarget());
+		REQUIRE(index.GetAncestor(chain.back()->GetHash(), 10) == chain[10]);
+		REQUIRE(index.GetMatchPrevHash(chain[19]->GetHash())->IsEqual(chain[20].get()));
+
+		// removed slots are reused
+		const BlockIndex::Header *record = index.GetHeader(chain[20]->GetHash());
+		REQUIRE(index.Remove(chain[20]));
+		REQUIRE(index.FullBlockCount() == chain.size() - 1);
+		REQUIRE(index.Insert(chain[20]));
+		REQUIRE(index.GetHeader(chain[20]->GetHash()) == record);
+		REQUIRE(index.Get(chain[20]->GetHash()) == chain[20]);
+	}
+
+	SECTION("forks share a previous block") {
+		index.Insert(chain[0]);
+		index.Insert(chain[1]);
+
+		MerkleBlockPtr fork(new MerkleBlock());
+		fork->SetHash(getRanduint256());
+		fork->SetPrevBlockHash(chain[0]->GetHash());
+		fork->SetHeight(1);
+		REQUIRE(index.Insert(fork));
+
+		REQUIRE(index.Remove(chain[1]));
+		REQUIRE(index.GetMatchPrevHash(chain[0]->GetHash()) == fork);
+	}
+}
+
+TEST_CASE("BlockIndex benchmark", "[.benchmark][BlockIndex]") {
+	Log::registerMultiLogger();
+	srand(time(nullptr));
+
+	const size_t headerCount = 100000;
+	std::vector<MerkleBlockPtr> chain = createChain(headerCount);
+
+	BlockIndex index;
+	size_t found = 0;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < chain.size(); ++i) {
+		index.Insert(chain[i]);
+		if (index.Get(chain[i]->GetPrevBlockHash()) != nullptr)
+			found++;
+	}
+	std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - start;
+	REQUIRE(found == headerCount - 1);
+	WARN("BlockIndex: " << headerCount << " headers, " << elapsed.count() / headerCount << " ns per insert+lookup");
+
+	// the linear set is quadratic, so only measure a slice of the chain
+	const size_t linearCount = 10000;
+	ElementSet<MerkleBlockPtr> set;
+	found = 0;
+	start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < linearCount; ++i) {
+		set.Insert(chain[i]);
+		if (set.Get(chain[i]->GetPrevBlockHash()) != nullptr)
+			found++;
+	}
+	elapsed = std::chrono::steady_clock::now() - start;
+	REQUIRE(found == linearCount - 1);
+	WARN("ElementSet: " << linearCount << " headers, " << elapsed.count() / linearCount << " ns per insert+lookup");
+}
+
+TEST_CASE("BlockIndex deep reorg benchmark", "[.benchmark][BlockIndex]") {
+	Log::registerMultiLogger();
+	srand(time(nullptr));
+
+	const size_t mainLength = 20000, forkDepth = 2000;
+	std::vector<MerkleBlockPtr> chain = createChain(mainLength);
+	const MerkleBlockPtr &joint = chain[mainLength - forkDepth - 1];
+	std::vector<MerkleBlockPtr> fork = createChain(forkDepth + 1, joint->GetHash(), joint->GetHeight() + 1);
+
+	BlockIndex index;
+	ElementSet<MerkleBlockPtr> set;
+	for (size_t i = 0; i < chain.size(); ++i) {
+		index.Insert(chain[i]);
+		set.Insert(chain[i]);
+	}
+	for (size_t i = 0; i < fork.size(); ++i) {
+		index.Insert(fork[i]);
+		set.Insert(fork[i]);
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	REQUIRE(forkLength(set, fork.back(), chain.back()) == fork.size());
+	std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - start;
+	WARN("ElementSet: " << forkDepth << "-block fork joined in " << elapsed.count() / 1000 << " us");
+
+	start = std::chrono::steady_clock::now();
+	REQUIRE(forkLength(index, fork.back(), chain.back()) == fork.size());
+	elapsed = std::chrono::steady_clock::now() - start;
+	WARN("BlockIndex: " << forkDepth << "-block fork joined in " << elapsed.count() / 1000 << " us");
+
+	// difficulty transition and block locator lookups reach far behind the tip
+	const size_t lookups = 1000;
+	size_t found = 0;
+	start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < lookups; ++i) {
+		const MerkleBlockPtr &tip = chain[mainLength - 1 - i];
+		MerkleBlockPtr b = tip;
+		for (size_t j = 0; b && j < BLOCK_DIFFICULTY_INTERVAL; ++j)
+			b = index.Get(b->GetPrevBlockHash());
+		if (b) found++;
+	}
+	elapsed = std::chrono::steady_clock::now() - start;
+	REQUIRE(found == lookups);
+	WARN("BlockIndex: prev walk of " << BLOCK_DIFFICULTY_INTERVAL << " blocks, " << elapsed.count() / lookups << " ns");
+
+	found = 0;
+	start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < lookups; ++i) {
+		const MerkleBlockPtr &tip = chain[mainLength - 1 - i];
+		if (index.GetAncestor(tip->GetHash(), tip->GetHeight() - BLOCK_DIFFICULTY_INTERVAL))
+			found++;
+	}
+	elapsed = std::chrono::steady_clock::now() - start;
+	REQUIRE(found == lookups);
+	WARN("BlockIndex: ancestor " << BLOCK_DIFFICULTY_INTERVAL << " blocks back, " << elapsed.count() / lookups << " ns");
+}
+
+static size_t heapInUse() {
+#if defined(__GLIBC__)
+#if __GLIBC_PREREQ(2, 33)
+	struct mallinfo2 info = mallinfo2();
+	return info.uordblks + info.hblkhd;
+#else
+	struct mallinfo info = mallinfo();
+	return (size_t) info.uordblks + (size_t) info.hblkhd;
+#endif
+#else
+	return 0;
+#endif
+}
+
+TEST_CASE("BlockIndex memory benchmark", "[.benchmark][BlockIndex]") {
+	Log::registerMultiLogger();
+	srand(time(nullptr));
+
+	const size_t headerCount = 10000;
+	size_t base = heapInUse();
+	std::vector<MerkleBlockPtr> chain;
+	uint256 prevHash = getRanduint256();
+	chain.reserve(headerCount);
+	for (size_t i = 0; i < headerCount; ++i) {
+		MerkleBlock *block = new MerkleBlock();
+		setMerkleBlockValues(block);
+		block->SetHash(getRanduint256());
+		block->SetPrevBlockHash(prevHash);
+		block->SetHeight((uint32_t) i);
+		prevHash = block->GetHash();
+		chain.push_back(MerkleBlockPtr(block));
+	}
+	size_t blocksMemory = heapInUse() - base;
+
+	BlockIndex index;
+	base = heapInUse();
+	for (size_t i = 0; i < chain.size(); ++i)
+		index.Insert(chain[i]);
+	size_t indexMemory = heapInUse() - base;
+	REQUIRE(index.FullBlockCount() == headerCount);
+
+	for (size_t i = 0; i < chain.size(); ++i)
+		REQUIRE(index.Compact(chain[i]->GetHash()));
+	REQUIRE(index.FullBlockCount() == 0);
+	chain.clear();
+
+	WARN("MerkleBlock objects: " << blocksMemory / 1024 << " KB per " << headerCount << " headers");
+	WARN("BlockIndex records: " << indexMemory / 1024 << " KB per " << headerCount << " headers (estimated "
+		 << index.MemoryUsage() / 1024 << " KB, " << sizeof(BlockIndex::Header) << " bytes per record)");
+}
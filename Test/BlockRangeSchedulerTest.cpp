@@ -0,0 +1,133 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#define CATCH_CONFIG_MAIN
+
+#include <catch.hpp>
+#include "TestHelper.h"
+
+#include <P2P/BlockRangeScheduler.h>
+#include <Common/Log.h>
+
+using namespace Elastos::ElaWallet;
+
+static std::vector<uint256> createHashes(size_t count) {
+	std::vector<uint256> hashes;
+	for (size_t i = 0; i < count; ++i)
+		hashes.push_back(getRanduint256());
+	return hashes;
+}
+
+TEST_CASE("BlockRangeScheduler test", "[BlockRangeScheduler]") {
+	Log::registerMultiLogger();
+	srand(time(nullptr));
+
+	PeerInfo peer1(uint128(), 20866, 0), peer2(uint128(), 20867, 0), peer3(uint128(), 20868, 0);
+
+	SECTION("assign") {
+		BlockRangeScheduler scheduler(100);
+		std::vector<uint256> hashes = createHashes(250);
+
+		scheduler.AddHashes(hashes, false);
+		REQUIRE(scheduler.Unassigned() == 250);
+
+		// disjoint ranges in chain order, one per peer
+		std::vector<uint256> range1 = scheduler.Assign(peer1, 0);
+		std::vector<uint256> range2 = scheduler.Assign(peer2, 0);
+		std::vector<uint256> range3 = scheduler.Assign(peer3, 0);
+		REQUIRE(range1 == std::vector<uint256>(hashes.begin(), hashes.begin() + 100));
+		REQUIRE(range2 == std::vector<uint256>(hashes.begin() + 100, hashes.begin() + 200));
+		REQUIRE(range3 == std::vector<uint256>(hashes.begin() + 200, hashes.end()));
+		REQUIRE(scheduler.Unassigned() == 0);
+		REQUIRE(scheduler.Assigned() == 250);
+
+		REQUIRE(scheduler.Assign(peer1, 0).empty());
+		REQUIRE(scheduler.IsAssigned(peer1));
+
+		// only the owner of a block counts as delivering it
+		REQUIRE(!scheduler.Received(peer2, hashes[0], 1));
+		REQUIRE(scheduler.Received(peer1, hashes[0], 1));
+		REQUIRE(!scheduler.Received(peer1, hashes[0], 1));
+		REQUIRE(!scheduler.Received(peer1, getRanduint256(), 1));
+
+		for (size_t i = 200; i < 250; ++i)
+			REQUIRE(scheduler.Received(peer3, hashes[i], 1));
+		REQUIRE(!scheduler.IsAssigned(peer3));
+		REQUIRE(scheduler.Assigned() == 199);
+
+		// hashes already queued or assigned are not queued again
+		scheduler.AddHashes(std::vector<uint256>(hashes.begin() + 50, hashes.begin() + 150), false);
+		REQUIRE(scheduler.Unassigned() == 0);
+
+		scheduler.Clear();
+		REQUIRE(scheduler.Unassigned() == 0);
+		REQUIRE(scheduler.Assigned() == 0);
+		REQUIRE(!scheduler.IsAssigned(peer1));
+	}
+
+	SECTION("stall") {
+		BlockRangeScheduler scheduler(100);
+		std::vector<uint256> hashes = createHashes(200);
+
+		scheduler.AddHashes(hashes, false);
+		scheduler.Assign(peer1, 0);
+		scheduler.Assign(peer2, 0);
+
+		for (size_t i = 0; i < 40; ++i)
+			REQUIRE(scheduler.Received(peer1, hashes[i], 20));
+		for (size_t i = 100; i < 110; ++i)
+			REQUIRE(scheduler.Received(peer2, hashes[i], 5));
+
+		// peer2 made no progress for longer than the timeout, what it didn't deliver goes back first in line
+		std::vector<PeerInfo> stalled = scheduler.Stalled(40, 30);
+		REQUIRE(stalled.size() == 1);
+		REQUIRE(stalled[0] == peer2);
+		REQUIRE(!scheduler.IsAssigned(peer2));
+		REQUIRE(scheduler.Unassigned() == 90);
+
+		std::vector<uint256> range = scheduler.Assign(peer3, 40);
+		REQUIRE(range == std::vector<uint256>(hashes.begin() + 110, hashes.end()));
+
+		// a late block from the stalled peer is not counted
+		REQUIRE(!scheduler.Received(peer2, hashes[110], 41));
+		REQUIRE(scheduler.Received(peer3, hashes[110], 41));
+
+		// a disconnected peer's range is released right away
+		scheduler.Release(peer1);
+		REQUIRE(scheduler.Unassigned() == 60);
+		REQUIRE(scheduler.Assign(peer2, 42).front() == hashes[40]);
+		REQUIRE(scheduler.Stalled(50, 30).empty());
+	}
+
+	SECTION("next batch") {
+		BlockRangeScheduler scheduler(100);
+		std::vector<uint256> hashes = createHashes(500), locators;
+
+		scheduler.AddHashes(hashes, true);
+		REQUIRE(!scheduler.NextLocators(locators));
+
+		scheduler.Assign(peer1, 0);
+		scheduler.Assign(peer2, 0);
+		REQUIRE(!scheduler.NextLocators(locators));
+
+		scheduler.Assign(peer3, 0);
+		REQUIRE(scheduler.Unassigned() == 200);
+		REQUIRE(!scheduler.NextLocators(locators));
+
+		// requested before the queue drains, and only once per batch
+		for (size_t i = 0; i < 100; ++i)
+			REQUIRE(scheduler.Received(peer1, hashes[i], 1));
+		scheduler.Assign(peer1, 1);
+		REQUIRE(scheduler.Unassigned() == 100);
+		REQUIRE(scheduler.NextLocators(locators));
+		REQUIRE(locators.size() == 2);
+		REQUIRE(locators[0] == hashes.back());
+		REQUIRE(locators[1] == hashes.front());
+		REQUIRE(!scheduler.NextLocators(locators));
+
+		// the last batch of the chain is short, nothing more to ask for
+		scheduler.AddHashes(createHashes(100), false);
+		REQUIRE(!scheduler.NextLocators(locators));
+	}
+}
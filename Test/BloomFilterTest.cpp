@@ -5,6 +5,7 @@
 #define CATCH_CONFIG_MAIN
 
 #include <catch.hpp>
+#include "TestHelper.h"
 
 #include <nlohmann/json.hpp>
 #include <WalletCore/BloomFilter.h>
@@ -153,5 +154,24 @@ TEST_CASE( "BloomFilter test", "[BloomFilter]" ) {
 		}
 	}
 
+	SECTION("false positive rate") {
+		const size_t capacity = 200;
+		BloomFilter filter(BLOOM_REDUCED_FALSEPOSITIVE_RATE, capacity, (uint32_t) 0x12345678, BLOOM_UPDATE_ALL);
+		REQUIRE(filter.FalsePositiveRate() == 0);
+
+		size_t count = 0;
+		for (; count < capacity; ++count)
+			filter.InsertData(getRandBytes(21));
+		REQUIRE(filter.FalsePositiveRate() < BLOOM_REDUCED_FALSEPOSITIVE_RATE * 1.5);
+
+		// elements added past the capacity degrade it quickly, the filter is rebuilt past ten times the rate
+		while (filter.FalsePositiveRate() <= BLOOM_REDUCED_FALSEPOSITIVE_RATE * 10.0) {
+			filter.InsertData(getRandBytes(21));
+			count++;
+		}
+		REQUIRE(count > capacity * 1.1);
+		REQUIRE(count < capacity * 1.5);
+	}
+
 }
 
@@ -17,11 +17,24 @@
 #include <Plugin/TokenPlugin.h>
 
 #include <fstream>
+#include <chrono>
 
 using namespace Elastos::ElaWallet;
 
 #define DBFILE "wallet.db"
 
+static int countRows(Sqlite &sqlite, const std::string &table) {
+	sqlite3_stmt *stmt;
+	int count = -1;
+
+	REQUIRE(sqlite.Prepare("SELECT COUNT(*) FROM " + table + ";", &stmt, nullptr));
+	if (SQLITE_ROW == sqlite.Step(stmt))
+		count = sqlite.ColumnInt(stmt, 0);
+	REQUIRE(sqlite.Finalize(stmt));
+
+	return count;
+}
+
 TEST_CASE("DatabaseManager test", "[DatabaseManager]") {
 	Log::registerMultiLogger();
 	std::string pluginType = "ELA";
@@ -337,6 +350,77 @@ TEST_CASE("DatabaseManager test", "[DatabaseManager]") {
 
 	}
 
+	SECTION("Peer score test") {
+		static std::vector<PeerScoreEntity> scoreToSave;
+
+		SECTION("Peer score prepare for test") {
+			for (uint16_t i = 0; i < DEFAULT_RECORD_CNT; i++) {
+				PeerScoreEntity score;
+				score.address = getRandUInt128();
+				score.port = i;
+				score.pingTime = rand() / (double) RAND_MAX;
+				score.bytesPerSecond = rand();
+				score.misbehaving = (uint32_t) rand();
+				score.connects = (uint32_t) rand();
+				score.failures = (uint32_t) rand();
+				score.lastSeen = (uint64_t) rand();
+				scoreToSave.push_back(score);
+			}
+		}
+
+		SECTION("Peer score save and read test") {
+			DatabaseManager dbm(DBFILE);
+			REQUIRE(dbm.PutPeerScores(scoreToSave));
+
+			// saving a peer again replaces its score
+			scoreToSave[0].failures++;
+			REQUIRE(dbm.PutPeerScores({scoreToSave[0]}));
+
+			std::vector<PeerScoreEntity> scores = dbm.GetAllPeerScores();
+			REQUIRE(scores.size() == scoreToSave.size());
+			for (size_t i = 0; i < scores.size(); i++) {
+				REQUIRE(scores[i].address == scoreToSave[scores[i].port].address);
+				REQUIRE(scores[i].pingTime == scoreToSave[scores[i].port].pingTime);
+				REQUIRE(scores[i].bytesPerSecond == scoreToSave[scores[i].port].bytesPerSecond);
+				REQUIRE(scores[i].misbehaving == scoreToSave[scores[i].port].misbehaving);
+				REQUIRE(scores[i].connects == scoreToSave[scores[i].port].connects);
+				REQUIRE(scores[i].failures == scoreToSave[scores[i].port].failures);
+				REQUIRE(scores[i].lastSeen == scoreToSave[scores[i].port].lastSeen);
+			}
+		}
+
+		SECTION("Peer score delete test") {
+			DatabaseManager dbm(DBFILE);
+			REQUIRE(dbm.DeleteAllPeerScores());
+			REQUIRE(dbm.GetAllPeerScores().empty());
+		}
+	}
+
+	SECTION("Seed peer test") {
+		DatabaseManager dbm(DBFILE);
+		std::vector<PeerEntity> peers1, peers2;
+		for (int i = 0; i < DEFAULT_RECORD_CNT; i++) {
+			PeerEntity peer;
+			peer.address = getRandUInt128();
+			peer.port = (uint16_t) rand();
+			peer.timeStamp = (uint64_t) rand();
+			(i % 2 ? peers1 : peers2).push_back(peer);
+		}
+
+		REQUIRE(dbm.PutSeedPeers("seed1", peers1));
+		REQUIRE(dbm.PutSeedPeers("seed2", peers2));
+		// a seed looked up again replaces what it returned before
+		REQUIRE(dbm.PutSeedPeers("seed2", {peers2[0]}));
+
+		std::map<std::string, std::vector<PeerEntity>> seeds = dbm.GetAllSeedPeers();
+		REQUIRE(seeds.size() == 2);
+		REQUIRE(seeds["seed1"].size() == peers1.size());
+		REQUIRE(seeds["seed2"].size() == 1);
+		REQUIRE(seeds["seed2"][0].address == peers2[0].address);
+		REQUIRE(seeds["seed2"][0].port == peers2[0].port);
+		REQUIRE(seeds["seed2"][0].timeStamp == peers2[0].timeStamp);
+	}
+
 	SECTION("Transaction test") {
 #define TEST_TX_RECORD_CNT DEFAULT_RECORD_CNT
 		static std::vector<TransactionPtr> txToSave;
@@ -433,6 +517,201 @@ TEST_CASE("DatabaseManager test", "[DatabaseManager]") {
 
 	}
 
+	SECTION("Transaction text key migration test") {
+		const std::string dbFile = "wallet_text_key.db";
+		std::vector<TransactionPtr> txns;
+
+		boost::filesystem::remove(dbFile);
+		for (size_t i = 0; i < 10; ++i) {
+			TransactionPtr tx(new Transaction());
+			initTransaction(*tx, Transaction::TxVersion::V09);
+			tx->SetBlockHeight(100 + i);
+			txns.push_back(tx);
+		}
+
+		{
+			// the table as it was before the blob keys, with one tx stored twice
+			Sqlite sqlite(dbFile);
+			REQUIRE(sqlite.exec("create table transactionTable(_id text not null, transactionBuff blob, "
+								"transactionBlockHeight integer, transactionTimeStamp integer, "
+								"transactionRemark text DEFAULT '', assetID text not null, "
+								"transactionISO text DEFAULT 'ELA');", nullptr, nullptr));
+			for (size_t i = 0; i <= txns.size(); ++i) {
+				const TransactionPtr &tx = txns[i % txns.size()];
+				std::string hash = tx->GetHash().GetHex();
+				ByteStream stream;
+				tx->Serialize(stream, true);
+
+				sqlite3_stmt *stmt = NULL;
+				REQUIRE(sqlite.Prepare("INSERT INTO transactionTable VALUES (?, ?, ?, ?, '', '', ?);", &stmt, nullptr));
+				REQUIRE(sqlite.BindText(stmt, 1, hash, nullptr));
+				REQUIRE(sqlite.BindBlob(stmt, 2, stream.GetBytes(), nullptr));
+				REQUIRE(sqlite.BindInt(stmt, 3, tx->GetBlockHeight()));
+				REQUIRE(sqlite.BindInt64(stmt, 4, tx->GetTimestamp()));
+				REQUIRE(sqlite.BindText(stmt, 5, ISO, nullptr));
+				REQUIRE(sqlite.Step(stmt) == SQLITE_DONE);
+				REQUIRE(sqlite.Finalize(stmt));
+			}
+		}
+
+		for (int open = 0; open < 2; ++open) {
+			DatabaseManager dm(dbFile);
+
+			std::vector<TransactionPtr> readTx = dm.GetNormalTxns(CHAINID_MAINCHAIN);
+			REQUIRE(readTx.size() == txns.size());
+			for (size_t i = 0; i < txns.size(); ++i) {
+				REQUIRE(readTx[i]->GetHash() == txns[i]->GetHash());
+				REQUIRE(readTx[i]->GetBlockHeight() == txns[i]->GetBlockHeight());
+				REQUIRE(dm.ContainTxn(txns[i]->GetHash()));
+			}
+			REQUIRE(!dm.ContainTxn(getRanduint256()));
+		}
+
+		boost::filesystem::remove(dbFile);
+	}
+
+	SECTION("Transaction batch with a duplicate hash test") {
+		const std::string dbFile = "wallet_duplicate_tx.db";
+		std::vector<TransactionPtr> txns;
+
+		boost::filesystem::remove(dbFile);
+		for (size_t i = 0; i < 3; ++i) {
+			TransactionPtr tx(new Transaction());
+			initTransaction(*tx, Transaction::TxVersion::V09);
+			tx->SetBlockHeight(100 + i);
+			txns.push_back(tx);
+		}
+		TransactionPtr duplicate(new Transaction(*txns[0]));
+		duplicate->SetBlockHeight(200);
+		txns.insert(txns.begin() + 1, duplicate);
+
+		{
+			DatabaseManager dm(dbFile);
+			REQUIRE(dm.PutNormalTxns(txns));
+
+			// the whole batch is stored, and the first row of the duplicate is kept
+			std::vector<TransactionPtr> readTx = dm.GetNormalTxns(CHAINID_MAINCHAIN);
+			REQUIRE(readTx.size() == 3);
+			REQUIRE(dm.ContainTxn(txns.back()->GetHash()));
+			TransactionPtr first = dm.GetNormalTxn(txns[0]->GetHash(), CHAINID_MAINCHAIN);
+			REQUIRE(first != nullptr);
+			REQUIRE(first->GetBlockHeight() == 100);
+
+			REQUIRE(!dm.PutNormalTxn(duplicate));
+		}
+
+		boost::filesystem::remove(dbFile);
+	}
+
+	SECTION("Group commit test") {
+		const std::string dbFile = "wallet_group_commit.db";
+		boost::filesystem::remove(dbFile);
+
+		SqliteConfig config;
+		config.groupCommitMilliseconds = 60000;
+		config.groupCommitTransactions = 5;
+
+		std::vector<TransactionPtr> txns;
+		for (size_t i = 0; i < 5; ++i) {
+			TransactionPtr tx(new Transaction());
+			initTransaction(*tx, Transaction::TxVersion::V09);
+			txns.push_back(tx);
+		}
+
+		{
+			DatabaseManager dm(dbFile, config);
+			Sqlite other(dbFile);
+			uint64_t commits = dm.GetCommitCount();
+
+			// seen at once by the database manager, by other connections once committed
+			REQUIRE(dm.PutNormalTxn(txns[0]));
+			REQUIRE(dm.ContainTxn(txns[0]->GetHash()));
+			REQUIRE(dm.GetNormalTxns(CHAINID_MAINCHAIN).size() == 1);
+			REQUIRE(countRows(other, "transactionTable") == 0);
+
+			dm.flush();
+			REQUIRE(dm.GetCommitCount() == commits + 1);
+			REQUIRE(countRows(other, "transactionTable") == 1);
+
+			// the fifth transaction commits the batch
+			for (size_t i = 1; i < 5; ++i)
+				REQUIRE(dm.PutNormalTxn(txns[i]));
+			REQUIRE(countRows(other, "transactionTable") == 1);
+			REQUIRE(dm.PutUTXOs({UTXOEntity(txns[0]->GetHash().GetHex(), 0)}));
+			REQUIRE(countRows(other, "transactionTable") == 5);
+			REQUIRE(dm.GetCommitCount() == commits + 2);
+
+			// and what is pending at the end is committed by the destructor
+			REQUIRE(dm.DeleteNormalTxn(txns[0]->GetHash()));
+			REQUIRE(countRows(other, "transactionTable") == 5);
+		}
+
+		{
+			Sqlite sqlite(dbFile);
+			REQUIRE(countRows(sqlite, "transactionTable") == 4);
+		}
+
+		// commits on time as well
+		config.groupCommitMilliseconds = 20;
+		config.groupCommitTransactions = 1000;
+		{
+			DatabaseManager dm(dbFile, config);
+			Sqlite other(dbFile);
+
+			REQUIRE(dm.PutNormalTxn(txns[0]));
+			for (int i = 0; i < 100 && countRows(other, "transactionTable") != 5; ++i)
+				boost::this_thread::sleep_for(boost::chrono::milliseconds(10));
+			REQUIRE(countRows(other, "transactionTable") == 5);
+		}
+
+		boost::filesystem::remove(dbFile);
+	}
+
+	SECTION("Transaction keyset page test") {
+		const std::string dbFile = "wallet_page.db";
+		boost::filesystem::remove(dbFile);
+
+		// few heights and timestamps, so that pages have to break ties on the hash
+		std::vector<TransactionPtr> txns;
+		for (size_t i = 0; i < 50; ++i) {
+			TransactionPtr tx(new Transaction());
+			initTransaction(*tx, Transaction::TxVersion::V09);
+			tx->SetBlockHeight(100 + i % 5);
+			tx->SetTimestamp(1000 + i % 2);
+			txns.push_back(tx);
+		}
+
+		DatabaseManager dm(dbFile);
+		REQUIRE(dm.PutNormalTxns(txns));
+
+		for (int asc = 0; asc < 2; ++asc) {
+			std::vector<TransactionPtr> all = dm.GetNormalTxns(CHAINID_MAINCHAIN, 0, txns.size(), asc);
+			REQUIRE(all.size() == txns.size());
+
+			std::vector<TransactionPtr> paged = dm.GetNormalTxns(CHAINID_MAINCHAIN, 0, 7, asc);
+			REQUIRE(paged.size() == 7);
+			for (;;) {
+				const TransactionPtr &last = paged.back();
+				std::vector<TransactionPtr> page = dm.GetNormalTxns(CHAINID_MAINCHAIN,
+					TxnCursor(last->GetBlockHeight(), last->GetTimestamp(), last->GetHash()), 7, asc);
+				paged.insert(paged.end(), page.begin(), page.end());
+				if (page.size() < 7)
+					break;
+			}
+
+			REQUIRE(paged.size() == all.size());
+			for (size_t i = 0; i < all.size(); ++i) {
+				REQUIRE(paged[i]->GetHash() == all[i]->GetHash());
+				if (i > 0 && asc)
+					REQUIRE(paged[i]->GetBlockHeight() >= paged[i - 1]->GetBlockHeight());
+				else if (i > 0)
+					REQUIRE(paged[i]->GetBlockHeight() <= paged[i - 1]->GetBlockHeight());
+			}
+		}
+
+		boost::filesystem::remove(dbFile);
+	}
+
 	SECTION("UTXO Store Test") {
 		if (boost::filesystem::exists(DBFILE) && boost::filesystem::is_regular_file(DBFILE)) {
 			boost::filesystem::remove(DBFILE);
@@ -574,3 +853,102 @@ TEST_CASE("DatabaseManager test", "[DatabaseManager]") {
 
 }
 
+TEST_CASE("Transaction lookup benchmark", "[.benchmark][DatabaseManager]") {
+	Log::registerMultiLogger();
+	const std::string dbFile = "wallet_lookup.db";
+	const size_t lookups = 1000;
+	const size_t tableSizes[] = {1000, 10000, 100000};
+
+	for (size_t size : tableSizes) {
+		boost::filesystem::remove(dbFile);
+		Sqlite sqlite(dbFile);
+		TransactionNormal table(&sqlite);
+		table.InitializeTable();
+
+		std::vector<TransactionPtr> txns;
+		for (size_t i = 0; i < size; ++i) {
+			TransactionPtr tx(new Transaction());
+			tx->SetLockTime(i);
+			tx->SetBlockHeight(i);
+			txns.push_back(tx);
+		}
+		REQUIRE(table.Puts(txns));
+
+		size_t found = 0;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < lookups; ++i) {
+			if (table.ContainHash(txns[rand() % size]->GetHash()))
+				found++;
+			if (table.ContainHash(getRanduint256()))
+				found++;
+		}
+		std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - start;
+		REQUIRE(found == lookups);
+
+		start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < lookups; ++i)
+			REQUIRE(table.Get(txns[rand() % size]->GetHash(), CHAINID_MAINCHAIN) != nullptr);
+		std::chrono::nanoseconds getElapsed = std::chrono::steady_clock::now() - start;
+
+		WARN("Transaction lookup: " << size << " txns, " << elapsed.count() / (2 * lookups) / 1000 <<
+			 " us per ContainHash, " << getElapsed.count() / lookups / 1000 << " us per Get");
+	}
+
+	boost::filesystem::remove(dbFile);
+}
+
+TEST_CASE("Transaction page benchmark", "[.benchmark][DatabaseManager]") {
+	Log::registerMultiLogger();
+	const std::string dbFile = "wallet_page.db";
+	const size_t tableSize = 100000;
+	const size_t pageSize = 20;
+	const size_t depths[] = {0, 1000, 10000, 99000};
+
+	boost::filesystem::remove(dbFile);
+	Sqlite sqlite(dbFile);
+	TransactionNormal table(&sqlite);
+	table.InitializeTable();
+
+	std::vector<TransactionPtr> txns;
+	for (size_t i = 0; i < tableSize; ++i) {
+		TransactionPtr tx(new Transaction());
+		tx->SetLockTime(i);
+		tx->SetBlockHeight(i / 4);
+		tx->SetTimestamp(i / 4);
+		txns.push_back(tx);
+	}
+	REQUIRE(table.Puts(txns));
+
+	for (size_t depth : depths) {
+		const size_t rounds = 100;
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		std::vector<TransactionPtr> byOffset;
+		for (size_t i = 0; i < rounds; ++i)
+			byOffset = table.Gets(CHAINID_MAINCHAIN, depth, pageSize);
+		std::chrono::nanoseconds offsetElapsed = std::chrono::steady_clock::now() - start;
+
+		TxnCursor after;
+		if (depth > 0) {
+			TransactionPtr last = table.Gets(CHAINID_MAINCHAIN, depth - 1, 1)[0];
+			after = TxnCursor(last->GetBlockHeight(), last->GetTimestamp(), last->GetHash());
+		}
+
+		start = std::chrono::steady_clock::now();
+		std::vector<TransactionPtr> byCursor;
+		for (size_t i = 0; i < rounds; ++i)
+			byCursor = depth > 0 ? table.Gets(CHAINID_MAINCHAIN, after, pageSize) :
+					   table.Gets(CHAINID_MAINCHAIN, 0, pageSize);
+		std::chrono::nanoseconds cursorElapsed = std::chrono::steady_clock::now() - start;
+
+		REQUIRE(byCursor.size() == pageSize);
+		for (size_t i = 0; i < pageSize; ++i)
+			REQUIRE(byCursor[i]->GetHash() == byOffset[i]->GetHash());
+
+		WARN("Transaction page: " << tableSize << " txns, page of " << pageSize << " at " << depth << ", " <<
+			 offsetElapsed.count() / rounds / 1000 << " us by offset, " <<
+			 cursorElapsed.count() / rounds / 1000 << " us by cursor");
+	}
+
+	boost::filesystem::remove(dbFile);
+}
@@ -0,0 +1,615 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef __ELASTOS_SDK_FAKEPEER_H__
+#define __ELASTOS_SDK_FAKEPEER_H__
+
+#include <P2P/Message/Message.h>
+#include <P2P/PeerInfo.h>
+#include <Plugin/Block/AuxPow.h>
+#include <Plugin/Block/MerkleBlock.h>
+#include <Plugin/Transaction/Transaction.h>
+#include <Plugin/Transaction/TransactionInput.h>
+#include <Plugin/Transaction/TransactionOutput.h>
+#include <Plugin/Transaction/Attribute.h>
+#include <Plugin/Transaction/Program.h>
+#include <WalletCore/Address.h>
+#include <Common/ByteStream.h>
+#include <Common/hash.h>
+
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+
+#include <atomic>
+#include <map>
+#include <random>
+#include <cstring>
+#include <poll.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#define FAKE_PEER_MAGIC         2018299
+#define FAKE_PEER_VERSION       70013
+#define FAKE_CHAIN_TARGET       0x1f7fffff // easiest target a merkleblock accepts, about 1 in 512 hashes meets it
+#define FAKE_CHAIN_BLOCK_TIME   120
+#define FAKE_PEER_MAX_INV       500
+
+namespace Elastos {
+	namespace ElaWallet {
+
+		/**
+		 * A synthetic ELA chain, the same for the same options. Every block carries an AuxPow and claims
+		 * TotalTxPerBlock transactions, of which TxPerBlock are matched and served along with its merkleblock, as if
+		 * they passed the bloom filter. Every WalletTxInterval blocks one of them pays an address of the wallet.
+		 */
+		class FakeChain {
+		public:
+			struct Options {
+				Options() :
+					Length(2000),
+					TxPerBlock(1),
+					TotalTxPerBlock(1000),
+					AuxPowBranch(12),
+					WalletTxInterval(0),
+					WalletAddressesInOrder(false),
+					MempoolTxs(1),
+					StartTime(0),
+					Seed(1) {
+				}
+
+				size_t Length;           // blocks after the genesis block
+				size_t TxPerBlock;       // matched tx served with each merkleblock
+				size_t TotalTxPerBlock;  // tx each block claims to hold, at least TxPerBlock
+				size_t AuxPowBranch;     // merkle branch length of each AuxPow
+				size_t WalletTxInterval; // a wallet tx every so many blocks, 0 for none
+				std::vector<Address> WalletAddresses;
+				bool WalletAddressesInOrder; // pay WalletAddresses one after the other instead of at random
+				size_t MempoolTxs;       // unconfirmed tx answered to a mempool request
+				time_t StartTime;        // genesis timestamp, 0 to end the chain now
+				uint32_t Seed;
+			};
+
+			explicit FakeChain(const Options &options) :
+				_options(options),
+				_random(options.Seed) {
+				time_t start = options.StartTime;
+				if (start == 0)
+					start = time(nullptr) - (options.Length + 1) * FAKE_CHAIN_BLOCK_TIME;
+
+				MineAuxPow();
+
+				for (size_t height = 0; height <= options.Length; ++height)
+					AddBlock(start + height * FAKE_CHAIN_BLOCK_TIME);
+
+				for (size_t i = 0; i < options.MempoolTxs; ++i) {
+					TransactionPtr tx = CreateTx(RandomAddress());
+					_mempool.push_back(tx);
+					_txs[tx->GetHash()] = tx;
+				}
+			}
+
+			uint32_t Height() const {
+				return (uint32_t) (_blocks.size() - 1);
+			}
+
+			const std::vector<MerkleBlockPtr> &Blocks() const {
+				return _blocks;
+			}
+
+			const std::vector<TransactionPtr> &BlockTxs(uint32_t height) const {
+				return _blockTxs[height];
+			}
+
+			const std::vector<TransactionPtr> &Mempool() const {
+				return _mempool;
+			}
+
+			size_t WalletTxCount() const {
+				return _walletTxCount;
+			}
+
+			// height of @hash on the chain, -1 if unknown
+			int Find(const uint256 &hash) const {
+				std::map<uint256, uint32_t>::const_iterator it = _heights.find(hash);
+				return it == _heights.end() ? -1 : (int) it->second;
+			}
+
+			TransactionPtr FindTx(const uint256 &hash) const {
+				std::map<uint256, TransactionPtr>::const_iterator it = _txs.find(hash);
+				return it == _txs.end() ? nullptr : it->second;
+			}
+
+			// the genesis block as a config checkpoint: [height, hash, timestamp, target]
+			nlohmann::json Checkpoint() const {
+				const MerkleBlockPtr &genesis = _blocks.front();
+				nlohmann::json j;
+				j.push_back(genesis->GetHeight());
+				j.push_back(genesis->GetHash().GetHex());
+				j.push_back(genesis->GetTimestamp());
+				j.push_back(genesis->GetTarget());
+				return j;
+			}
+
+		private:
+			bytes_t RandomBytes(size_t size) {
+				bytes_t bytes(size);
+				for (size_t i = 0; i < size; ++i)
+					bytes[i] = (uint8_t) _random();
+				return bytes;
+			}
+
+			uint256 RandomHash() {
+				return uint256(RandomBytes(32));
+			}
+
+			Address RandomAddress() {
+				bytes_t programHash = RandomBytes(21);
+				programHash[0] = PrefixStandard;
+				return Address(uint168(programHash));
+			}
+
+			Address WalletAddress() {
+				size_t i = _options.WalletAddressesInOrder ? _walletTxCount : (size_t) _random();
+				return _options.WalletAddresses[i % _options.WalletAddresses.size()];
+			}
+
+			// the parent block header only has to meet the target, the same AuxPow serves every block
+			void MineAuxPow() {
+				std::vector<uint256> branch;
+				for (size_t i = 0; i < _options.AuxPowBranch; ++i)
+					branch.push_back(RandomHash());
+				_auxPow.SetAuxMerkleBranch(branch);
+				_auxPow.SetCoinBaseMerkle(branch);
+
+				BRTransaction *coinbase = BRTransactionNew();
+				bytes_t script = RandomBytes(25), signature = RandomBytes(100);
+				BRTransactionAddInput(coinbase, UINT256_ZERO, 0xffffffff, 0, &script[0], script.size(), &signature[0],
+									  signature.size(), nullptr, 0, 0xffffffff);
+				BRTransactionAddOutput(coinbase, 1250000000, &script[0], script.size());
+				_auxPow.SetBTCTransaction(coinbase);
+
+				BRMerkleBlock *header = _auxPow.GetParBlockHeader();
+				header->version = 0x20000000;
+				header->timestamp = (uint32_t) time(nullptr);
+				header->target = 0x1d00ffff;
+				memcpy(header->prevBlock.u8, RandomHash().begin(), sizeof(header->prevBlock));
+				memcpy(header->merkleRoot.u8, RandomHash().begin(), sizeof(header->merkleRoot));
+				header->nonce = 0;
+				while (!MeetsTarget(_auxPow.GetParBlockHeaderHash(), FAKE_CHAIN_TARGET))
+					header->nonce++;
+			}
+
+			static bool MeetsTarget(const uint256 &hash, uint32_t compact) {
+				const uint32_t size = compact >> 24, target = compact & 0x00ffffff;
+				uint256 t;
+
+				*(uint32_t *) (t.begin() + size - 3) = target;
+				for (int i = t.size() - 1; i >= 0; i--) {
+					if (hash.begin()[i] != t.begin()[i])
+						return hash.begin()[i] < t.begin()[i];
+				}
+				return true;
+			}
+
+			TransactionPtr CreateTx(const Address &to) {
+				TransactionPtr tx(new Transaction());
+				tx->SetVersion(Transaction::TxVersion::V09);
+				tx->SetLockTime(0);
+
+				InputPtr input(new TransactionInput());
+				input->SetTxHash(RandomHash());
+				input->SetIndex(0);
+				input->SetSequence(0xffffffff);
+				tx->AddInput(input);
+
+				tx->AddOutput(OutputPtr(new TransactionOutput(BigInt(100000000 + _random() % 100000000), to)));
+				tx->AddOutput(OutputPtr(new TransactionOutput(BigInt(_random()), RandomAddress())));
+				tx->AddAttribute(AttributePtr(new Attribute(Attribute::Nonce, RandomBytes(8))));
+				tx->AddProgram(ProgramPtr(new Program("", RandomBytes(35), RandomBytes(65))));
+				tx->GetHash();
+
+				return tx;
+			}
+
+			void AddBlock(time_t timestamp) {
+				uint32_t height = (uint32_t) _blocks.size();
+				size_t total = std::max(_options.TotalTxPerBlock, _options.TxPerBlock + 1);
+				std::vector<TransactionPtr> txs;
+				std::vector<uint256> leaves;
+				std::vector<bool> matched(total, false);
+
+				for (size_t i = 0; i < total; ++i)
+					leaves.push_back(RandomHash());
+
+				// matched tx spread over the block, the coinbase at 0 never is one
+				for (size_t i = 0; height > 0 && i < _options.TxPerBlock; ++i) {
+					bool toWallet = i == 0 && _options.WalletTxInterval > 0 && !_options.WalletAddresses.empty() &&
+									height % _options.WalletTxInterval == 0;
+					TransactionPtr tx = CreateTx(toWallet ? WalletAddress() : RandomAddress());
+					size_t pos = 1 + i * (total - 1) / _options.TxPerBlock;
+
+					leaves[pos] = tx->GetHash();
+					matched[pos] = true;
+					txs.push_back(tx);
+					_txs[tx->GetHash()] = tx;
+					if (toWallet) _walletTxCount++;
+				}
+
+				std::vector<uint256> hashes;
+				std::vector<bool> bits;
+				int depth = 0;
+				while (TreeWidth(total, depth) > 1) depth++;
+				Traverse(leaves, matched, depth, 0, hashes, bits);
+
+				std::vector<uint8_t> flags((bits.size() + 7) / 8, 0);
+				for (size_t i = 0; i < bits.size(); ++i)
+					if (bits[i]) flags[i / 8] |= (uint8_t) (1 << (i % 8));
+
+				boost::shared_ptr<MerkleBlock> block(new MerkleBlock());
+				block->SetVersion(0);
+				block->SetPrevBlockHash(height == 0 ? uint256() : _blocks.back()->GetHash());
+				block->SetRootBlockHash(TreeHash(leaves, depth, 0));
+				block->SetTimestamp((uint32_t) timestamp);
+				block->SetTarget(FAKE_CHAIN_TARGET);
+				block->SetNonce((uint32_t) _random());
+				block->SetHeight(height);
+				block->SetTransactionCount((uint32_t) total);
+				block->SetHashes(hashes);
+				block->SetFlags(flags);
+				block->SetAuxPow(_auxPow);
+
+				_heights[block->GetHash()] = height;
+				_blocks.push_back(block);
+				_blockTxs.push_back(txs);
+			}
+
+			static size_t TreeWidth(size_t total, int depth) {
+				return (total + (((size_t) 1) << depth) - 1) >> depth;
+			}
+
+			uint256 TreeHash(const std::vector<uint256> &leaves, int depth, size_t pos) const {
+				if (depth == 0)
+					return leaves[pos];
+
+				uint256 left = TreeHash(leaves, depth - 1, pos * 2), right = left;
+				if (pos * 2 + 1 < TreeWidth(leaves.size(), depth - 1))
+					right = TreeHash(leaves, depth - 1, pos * 2 + 1);
+
+				bytes_t data(left.begin(), left.size());
+				data += bytes_t(right.begin(), right.size());
+				return uint256(sha256_2(data));
+			}
+
+			// the partial merkle tree of a merkleblock, depth first: a flag per node, and the hash of every node
+			// that has no matched tx below it or is a matched leaf
+			void Traverse(const std::vector<uint256> &leaves, const std::vector<bool> &matched, int depth, size_t pos,
+						  std::vector<uint256> &hashes, std::vector<bool> &bits) const {
+				bool parentOfMatch = false;
+				for (size_t i = pos << depth; i < ((pos + 1) << depth) && i < leaves.size(); ++i)
+					parentOfMatch = parentOfMatch || matched[i];
+
+				bits.push_back(parentOfMatch);
+				if (depth == 0 || !parentOfMatch) {
+					hashes.push_back(TreeHash(leaves, depth, pos));
+				} else {
+					Traverse(leaves, matched, depth - 1, pos * 2, hashes, bits);
+					if (pos * 2 + 1 < TreeWidth(leaves.size(), depth - 1))
+						Traverse(leaves, matched, depth - 1, pos * 2 + 1, hashes, bits);
+				}
+			}
+
+		private:
+			Options _options;
+			std::mt19937 _random;
+			AuxPow _auxPow;
+			std::vector<MerkleBlockPtr> _blocks;
+			std::vector<std::vector<TransactionPtr>> _blockTxs;
+			std::vector<TransactionPtr> _mempool;
+			std::map<uint256, uint32_t> _heights;
+			std::map<uint256, TransactionPtr> _txs;
+			size_t _walletTxCount = 0;
+		};
+
+		/**
+		 * Serves a FakeChain over loopback the way an ELA node answers an SPV wallet: version/verack, getblocks with
+		 * an inv of the next block hashes, getdata with merkleblocks and their matched tx, ping/pong, and mempool
+		 * with an inv of the unconfirmed tx. filterload and filteradd are counted and otherwise ignored. One thread
+		 * accepts, and one thread serves each connection.
+		 */
+		class FakePeer {
+		public:
+			FakePeer(const FakeChain &chain, uint32_t magic = FAKE_PEER_MAGIC) :
+				_chain(chain),
+				_magic(magic),
+				_stopped(false),
+				_connections(0),
+				_messagesSent(0),
+				_blocksServed(0),
+				_filterLoads(0),
+				_filterAdds(0) {
+				struct sockaddr_in addr;
+				socklen_t len = sizeof(addr);
+				int on = 1;
+
+				memset(&addr, 0, sizeof(addr));
+				addr.sin_family = AF_INET;
+				addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+				addr.sin_port = 0;
+
+				_listener = socket(AF_INET, SOCK_STREAM, 0);
+				setsockopt(_listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+				bind(_listener, (struct sockaddr *) &addr, sizeof(addr));
+				listen(_listener, 8);
+				getsockname(_listener, (struct sockaddr *) &addr, &len);
+				_port = ntohs(addr.sin_port);
+
+				_threads.create_thread(boost::bind(&FakePeer::AcceptLoop, this));
+			}
+
+			~FakePeer() {
+				Stop();
+			}
+
+			void Stop() {
+				{
+					boost::mutex::scoped_lock scopedLock(_lock);
+					if (_stopped) return;
+					_stopped = true;
+					for (size_t i = 0; i < _sockets.size(); ++i)
+						shutdown(_sockets[i], SHUT_RDWR);
+				}
+
+				_threads.join_all();
+				close(_listener);
+			}
+
+			uint16_t Port() const {
+				return _port;
+			}
+
+			size_t Connections() const {
+				return _connections;
+			}
+
+			size_t MessagesSent() const {
+				return _messagesSent;
+			}
+
+			size_t BlocksServed() const {
+				return _blocksServed;
+			}
+
+			size_t FilterLoads() const {
+				return _filterLoads;
+			}
+
+			size_t FilterAdds() const {
+				return _filterAdds;
+			}
+
+			// frame @payload as a message of @type for @magic
+			static bytes_t Frame(uint32_t magic, const std::string &type, const bytes_t &payload) {
+				ByteStream stream;
+
+				stream.WriteUint32(magic);
+				stream.WriteBytes(type.c_str(), type.size());
+				stream.WriteBytes(bytes_t(12 - type.size(), 0));
+				stream.WriteUint32((uint32_t) payload.size());
+				stream.WriteUint32(sha256_2_checksum(payload.data(), payload.size()));
+				stream.WriteBytes(payload);
+
+				return stream.GetBytes();
+			}
+
+			// read one message of @magic from @socket, false once the connection is gone or out of step
+			static bool Read(int socket, uint32_t magic, std::string &type, bytes_t &payload) {
+				uint8_t header[24];
+
+				if (!ReadAll(socket, header, sizeof(header)) || *(uint32_t *) header != magic || header[15] != 0)
+					return false;
+
+				type = (const char *) &header[4];
+				payload.resize(*(uint32_t *) &header[16]);
+				return payload.empty() || ReadAll(socket, &payload[0], payload.size());
+			}
+
+			static bool Write(int socket, const bytes_t &data) {
+				size_t sent = 0;
+
+				while (sent < data.size()) {
+					ssize_t n = send(socket, &data[sent], data.size() - sent, MSG_NOSIGNAL);
+					if (n <= 0) return false;
+					sent += n;
+				}
+
+				return true;
+			}
+
+		private:
+			static bool ReadAll(int socket, uint8_t *buf, size_t size) {
+				size_t got = 0;
+
+				while (got < size) {
+					ssize_t n = recv(socket, buf + got, size - got, 0);
+					if (n <= 0) return false;
+					got += n;
+				}
+
+				return true;
+			}
+
+			void AcceptLoop() {
+				for (;;) {
+					struct pollfd fd = {_listener, POLLIN, 0};
+
+					if (poll(&fd, 1, 50) > 0) {
+						int socket = accept(_listener, nullptr, nullptr);
+						if (socket < 0) continue;
+
+						boost::mutex::scoped_lock scopedLock(_lock);
+						if (_stopped) {
+							close(socket);
+							return;
+						}
+
+						_sockets.push_back(socket);
+						_connections++;
+						_threads.create_thread(boost::bind(&FakePeer::Serve, this, socket));
+					}
+
+					boost::mutex::scoped_lock scopedLock(_lock);
+					if (_stopped) return;
+				}
+			}
+
+			void Serve(int socket) {
+				std::string type;
+				bytes_t payload;
+
+				while (Read(socket, _magic, type, payload) && Handle(socket, type, ByteStream(payload)));
+
+				shutdown(socket, SHUT_RDWR);
+			}
+
+			bool Send(int socket, const std::string &type, const bytes_t &payload) {
+				_messagesSent++;
+				return Write(socket, Frame(_magic, type, payload));
+			}
+
+			bool SendTx(int socket, const TransactionPtr &tx) {
+				ByteStream stream;
+				tx->Serialize(stream);
+				return Send(socket, MSG_TX, stream.GetBytes());
+			}
+
+			bool Handle(int socket, const std::string &type, const ByteStream &stream) {
+				if (type == MSG_VERSION) {
+					ByteStream version;
+					version.WriteUint32(FAKE_PEER_VERSION);
+					version.WriteUint64(SERVICES_NODE_NETWORK);
+					version.WriteUint32((uint32_t) time(nullptr));
+					version.WriteUint16(_port);
+					version.WriteUint64(((uint64_t) _port << 32) | _connections);
+					version.WriteUint64(_chain.Height());
+					version.WriteUint8(1);
+					return Send(socket, MSG_VERSION, version.GetBytes()) && Send(socket, MSG_VERACK, bytes_t());
+				} else if (type == MSG_PING) {
+					return Send(socket, MSG_PONG, stream.GetBytes());
+				} else if (type == MSG_GETBLOCKS) {
+					return HandleGetBlocks(socket, stream);
+				} else if (type == MSG_GETDATA) {
+					return HandleGetData(socket, stream);
+				} else if (type == MSG_MEMPOOL) {
+					return SendInv(socket, inv_tx, _chain.Mempool());
+				} else if (type == MSG_FILTERLOAD) {
+					_filterLoads++;
+				} else if (type == MSG_FILTERADD) {
+					_filterAdds++;
+				}
+
+				return true; // verack, filterload, filteradd, getaddr, inv, pong
+			}
+
+			bool HandleGetBlocks(int socket, const ByteStream &stream) {
+				uint32_t count;
+				uint256 hash;
+				int start = -1;
+
+				if (!stream.ReadUint32(count)) return false;
+				for (uint32_t i = 0; i < count; ++i) {
+					if (!stream.ReadBytes(hash)) return false;
+					if (start < 0) start = _chain.Find(hash);
+				}
+
+				if (start < 0) return true; // nothing in common with the caller
+
+				ByteStream inv;
+				size_t last = std::min((size_t) _chain.Height(), (size_t) start + FAKE_PEER_MAX_INV);
+				inv.WriteUint32((uint32_t) (last - start));
+				for (size_t height = start + 1; height <= last; ++height) {
+					inv.WriteUint32(inv_block);
+					inv.WriteBytes(_chain.Blocks()[height]->GetHash());
+				}
+
+				return last == (size_t) start || Send(socket, MSG_INV, inv.GetBytes());
+			}
+
+			bool HandleGetData(int socket, const ByteStream &stream) {
+				uint32_t count, type;
+				uint256 hash;
+				ByteStream notfound;
+				uint32_t missing = 0;
+
+				if (!stream.ReadUint32(count)) return false;
+				for (uint32_t i = 0; i < count; ++i) {
+					if (!stream.ReadUint32(type) || !stream.ReadBytes(hash)) return false;
+
+					if (type == inv_tx) {
+						TransactionPtr tx = _chain.FindTx(hash);
+						if (tx) {
+							if (!SendTx(socket, tx)) return false;
+							continue;
+						}
+					} else if (type == inv_filtered_block || type == inv_filtered_sidechain_block) {
+						int height = _chain.Find(hash);
+						if (height >= 0) {
+							ByteStream block;
+							_chain.Blocks()[height]->Serialize(block, MERKLEBLOCK_VERSION_1);
+							if (!Send(socket, MSG_MERKLEBLOCK, block.GetBytes())) return false;
+
+							const std::vector<TransactionPtr> &txs = _chain.BlockTxs(height);
+							for (size_t j = 0; j < txs.size(); ++j)
+								if (!SendTx(socket, txs[j])) return false;
+
+							_blocksServed++;
+							continue;
+						}
+					}
+
+					notfound.WriteUint32(type);
+					notfound.WriteBytes(hash);
+					missing++;
+				}
+
+				if (missing == 0) return true;
+
+				ByteStream msg;
+				msg.WriteUint32(missing);
+				msg.WriteBytes(notfound.GetBytes());
+				return Send(socket, MSG_NOTFOUND, msg.GetBytes());
+			}
+
+			bool SendInv(int socket, uint32_t type, const std::vector<TransactionPtr> &txs) {
+				if (txs.empty()) return true;
+
+				ByteStream inv;
+				inv.WriteUint32((uint32_t) txs.size());
+				for (size_t i = 0; i < txs.size(); ++i) {
+					inv.WriteUint32(type);
+					inv.WriteBytes(txs[i]->GetHash());
+				}
+
+				return Send(socket, MSG_INV, inv.GetBytes());
+			}
+
+		private:
+			const FakeChain &_chain;
+			uint32_t _magic;
+			int _listener;
+			uint16_t _port;
+
+			boost::mutex _lock;
+			bool _stopped;
+			std::vector<int> _sockets;
+			boost::thread_group _threads;
+
+			std::atomic<size_t> _connections, _messagesSent, _blocksServed, _filterLoads, _filterAdds;
+		};
+
+	}
+}
+
+#endif //__ELASTOS_SDK_FAKEPEER_H__
@@ -0,0 +1,87 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#define CATCH_CONFIG_MAIN
+
+#include <catch.hpp>
+#include "TestHelper.h"
+
+#include <P2P/KnownInventory.h>
+#include <Common/Log.h>
+
+using namespace Elastos::ElaWallet;
+
+static std::vector<uint256> createHashes(size_t count) {
+	std::vector<uint256> hashes;
+	for (size_t i = 0; i < count; ++i)
+		hashes.push_back(getRanduint256());
+	return hashes;
+}
+
+TEST_CASE("KnownInventory test", "[KnownInventory]") {
+	Log::registerMultiLogger();
+	srand(time(nullptr));
+
+	SECTION("add and remove") {
+		KnownInventory known;
+		std::vector<uint256> hashes = createHashes(100);
+
+		for (size_t i = 0; i < hashes.size(); ++i)
+			REQUIRE(known.Add(hashes[i]));
+		REQUIRE(!known.Add(hashes[10]));
+		REQUIRE(known.Size() == 100);
+		REQUIRE(known.Contains(hashes[99]));
+		REQUIRE(!known.Contains(getRanduint256()));
+		REQUIRE(known.Hashes() == hashes);
+
+		REQUIRE(known.Remove(hashes[10]));
+		REQUIRE(!known.Remove(hashes[10]));
+		REQUIRE(!known.Contains(hashes[10]));
+		hashes.erase(hashes.begin() + 10);
+		REQUIRE(known.Hashes() == hashes);
+		REQUIRE(known.MemoryUsage() > 99 * sizeof(uint256));
+
+		known.Clear();
+		REQUIRE(known.Size() == 0);
+		REQUIRE(known.Hashes().empty());
+	}
+
+	SECTION("rolling capacity") {
+		KnownInventory known(50);
+		std::vector<uint256> hashes = createHashes(120);
+
+		for (size_t i = 0; i < hashes.size(); ++i)
+			known.Add(hashes[i]);
+
+		// only the latest hashes are kept, still in the order they were added
+		REQUIRE(known.Size() == 50);
+		REQUIRE(!known.Contains(hashes[69]));
+		REQUIRE(known.Contains(hashes[70]));
+		REQUIRE(known.Hashes() == std::vector<uint256>(hashes.begin() + 70, hashes.end()));
+
+		size_t usage = known.MemoryUsage();
+		known.SetCapacity(20);
+		REQUIRE(known.Capacity() == 20);
+		REQUIRE(known.Hashes() == std::vector<uint256>(hashes.begin() + 100, hashes.end()));
+		REQUIRE(known.MemoryUsage() < usage);
+	}
+
+	SECTION("trim for rerequest") {
+		KnownInventory known;
+		std::vector<uint256> hashes = createHashes(500);
+
+		for (size_t i = 0; i < hashes.size(); ++i)
+			known.Add(hashes[i]);
+
+		REQUIRE(!known.TrimBefore(getRanduint256()));
+		REQUIRE(known.Size() == 500);
+
+		REQUIRE(known.TrimBefore(hashes[300]));
+		REQUIRE(known.Hashes() == std::vector<uint256>(hashes.begin() + 300, hashes.end()));
+		REQUIRE(!known.Contains(hashes[299]));
+
+		REQUIRE(known.TrimBefore(hashes[300]));
+		REQUIRE(known.Size() == 200);
+	}
+}
@@ -0,0 +1,105 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#define CATCH_CONFIG_MAIN
+
+#include <catch.hpp>
+#include "TestHelper.h"
+
+#include <P2P/OrphanPool.h>
+#include <Plugin/Block/MerkleBlock.h>
+#include <Common/Log.h>
+
+using namespace Elastos::ElaWallet;
+
+static MerkleBlockPtr createBlock(const uint256 &prevHash, uint32_t height) {
+	MerkleBlockPtr block(new MerkleBlock());
+	block->SetHash(getRanduint256());
+	block->SetPrevBlockHash(prevHash);
+	block->SetHeight(height);
+	block->SetTimestamp(height * 120);
+	return block;
+}
+
+TEST_CASE("OrphanPool test", "[OrphanPool]") {
+	Log::registerMultiLogger();
+	srand(time(nullptr));
+
+	SECTION("index") {
+		OrphanPool pool;
+		MerkleBlockPtr block1 = createBlock(getRanduint256(), 10);
+		MerkleBlockPtr block2 = createBlock(block1->GetHash(), 11);
+		MerkleBlockPtr fork2 = createBlock(block1->GetHash(), 11);
+
+		pool.Insert(block2);
+		pool.Insert(fork2);
+		REQUIRE(pool.Size() == 2);
+		REQUIRE(pool.Bytes() > 0);
+		REQUIRE(pool.Contains(block2->GetHash()));
+		REQUIRE(!pool.Contains(block1->GetHash()));
+
+		MerkleBlockPtr next = pool.GetMatchPrevHash(block1->GetHash());
+		REQUIRE(next != nullptr);
+		REQUIRE(pool.Remove(next));
+		REQUIRE(!pool.Remove(next));
+
+		next = pool.GetMatchPrevHash(block1->GetHash());
+		REQUIRE(next != nullptr);
+		REQUIRE(pool.Remove(next));
+		REQUIRE(pool.GetMatchPrevHash(block1->GetHash()) == nullptr);
+		REQUIRE(pool.Size() == 0);
+		REQUIRE(pool.Bytes() == 0);
+
+		// inserting the same block again doesn't count it twice
+		pool.Insert(block2);
+		size_t bytes = pool.Bytes();
+		pool.Insert(block2);
+		REQUIRE(pool.Size() == 1);
+		REQUIRE(pool.Bytes() == bytes);
+
+		pool.Clear();
+		REQUIRE(pool.Size() == 0);
+		REQUIRE(pool.GetMatchPrevHash(block1->GetHash()) == nullptr);
+	}
+
+	SECTION("count cap") {
+		OrphanPool pool(3);
+		std::vector<MerkleBlockPtr> blocks;
+		for (uint32_t i = 0; i < 5; ++i) {
+			blocks.push_back(createBlock(getRanduint256(), 100 + i));
+			pool.Insert(blocks.back());
+		}
+
+		// the orphans received first go first
+		REQUIRE(pool.Size() == 3);
+		REQUIRE(pool.Evicted() == 2);
+		REQUIRE(!pool.Contains(blocks[0]->GetHash()));
+		REQUIRE(!pool.Contains(blocks[1]->GetHash()));
+		REQUIRE(pool.Contains(blocks[4]->GetHash()));
+		REQUIRE(pool.GetMatchPrevHash(blocks[0]->GetPrevBlockHash()) == nullptr);
+		REQUIRE(pool.GetMatchPrevHash(blocks[2]->GetPrevBlockHash()) == blocks[2]);
+	}
+
+	SECTION("byte cap") {
+		MerkleBlockPtr block = createBlock(getRanduint256(), 1);
+		OrphanPool probe;
+		probe.Insert(block);
+		size_t blockBytes = probe.Bytes();
+
+		OrphanPool pool(100, blockBytes * 2);
+		for (uint32_t i = 0; i < 4; ++i)
+			pool.Insert(createBlock(getRanduint256(), 1));
+		REQUIRE(pool.Size() == 2);
+		REQUIRE(pool.Bytes() <= blockBytes * 2);
+		REQUIRE(pool.Evicted() == 2);
+
+		// a single block over the cap is still held
+		OrphanPool tiny(100, 1);
+		tiny.Insert(block);
+		REQUIRE(tiny.Size() == 1);
+		tiny.Insert(createBlock(getRanduint256(), 2));
+		REQUIRE(tiny.Size() == 1);
+		REQUIRE(!tiny.Contains(block->GetHash()));
+	}
+}
@@ -0,0 +1,314 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#define CATCH_CONFIG_MAIN
+
+#include <catch.hpp>
+#include "TestHelper.h"
+
+#include <P2P/PeerManager.h>
+#include <P2P/ChainParams.h>
+#include <Account/Account.h>
+#include <Account/SubAccount.h>
+#include <Database/DatabaseManager.h>
+#include <Plugin/Registry.h>
+#include <Plugin/ELAPlugin.h>
+#include <Plugin/Transaction/Attribute.h>
+#include <Plugin/Transaction/Transaction.h>
+#include <Plugin/Transaction/TransactionInput.h>
+#include <Plugin/Transaction/TransactionOutput.h>
+#include <Wallet/Wallet.h>
+#include <Common/Log.h>
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+
+using namespace Elastos::ElaWallet;
+
+class NullListener : public PeerManager::Listener {
+public:
+	virtual void syncStarted() {}
+
+	virtual void syncProgress(uint32_t progress, time_t lastBlockTime, uint32_t bytesPerSecond,
+							  const std::string &downloadPeer) {}
+
+	virtual void syncStopped(const std::string &error) {}
+
+	virtual void txStatusUpdate() {}
+
+	virtual void saveBlocks(bool replace, const std::vector<MerkleBlockPtr> &blocks) {}
+
+	virtual void savePeers(bool replace, const std::vector<PeerInfo> &peers) {}
+
+	virtual void saveBlackPeer(const PeerInfo &peer) {}
+
+	virtual void savePeerScores(const std::vector<PeerScore> &scores) {}
+
+	virtual void saveSeedPeers(const std::string &seed, const std::vector<PeerInfo> &peers) {}
+
+	virtual bool networkIsReachable() { return true; }
+
+	virtual void txPublished(const std::string &hash, const nlohmann::json &result) {}
+
+	virtual void connectStatusChanged(const std::string &status) {}
+};
+
+class NullWalletListener : public Wallet::Listener {
+public:
+	virtual void onBalanceChanged(const uint256 &asset, const BigInt &balance) {}
+
+	virtual void onTxAdded(const TransactionPtr &tx) {}
+
+	virtual void onTxUpdated(const std::vector<TransactionPtr> &txns) {}
+
+	virtual void onTxDeleted(const TransactionPtr &tx, bool notifyUser, bool recommendRescan) {}
+
+	virtual void onAssetRegistered(const AssetPtr &asset, uint64_t amount, const uint168 &controller) {}
+};
+
+// a relay map small enough for a test to fill
+class RelayPeerManager : public PeerManager {
+public:
+	RelayPeerManager(const ChainParamsPtr &params, const WalletPtr &wallet,
+					 const boost::shared_ptr<Listener> &listener, size_t maxRelays) :
+		PeerManager(params, wallet, 0, 0, {}, {}, {}, {}, {}, listener, "ELA", "TestNet") {
+		_txRelays = TransactionPeerMap(maxRelays);
+	}
+
+	// relays of tx the wallet doesn't know
+	void RelayOther(const PeerInfo &peer, size_t count) {
+		for (size_t i = 0; i < count; ++i)
+			_txRelays.AddPeer(getRanduint256(), peer, time(NULL));
+	}
+
+	uint64_t GetEvictedRelays() const {
+		return _txRelays.Evicted();
+	}
+
+	using PeerManager::RemoveUnrelayedTx;
+};
+
+static std::vector<MerkleBlockPtr> createChain(size_t count, const uint256 &prevBlock, uint32_t startHeight) {
+	std::vector<MerkleBlockPtr> chain;
+	uint256 prevHash = prevBlock;
+
+	for (size_t i = 0; i < count; ++i) {
+		MerkleBlockPtr block(new MerkleBlock());
+		block->SetHash(getRanduint256());
+		block->SetPrevBlockHash(prevHash);
+		block->SetHeight(startHeight + (uint32_t) i);
+		block->SetTimestamp((startHeight + (uint32_t) i) * 120);
+		prevHash = block->GetHash();
+		chain.push_back(block);
+	}
+
+	return chain;
+}
+
+TEST_CASE("PeerManager stored chain load", "[PeerManager]") {
+	Log::registerMultiLogger();
+	REGISTER_MERKLEBLOCKPLUGIN(ELA, getELAPluginComponent);
+
+	uint256 genesis = getRanduint256();
+	std::vector<CheckPoint> checkpoints;
+	checkpoints.push_back(CheckPoint(0, genesis.GetHex(), 0, 0x1d03ffff));
+	ChainParamsPtr params(new ChainParams(20866, 0, {}, checkpoints));
+	boost::shared_ptr<PeerManager::Listener> listener(new NullListener());
+
+	// main chain #1 - #30, a fork from #20 that is longer, and a shorter one from #10
+	std::vector<MerkleBlockPtr> main = createChain(30, genesis, 1);
+	std::vector<MerkleBlockPtr> longFork = createChain(15, main[19]->GetHash(), 21);
+	std::vector<MerkleBlockPtr> shortFork = createChain(3, main[9]->GetHash(), 11);
+
+	std::vector<MerkleBlockPtr> stored;
+	stored.insert(stored.end(), main.begin(), main.end());
+	stored.insert(stored.end(), longFork.begin(), longFork.end());
+	stored.insert(stored.end(), shortFork.begin(), shortFork.end());
+	// stored blocks come back in no particular order
+	std::random_shuffle(stored.begin(), stored.end());
+
+	SECTION("every branch is indexed and the highest tip is the last block") {
+		PeerManager manager(params, nullptr, 0, 0, stored, {}, {}, {}, {}, listener, "ELA", "TestNet");
+
+		REQUIRE(manager.GetBlockCount() == 1 + stored.size());
+		REQUIRE(manager.GetLastBlockHeight() == longFork.back()->GetHeight());
+		REQUIRE(manager.GetOrphanCount() == 0);
+	}
+
+	SECTION("blocks that don't link to the chain are left out") {
+		std::vector<MerkleBlockPtr> unlinked = createChain(5, getRanduint256(), 100);
+		stored.insert(stored.end(), unlinked.begin(), unlinked.end());
+
+		PeerManager manager(params, nullptr, 0, 0, stored, {}, {}, {}, {}, listener, "ELA", "TestNet");
+
+		REQUIRE(manager.GetBlockCount() == 1 + stored.size() - unlinked.size());
+		REQUIRE(manager.GetLastBlockHeight() == longFork.back()->GetHeight());
+	}
+}
+
+TEST_CASE("PeerManager difficulty retarget", "[PeerManager]") {
+	const uint32_t targetTimeSpan = 86400;
+
+	// an interval on schedule keeps the target
+	REQUIRE(PeerManager::RetargetCompact(0x1d03ffff, targetTimeSpan, targetTimeSpan) == 0x1d03ffff);
+	REQUIRE(PeerManager::RetargetCompact(0x1f7fffff, targetTimeSpan, targetTimeSpan) == 0x1f7fffff);
+
+	// twice as fast halves the target, twice as slow doubles it
+	REQUIRE(PeerManager::RetargetCompact(0x1d03ffff, targetTimeSpan / 2, targetTimeSpan) == 0x1d01ffff);
+	REQUIRE(PeerManager::RetargetCompact(0x1d03ffff, targetTimeSpan * 2, targetTimeSpan) == 0x1d07fffe);
+
+	// the change is limited to -75% or +400%
+	REQUIRE(PeerManager::RetargetCompact(0x1d03ffff, 0, targetTimeSpan) == 0x1d00ffff);
+	REQUIRE(PeerManager::RetargetCompact(0x1d03ffff, targetTimeSpan * 10, targetTimeSpan) == 0x1d0ffffc);
+
+	// timespans that don't divide evenly truncate like the full width target does
+	REQUIRE(PeerManager::RetargetCompact(0x1b0404cb, 86000, targetTimeSpan) == 0x1b040007);
+	REQUIRE(PeerManager::RetargetCompact(0x18012345, 86399, targetTimeSpan) == 0x18012344);
+	REQUIRE(PeerManager::RetargetCompact(0x1a7fffff, 90000, targetTimeSpan) == 0x1b008555);
+
+	// timestamps aren't ordered, an interval that took negative time is the fastest one
+	REQUIRE(PeerManager::RetargetCompact(0x1d03ffff, -5000, targetTimeSpan) == 0x1d00ffff);
+}
+
+// VerifyDifficulty against the blocks a manager was loaded with
+class DifficultyPeerManager : public PeerManager {
+public:
+	DifficultyPeerManager(const ChainParamsPtr &params, const std::vector<MerkleBlockPtr> &blocks,
+						  const boost::shared_ptr<Listener> &listener) :
+		PeerManager(params, nullptr, 0, 0, blocks, {}, {}, {}, {}, listener, "ELA", "MainNet") {
+	}
+
+	using PeerManager::VerifyDifficulty;
+};
+
+static MerkleBlockPtr createBlock(const MerkleBlockPtr &prev, uint32_t timestamp, uint32_t target) {
+	MerkleBlockPtr block(new MerkleBlock());
+	block->SetHash(getRanduint256());
+	block->SetPrevBlockHash(prev->GetHash());
+	block->SetHeight(prev->GetHeight() + 1);
+	block->SetTimestamp(timestamp);
+	block->SetTarget(target);
+	return block;
+}
+
+TEST_CASE("PeerManager difficulty of the MainNet launch", "[PeerManager]") {
+	Log::registerMultiLogger();
+	REGISTER_MERKLEBLOCKPLUGIN(ELA, getELAPluginComponent);
+
+	// the MainNet checkpoints at #0 and #2016: ELA mines block #1 at its pow limit bits 0x1f0008ff, with launch
+	// blocks every 30 seconds both retargets before #2016 are held to -75%, which lands exactly on the bits of
+	// checkpoint #2016
+	const CheckPoint genesis(0, "05f458a5522851622cae2bb138498dec60a8f0b233802c97a1ca41f9f214708d", 1513936800,
+							 486801407);
+	const uint32_t checkpoint2016Bits = 503353328, checkpoint2016Time = 1513999567;
+	std::vector<CheckPoint> checkpoints;
+	checkpoints.push_back(genesis);
+	ChainParamsPtr params(new ChainParams(20866, 0, {}, checkpoints));
+	boost::shared_ptr<PeerManager::Listener> listener(new NullListener());
+
+	const uint32_t blockTime = 30;
+	MerkleBlockPtr prev(new MerkleBlock());
+	prev->SetHash(genesis.Hash());
+	prev->SetTimestamp(genesis.Timestamp());
+	prev->SetTarget(genesis.Target());
+
+	std::vector<MerkleBlockPtr> chain; // #1 - #2015
+	uint32_t target = 0x1f0008ff;
+	for (uint32_t height = 1; height < 2016; ++height) {
+		if (height == 720) target = 0x1e023fc0;
+		if (height == 1440) target = 0x1e008ff0;
+		prev = createBlock(prev, genesis.Timestamp() + height * blockTime, target);
+		chain.push_back(prev);
+	}
+	REQUIRE(target == checkpoint2016Bits);
+
+	DifficultyPeerManager manager(params, chain, listener);
+	REQUIRE(manager.GetLastBlockHeight() == 2015);
+
+	SECTION("every block of the launch is accepted, across both retargets") {
+		for (size_t i = 1; i < chain.size(); ++i)
+			REQUIRE(manager.VerifyDifficulty(chain[i], chain[i - 1]));
+
+		MerkleBlockPtr checkpoint = createBlock(chain.back(), checkpoint2016Time, checkpoint2016Bits);
+		REQUIRE(manager.VerifyDifficulty(checkpoint, chain.back()));
+	}
+
+	SECTION("bits change only at a retarget, and only by the previous interval's timespan") {
+		MerkleBlockPtr block = createBlock(chain.back(), checkpoint2016Time, 0x1e008ff1);
+		REQUIRE(!manager.VerifyDifficulty(block, chain.back()));
+
+		// #1440 keeping the bits of #720, or retargeting as if on schedule
+		MerkleBlockPtr transition = createBlock(chain[1438], chain[1439]->GetTimestamp(), 0x1e023fc0);
+		REQUIRE(!manager.VerifyDifficulty(transition, chain[1438]));
+		transition->SetTarget(PeerManager::RetargetCompact(0x1e023fc0, 2 * 86400, 86400));
+		REQUIRE(!manager.VerifyDifficulty(transition, chain[1438]));
+		transition->SetTarget(0x1e008ff0);
+		REQUIRE(manager.VerifyDifficulty(transition, chain[1438]));
+	}
+}
+
+TEST_CASE("PeerManager unrelayed tx", "[PeerManager]") {
+	Log::registerMultiLogger();
+	REGISTER_MERKLEBLOCKPLUGIN(ELA, getELAPluginComponent);
+
+	const std::string rootPath = "./PeerManagerTest/";
+	boost::filesystem::remove_all(rootPath);
+	boost::filesystem::create_directories(rootPath);
+
+	{
+		std::vector<CheckPoint> checkpoints;
+		checkpoints.push_back(CheckPoint(0, getRanduint256().GetHex(), 0, 0x1d03ffff));
+		ChainParamsPtr params(new ChainParams(20866, 0, {}, checkpoints));
+		boost::shared_ptr<PeerManager::Listener> listener(new NullListener());
+
+		AccountPtr account(new Account(rootPath + "account", "abandon abandon abandon abandon abandon abandon "
+										"abandon abandon abandon abandon abandon about", "", "payPassword", false));
+		SubAccountPtr subAccount(new SubAccount(account, 0));
+		subAccount->Init();
+		DatabaseManagerPtr database(new DatabaseManager(rootPath + "wallet.db"));
+		boost::shared_ptr<Wallet::Listener> walletListener(new NullWalletListener());
+		WalletPtr wallet(new Wallet(0, "PeerManagerTest", CHAINID_MAINCHAIN, subAccount, walletListener, database));
+
+		AddressArray addrs;
+		wallet->GetAllAddresses(addrs, 0, 1, false);
+		TransactionPtr tx(new Transaction());
+		InputPtr input(new TransactionInput());
+		input->SetTxHash(getRanduint256());
+		input->SetIndex(0);
+		input->SetSequence(0xffffffff);
+		tx->AddInput(input);
+		tx->AddOutput(OutputPtr(new TransactionOutput(BigInt(100000000), *addrs[0])));
+		tx->AddAttribute(AttributePtr(new Attribute(Attribute::Nonce, getRandBytes(8))));
+		tx->SetBlockHeight(TX_UNCONFIRMED);
+		REQUIRE(wallet->RegisterTransaction(tx));
+
+		RelayPeerManager manager(params, wallet, listener, 3);
+		PeerInfo relayedBy(uint128(), 20866, 0), other(uint128(), 20867, 0);
+		PeerPtr peer(new Peer(&manager, params->MagicNumber()));
+		peer->SetPeerInfo(relayedBy);
+
+		SECTION("a wallet tx whose relays are pushed out of the relay map is kept") {
+			manager.OnHasTx(peer, tx->GetHash());
+			manager.FlushWalletApply();
+			REQUIRE(manager.GetRelayCount(tx->GetHash()) == 1);
+
+			manager.RelayOther(other, 10);
+			REQUIRE(manager.GetEvictedRelays() > 0);
+			REQUIRE(manager.GetRelayCount(tx->GetHash()) == 1);
+
+			manager.RemoveUnrelayedTx(peer);
+			REQUIRE(wallet->TransactionForHash(tx->GetHash()) != nullptr);
+		}
+
+		SECTION("a wallet tx no peer relays is removed") {
+			manager.RemoveUnrelayedTx(peer);
+			REQUIRE(wallet->TransactionForHash(tx->GetHash()) == nullptr);
+		}
+
+		manager.StopWalletApply();
+	}
+
+	boost::filesystem::remove_all(rootPath);
+}
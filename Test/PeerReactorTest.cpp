@@ -0,0 +1,138 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#define CATCH_CONFIG_MAIN
+
+#include <catch.hpp>
+
+#include <P2P/PeerReactor.h>
+#include <Common/Log.h>
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <atomic>
+#include <stdexcept>
+
+using namespace Elastos::ElaWallet;
+
+static void count(std::atomic<int> *counter) {
+	(*counter)++;
+}
+
+static void countSlowly(std::atomic<int> *counter) {
+	boost::this_thread::sleep_for(boost::chrono::milliseconds(100));
+	(*counter)++;
+}
+
+// signalled once a task has started running
+class Latch {
+public:
+	Latch() : _open(false) {}
+
+	void Open() {
+		boost::mutex::scoped_lock scopedLock(_lock);
+		_open = true;
+		_cond.notify_all();
+	}
+
+	void Wait() {
+		boost::mutex::scoped_lock scopedLock(_lock);
+		while (!_open)
+			_cond.wait(scopedLock);
+	}
+
+private:
+	boost::mutex _lock;
+	boost::condition_variable _cond;
+	bool _open;
+};
+
+static void countSlowlyStarted(Latch *started, std::atomic<int> *counter) {
+	started->Open();
+	countSlowly(counter);
+}
+
+static void throwStarted(Latch *started) {
+	started->Open();
+	boost::this_thread::sleep_for(boost::chrono::milliseconds(50));
+	throw std::runtime_error("scheduled task failed");
+}
+
+static void waitFor(const std::atomic<int> &counter, int value) {
+	for (int i = 0; i < 200 && counter < value; ++i)
+		boost::this_thread::sleep_for(boost::chrono::milliseconds(10));
+}
+
+TEST_CASE("PeerReactor test", "[PeerReactor]") {
+	Log::registerMultiLogger();
+	PeerReactor *reactor = PeerReactor::Instance();
+
+	SECTION("schedule") {
+		std::atomic<int> counter(0);
+
+		reactor->Schedule(0, boost::bind(&count, &counter));
+		reactor->Schedule(0.05, boost::bind(&count, &counter));
+		waitFor(counter, 2);
+		REQUIRE(counter == 2);
+		REQUIRE(reactor->PendingTasks() == 0);
+	}
+
+	SECTION("cancel") {
+		std::atomic<int> counter(0);
+
+		PeerReactor::TimerID id = reactor->Schedule(0.2, boost::bind(&count, &counter));
+		reactor->Schedule(0.1, boost::bind(&count, &counter));
+		REQUIRE(reactor->PendingTasks() == 2);
+		REQUIRE(reactor->PendingTimers() >= 2);
+
+		REQUIRE(reactor->Cancel(id));
+		REQUIRE(!reactor->Cancel(id));
+		REQUIRE(reactor->PendingTasks() == 1);
+
+		waitFor(counter, 1);
+		boost::this_thread::sleep_for(boost::chrono::milliseconds(300));
+		REQUIRE(counter == 1);
+		REQUIRE(reactor->PendingTasks() == 0);
+	}
+
+	SECTION("wait for a running task") {
+		std::atomic<int> counter(0);
+
+		Latch started;
+
+		PeerReactor::TimerID id = reactor->Schedule(0, boost::bind(&countSlowlyStarted, &started, &counter));
+		started.Wait();
+
+		// too late to cancel, but it's done once the wait returns
+		REQUIRE(!reactor->Cancel(id));
+		reactor->WaitForRunningTask();
+		REQUIRE(counter == 1);
+	}
+
+	SECTION("a throwing task") {
+		std::atomic<int> counter(0);
+
+		Latch started;
+
+		reactor->Schedule(0, boost::bind(&throwStarted, &started));
+		started.Wait();
+
+		// the wait returns once the task threw, and the timer thread keeps running the later ones
+		reactor->WaitForRunningTask();
+		reactor->Schedule(0, boost::bind(&count, &counter));
+		waitFor(counter, 1);
+		REQUIRE(counter == 1);
+	}
+
+	SECTION("many timers on one thread") {
+		std::atomic<int> counter(0);
+
+		for (int i = 0; i < 1000; ++i)
+			reactor->Schedule((i % 10) * 0.01, boost::bind(&count, &counter));
+		waitFor(counter, 1000);
+		REQUIRE(counter == 1000);
+		REQUIRE(reactor->PendingTasks() == 0);
+	}
+}
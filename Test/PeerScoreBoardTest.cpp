@@ -0,0 +1,118 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#define CATCH_CONFIG_MAIN
+
+#include <catch.hpp>
+#include "TestHelper.h"
+
+#include <P2P/PeerScoreBoard.h>
+#include <Common/Log.h>
+
+using namespace Elastos::ElaWallet;
+
+TEST_CASE("PeerScoreBoard test", "[PeerScoreBoard]") {
+	Log::registerMultiLogger();
+
+	PeerInfo peer1(uint128(), 20866, 0), peer2(uint128(), 20867, 0), peer3(uint128(), 20868, 0);
+
+	SECTION("rank") {
+		PeerScoreBoard board;
+
+		// a peer never seen ranks the same as any other unknown peer
+		REQUIRE(board.Rank(peer1) == board.Rank(peer2));
+		REQUIRE(board.Size() == 0);
+
+		board.Connected(peer1, 0.05, 100);
+		board.Connected(peer2, 0.8, 100);
+		REQUIRE(board.Rank(peer1) > board.Rank(peer3));
+		REQUIRE(board.Rank(peer3) > board.Rank(peer2));
+
+		// measured throughput outweighs latency
+		board.Throughput(peer2, 4 * PEER_SCORE_DEFAULT_BPS);
+		REQUIRE(board.Rank(peer2) > board.Rank(peer1));
+		REQUIRE(board.BestThroughput() == 4 * PEER_SCORE_DEFAULT_BPS);
+
+		double rank = board.Rank(peer2);
+		board.Disconnected(peer2, false);
+		REQUIRE(board.Rank(peer2) == rank);
+		board.Disconnected(peer2, true);
+		REQUIRE(board.Rank(peer2) < rank);
+
+		rank = board.Rank(peer1);
+		board.Misbehaved(peer1);
+		REQUIRE(board.Get(peer1).Misbehaving == 1);
+		REQUIRE(board.Rank(peer1) < rank);
+	}
+
+	SECTION("moving averages") {
+		PeerScoreBoard board;
+
+		board.Connected(peer1, 0.1, 100);
+		REQUIRE(board.Get(peer1).PingTime == Approx(0.1));
+		board.Connected(peer1, 0.2, 200);
+		REQUIRE(board.Get(peer1).PingTime == Approx(0.1 * (1 - PEER_SCORE_WEIGHT) + 0.2 * PEER_SCORE_WEIGHT));
+		REQUIRE(board.Get(peer1).Connects == 2);
+		REQUIRE(board.Get(peer1).LastSeen == 200);
+
+		// an unmeasured ping doesn't pull the average down
+		board.Connected(peer1, 0, 300);
+		REQUIRE(board.Get(peer1).PingTime > 0.1);
+
+		board.Throughput(peer1, 1000);
+		board.Throughput(peer1, 2000);
+		REQUIRE(board.Get(peer1).BytesPerSecond == Approx(1000 * (1 - PEER_SCORE_WEIGHT) + 2000 * PEER_SCORE_WEIGHT));
+	}
+
+	SECTION("changed and load") {
+		PeerScoreBoard board;
+
+		board.Connected(peer1, 0.1, 100);
+		board.Throughput(peer1, 1000);
+		board.Connected(peer2, 0.1, 100);
+		board.Disconnected(peer3, false);
+
+		std::vector<PeerScore> changed = board.TakeChanged();
+		REQUIRE(changed.size() == 2);
+		REQUIRE(board.TakeChanged().empty());
+
+		board.Misbehaved(peer2);
+		changed = board.TakeChanged();
+		REQUIRE(changed.size() == 1);
+		REQUIRE(changed[0].Info == peer2);
+		REQUIRE(changed[0].Misbehaving == 1);
+
+		// scores not seen for too long are dropped on load
+		PeerScore old(peer3);
+		old.LastSeen = 100;
+		changed.push_back(old);
+
+		PeerScoreBoard loaded;
+		loaded.Load(changed, 100 + PEER_SCORE_MAX_AGE + 1);
+		REQUIRE(loaded.Size() == 0);
+		loaded.Load(changed, 100 + PEER_SCORE_MAX_AGE);
+		REQUIRE(loaded.Size() == 2);
+		REQUIRE(loaded.Get(peer2).Misbehaving == 1);
+		REQUIRE(loaded.TakeChanged().empty());
+
+		// throughput saved by an earlier session is no yardstick for the peers of this one
+		REQUIRE(loaded.Get(peer1).BytesPerSecond == Approx(1000));
+		REQUIRE(loaded.BestThroughput() == 0);
+		loaded.Throughput(peer2, 10);
+		REQUIRE(loaded.BestThroughput() == Approx(10));
+
+		loaded.Clear();
+		REQUIRE(loaded.Size() == 0);
+	}
+
+	SECTION("capacity") {
+		PeerScoreBoard board;
+
+		for (uint16_t i = 0; i <= PEER_SCORE_MAX_PEERS; ++i)
+			board.Connected(PeerInfo(uint128(), (uint16_t) (1000 + i), 0), 0.1, 100 + i);
+		REQUIRE(board.Size() == PEER_SCORE_MAX_PEERS);
+		REQUIRE(board.Get(PeerInfo(uint128(), 1000, 0)).Connects == 0);
+		REQUIRE(board.Get(PeerInfo(uint128(), 1001, 0)).Connects == 1);
+	}
+}
@@ -0,0 +1,230 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#define CATCH_CONFIG_MAIN
+
+#include <catch.hpp>
+#include "TestHelper.h"
+
+#include <P2P/Peer.h>
+#include <P2P/ReceiveBuffer.h>
+#include <P2P/Message/Message.h>
+#include <Common/ByteStream.h>
+#include <Common/hash.h>
+#include <Common/Log.h>
+
+#include <chrono>
+
+using namespace Elastos::ElaWallet;
+
+#define TEST_MAGIC 2017001
+
+static bytes_t frameMessage(const std::string &type, const bytes_t &payload) {
+	ByteStream stream;
+
+	stream.WriteUint32(TEST_MAGIC);
+	stream.WriteBytes(type.c_str(), type.size());
+	stream.WriteBytes(bytes_t(12 - type.size(), 0));
+	stream.WriteUint32(payload.size());
+	stream.WriteUint32(sha256_2_checksum(payload.data(), payload.size()));
+	stream.WriteBytes(payload);
+
+	return stream.GetBytes();
+}
+
+static bool deserializePayload(const std::string &type, const ByteStream &stream) {
+	if (type == MSG_MERKLEBLOCK) {
+		MerkleBlock block;
+		return block.Deserialize(stream, MERKLEBLOCK_VERSION_0);
+	}
+
+	Transaction tx;
+	return tx.Deserialize(stream);
+}
+
+// how Peer read and parsed messages before: header into a stack array, payload into its own vector,
+// a temporary vector for the checksum and another copy for the ByteStream
+static size_t replayCopying(const bytes_t &capture, size_t readSize) {
+	size_t messages = 0, pos = 0;
+
+	while (pos + HEADER_LENGTH <= capture.size()) {
+		uint8_t header[HEADER_LENGTH];
+		memcpy(header, &capture[pos], HEADER_LENGTH);
+		pos += HEADER_LENGTH;
+
+		std::string type = (const char *) &header[4];
+		uint32_t msgLen = *(uint32_t *) &header[16];
+		bytes_t payload;
+		payload.resize(msgLen);
+		for (size_t len = 0; len < msgLen; ) {
+			size_t n = std::min(readSize, msgLen - len);
+			memcpy(&payload[len], &capture[pos + len], n);
+			len += n;
+		}
+		pos += msgLen;
+
+		bytes_t hash = sha256_2(payload);
+		if (*(uint32_t *) &hash[0] != *(uint32_t *) &header[20])
+			break;
+
+		ByteStream stream(payload);
+		if (deserializePayload(type, stream))
+			messages++;
+	}
+
+	return messages;
+}
+
+// how Peer reads now: batched reads into the receive buffer, messages parsed in place
+static size_t replayInPlace(const bytes_t &capture, size_t readSize) {
+	ReceiveBuffer buffer;
+	size_t messages = 0, pos = 0, wanted = HEADER_LENGTH;
+
+	while (pos < capture.size()) {
+		uint8_t *buf = buffer.Prepare(wanted);
+		size_t n = std::min(std::min(readSize, buffer.Writable()), capture.size() - pos);
+		memcpy(buf, &capture[pos], n);
+		buffer.Commit(n);
+		pos += n;
+
+		while (buffer.Size() >= HEADER_LENGTH) {
+			const uint8_t *header = buffer.Data();
+			uint32_t msgLen = *(uint32_t *) &header[16];
+			if (buffer.Size() < HEADER_LENGTH + msgLen) {
+				wanted = HEADER_LENGTH + msgLen;
+				break;
+			}
+
+			if (sha256_2_checksum(header + HEADER_LENGTH, msgLen) != *(uint32_t *) &header[20])
+				return messages;
+
+			ByteStream stream = ByteStream::View(header + HEADER_LENGTH, msgLen);
+			if (deserializePayload((const char *) &header[4], stream))
+				messages++;
+			buffer.Consume(HEADER_LENGTH + msgLen);
+			wanted = HEADER_LENGTH;
+		}
+	}
+
+	return messages;
+}
+
+TEST_CASE("ReceiveBuffer test", "[ReceiveBuffer]") {
+	Log::registerMultiLogger();
+	srand(time(nullptr));
+
+	ReceiveBuffer buffer(1024);
+
+	SECTION("read and consume") {
+		bytes_t data = getRandBytes(700);
+
+		uint8_t *buf = buffer.Prepare(HEADER_LENGTH);
+		REQUIRE(buffer.Writable() == 1024);
+		memcpy(buf, data.data(), data.size());
+		buffer.Commit(data.size());
+		REQUIRE(buffer.Size() == data.size());
+		REQUIRE(memcmp(buffer.Data(), data.data(), data.size()) == 0);
+
+		buffer.Consume(500);
+		REQUIRE(buffer.Size() == 200);
+		REQUIRE(memcmp(buffer.Data(), &data[500], 200) == 0);
+
+		// not enough room behind the unread bytes, they move to the front
+		buf = buffer.Prepare(600);
+		REQUIRE(buffer.Writable() == 1024 - 200);
+		REQUIRE(memcmp(buffer.Data(), &data[500], 200) == 0);
+		memcpy(buf, data.data(), 400);
+		buffer.Commit(400);
+		REQUIRE(buffer.Size() == 600);
+		REQUIRE(memcmp(buffer.Data() + 200, data.data(), 400) == 0);
+
+		buffer.Consume(600);
+		REQUIRE(buffer.Size() == 0);
+	}
+
+	SECTION("big message") {
+		bytes_t data = getRandBytes(5000);
+
+		size_t len = 0;
+		while (len < data.size()) {
+			uint8_t *buf = buffer.Prepare(data.size());
+			size_t n = std::min(buffer.Writable(), data.size() - len);
+			memcpy(buf, &data[len], n);
+			buffer.Commit(n);
+			len += n;
+		}
+		REQUIRE(buffer.Capacity() >= data.size());
+		REQUIRE(buffer.Size() == data.size());
+		REQUIRE(memcmp(buffer.Data(), data.data(), data.size()) == 0);
+
+		buffer.Consume(data.size());
+		buffer.Prepare(HEADER_LENGTH);
+		REQUIRE(buffer.Capacity() == 1024);
+	}
+
+	SECTION("byte stream view") {
+		bytes_t data = getRandBytes(100);
+		ByteStream stream = ByteStream::View(data.data(), data.size());
+		REQUIRE(stream.size() == data.size());
+
+		uint32_t u32;
+		bytes_t bytes;
+		REQUIRE(stream.ReadUint32(u32));
+		REQUIRE(u32 == *(uint32_t *) data.data());
+		REQUIRE(stream.ReadBytes(bytes, 96));
+		REQUIRE(bytes == bytes_t(&data[4], 96));
+		REQUIRE(!stream.ReadUint8(data[0]));
+
+		// writing detaches the view from the caller's buffer
+		stream.WriteUint8(1);
+		REQUIRE(stream.size() == data.size() + 1);
+		REQUIRE(stream.GetBytes() == data + bytes_t(1, 1));
+	}
+
+	SECTION("checksum") {
+		bytes_t data = getRandBytes(1000);
+		bytes_t hash = sha256_2(data);
+		REQUIRE(sha256_2_checksum(data.data(), data.size()) == *(uint32_t *) &hash[0]);
+	}
+}
+
+TEST_CASE("ReceiveBuffer replay benchmark", "[.benchmark][ReceiveBuffer]") {
+	Log::registerMultiLogger();
+	srand(time(nullptr));
+
+	// a captured sync stream is mostly merkleblocks, with a matched tx now and then
+	const size_t blockCount = 2000;
+	bytes_t capture;
+	size_t messageCount = 0;
+	for (size_t i = 0; i < blockCount; ++i) {
+		MerkleBlock block;
+		setMerkleBlockValues(&block);
+		ByteStream stream;
+		block.Serialize(stream, MERKLEBLOCK_VERSION_0);
+		capture += frameMessage(MSG_MERKLEBLOCK, stream.GetBytes());
+		messageCount++;
+
+		if (i % 10 == 0) {
+			Transaction tx;
+			initTransaction(tx, Transaction::TxVersion::Default);
+			ByteStream txStream;
+			tx.Serialize(txStream);
+			capture += frameMessage(MSG_TX, txStream.GetBytes());
+			messageCount++;
+		}
+	}
+
+	const size_t readSize = 16 * 1024;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	REQUIRE(replayCopying(capture, readSize) == messageCount);
+	std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - start;
+	WARN("copying: " << messageCount << " messages, " << capture.size() / 1024 << " KB in "
+		 << elapsed.count() / 1000000 << " ms, " << capture.size() * 1000.0 / elapsed.count() << " MB/s");
+
+	start = std::chrono::steady_clock::now();
+	REQUIRE(replayInPlace(capture, readSize) == messageCount);
+	elapsed = std::chrono::steady_clock::now() - start;
+	WARN("in place: " << messageCount << " messages, " << capture.size() / 1024 << " KB in "
+		 << elapsed.count() / 1000000 << " ms, " << capture.size() * 1000.0 / elapsed.count() << " MB/s");
+}
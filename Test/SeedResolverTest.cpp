@@ -0,0 +1,154 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#define CATCH_CONFIG_MAIN
+
+#include <catch.hpp>
+#include "TestHelper.h"
+
+#include <P2P/SeedResolver.h>
+#include <Common/Log.h>
+
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
+using namespace Elastos::ElaWallet;
+
+// answers from a table instead of the network, each lookup waits until released
+class LocalDNSResolver : public DNSResolver {
+public:
+	LocalDNSResolver() : _released(false), _lookups(0) {}
+
+	virtual std::vector<uint128> Lookup(const std::string &hostname) {
+		boost::mutex::scoped_lock scopedLock(_lock);
+		_lookups++;
+		while (!_released)
+			_cond.wait(scopedLock);
+		return _hosts[hostname];
+	}
+
+	void AddHost(const std::string &hostname, const std::vector<uint128> &addresses) {
+		boost::mutex::scoped_lock scopedLock(_lock);
+		_hosts[hostname] = addresses;
+	}
+
+	void Release() {
+		boost::mutex::scoped_lock scopedLock(_lock);
+		_released = true;
+		_cond.notify_all();
+	}
+
+	size_t Lookups() {
+		boost::mutex::scoped_lock scopedLock(_lock);
+		return _lookups;
+	}
+
+private:
+	boost::mutex _lock;
+	boost::condition_variable _cond;
+	std::map<std::string, std::vector<uint128>> _hosts;
+	bool _released;
+	size_t _lookups;
+};
+
+class Results {
+public:
+	void OnResolved(const std::string &seed, const std::vector<PeerInfo> &peers) {
+		boost::mutex::scoped_lock scopedLock(_lock);
+		_peers[seed] = peers;
+		_cond.notify_all();
+	}
+
+	bool WaitFor(size_t count) {
+		boost::mutex::scoped_lock scopedLock(_lock);
+		return _cond.wait_for(scopedLock, boost::chrono::seconds(5), [this, count]() {
+			return _peers.size() >= count;
+		});
+	}
+
+	SeedPeerMap Peers() {
+		boost::mutex::scoped_lock scopedLock(_lock);
+		return _peers;
+	}
+
+private:
+	boost::mutex _lock;
+	boost::condition_variable _cond;
+	SeedPeerMap _peers;
+};
+
+TEST_CASE("SeedResolver test", "[SeedResolver]") {
+	Log::registerMultiLogger();
+	srand(time(nullptr));
+
+	uint128 addr1 = getRandUInt128(), addr2 = getRandUInt128(), addr3 = getRandUInt128();
+
+	SECTION("resolve and cache") {
+		boost::shared_ptr<LocalDNSResolver> dns(new LocalDNSResolver());
+		dns->AddHost("seed1", {addr1, addr2});
+		dns->AddHost("seed2", {addr3, uint128()});
+
+		SeedResolver resolver(100);
+		resolver.SetResolver(dns);
+		Results results;
+		uint64_t now = time(nullptr);
+
+		REQUIRE(resolver.Resolve("seed1", 20866, 30, boost::bind(&Results::OnResolved, &results, _1, _2)));
+		REQUIRE(resolver.Resolve("seed2", 20866, 30, boost::bind(&Results::OnResolved, &results, _1, _2)));
+		REQUIRE(!resolver.Resolve("seed1", 20866, 30, boost::bind(&Results::OnResolved, &results, _1, _2)));
+		REQUIRE(resolver.Pending(now) == 2);
+		// nothing to wait for once the deadline passed
+		REQUIRE(resolver.Pending(now + 31) == 0);
+		REQUIRE(resolver.Cached("seed1", now).empty());
+
+		dns->Release();
+		REQUIRE(results.WaitFor(2));
+		REQUIRE(resolver.Pending(now) == 0);
+
+		SeedPeerMap peers = results.Peers();
+		REQUIRE(peers["seed1"].size() == 2);
+		REQUIRE(peers["seed1"][0].Address == addr1);
+		REQUIRE(peers["seed1"][0].Port == 20866);
+		REQUIRE(peers["seed2"].size() == 1);
+
+		std::vector<PeerInfo> cached = resolver.Cached("seed1", now);
+		REQUIRE(cached.size() == 2);
+		REQUIRE(cached[1].Address == addr2);
+		REQUIRE(resolver.Cached("seed1", cached[0].Timestamp + 100).empty());
+		REQUIRE(dns->Lookups() == 2);
+	}
+
+	SECTION("cancel") {
+		boost::shared_ptr<LocalDNSResolver> dns(new LocalDNSResolver());
+		dns->AddHost("seed1", {addr1});
+
+		SeedResolver resolver(100);
+		resolver.SetResolver(dns);
+		Results results;
+		uint64_t now = time(nullptr);
+
+		REQUIRE(resolver.Resolve("seed1", 20866, 30, boost::bind(&Results::OnResolved, &results, _1, _2)));
+		resolver.Cancel();
+		REQUIRE(resolver.Pending(now) == 0);
+
+		// a cancelled lookup doesn't call back, but what it finds is still cached
+		dns->Release();
+		for (int i = 0; i < 500 && resolver.Cached("seed1", now).empty(); ++i)
+			boost::this_thread::sleep_for(boost::chrono::milliseconds(10));
+		REQUIRE(resolver.Cached("seed1", now).size() == 1);
+		REQUIRE(results.Peers().empty());
+	}
+
+	SECTION("load") {
+		uint64_t now = time(nullptr);
+		SeedPeerMap seeds;
+		seeds["seed1"].push_back(PeerInfo(addr1, 20866, now - 50));
+		seeds["seed2"].push_back(PeerInfo(addr2, 20866, now - 150));
+
+		SeedResolver resolver(100);
+		resolver.Load(seeds, now);
+		REQUIRE(resolver.Cached("seed1", now).size() == 1);
+		REQUIRE(resolver.Cached("seed2", now).empty());
+	}
+}
@@ -0,0 +1,126 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#define CATCH_CONFIG_MAIN
+
+#include <catch.hpp>
+#include "TestHelper.h"
+
+#include <P2P/SendQueue.h>
+#include <Common/Log.h>
+
+#include <sys/socket.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+using namespace Elastos::ElaWallet;
+
+static bytes_t gathered(const SendQueue &queue, size_t count) {
+	std::vector<struct iovec> iov(count);
+	bytes_t data;
+
+	size_t n = queue.Gather(&iov[0], count);
+	for (size_t i = 0; i < n; ++i)
+		data += bytes_t((const uint8_t *) iov[i].iov_base, iov[i].iov_len);
+
+	return data;
+}
+
+TEST_CASE("SendQueue test", "[SendQueue]") {
+	Log::registerMultiLogger();
+	srand(time(nullptr));
+
+	SECTION("gather and consume") {
+		SendQueue queue;
+		bytes_t header1 = getRandBytes(24), payload1 = getRandBytes(100);
+		bytes_t header2 = getRandBytes(24), payload2;
+		bytes_t header3 = getRandBytes(24), payload3 = getRandBytes(1000);
+
+		queue.Push(header1, payload1);
+		queue.Push(header2, payload2);
+		queue.Push(header3, payload3);
+		REQUIRE(queue.Messages() == 3);
+		REQUIRE(queue.Bytes() == 24 * 3 + 1100);
+
+		// all messages go out in one write, an empty payload takes no buffer
+		bytes_t all = header1 + payload1 + header2 + header3 + payload3;
+		struct iovec iov[SEND_QUEUE_MAX_IOV];
+		REQUIRE(queue.Gather(iov, SEND_QUEUE_MAX_IOV) == 5);
+		REQUIRE(gathered(queue, SEND_QUEUE_MAX_IOV) == all);
+		REQUIRE(gathered(queue, 2) == header1 + payload1);
+
+		// a partial write continues in the middle of a buffer
+		queue.Consume(50);
+		REQUIRE(queue.Messages() == 3);
+		REQUIRE(gathered(queue, SEND_QUEUE_MAX_IOV) == bytes_t(all.begin() + 50, all.end()));
+
+		queue.Consume(24 + 100 - 50 + 24 + 10);
+		REQUIRE(queue.Messages() == 1);
+		REQUIRE(queue.Bytes() == 24 + 1000 - 10);
+		REQUIRE(gathered(queue, SEND_QUEUE_MAX_IOV) == bytes_t(all.begin() + 24 + 100 + 24 + 10, all.end()));
+
+		queue.Consume(queue.Bytes());
+		REQUIRE(queue.Empty());
+		REQUIRE(queue.Gather(iov, SEND_QUEUE_MAX_IOV) == 0);
+	}
+
+	SECTION("backpressure") {
+		SendQueue queue(1000);
+
+		for (size_t i = 0; i < 10; ++i)
+			queue.Push(getRandBytes(24), getRandBytes(100));
+		REQUIRE(queue.Congested());
+		REQUIRE(queue.CongestedCount() == 1);
+
+		queue.Push(getRandBytes(24), getRandBytes(100));
+		REQUIRE(queue.CongestedCount() == 1);
+		REQUIRE(queue.PeakBytes() == 11 * 124);
+
+		queue.Consume(124 * 5);
+		REQUIRE(!queue.Congested());
+		queue.Push(getRandBytes(24), getRandBytes(500));
+		REQUIRE(queue.CongestedCount() == 2);
+		REQUIRE(queue.PeakBytes() == 11 * 124);
+
+		queue.Clear();
+		REQUIRE(queue.Empty());
+		REQUIRE(queue.Bytes() == 0);
+		REQUIRE(!queue.Congested());
+	}
+
+	SECTION("socket") {
+		int fds[2];
+		REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+		fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+
+		SendQueue queue;
+		bytes_t expected;
+		for (size_t i = 0; i < 200; ++i) {
+			bytes_t header = getRandBytes(24), payload = getRandBytes(rand() % 5000);
+			queue.Push(header, payload);
+			expected += header + payload;
+		}
+
+		// the writer never blocks, it drains what the reader made room for
+		bytes_t received;
+		uint8_t buf[4096];
+		while (!queue.Empty() || received.size() < expected.size()) {
+			struct iovec iov[SEND_QUEUE_MAX_IOV];
+			size_t count = queue.Gather(iov, SEND_QUEUE_MAX_IOV);
+			if (count > 0) {
+				ssize_t n = writev(fds[0], iov, count);
+				if (n > 0) queue.Consume(n);
+				else REQUIRE(errno == EAGAIN);
+			}
+
+			ssize_t n = read(fds[1], buf, sizeof(buf));
+			REQUIRE(n > 0);
+			received += bytes_t(buf, n);
+		}
+
+		REQUIRE(received == expected);
+		close(fds[0]);
+		close(fds[1]);
+	}
+}
@@ -0,0 +1,389 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#define CATCH_CONFIG_MAIN
+
+#include <catch.hpp>
+#include "TestHelper.h"
+
+#include <Database/Sqlite.h>
+#include <Database/TransactionNormal.h>
+#include <Database/MerkleBlockDataSource.h>
+#include <Database/UTXOStore.h>
+#include <Plugin/Transaction/Transaction.h>
+#include <Plugin/Block/MerkleBlock.h>
+#include <Common/Log.h>
+
+#include <chrono>
+
+using namespace Elastos::ElaWallet;
+
+#define DBFILE "sqlite_test.db"
+
+static const std::string insertSql = "INSERT INTO t(k, v) VALUES (?, ?);";
+
+static int countRows(Sqlite &sqlite, const std::string &where) {
+	sqlite3_stmt *stmt;
+	int count = -1;
+
+	REQUIRE(sqlite.Prepare("SELECT COUNT(*) FROM t WHERE " + where + ";", &stmt, nullptr));
+	if (SQLITE_ROW == sqlite.Step(stmt))
+		count = sqlite.ColumnInt(stmt, 0);
+	REQUIRE(sqlite.Finalize(stmt));
+
+	return count;
+}
+
+TEST_CASE("Sqlite statement cache test", "[Sqlite]") {
+	Log::registerMultiLogger();
+	boost::filesystem::remove(DBFILE);
+
+	{
+		Sqlite sqlite(DBFILE);
+		REQUIRE(sqlite.exec("CREATE TABLE t(k INTEGER PRIMARY KEY, v TEXT);", nullptr, nullptr));
+
+		sqlite3_stmt *first, *second;
+
+		SECTION("a released statement is handed out again") {
+			REQUIRE(sqlite.PrepareCached(insertSql, &first));
+			REQUIRE(sqlite.BindInt(first, 1, 1));
+			REQUIRE(sqlite.BindText(first, 2, "one", nullptr));
+			REQUIRE(sqlite.Step(first) == SQLITE_DONE);
+			REQUIRE(sqlite.Release(insertSql, first));
+			REQUIRE(sqlite.CachedStatementCount() == 1);
+
+			REQUIRE(sqlite.PrepareCached(insertSql, &second));
+			REQUIRE(second == first);
+			REQUIRE(sqlite.CachedStatementCount() == 0);
+
+			// the bindings of the last caller are gone
+			REQUIRE(sqlite.BindInt(second, 1, 2));
+			REQUIRE(sqlite.Step(second) == SQLITE_DONE);
+			REQUIRE(sqlite.Release(insertSql, second));
+			REQUIRE(countRows(sqlite, "k = 2 AND v IS NULL") == 1);
+		}
+
+		SECTION("statements in use are not shared") {
+			REQUIRE(sqlite.PrepareCached(insertSql, &first));
+			REQUIRE(sqlite.PrepareCached(insertSql, &second));
+			REQUIRE(first != second);
+			REQUIRE(sqlite.Release(insertSql, first));
+			REQUIRE(sqlite.Release(insertSql, second));
+			REQUIRE(sqlite.CachedStatementCount() == 2);
+
+			// only a few idle statements are kept for one sql
+			std::vector<sqlite3_stmt *> stmts(SQLITE_CACHED_STATEMENTS_PER_SQL + 2);
+			for (size_t i = 0; i < stmts.size(); ++i)
+				REQUIRE(sqlite.PrepareCached(insertSql, &stmts[i]));
+			for (size_t i = 0; i < stmts.size(); ++i)
+				REQUIRE(sqlite.Release(insertSql, stmts[i]));
+			REQUIRE(sqlite.CachedStatementCount() == SQLITE_CACHED_STATEMENTS_PER_SQL);
+		}
+
+		SECTION("statements are cached under the caller's sql") {
+			// sqlite3_sql() of this statement stops at the semicolon
+			const std::string sql = insertSql + " -- trailing comment";
+			REQUIRE(sqlite.PrepareCached(sql, &first));
+			REQUIRE(sqlite.Release(sql, first));
+
+			REQUIRE(sqlite.PrepareCached(sql, &second));
+			REQUIRE(second == first);
+			REQUIRE(sqlite.Release(sql, second));
+		}
+
+		SECTION("a failed step is reported on release") {
+			REQUIRE(sqlite.PrepareCached(insertSql, &first));
+			REQUIRE(sqlite.BindInt(first, 1, 1));
+			REQUIRE(sqlite.Step(first) == SQLITE_DONE);
+			REQUIRE(sqlite.Release(insertSql, first));
+
+			REQUIRE(sqlite.PrepareCached(insertSql, &first));
+			REQUIRE(sqlite.BindInt(first, 1, 1));
+			REQUIRE(sqlite.Step(first) != SQLITE_DONE);
+			REQUIRE(!sqlite.Release(insertSql, first));
+
+			// and the statement is still good
+			REQUIRE(sqlite.PrepareCached(insertSql, &first));
+			REQUIRE(sqlite.BindInt(first, 1, 3));
+			REQUIRE(sqlite.Step(first) == SQLITE_DONE);
+			REQUIRE(sqlite.Release(insertSql, first));
+			REQUIRE(countRows(sqlite, "1") == 2);
+		}
+
+		SECTION("a prepare error is reported") {
+			REQUIRE(!sqlite.PrepareCached("INSERT INTO missing(k) VALUES (?);", &first));
+			REQUIRE(sqlite.CachedStatementCount() == 0);
+		}
+	}
+
+	boost::filesystem::remove(DBFILE);
+}
+
+static std::string pragma(Sqlite &sqlite, const std::string &name) {
+	sqlite3_stmt *stmt;
+	std::string value;
+
+	REQUIRE(sqlite.Prepare("PRAGMA " + name + ";", &stmt, nullptr));
+	if (SQLITE_ROW == sqlite.Step(stmt))
+		value = sqlite.ColumnText(stmt, 0);
+	REQUIRE(sqlite.Finalize(stmt));
+
+	return value;
+}
+
+static void insertCommits(Sqlite &sqlite, size_t first, size_t count) {
+	for (size_t i = first; i < first + count; ++i) {
+		sqlite3_stmt *stmt;
+		REQUIRE(sqlite.BeginTransaction(IMMEDIATE));
+		REQUIRE(sqlite.PrepareCached(insertSql, &stmt));
+		sqlite.BindInt64(stmt, 1, i);
+		REQUIRE(sqlite.Step(stmt) == SQLITE_DONE);
+		REQUIRE(sqlite.Release(insertSql, stmt));
+		REQUIRE(sqlite.EndTransaction());
+	}
+}
+
+TEST_CASE("Sqlite config test", "[Sqlite]") {
+	Log::registerMultiLogger();
+	boost::filesystem::remove(DBFILE);
+
+	SECTION("defaults") {
+		Sqlite sqlite(DBFILE);
+		REQUIRE(pragma(sqlite, "journal_mode") == "wal");
+		REQUIRE(pragma(sqlite, "synchronous") == "1");
+		REQUIRE(pragma(sqlite, "cache_size") == std::to_string(-SQLITE_DEFAULT_CACHE_SIZE_KB));
+		REQUIRE(pragma(sqlite, "wal_autocheckpoint") == std::to_string(SQLITE_DEFAULT_CHECKPOINT_PAGES));
+		REQUIRE(sqlite.GetJournalMode() == "wal");
+
+		// commits only append to the WAL, the checkpoint syncs
+		REQUIRE(sqlite.exec("CREATE TABLE t(k INTEGER PRIMARY KEY, v TEXT);", nullptr, nullptr));
+		uint64_t syncs = sqlite.GetSyncCount();
+		insertCommits(sqlite, 0, 20);
+		REQUIRE(sqlite.GetSyncCount() == syncs);
+		REQUIRE(sqlite.Checkpoint());
+		REQUIRE(sqlite.GetSyncCount() > syncs);
+	}
+
+	SECTION("rollback journal with full sync") {
+		SqliteConfig config;
+		config.journalMode = "delete";
+		config.synchronous = "FULL";
+		config.cacheSizeKB = 1024;
+		config.mmapSize = 0;
+
+		Sqlite sqlite(DBFILE, config);
+		REQUIRE(sqlite.GetJournalMode() == "delete");
+		REQUIRE(pragma(sqlite, "synchronous") == "2");
+		REQUIRE(pragma(sqlite, "cache_size") == "-1024");
+		REQUIRE(!sqlite.Checkpoint());
+
+		// every commit syncs the journal and the database
+		REQUIRE(sqlite.exec("CREATE TABLE t(k INTEGER PRIMARY KEY, v TEXT);", nullptr, nullptr));
+		uint64_t syncs = sqlite.GetSyncCount();
+		insertCommits(sqlite, 0, 20);
+		REQUIRE(sqlite.GetSyncCount() >= syncs + 2 * 20);
+		REQUIRE(sqlite.GetSyncMicroseconds() > 0);
+
+		// connections to the same file share the count
+		Sqlite other(DBFILE, config);
+		REQUIRE(other.GetSyncCount() == sqlite.GetSyncCount());
+	}
+
+	SECTION("invalid modes are ignored") {
+		SqliteConfig config;
+		config.journalMode = "WAL; DROP TABLE t";
+		config.synchronous = "SOMETIMES";
+
+		Sqlite sqlite(DBFILE, config);
+		REQUIRE(sqlite.IsValid());
+		REQUIRE(sqlite.GetJournalMode() == "delete");
+		REQUIRE(pragma(sqlite, "synchronous") == "2");
+	}
+
+	boost::filesystem::remove(DBFILE);
+}
+
+TEST_CASE("Sqlite group commit test", "[Sqlite]") {
+	Log::registerMultiLogger();
+	boost::filesystem::remove(DBFILE);
+
+	{
+		Sqlite sqlite(DBFILE);
+		Sqlite other(DBFILE);
+		REQUIRE(sqlite.exec("CREATE TABLE t(k INTEGER PRIMARY KEY, v TEXT);", nullptr, nullptr));
+
+		sqlite.SetGroupCommit(3);
+		uint64_t commits = sqlite.GetCommitCount();
+
+		insertCommits(sqlite, 0, 2);
+		REQUIRE(sqlite.BatchedTransactions() == 2);
+		REQUIRE(countRows(sqlite, "1") == 2);
+		REQUIRE(countRows(other, "1") == 0);
+
+		insertCommits(sqlite, 2, 1);
+		REQUIRE(sqlite.BatchedTransactions() == 0);
+		REQUIRE(sqlite.GetCommitCount() == commits + 1);
+		REQUIRE(countRows(other, "1") == 3);
+
+		// a failed transaction does not undo the batch
+		REQUIRE(sqlite.BeginTransaction(IMMEDIATE));
+		REQUIRE(!sqlite.exec("INSERT INTO t(k) VALUES (0);", nullptr, nullptr));
+		REQUIRE(sqlite.EndTransaction());
+		insertCommits(sqlite, 3, 1);
+		REQUIRE(sqlite.BatchedTransactions() == 2);
+
+		REQUIRE(sqlite.CommitBatch());
+		REQUIRE(sqlite.CommitBatch());
+		REQUIRE(sqlite.GetCommitCount() == commits + 2);
+		REQUIRE(countRows(other, "1") == 4);
+
+		// turning it off commits what is pending, then every transaction commits
+		insertCommits(sqlite, 4, 1);
+		sqlite.SetGroupCommit(0);
+		REQUIRE(countRows(other, "1") == 5);
+		insertCommits(sqlite, 5, 1);
+		REQUIRE(countRows(other, "1") == 6);
+		REQUIRE(sqlite.GetCommitCount() == commits + 4);
+
+		// sqlite rolling the batch back on its own, as it may after SQLITE_FULL or SQLITE_IOERR, fails the
+		// transaction that sees it and the batch starts over
+		sqlite.SetGroupCommit(100);
+		insertCommits(sqlite, 6, 1);
+		REQUIRE(sqlite.BeginTransaction(IMMEDIATE));
+		REQUIRE(sqlite.exec("ROLLBACK;", nullptr, nullptr));
+		REQUIRE(!sqlite.EndTransaction());
+		REQUIRE(sqlite.BatchedTransactions() == 0);
+		REQUIRE(sqlite.CommitBatch());
+		REQUIRE(countRows(other, "1") == 6);
+
+		// closing commits as well
+		insertCommits(sqlite, 6, 1);
+		REQUIRE(sqlite.BatchedTransactions() == 1);
+	}
+
+	{
+		Sqlite sqlite(DBFILE);
+		REQUIRE(countRows(sqlite, "1") == 7);
+	}
+
+	boost::filesystem::remove(DBFILE);
+}
+
+TEST_CASE("Database commit benchmark", "[.benchmark][Sqlite]") {
+	Log::registerMultiLogger();
+	const size_t commits = 2000;
+
+	const char *modes[][3] = {{"DELETE", "FULL", "0"}, {"WAL", "FULL", "0"}, {"WAL", "NORMAL", "0"},
+							  {"WAL", "NORMAL", "1000"}};
+	for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); ++m) {
+		boost::filesystem::remove(DBFILE);
+		SqliteConfig config;
+		config.journalMode = modes[m][0];
+		config.synchronous = modes[m][1];
+
+		Sqlite sqlite(DBFILE, config);
+		REQUIRE(sqlite.exec("CREATE TABLE t(k INTEGER PRIMARY KEY, v TEXT);", nullptr, nullptr));
+		sqlite.SetGroupCommit(std::stoul(modes[m][2]));
+
+		uint64_t syncs = sqlite.GetSyncCount();
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		insertCommits(sqlite, 0, commits);
+		std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - start;
+		syncs = sqlite.GetSyncCount() - syncs;
+
+		WARN(modes[m][0] << "/" << modes[m][1] << ", group commit " << modes[m][2] << ": " <<
+			 commits * 1000000000 / elapsed.count() << " transactions/s, " << (double) syncs / commits <<
+			 " fsyncs per transaction");
+	}
+
+	boost::filesystem::remove(DBFILE);
+}
+
+TEST_CASE("Database bulk insert benchmark", "[.benchmark][Sqlite]") {
+	Log::registerMultiLogger();
+	const size_t rows = 20000;
+	std::chrono::nanoseconds elapsed;
+	std::chrono::steady_clock::time_point start;
+
+	boost::filesystem::remove(DBFILE);
+	{
+		Sqlite sqlite(DBFILE);
+		REQUIRE(sqlite.exec("CREATE TABLE t(k INTEGER PRIMARY KEY, v TEXT);", nullptr, nullptr));
+		std::string value = getRandString(64);
+
+		// one statement prepared and finalized per row, as every table did before the cache
+		REQUIRE(sqlite.BeginTransaction(IMMEDIATE));
+		start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < rows; ++i) {
+			sqlite3_stmt *stmt;
+			REQUIRE(sqlite.Prepare(insertSql, &stmt, nullptr));
+			sqlite.BindInt64(stmt, 1, i);
+			sqlite.BindText(stmt, 2, value, nullptr);
+			REQUIRE(sqlite.Step(stmt) == SQLITE_DONE);
+			REQUIRE(sqlite.Finalize(stmt));
+		}
+		elapsed = std::chrono::steady_clock::now() - start;
+		REQUIRE(sqlite.EndTransaction());
+		WARN("Prepare/Finalize: " << rows * 1000000000 / elapsed.count() << " rows/s");
+
+		REQUIRE(sqlite.BeginTransaction(IMMEDIATE));
+		start = std::chrono::steady_clock::now();
+		for (size_t i = rows; i < 2 * rows; ++i) {
+			sqlite3_stmt *stmt;
+			REQUIRE(sqlite.PrepareCached(insertSql, &stmt));
+			sqlite.BindInt64(stmt, 1, i);
+			sqlite.BindText(stmt, 2, value, nullptr);
+			REQUIRE(sqlite.Step(stmt) == SQLITE_DONE);
+			REQUIRE(sqlite.Release(insertSql, stmt));
+		}
+		elapsed = std::chrono::steady_clock::now() - start;
+		REQUIRE(sqlite.EndTransaction());
+		WARN("PrepareCached/Release: " << rows * 1000000000 / elapsed.count() << " rows/s");
+
+		std::vector<TransactionPtr> txns;
+		for (size_t i = 0; i < rows; ++i) {
+			TransactionPtr tx(new Transaction());
+			tx->SetLockTime(i);
+			tx->SetBlockHeight(i);
+			txns.push_back(tx);
+		}
+
+		TransactionNormal txTable(&sqlite);
+		txTable.InitializeTable();
+		start = std::chrono::steady_clock::now();
+		REQUIRE(txTable.Puts(txns));
+		elapsed = std::chrono::steady_clock::now() - start;
+		REQUIRE(txTable.GetAllCount() == rows);
+		WARN("TransactionNormal::Puts: " << rows * 1000000000 / elapsed.count() << " rows/s");
+
+		std::vector<MerkleBlockPtr> blocks;
+		for (size_t i = 0; i < rows; ++i) {
+			MerkleBlockPtr block(new MerkleBlock());
+			setMerkleBlockValues(static_cast<MerkleBlock *>(block.get()));
+			block->SetHeight(i + 1);
+			blocks.push_back(block);
+		}
+
+		MerkleBlockDataSource blockTable(&sqlite);
+		blockTable.InitializeTable();
+		start = std::chrono::steady_clock::now();
+		REQUIRE(blockTable.PutMerkleBlocks(false, blocks));
+		elapsed = std::chrono::steady_clock::now() - start;
+		WARN("MerkleBlockDataSource::PutMerkleBlocks: " << rows * 1000000000 / elapsed.count() << " rows/s");
+
+		std::vector<UTXOEntity> utxos;
+		for (size_t i = 0; i < rows; ++i)
+			utxos.push_back(UTXOEntity(txns[i]->GetHash().GetHex(), 0));
+
+		UTXOStore utxoTable(&sqlite);
+		utxoTable.InitializeTable();
+		start = std::chrono::steady_clock::now();
+		REQUIRE(utxoTable.Puts(utxos));
+		elapsed = std::chrono::steady_clock::now() - start;
+		REQUIRE(utxoTable.Gets().size() == rows);
+		WARN("UTXOStore::Puts: " << rows * 1000000000 / elapsed.count() << " rows/s");
+	}
+
+	boost::filesystem::remove(DBFILE);
+}
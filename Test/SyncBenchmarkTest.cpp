@@ -0,0 +1,359 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#define CATCH_CONFIG_MAIN
+
+#include <catch.hpp>
+
+#include <Common/Log.h>
+#include <Account/Account.h>
+#include <Account/SubAccount.h>
+#include <WalletCore/HDKeychain.h>
+#include <MasterWalletManager.h>
+
+#include "FakePeer.h"
+
+#include <chrono>
+#include <boost/scoped_ptr.hpp>
+#include <boost/filesystem.hpp>
+#include <sys/resource.h>
+
+using namespace Elastos::ElaWallet;
+
+static const std::string __rootPath = "./SyncBenchmark/";
+static const std::string masterWalletId = "SyncBenchmark";
+static const std::string payPassword = "payPassword";
+static const std::string mnemonic = "abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon about";
+
+class SyncMasterWalletManager : public MasterWalletManager {
+public:
+	SyncMasterWalletManager(const std::string &rootPath, const std::string &netType, const nlohmann::json &config) :
+		MasterWalletManager(rootPath, netType, config) {
+		_p2pEnable = false;
+	}
+};
+
+static int connectTo(uint16_t port) {
+	struct sockaddr_in addr;
+	int socket = ::socket(AF_INET, SOCK_STREAM, 0);
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = htons(port);
+	REQUIRE(connect(socket, (struct sockaddr *) &addr, sizeof(addr)) == 0);
+
+	return socket;
+}
+
+static void send(int socket, const std::string &type, const bytes_t &payload) {
+	REQUIRE(FakePeer::Write(socket, FakePeer::Frame(FAKE_PEER_MAGIC, type, payload)));
+}
+
+static ByteStream receive(int socket, const std::string &expectedType) {
+	std::string type;
+	bytes_t payload;
+
+	REQUIRE(FakePeer::Read(socket, FAKE_PEER_MAGIC, type, payload));
+	REQUIRE(type == expectedType);
+	return ByteStream(payload);
+}
+
+TEST_CASE("FakePeer test", "[FakePeer]") {
+	Log::registerMultiLogger();
+
+	FakeChain::Options options;
+	options.Length = 600;
+	options.TxPerBlock = 2;
+	options.TotalTxPerBlock = 50;
+	options.MempoolTxs = 3;
+	FakeChain chain(options);
+	FakeChain again(options);
+
+	SECTION("the chain") {
+		REQUIRE(chain.Height() == 600);
+		REQUIRE(chain.Blocks().back()->GetHash() == again.Blocks().back()->GetHash());
+
+		time_t now = time(nullptr);
+		for (uint32_t height = 1; height <= chain.Height(); ++height) {
+			const MerkleBlockPtr &block = chain.Blocks()[height];
+			std::vector<uint256> matched;
+
+			REQUIRE(block->GetHeight() == height);
+			REQUIRE(block->GetPrevBlockHash() == chain.Blocks()[height - 1]->GetHash());
+			REQUIRE(block->IsValid(now));
+			REQUIRE(block->MerkleBlockTxHashes(matched) == 2);
+			REQUIRE(matched[0] == chain.BlockTxs(height)[0]->GetHash());
+			REQUIRE(matched[1] == chain.BlockTxs(height)[1]->GetHash());
+		}
+	}
+
+	SECTION("the wire") {
+		FakePeer peer(chain);
+		int socket = connectTo(peer.Port());
+
+		ByteStream version;
+		version.WriteUint32(FAKE_PEER_VERSION);
+		version.WriteUint64(0);
+		version.WriteUint32((uint32_t) time(nullptr));
+		version.WriteUint16(0);
+		version.WriteUint64(1);
+		version.WriteUint64(0);
+		version.WriteUint8(0);
+		send(socket, MSG_VERSION, version.GetBytes());
+
+		uint32_t u32;
+		uint64_t u64;
+		ByteStream reply = receive(socket, MSG_VERSION);
+		REQUIRE(reply.ReadUint32(u32));
+		REQUIRE(u32 == FAKE_PEER_VERSION);
+		REQUIRE(reply.ReadUint64(u64));
+		REQUIRE(u64 == SERVICES_NODE_NETWORK);
+		receive(socket, MSG_VERACK);
+
+		// getblocks from the genesis block answers the next 500 hashes
+		ByteStream getblocks;
+		getblocks.WriteUint32(1);
+		getblocks.WriteBytes(chain.Blocks()[0]->GetHash());
+		getblocks.WriteBytes(uint256());
+		send(socket, MSG_GETBLOCKS, getblocks.GetBytes());
+
+		ByteStream inv = receive(socket, MSG_INV);
+		uint256 hash;
+		REQUIRE(inv.ReadUint32(u32));
+		REQUIRE(u32 == FAKE_PEER_MAX_INV);
+		for (uint32_t i = 1; i <= FAKE_PEER_MAX_INV; ++i) {
+			REQUIRE(inv.ReadUint32(u32));
+			REQUIRE(u32 == inv_block);
+			REQUIRE(inv.ReadBytes(hash));
+			REQUIRE(hash == chain.Blocks()[i]->GetHash());
+		}
+
+		// getdata of a filtered block answers the merkleblock, then its matched tx
+		ByteStream getdata;
+		getdata.WriteUint32(2);
+		getdata.WriteUint32(inv_filtered_block);
+		getdata.WriteBytes(chain.Blocks()[7]->GetHash());
+		getdata.WriteUint32(inv_filtered_block);
+		getdata.WriteBytes(uint256(7));
+		send(socket, MSG_GETDATA, getdata.GetBytes());
+
+		MerkleBlock block;
+		REQUIRE(block.Deserialize(receive(socket, MSG_MERKLEBLOCK), MERKLEBLOCK_VERSION_1));
+		REQUIRE(block.GetHash() == chain.Blocks()[7]->GetHash());
+		REQUIRE(block.GetPrevBlockHash() == chain.Blocks()[6]->GetHash());
+		REQUIRE(block.IsValid((uint32_t) time(nullptr)));
+		for (size_t i = 0; i < 2; ++i) {
+			Transaction tx;
+			REQUIRE(tx.Deserialize(receive(socket, MSG_TX)));
+			REQUIRE(tx.GetHash() == chain.BlockTxs(7)[i]->GetHash());
+		}
+
+		ByteStream notfound = receive(socket, MSG_NOTFOUND);
+		REQUIRE(notfound.ReadUint32(u32));
+		REQUIRE(u32 == 1);
+
+		// ping answers a pong with the same nonce
+		ByteStream ping;
+		ping.WriteUint64(0x1234567890abcdefULL);
+		send(socket, MSG_PING, ping.GetBytes());
+		REQUIRE(receive(socket, MSG_PONG).GetBytes() == ping.GetBytes());
+
+		// filterload is counted silently, mempool answers the unconfirmed tx
+		send(socket, MSG_FILTERLOAD, bytes_t(10, 0));
+		send(socket, MSG_MEMPOOL, bytes_t());
+		inv = receive(socket, MSG_INV);
+		REQUIRE(inv.ReadUint32(u32));
+		REQUIRE(u32 == 3);
+		REQUIRE(inv.ReadUint32(u32));
+		REQUIRE(u32 == inv_tx);
+		REQUIRE(inv.ReadBytes(hash));
+		REQUIRE(hash == chain.Mempool()[0]->GetHash());
+
+		REQUIRE(peer.Connections() == 1);
+		REQUIRE(peer.BlocksServed() == 1);
+		REQUIRE(peer.FilterLoads() == 1);
+
+		close(socket);
+		peer.Stop();
+	}
+}
+
+// external addresses of the wallet from @start on, generated past the ones a new wallet starts with
+static std::vector<Address> walletAddresses(uint32_t start, uint32_t count) {
+	AccountPtr account(new Account(__rootPath + "addresses/", mnemonic, "", payPassword, false));
+	SubAccountPtr subAccount(new SubAccount(account, 0));
+	subAccount->Init();
+	subAccount->UnusedAddresses(start + count, false);
+
+	AddressArray addresses;
+	subAccount->GetAllAddresses(addresses, start, count, false);
+
+	std::vector<Address> result;
+	for (size_t i = 0; i < addresses.size(); ++i)
+		result.push_back(*addresses[i]);
+	return result;
+}
+
+static nlohmann::json syncConfig(const FakeChain &chain, const FakePeer &peer) {
+	nlohmann::json config;
+	config["ELA"]["GenesisAddress"] = "";
+	config["ELA"]["ChainParameters"]["MagicNumber"] = FAKE_PEER_MAGIC;
+	config["ELA"]["ChainParameters"]["StandardPort"] = peer.Port();
+	config["ELA"]["ChainParameters"]["DNSSeeds"] = {"127.0.0.1"};
+	config["ELA"]["ChainParameters"]["CheckPoints"].push_back(chain.Checkpoint());
+	return config;
+}
+
+// the sync metrics once @subWallet has the whole chain and applied it to the wallet
+static nlohmann::json waitForSync(ISubWallet *subWallet, const FakeChain &chain, std::chrono::seconds timeout) {
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	nlohmann::json metrics;
+
+	for (;;) {
+		boost::this_thread::sleep_for(boost::chrono::milliseconds(20));
+		metrics = subWallet->GetSyncMetrics();
+		if (metrics["LastBlockHeight"] == chain.Height() && metrics["Counters"]["WalletApplyPending"] == 0)
+			return metrics;
+		REQUIRE(std::chrono::steady_clock::now() - start < timeout);
+	}
+}
+
+TEST_CASE("Bloom filter growth", "[Sync]") {
+	Log::registerMultiLogger();
+
+	boost::filesystem::remove_all(__rootPath);
+	boost::filesystem::create_directories(__rootPath);
+
+	// every block pays the wallet, so that no block carries a false positive that could rebuild the filter
+	FakeChain::Options options;
+	options.TxPerBlock = 1;
+	options.TotalTxPerBlock = 10;
+	options.WalletTxInterval = 1;
+	options.MempoolTxs = 0;
+
+	SECTION("addresses within the spare capacity are sent as filteradd") {
+		// a new wallet starts with SEQUENCE_GAP_LIMIT_EXTERNAL + 100 external addresses, paying the last of them
+		// generates at most SEQUENCE_GAP_LIMIT_EXTERNAL more
+		options.Length = 300;
+		options.WalletAddresses = walletAddresses(100, SEQUENCE_GAP_LIMIT_EXTERNAL);
+		FakeChain chain(options);
+		FakePeer peer(chain);
+
+		boost::scoped_ptr<SyncMasterWalletManager> manager(
+			new SyncMasterWalletManager(__rootPath + "sync/", "PrvNet", syncConfig(chain, peer)));
+		IMasterWallet *masterWallet = manager->CreateMasterWallet(masterWalletId, mnemonic, "", payPassword, false);
+		ISubWallet *subWallet = masterWallet->CreateSubWallet("ELA");
+
+		subWallet->SyncStart();
+		nlohmann::json metrics = waitForSync(subWallet, chain, std::chrono::seconds(60));
+
+		size_t adds = metrics["Counters"]["BloomFilterAdds"];
+		REQUIRE(adds > 0);
+		REQUIRE(adds <= SEQUENCE_GAP_LIMIT_EXTERNAL);
+		// one filterload for each connection, none for the new addresses
+		REQUIRE(metrics["Counters"]["BloomFilterRebuilds"] == peer.Connections());
+
+		for (int i = 0; i < 250 && peer.FilterAdds() < adds; ++i)
+			boost::this_thread::sleep_for(boost::chrono::milliseconds(20));
+		REQUIRE(peer.FilterAdds() == adds);
+		REQUIRE(peer.FilterLoads() == peer.Connections());
+
+		// the connected peer announced every block hash
+		REQUIRE(metrics["KnownInventoryBytes"] > 0);
+
+		subWallet->SyncStop();
+		peer.Stop();
+	}
+
+	SECTION("once the elements added degrade the false positive rate the filter is rebuilt") {
+		// each payment to the next address adds one address past the gap limit and a UTXO, until the elements
+		// added push the filter's false positive rate past ten times what it was built for
+		options.Length = 1000;
+		options.WalletAddresses = walletAddresses(0, 1000);
+		options.WalletAddressesInOrder = true;
+		FakeChain chain(options);
+		FakePeer peer(chain);
+
+		boost::scoped_ptr<SyncMasterWalletManager> manager(
+			new SyncMasterWalletManager(__rootPath + "sync/", "PrvNet", syncConfig(chain, peer)));
+		IMasterWallet *masterWallet = manager->CreateMasterWallet(masterWalletId, mnemonic, "", payPassword, false);
+		ISubWallet *subWallet = masterWallet->CreateSubWallet("ELA");
+
+		subWallet->SyncStart();
+		nlohmann::json metrics = waitForSync(subWallet, chain, std::chrono::seconds(120));
+
+		size_t rebuilds = metrics["Counters"]["BloomFilterRebuilds"];
+		REQUIRE(metrics["Counters"]["BloomFilterAdds"] > 0);
+		REQUIRE(rebuilds > peer.Connections());
+
+		for (int i = 0; i < 250 && peer.FilterLoads() < rebuilds; ++i)
+			boost::this_thread::sleep_for(boost::chrono::milliseconds(20));
+		REQUIRE(peer.FilterLoads() == rebuilds);
+
+		subWallet->SyncStop();
+		peer.Stop();
+	}
+
+	boost::filesystem::remove_all(__rootPath);
+}
+
+static double cpuSeconds(const struct rusage &usage) {
+	return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+}
+
+TEST_CASE("Sync benchmark", "[.benchmark][Sync]") {
+	Log::registerMultiLogger();
+
+	const size_t chainLength = 20000;
+	const size_t walletAddressCount = 20;
+
+	boost::filesystem::remove_all(__rootPath);
+	boost::filesystem::create_directories(__rootPath);
+
+	// the wallet addresses only depend on the mnemonic, the chain needs them before the wallet may know the chain
+	FakeChain::Options options;
+	{
+		boost::scoped_ptr<SyncMasterWalletManager> manager(
+			new SyncMasterWalletManager(__rootPath + "addresses/", "MainNet", nlohmann::json()));
+		IMasterWallet *masterWallet = manager->CreateMasterWallet(masterWalletId, mnemonic, "", payPassword, false);
+		nlohmann::json addresses = masterWallet->CreateSubWallet("ELA")->GetAllAddress(0, walletAddressCount)["Addresses"];
+		for (nlohmann::json::iterator it = addresses.begin(); it != addresses.end(); ++it)
+			options.WalletAddresses.push_back(Address(it->get<std::string>()));
+	}
+
+	options.Length = chainLength;
+	options.WalletTxInterval = 100;
+	FakeChain chain(options);
+	FakePeer peer(chain);
+
+	boost::scoped_ptr<SyncMasterWalletManager> manager(
+		new SyncMasterWalletManager(__rootPath + "sync/", "PrvNet", syncConfig(chain, peer)));
+	IMasterWallet *masterWallet = manager->CreateMasterWallet(masterWalletId, mnemonic, "", payPassword, false);
+	ISubWallet *subWallet = masterWallet->CreateSubWallet("ELA");
+
+	struct rusage before, after;
+	getrusage(RUSAGE_SELF, &before);
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	subWallet->SyncStart();
+	nlohmann::json metrics = waitForSync(subWallet, chain, std::chrono::minutes(10));
+
+	std::chrono::milliseconds elapsed =
+		std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+	getrusage(RUSAGE_SELF, &after);
+
+	subWallet->SyncStop();
+	peer.Stop();
+
+	REQUIRE(peer.BlocksServed() >= chainLength);
+	WARN("Sync: " << chainLength << " blocks, " << chain.WalletTxCount() << " wallet tx in " << elapsed.count() <<
+		 " ms, " << chainLength * 1000 / std::max<int64_t>(elapsed.count(), 1) << " blocks/s, " <<
+		 cpuSeconds(after) - cpuSeconds(before) << " s cpu, " << after.ru_maxrss / 1024 << " MiB peak rss, " <<
+		 peer.Connections() << " connections, " << peer.MessagesSent() << " messages");
+	WARN("Sync metrics: " << metrics.dump());
+
+	manager.reset();
+	boost::filesystem::remove_all(__rootPath);
+}
@@ -0,0 +1,117 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#define CATCH_CONFIG_MAIN
+
+#include <catch.hpp>
+
+#include <P2P/SyncMetrics.h>
+#include <Common/Log.h>
+
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
+using namespace Elastos::ElaWallet;
+
+static void RecordMany(SyncMetrics *metrics, size_t count) {
+	for (size_t i = 0; i < count; ++i) {
+		metrics->Record(SyncMetrics::Checksum, i % 100);
+		metrics->Add(SyncMetrics::BytesReceived, 10);
+	}
+}
+
+TEST_CASE("SyncMetrics test", "[SyncMetrics]") {
+	Log::registerMultiLogger();
+
+	SECTION("histogram") {
+		SyncMetrics metrics;
+
+		REQUIRE(metrics.Get(SyncMetrics::VerifyBlock).Count == 0);
+		REQUIRE(metrics.Get(SyncMetrics::VerifyBlock).Percentile(50) == 0);
+
+		// 90 fast ones and 10 slow ones
+		for (int i = 0; i < 90; ++i)
+			metrics.Record(SyncMetrics::VerifyBlock, 3);
+		for (int i = 0; i < 10; ++i)
+			metrics.Record(SyncMetrics::VerifyBlock, 1000);
+
+		SyncMetrics::StageStats stats = metrics.Get(SyncMetrics::VerifyBlock);
+		REQUIRE(stats.Count == 100);
+		REQUIRE(stats.TotalMicroseconds == 90 * 3 + 10 * 1000);
+		REQUIRE(stats.MaxMicroseconds == 1000);
+		REQUIRE(stats.Buckets[2] == 90);  // 2 <= 3 < 4
+		REQUIRE(stats.Buckets[10] == 10); // 512 <= 1000 < 1024
+		REQUIRE(stats.Percentile(50) == 4);
+		REQUIRE(stats.Percentile(89) == 4);
+		REQUIRE(stats.Percentile(90) == 1000); // the bucket bound is capped by the max
+		REQUIRE(stats.Percentile(100) == 1000);
+
+		// too slow for any bucket but the last
+		metrics.Record(SyncMetrics::VerifyBlock, (uint64_t) 1 << 40);
+		REQUIRE(metrics.Get(SyncMetrics::VerifyBlock).Buckets[SYNC_METRICS_BUCKETS - 1] == 1);
+		REQUIRE(metrics.Get(SyncMetrics::VerifyBlock).Percentile(100) == (uint64_t) 1 << 40);
+
+		REQUIRE(metrics.Get(SyncMetrics::Checksum).Count == 0);
+	}
+
+	SECTION("counters, timer and reset") {
+		SyncMetrics metrics;
+
+		metrics.Add(SyncMetrics::MessagesReceived);
+		metrics.Add(SyncMetrics::BytesReceived, 100);
+		metrics.Add(SyncMetrics::BytesReceived, 24);
+		REQUIRE(metrics.Get(SyncMetrics::MessagesReceived) == 1);
+		REQUIRE(metrics.Get(SyncMetrics::BytesReceived) == 124);
+
+		{
+			SyncMetrics::Timer timer(metrics, SyncMetrics::SaveBlocks);
+			boost::this_thread::sleep_for(boost::chrono::milliseconds(2));
+		}
+		REQUIRE(metrics.Get(SyncMetrics::SaveBlocks).Count == 1);
+		REQUIRE(metrics.Get(SyncMetrics::SaveBlocks).MaxMicroseconds >= 2000);
+
+		metrics.Reset();
+		REQUIRE(metrics.Get(SyncMetrics::BytesReceived) == 0);
+		REQUIRE(metrics.Get(SyncMetrics::SaveBlocks).Count == 0);
+		REQUIRE(metrics.Get(SyncMetrics::SaveBlocks).MaxMicroseconds == 0);
+	}
+
+	SECTION("json") {
+		SyncMetrics metrics;
+
+		metrics.Record(SyncMetrics::UpdateTxns, 10);
+		metrics.Record(SyncMetrics::UpdateTxns, 30);
+		metrics.Add(SyncMetrics::ChecksumFailures);
+
+		nlohmann::json j = metrics.ToJson();
+		for (int i = 0; i < SyncMetrics::StageCount; ++i)
+			REQUIRE(j["Stages"].find(SyncMetrics::StageName((SyncMetrics::Stage) i)) != j["Stages"].end());
+		for (int i = 0; i < SyncMetrics::CounterCount; ++i)
+			REQUIRE(j["Counters"].find(SyncMetrics::CounterName((SyncMetrics::Counter) i)) != j["Counters"].end());
+
+		REQUIRE(j["Stages"]["UpdateTxns"]["Count"] == 2);
+		REQUIRE(j["Stages"]["UpdateTxns"]["AverageMicroseconds"] == 20);
+		REQUIRE(j["Stages"]["UpdateTxns"]["MaxMicroseconds"] == 30);
+		REQUIRE(j["Counters"]["ChecksumFailures"] == 1);
+	}
+
+	SECTION("concurrent recording") {
+		SyncMetrics metrics;
+		boost::thread_group threads;
+
+		for (int i = 0; i < 4; ++i)
+			threads.create_thread(boost::bind(&RecordMany, &metrics, 10000));
+		threads.join_all();
+
+		SyncMetrics::StageStats stats = metrics.Get(SyncMetrics::Checksum);
+		uint64_t buckets = 0;
+		for (size_t i = 0; i < SYNC_METRICS_BUCKETS; ++i)
+			buckets += stats.Buckets[i];
+
+		REQUIRE(stats.Count == 40000);
+		REQUIRE(buckets == 40000);
+		REQUIRE(stats.MaxMicroseconds == 99);
+		REQUIRE(metrics.Get(SyncMetrics::BytesReceived) == 400000);
+	}
+}
@@ -0,0 +1,162 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#define CATCH_CONFIG_MAIN
+
+#include <catch.hpp>
+#include "TestHelper.h"
+
+#include <P2P/TransactionPeerMap.h>
+#include <P2P/PublishedTransactionQueue.h>
+#include <Common/Log.h>
+
+using namespace Elastos::ElaWallet;
+
+static TransactionPtr createTx(uint32_t lockTime) {
+	TransactionPtr tx(new Transaction());
+	tx->SetLockTime(lockTime);
+	tx->SetBlockHeight(TX_UNCONFIRMED);
+	return tx;
+}
+
+static void publishCallback(const uint256 &, int, const std::string &) {
+}
+
+TEST_CASE("TransactionPeerMap test", "[TransactionPeerMap]") {
+	Log::registerMultiLogger();
+	srand(time(nullptr));
+
+	PeerInfo peer1(uint128(), 20866, 0), peer2(uint128(), 20867, 0), peer3(uint128(), 20868, 0);
+
+	SECTION("add and remove") {
+		TransactionPeerMap map;
+		uint256 tx1 = getRanduint256(), tx2 = getRanduint256();
+
+		REQUIRE(map.AddPeer(tx1, peer1, 0) == 1);
+		REQUIRE(map.AddPeer(tx1, peer1, 0) == 1);
+		REQUIRE(map.AddPeer(tx1, peer2, 0) == 2);
+		REQUIRE(map.AddPeer(tx2, peer2, 0) == 1);
+		REQUIRE(map.Size() == 2);
+
+		REQUIRE(map.HasPeer(tx1, peer1));
+		REQUIRE(!map.HasPeer(tx2, peer1));
+		REQUIRE(map.PeerCount(tx1) == 2);
+		REQUIRE(map.PeerCount(getRanduint256()) == 0);
+
+		REQUIRE(map.RemovePeer(tx1, peer1));
+		REQUIRE(!map.RemovePeer(tx1, peer1));
+		REQUIRE(!map.RemovePeer(tx1, peer3));
+		REQUIRE(map.PeerCount(tx1) == 1);
+
+		// a tx without peers left is forgotten
+		map.RemovePeer(peer2);
+		REQUIRE(map.Size() == 0);
+		REQUIRE(map.PeerCount(tx1) == 0);
+		REQUIRE(map.PeerCount(tx2) == 0);
+		REQUIRE(map.Evicted() == 0);
+
+		map.AddPeer(tx1, peer3, 0);
+		map.Clear();
+		REQUIRE(map.Size() == 0);
+	}
+
+	SECTION("eviction") {
+		TransactionPeerMap map(3, 100);
+		std::vector<uint256> hashes;
+		for (size_t i = 0; i < 4; ++i)
+			hashes.push_back(getRanduint256());
+
+		map.AddPeer(hashes[0], peer1, 0);
+		map.AddPeer(hashes[1], peer1, 1);
+		map.AddPeer(hashes[2], peer1, 2);
+
+		// hashes[0] was announced again, hashes[1] is now the least recent one
+		map.AddPeer(hashes[0], peer2, 3);
+		map.AddPeer(hashes[3], peer1, 4);
+		REQUIRE(map.Size() == 3);
+		REQUIRE(map.Evicted() == 1);
+		REQUIRE(map.PeerCount(hashes[1]) == 0);
+		REQUIRE(map.PeerCount(hashes[0]) == 2);
+
+		// entries older than the max age go before the map fills up
+		map.AddPeer(getRanduint256(), peer1, 102);
+		REQUIRE(map.PeerCount(hashes[2]) == 0);
+		REQUIRE(map.PeerCount(hashes[0]) == 2);
+		REQUIRE(map.Size() == 3);
+		REQUIRE(map.Evicted() == 2);
+	}
+
+	SECTION("kept tx") {
+		TransactionPeerMap map(2, 100);
+		uint256 walletTx = getRanduint256(), relayedTx = getRanduint256();
+
+		map.AddPeer(walletTx, peer1, 0, true);
+		map.AddPeer(relayedTx, peer1, 0);
+		// a tx becomes kept once it's added to be kept
+		map.AddPeer(relayedTx, peer2, 1, true);
+
+		// neither a full map nor the max age evicts them
+		for (size_t i = 0; i < 5; ++i)
+			map.AddPeer(getRanduint256(), peer1, 200 + i);
+		REQUIRE(map.PeerCount(walletTx) == 1);
+		REQUIRE(map.PeerCount(relayedTx) == 2);
+		REQUIRE(map.Size() == 4);
+		REQUIRE(map.Evicted() == 3);
+
+		// they are forgotten once no peer is left for them
+		map.RemovePeer(peer2);
+		REQUIRE(map.PeerCount(relayedTx) == 1);
+		map.RemovePeer(peer1);
+		REQUIRE(map.Size() == 0);
+	}
+}
+
+TEST_CASE("PublishedTransactionQueue test", "[PublishedTransactionQueue]") {
+	Log::registerMultiLogger();
+
+	SECTION("callbacks") {
+		PublishedTransactionQueue queue;
+		TransactionPtr tx1 = createTx(1), tx2 = createTx(2);
+
+		REQUIRE(queue.Add(PublishedTransaction(tx1, publishCallback), 0));
+		REQUIRE(!queue.Add(PublishedTransaction(tx1, publishCallback), 0));
+		REQUIRE(queue.Add(PublishedTransaction(tx2), 0));
+		REQUIRE(queue.Size() == 2);
+		REQUIRE(queue.Contains(tx2->GetHash()));
+		REQUIRE(queue.PendingCallbacks() == 1);
+		REQUIRE(queue.PendingHashes() == std::vector<uint256>{tx1->GetHash()});
+		REQUIRE(queue.Hashes() == (std::vector<uint256>{tx1->GetHash(), tx2->GetHash()}));
+
+		// the callback is handed out once
+		REQUIRE(queue.TakeCallback(tx1->GetHash()).HasCallback());
+		REQUIRE(!queue.TakeCallback(tx1->GetHash()).HasCallback());
+		REQUIRE(!queue.HasPendingCallbacks());
+		REQUIRE(queue.Get(tx1->GetHash()).GetTransaction() == tx1);
+		REQUIRE(queue.Get(getRanduint256()).GetTransaction() == nullptr);
+
+		REQUIRE(queue.Remove(tx1->GetHash()));
+		REQUIRE(!queue.Remove(tx1->GetHash()));
+		REQUIRE(queue.Size() == 1);
+	}
+
+	SECTION("eviction") {
+		PublishedTransactionQueue queue(2, 100);
+		TransactionPtr tx1 = createTx(1), tx2 = createTx(2), tx3 = createTx(3), tx4 = createTx(4);
+
+		queue.Add(PublishedTransaction(tx1, publishCallback), 0);
+		queue.Add(PublishedTransaction(tx2), 1);
+
+		// a tx still waiting for its callback is never dropped
+		queue.Add(PublishedTransaction(tx3), 2);
+		REQUIRE(queue.Contains(tx1->GetHash()));
+		REQUIRE(!queue.Contains(tx2->GetHash()));
+		REQUIRE(queue.Evicted() == 1);
+
+		queue.Add(PublishedTransaction(tx4), 102);
+		REQUIRE(queue.Contains(tx1->GetHash()));
+		REQUIRE(!queue.Contains(tx3->GetHash()));
+		REQUIRE(queue.Contains(tx4->GetHash()));
+		REQUIRE(queue.PendingCallbacks() == 1);
+	}
+}
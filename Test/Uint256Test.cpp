@@ -9,6 +9,8 @@
 #include <Common/uint256.h>
 #include <Common/Utils.h>
 
+#include <set>
+
 using namespace Elastos::ElaWallet;
 
 TEST_CASE("uint256 test", "[uint256]") {
@@ -27,5 +29,21 @@ TEST_CASE("uint256 test", "[uint256]") {
 		REQUIRE(temp160 == u160);
 	}
 
+	SECTION("hasher") {
+		// SipHash-2-4 reference vector, key 00..0f and the 32 bytes 00..1f
+		uint256 val("1f1e1d1c1b1a191817161514131211100f0e0d0c0b0a09080706050403020100");
+		REQUIRE(SipHashUint256(0x0706050403020100ULL, 0x0F0E0D0C0B0A0908ULL, val) == 0x7127512f72f27cceULL);
+
+		// hashes a peer made equal in their low 64 bits still spread out
+		uint256Hasher hasher;
+		bytes_t data = Utils::GetRandom(32);
+		std::set<size_t> hashes;
+		for (uint8_t i = 0; i < 100; ++i) {
+			data[31] = i;
+			hashes.insert(hasher(uint256(data)));
+		}
+		REQUIRE(hashes.size() == 100);
+	}
+
 }
 
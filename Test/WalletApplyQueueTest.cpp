@@ -0,0 +1,87 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#define CATCH_CONFIG_MAIN
+
+#include <catch.hpp>
+
+#include <P2P/WalletApplyQueue.h>
+#include <Common/Log.h>
+
+#include <stdexcept>
+#include <boost/bind.hpp>
+
+using namespace Elastos::ElaWallet;
+
+class Applied {
+public:
+	void Add(int n) {
+		boost::mutex::scoped_lock scopedLock(_lock);
+		_values.push_back(n);
+	}
+
+	void Throw() {
+		throw std::runtime_error("apply failed");
+	}
+
+	std::vector<int> Values() {
+		boost::mutex::scoped_lock scopedLock(_lock);
+		return _values;
+	}
+
+private:
+	boost::mutex _lock;
+	std::vector<int> _values;
+};
+
+TEST_CASE("WalletApplyQueue test", "[WalletApplyQueue]") {
+	Log::registerMultiLogger();
+
+	SECTION("order and flush") {
+		WalletApplyQueue queue;
+		Applied applied;
+
+		for (int i = 0; i < 100; ++i)
+			queue.Post(boost::bind(&Applied::Add, &applied, i));
+		queue.Flush();
+
+		std::vector<int> values = applied.Values();
+		REQUIRE(values.size() == 100);
+		for (int i = 0; i < 100; ++i)
+			REQUIRE(values[i] == i);
+		REQUIRE(queue.Pending() == 0);
+		REQUIRE(queue.Applied() == 100);
+		REQUIRE(queue.PeakPending() >= 1);
+	}
+
+	SECTION("a failing task doesn't stop the ones after it") {
+		WalletApplyQueue queue;
+		Applied applied;
+
+		queue.Post(boost::bind(&Applied::Add, &applied, 1));
+		queue.Post(boost::bind(&Applied::Throw, &applied));
+		queue.Post(boost::bind(&Applied::Add, &applied, 2));
+		queue.Flush();
+
+		REQUIRE(applied.Values() == std::vector<int>({1, 2}));
+		REQUIRE(queue.Applied() == 3);
+	}
+
+	SECTION("stop") {
+		WalletApplyQueue queue;
+		Applied applied;
+
+		// tasks posted before stop still run
+		for (int i = 0; i < 10; ++i)
+			queue.Post(boost::bind(&Applied::Add, &applied, i));
+		queue.Stop();
+		REQUIRE(applied.Values().size() == 10);
+
+		// after stop tasks are dropped, not run on the caller
+		queue.Post(boost::bind(&Applied::Add, &applied, 10));
+		REQUIRE(applied.Values().size() == 10);
+		REQUIRE(queue.Pending() == 0);
+		REQUIRE(queue.Applied() == 10);
+	}
+}
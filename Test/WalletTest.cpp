@@ -0,0 +1,162 @@
+// Copyright (c) 2012-2018 The Elastos Open Source Project
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#define CATCH_CONFIG_MAIN
+
+#include <catch.hpp>
+#include "TestHelper.h"
+
+#include <Account/Account.h>
+#include <Account/SubAccount.h>
+#include <Database/DatabaseManager.h>
+#include <Plugin/Registry.h>
+#include <Plugin/Transaction/Attribute.h>
+#include <Plugin/Transaction/Program.h>
+#include <Plugin/Transaction/Transaction.h>
+#include <Plugin/Transaction/TransactionInput.h>
+#include <Plugin/Transaction/TransactionOutput.h>
+#include <Wallet/Wallet.h>
+#include <WalletCore/HDKeychain.h>
+#include <Common/Log.h>
+
+#include <boost/filesystem.hpp>
+
+#include <set>
+
+using namespace Elastos::ElaWallet;
+
+static const std::string __rootPath = "./WalletTest/";
+static const std::string mnemonic = "abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon about";
+static const std::string payPassword = "payPassword";
+
+class NullWalletListener : public Wallet::Listener {
+public:
+	virtual void onBalanceChanged(const uint256 &asset, const BigInt &balance) {}
+
+	virtual void onTxAdded(const TransactionPtr &tx) {}
+
+	virtual void onTxUpdated(const std::vector<TransactionPtr> &txns) {}
+
+	virtual void onTxDeleted(const TransactionPtr &tx, bool notifyUser, bool recommendRescan) {}
+
+	virtual void onAssetRegistered(const AssetPtr &asset, uint64_t amount, const uint168 &controller) {}
+};
+
+// what LoadBloomFilter derived from the wallet for every filter before the elements were kept up to date
+static std::set<bytes_t> derivedElements(const WalletPtr &wallet) {
+	std::set<bytes_t> elements;
+	AddressArray addrs, addrInternal, allCID, special = wallet->GetAllSpecialAddresses();
+
+	wallet->GetAllAddresses(addrs, 0, UINT32_MAX, false);
+	wallet->GetAllAddresses(addrInternal, 0, UINT32_MAX, true);
+	addrs.insert(addrs.end(), addrInternal.begin(), addrInternal.end());
+	addrs.insert(addrs.end(), special.begin(), special.end());
+	for (size_t i = 0; i < addrs.size(); ++i) {
+		if (addrs[i]->Valid())
+			elements.insert(addrs[i]->ProgramHash().bytes());
+	}
+
+	wallet->GetAllCID(allCID, 0, UINT32_MAX);
+	for (size_t i = 0; i < allCID.size(); ++i)
+		elements.insert(allCID[i]->ProgramHash().bytes());
+
+	UTXOArray utxos = wallet->GetAllUTXO("");
+	for (size_t i = 0; i < utxos.size(); ++i) {
+		bytes_t o = utxos[i]->Hash().bytes();
+		o.append(utxos[i]->Index());
+		elements.insert(o);
+	}
+
+	return elements;
+}
+
+static std::set<bytes_t> keptElements(const WalletPtr &wallet) {
+	std::vector<bytes_t> elements;
+	wallet->GetBloomFilterElements(elements);
+	return std::set<bytes_t>(elements.begin(), elements.end());
+}
+
+static TransactionPtr createTx(const uint256 &inputHash, uint16_t inputIndex, const Address &to) {
+	TransactionPtr tx(new Transaction());
+	tx->SetVersion(Transaction::TxVersion::V09);
+	tx->SetLockTime(0);
+
+	InputPtr input(new TransactionInput());
+	input->SetTxHash(inputHash);
+	input->SetIndex(inputIndex);
+	input->SetSequence(0xffffffff);
+	tx->AddInput(input);
+
+	tx->AddOutput(OutputPtr(new TransactionOutput(BigInt(100000000), to)));
+	tx->AddAttribute(AttributePtr(new Attribute(Attribute::Nonce, getRandBytes(8))));
+
+	return tx;
+}
+
+TEST_CASE("Wallet bloom filter elements", "[Wallet]") {
+	Log::registerMultiLogger();
+
+	boost::filesystem::remove_all(__rootPath);
+	boost::filesystem::create_directories(__rootPath);
+
+	{
+		AccountPtr account(new Account(__rootPath + "account", mnemonic, "", payPassword, false));
+		SubAccountPtr subAccount(new SubAccount(account, 0));
+		subAccount->Init();
+		DatabaseManagerPtr database(new DatabaseManager(__rootPath + "wallet.db"));
+		boost::shared_ptr<Wallet::Listener> listener(new NullWalletListener());
+		WalletPtr wallet(new Wallet(0, "WalletTest", CHAINID_MAINCHAIN, subAccount, listener, database));
+
+		REQUIRE(keptElements(wallet) == derivedElements(wallet));
+
+		// addresses generated past the ones the wallet starts with
+		wallet->UnusedAddresses(SEQUENCE_GAP_LIMIT_EXTERNAL + 300, 0);
+		wallet->UnusedAddresses(SEQUENCE_GAP_LIMIT_INTERNAL + 200, 1);
+		REQUIRE(keptElements(wallet) == derivedElements(wallet));
+
+		AddressArray addrs;
+		wallet->GetAllAddresses(addrs, 0, 1, false);
+		AddressPtr receiveAddress = addrs[0];
+
+		// confirmed receives add UTXOs, and generate addresses past the one paid
+		TransactionPtr receive1 = createTx(getRanduint256(), 0, *receiveAddress);
+		receive1->SetBlockHeight(10);
+		receive1->SetTimestamp(time(nullptr));
+		REQUIRE(wallet->RegisterTransaction(receive1));
+
+		TransactionPtr receive2 = createTx(getRanduint256(), 0, *receiveAddress);
+		receive2->SetBlockHeight(11);
+		receive2->SetTimestamp(time(nullptr));
+		REQUIRE(wallet->RegisterTransaction(receive2));
+
+		REQUIRE(wallet->GetAllUTXO("").size() == 2);
+		REQUIRE(keptElements(wallet) == derivedElements(wallet));
+
+		// a confirmed spend drops the UTXO it spends, and adds its change
+		addrs.clear();
+		wallet->GetAllAddresses(addrs, 0, 1, true);
+		TransactionPtr spend = createTx(receive1->GetHash(), 0, *addrs[0]);
+		bytes_t code;
+		std::string path;
+		REQUIRE(subAccount->GetCodeAndPath(receiveAddress, code, path));
+		spend->AddProgram(ProgramPtr(new Program(path, code, bytes_t())));
+		wallet->SignTransaction(spend, payPassword);
+		spend->SetBlockHeight(12);
+		spend->SetTimestamp(time(nullptr));
+		REQUIRE(wallet->RegisterTransaction(spend));
+
+		UTXOArray utxos = wallet->GetAllUTXO("");
+		REQUIRE(utxos.size() == 2);
+		for (size_t i = 0; i < utxos.size(); ++i)
+			REQUIRE(utxos[i]->Hash() != receive1->GetHash());
+		REQUIRE(keptElements(wallet) == derivedElements(wallet));
+
+		// removing a receive drops its UTXO
+		wallet->RemoveTransaction(receive2->GetHash());
+		REQUIRE(wallet->GetAllUTXO("").size() == 1);
+		REQUIRE(keptElements(wallet) == derivedElements(wallet));
+	}
+
+	boost::filesystem::remove_all(__rootPath);
+}